@@ -0,0 +1,523 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+#
+# SPDX-License-Identifier: MIT
+#
+"""Scripted boot flow of the miv-rv32-bootloader on Renode.
+
+Starts Renode with miv-rv32-bootloader.resc, then drives the bootloader menu
+over the UART pty and Renode through its monitor port:
+
+  menu       reset to the bootloader menu
+  ymodem     menu option 3, YMODEM download of the application image to LSRAM,
+             or menu option 7 for an ELF image (Bootloader-Release --elf only)
+  spi-flash  menu option 1, LSRAM copied to the SPI flash
+  eeprom     menu option 2, LSRAM copied to the I2C EEPROM (--eeprom only)
+  upload     menu option u, SPI flash boot image sent back with YMODEM, or
+             YMODEM-G with --ymodem-g, and compared (--upload only)
+  boot       MIV_ESS bootstrap copy from the SPI flash to the TCM, processor
+             reset, until the application prints the --expect string
+
+The simulated time taken by each phase is read from Renode and reported along
+with the host time. The application image must be a raw binary linked for the
+TCM (0x40000000), an Intel HEX file which is converted to one, or an ELF file
+whose segments are loaded by the bootloader. By default the bootloader's own
+Bootloader-Debug image is used, so the boot phase ends when the bootloader menu
+is printed again from the copy loaded from flash.
+"""
+
+import argparse
+import os
+import re
+import select
+import socket
+import subprocess
+import sys
+import termios
+import time
+import tty
+
+SOH = 0x01
+STX = 0x02
+EOT = 0x04
+ACK = 0x06
+NAK = 0x15
+CAN = 0x18
+CRC = 0x43
+YMG = 0x47
+RES = 0x52
+
+MENU_PROMPT = b"Type 3 Download"
+YMODEM_PROMPT = b"initiate transfer on host computer."
+UPLOAD_CHOICE = b"b slot B image"
+UPLOAD_PROMPT = b"start receiving the file on host computer."
+FLASH_DONE = b"Flash write success"
+EEPROM_DONE = b"MIV_I2C Write Complete!"
+
+ANSI_ESCAPE = re.compile(rb"\x1b\[[0-9;?]*[A-Za-z]")
+TELNET_COMMAND = re.compile(rb"\xff[\xfb-\xfe].|\xff[\xf0-\xfa]")
+MONITOR_PROMPT = re.compile(rb"\([^\s()]+\) $")
+TIME_STAMP = re.compile(r"(\d+):(\d{2}):(\d{2}(?:\.\d+)?)")
+
+
+class ScenarioError(Exception):
+    pass
+
+
+class Monitor:
+    """Renode monitor over its telnet port."""
+
+    def __init__(self, port, timeout):
+        deadline = time.monotonic() + timeout
+        while True:
+            try:
+                self.sock = socket.create_connection(("localhost", port), timeout=1.0)
+                break
+            except OSError:
+                if time.monotonic() > deadline:
+                    raise ScenarioError("cannot connect to the Renode monitor on port %d" % port)
+                time.sleep(0.5)
+        self.timeout = timeout
+        self._read_until_prompt()
+
+    def _read_until_prompt(self):
+        data = b""
+        deadline = time.monotonic() + self.timeout
+        while True:
+            text = ANSI_ESCAPE.sub(b"", TELNET_COMMAND.sub(b"", data))
+            if MONITOR_PROMPT.search(text):
+                return text.decode("utf-8", "replace")
+            if time.monotonic() > deadline:
+                raise ScenarioError("no prompt from the Renode monitor")
+            self.sock.settimeout(max(0.1, deadline - time.monotonic()))
+            try:
+                chunk = self.sock.recv(4096)
+            except socket.timeout:
+                continue
+            if not chunk:
+                raise ScenarioError("Renode monitor connection closed")
+            data += chunk
+
+    def command(self, cmd):
+        self.sock.sendall(cmd.encode("utf-8") + b"\n")
+        lines = self._read_until_prompt().replace("\r", "").split("\n")
+        # Drop the echoed command and the prompt
+        lines = [line for line in lines[:-1] if line.strip() and line.strip() != cmd]
+        return "\n".join(lines)
+
+    def virtual_time(self, time_command):
+        output = self.command(time_command)
+        match = TIME_STAMP.search(output)
+        if match:
+            return int(match.group(1)) * 3600 + int(match.group(2)) * 60 + float(match.group(3))
+        try:
+            return float(output.split()[-1])
+        except (ValueError, IndexError):
+            raise ScenarioError("cannot parse the virtual time from '%s'" % output)
+
+    def close(self):
+        try:
+            self.sock.sendall(b"quit\n")
+        except OSError:
+            pass
+        self.sock.close()
+
+
+class Uart:
+    """The bootloader UART, through the pty created by the Renode script."""
+
+    def __init__(self, path, timeout):
+        deadline = time.monotonic() + timeout
+        while not os.path.exists(path):
+            if time.monotonic() > deadline:
+                raise ScenarioError("pty %s not created" % path)
+            time.sleep(0.1)
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        tty.setraw(self.fd)
+        termios.tcflush(self.fd, termios.TCIOFLUSH)
+        self.buffer = bytearray()
+
+    def _fill(self, timeout):
+        ready, _, _ = select.select([self.fd], [], [], timeout)
+        if ready:
+            self.buffer += os.read(self.fd, 4096)
+            return True
+        return False
+
+    def write(self, data):
+        view = memoryview(data)
+        while view:
+            written = os.write(self.fd, view)
+            view = view[written:]
+
+    def read_byte(self, timeout):
+        deadline = time.monotonic() + timeout
+        while not self.buffer:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0 or not self._fill(remaining):
+                return None
+        byte = self.buffer[0]
+        del self.buffer[0]
+        return byte
+
+    def expect(self, text, timeout, echo=None):
+        """Consume the UART output up to and including text."""
+        deadline = time.monotonic() + timeout
+        while True:
+            index = self.buffer.find(text)
+            if index >= 0:
+                if echo:
+                    echo.write(self.buffer[:index + len(text)].decode("latin-1"))
+                del self.buffer[:index + len(text)]
+                return
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                raise ScenarioError("timeout waiting for '%s' on the UART" % text.decode())
+            self._fill(remaining)
+
+    def discard(self):
+        while self._fill(0):
+            pass
+        self.buffer.clear()
+
+    def close(self):
+        os.close(self.fd)
+
+
+def crc16(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if (crc & 0x8000) else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def ymodem_packet(seq, payload):
+    header = STX if len(payload) == 1024 else SOH
+    return (bytes([header, seq & 0xFF, 0xFF - (seq & 0xFF)]) + payload
+            + crc16(payload).to_bytes(2, "big"))
+
+
+def ymodem_send(uart, name, data, timeout, retries=10):
+    """YMODEM batch sender, one file, CRC-16, 1K blocks.
+
+    The header announces "+resume". If the bootloader holds part of the same
+    file from an interrupted download, it replies with 'R' and the offset of
+    the first missing 1K block, and only the rest of the file is sent. Returns
+    that offset.
+    """
+
+    def wait_for(expected):
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            byte = uart.read_byte(deadline - time.monotonic())
+            if byte in expected:
+                return byte
+            if byte == CAN:
+                raise ScenarioError("YMODEM transfer cancelled by the receiver")
+        raise ScenarioError("YMODEM receiver not responding")
+
+    def send(packet, expected=(ACK,)):
+        for _ in range(retries):
+            uart.write(packet)
+            if wait_for((ACK, NAK, CRC)) in expected:
+                return
+        raise ScenarioError("YMODEM packet rejected %d times" % retries)
+
+    wait_for((CRC,))
+
+    header = name.encode() + b"\0" + str(len(data)).encode() + b" +resume\0"
+    send(ymodem_packet(0, header.ljust(128, b"\0")))
+
+    offset = 0
+    if wait_for((CRC, RES)) == RES:
+        digits = bytes(uart.read_byte(timeout) or 0 for _ in range(8))
+        try:
+            offset = int(digits, 16)
+        except ValueError:
+            raise ScenarioError("YMODEM bad resume offset %r" % digits)
+        if offset > len(data):
+            raise ScenarioError("YMODEM resume offset %d beyond the file" % offset)
+        wait_for((CRC,))
+
+    start = offset
+    seq = 1
+    while offset < len(data):
+        size = 1024 if len(data) - offset > 128 else 128
+        block = data[offset:offset + size].ljust(size, b"\x1a")
+        send(ymodem_packet(seq, block))
+        offset += size
+        seq += 1
+
+    send(bytes([EOT]))
+
+    # Empty header packet closes the batch
+    wait_for((CRC,))
+    send(ymodem_packet(0, bytes(128)))
+
+    return start
+
+
+def ymodem_receive(uart, timeout, streaming=False):
+    """YMODEM batch receiver, one file, CRC-16.
+
+    Requests YMODEM-G when streaming is set: the sender does not wait for an
+    ACK after each packet. Returns the file name and the file content.
+    """
+    start = YMG if streaming else CRC
+
+    def read_packet():
+        header = uart.read_byte(timeout)
+        if header is None:
+            raise ScenarioError("YMODEM sender not responding")
+        if header == EOT:
+            return None, None
+        if header == CAN:
+            raise ScenarioError("YMODEM transfer cancelled by the sender")
+        if header not in (SOH, STX):
+            return -1, None
+        size = 1024 if header == STX else 128
+        body = bytearray()
+        while len(body) < size + 4:
+            byte = uart.read_byte(timeout)
+            if byte is None:
+                raise ScenarioError("YMODEM sender not responding")
+            body.append(byte)
+        seq, payload = body[0], bytes(body[2:2 + size])
+        if body[1] != 0xFF - seq or crc16(payload) != int.from_bytes(body[2 + size:], "big"):
+            return -1, None
+        return seq, payload
+
+    def reject():
+        if streaming:
+            uart.write(bytes([CAN, CAN]))
+            raise ScenarioError("YMODEM-G packet error")
+        uart.write(bytes([NAK]))
+
+    uart.write(bytes([start]))
+    seq, header = read_packet()
+    while seq != 0:
+        reject()
+        seq, header = read_packet()
+    name, _, fields = header.partition(b"\0")
+    length = int(fields.split(b"\0")[0].split(b" ")[0])
+    uart.write(bytes([start]) if streaming else bytes([ACK, start]))
+
+    data = bytearray()
+    expected = 1
+    while True:
+        seq, payload = read_packet()
+        if seq is None:
+            uart.write(bytes([ACK]))
+            break
+        if seq == -1:
+            reject()
+            continue
+        if seq == expected & 0xFF:
+            data += payload
+            expected += 1
+        if not streaming:
+            uart.write(bytes([ACK]))
+
+    # Empty header packet closes the batch
+    uart.write(bytes([start]))
+    read_packet()
+    uart.write(bytes([ACK]))
+
+    if len(data) < length:
+        raise ScenarioError("YMODEM file truncated, %d of %d bytes" % (len(data), length))
+    return name.decode(), bytes(data[:length])
+
+
+def load_image(path):
+    with open(path, "rb") as image:
+        content = image.read()
+    if not path.lower().endswith(".hex"):
+        return content
+
+    records = {}
+    upper = 0
+    for line in content.decode("ascii").splitlines():
+        line = line.strip()
+        if not line.startswith(":"):
+            continue
+        record = bytes.fromhex(line[1:])
+        count, address, kind = record[0], (record[1] << 8) | record[2], record[3]
+        if kind == 0x00:
+            records[upper + address] = record[4:4 + count]
+        elif kind == 0x02:
+            upper = ((record[4] << 8) | record[5]) << 4
+        elif kind == 0x04:
+            upper = ((record[4] << 8) | record[5]) << 16
+        elif kind == 0x01:
+            break
+    if not records:
+        raise ScenarioError("no data in %s" % path)
+    base = min(records)
+    image = bytearray(max(a + len(d) for a, d in records.items()) - base)
+    for address, data in records.items():
+        image[address - base:address - base + len(data)] = data
+    return bytes(image)
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    project = os.path.dirname(here)
+    default_elf = os.path.join(project, "Bootloader-Debug", "miv-rv32-bootloader.elf")
+
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--renode", default="renode", help="Renode executable")
+    parser.add_argument("--port", type=int, default=1234, help="Renode monitor port")
+    parser.add_argument("--elf", default=default_elf, help="bootloader ELF file")
+    parser.add_argument("--image", help="application image to download, .bin, .hex or .elf "
+                        "(default: the bootloader ELF converted to a binary by objcopy)")
+    parser.add_argument("--objcopy", default="riscv64-unknown-elf-objcopy",
+                        help="objcopy used to convert the default image")
+    parser.add_argument("--expect", default="MIV_ESS Bootloader",
+                        help="text printed by the application once booted")
+    parser.add_argument("--pty", default="/tmp/miv-rv32-bootloader-uart", help="UART pty path")
+    parser.add_argument("--eeprom", action="store_true", help="also copy the image to the I2C EEPROM")
+    parser.add_argument("--upload", action="store_true",
+                        help="also upload the SPI flash boot image back to the host")
+    parser.add_argument("--ymodem-g", action="store_true", help="upload with YMODEM-G")
+    parser.add_argument("--ymodem-attempts", type=int, default=1,
+                        help="YMODEM downloads attempted, each resuming the previous one")
+    parser.add_argument("--timeout", type=float, default=600.0, help="timeout per phase, host seconds")
+    parser.add_argument("--time-command", default="machine ElapsedVirtualTime",
+                        help="monitor command returning the elapsed virtual time")
+    parser.add_argument("--csv", help="also write the results to this CSV file")
+    parser.add_argument("--verbose", action="store_true", help="echo the UART output")
+    args = parser.parse_args()
+
+    if args.image:
+        image = load_image(args.image)
+        image_name = os.path.basename(args.image)
+    else:
+        image_path = os.path.splitext(args.elf)[0] + ".bin"
+        subprocess.check_call([args.objcopy, "-O", "binary", args.elf, image_path])
+        image = load_image(image_path)
+        image_name = os.path.basename(image_path)
+
+    echo = sys.stdout if args.verbose else None
+    log = open(os.path.join(here, "renode.log"), "w")
+    renode = subprocess.Popen([args.renode, "--disable-xwt", "--port", str(args.port)],
+                              stdout=log, stderr=subprocess.STDOUT)
+    monitor = None
+    uart = None
+    results = []
+    status = 0
+
+    try:
+        monitor = Monitor(args.port, 60.0)
+        monitor.command("$elf=@%s" % os.path.abspath(args.elf))
+        monitor.command("$pty=\"%s\"" % args.pty)
+        monitor.command("include @%s" % os.path.join(here, "miv-rv32-bootloader.resc"))
+        uart = Uart(args.pty, 30.0)
+
+        def phase(name, action, done):
+            sim_start = monitor.virtual_time(args.time_command)
+            host_start = time.monotonic()
+            action()
+            done()
+            sim_end = monitor.virtual_time(args.time_command)
+            results.append((name, sim_end - sim_start, time.monotonic() - host_start))
+            print("%-10s %12.6f s simulated" % (name, sim_end - sim_start))
+
+        phase("menu",
+              lambda: monitor.command("start"),
+              lambda: uart.expect(MENU_PROMPT, args.timeout, echo))
+
+        def start_download():
+            uart.discard()
+            uart.write(b"7" if image_name.lower().endswith(".elf") else b"3")
+            uart.expect(YMODEM_PROMPT, args.timeout, echo)
+
+        def download():
+            for attempt in range(args.ymodem_attempts):
+                try:
+                    offset = ymodem_send(uart, image_name, image, args.timeout)
+                    if offset:
+                        print("ymodem resumed at offset %d" % offset)
+                    return
+                except ScenarioError as error:
+                    if attempt + 1 == args.ymodem_attempts:
+                        raise
+                    print("ymodem attempt %d failed: %s" % (attempt + 1, error))
+                    # The receiver sends 'C' every second until it gives up
+                    while uart.read_byte(3.0) is not None:
+                        pass
+                    start_download()
+
+        phase("ymodem", start_download, download)
+
+        phase("spi-flash",
+              lambda: uart.write(b"1"),
+              lambda: uart.expect(FLASH_DONE, args.timeout, echo))
+
+        if args.eeprom:
+            phase("eeprom",
+                  lambda: uart.write(b"2"),
+                  lambda: uart.expect(EEPROM_DONE, args.timeout, echo))
+
+        def upload():
+            name, content = ymodem_receive(uart, args.timeout, args.ymodem_g)
+            if not image_name.lower().endswith(".elf") and content[:len(image)] != image:
+                raise ScenarioError("%s differs from the downloaded image" % name)
+
+        def start_upload():
+            uart.write(b"u")
+            uart.expect(UPLOAD_CHOICE, args.timeout, echo)
+            uart.write(b"0")
+            uart.expect(UPLOAD_PROMPT, args.timeout, echo)
+
+        if args.upload:
+            phase("upload", start_upload, upload)
+
+        def bootstrap():
+            monitor.command("pause")
+            uart.discard()
+            monitor.command("bootstrap Boot")
+            monitor.command("start")
+
+        phase("boot",
+              bootstrap,
+              lambda: uart.expect(args.expect.encode(), args.timeout, echo))
+
+    except (ScenarioError, subprocess.CalledProcessError) as error:
+        print("error: %s" % error, file=sys.stderr)
+        status = 1
+
+    finally:
+        if uart:
+            uart.close()
+        if monitor:
+            monitor.close()
+        try:
+            renode.wait(10)
+        except subprocess.TimeoutExpired:
+            renode.kill()
+        log.close()
+
+    print()
+    print("image: %s, %d bytes" % (image_name, len(image)))
+    print("%-10s %14s %10s" % ("phase", "simulated [s]", "host [s]"))
+    for name, sim_time, host_time in results:
+        print("%-10s %14.6f %10.3f" % (name, sim_time, host_time))
+    print("%-10s %14.6f %10.3f" % ("total",
+                                   sum(r[1] for r in results),
+                                   sum(r[2] for r in results)))
+
+    if args.csv:
+        with open(args.csv, "w") as csv:
+            csv.write("phase,simulated_s,host_s\n")
+            for name, sim_time, host_time in results:
+                csv.write("%s,%.6f,%.3f\n" % (name, sim_time, host_time))
+
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,112 @@
+//
+// Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+//
+// SPDX-License-Identifier: MIT
+//
+// I2C EEPROM with a two byte memory address, such as the devices on the
+// MikroBus Dual EE Click board, for the miv-rv32-bootloader Renode platform.
+//
+// The first two bytes written after a start condition set the memory address.
+// The data bytes that follow are buffered and written to the page containing
+// the address when the stop condition is received, wrapping around at the end
+// of the page. Reads return the bytes from the current address onwards. The
+// write cycle time is not modelled.
+//
+using System.Collections.Generic;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Logging;
+
+namespace Antmicro.Renode.Peripherals.I2C
+{
+    public class I2C_EEPROM : II2CPeripheral
+    {
+        public I2C_EEPROM(int size = 0x10000, int pageSize = 256)
+        {
+            this.pageSize = pageSize;
+            memory = new byte[size];
+            pending = new List<byte>();
+            for(var idx = 0; idx < size; ++idx)
+            {
+                memory[idx] = 0xFF;
+            }
+        }
+
+        public void Reset()
+        {
+            addressBytes = 0;
+            address = 0;
+            pending.Clear();
+        }
+
+        public void Write(byte[] data)
+        {
+            foreach(var b in data)
+            {
+                if(addressBytes < AddressLength)
+                {
+                    address = ((address << 8) | b) % memory.Length;
+                    ++addressBytes;
+                }
+                else
+                {
+                    pending.Add(b);
+                }
+            }
+        }
+
+        public byte[] Read(int count = 1)
+        {
+            var data = new byte[count];
+
+            for(var idx = 0; idx < count; ++idx)
+            {
+                data[idx] = memory[address];
+                address = (address + 1) % memory.Length;
+            }
+
+            return data;
+        }
+
+        public void FinishTransmission()
+        {
+            if(pending.Count > 0)
+            {
+                var pageBase = address - (address % pageSize);
+                var offset = address % pageSize;
+
+                if(pending.Count > pageSize)
+                {
+                    this.Log(LogLevel.Warning, "{0} bytes written in one page write, only the last {1} are kept", pending.Count, pageSize);
+                }
+                foreach(var b in pending)
+                {
+                    memory[pageBase + offset] = b;
+                    offset = (offset + 1) % pageSize;
+                }
+                this.Log(LogLevel.Debug, "Wrote {0} bytes at 0x{1:X4}", pending.Count, address);
+                pending.Clear();
+            }
+            addressBytes = 0;
+        }
+
+        public byte[] ReadBytes(int offset, int count)
+        {
+            var data = new byte[count];
+
+            for(var idx = 0; idx < count; ++idx)
+            {
+                data[idx] = memory[(offset + idx) % memory.Length];
+            }
+
+            return data;
+        }
+
+        private readonly int pageSize;
+        private readonly byte[] memory;
+        private readonly List<byte> pending;
+        private int addressBytes;
+        private int address;
+
+        private const int AddressLength = 2;
+    }
+}
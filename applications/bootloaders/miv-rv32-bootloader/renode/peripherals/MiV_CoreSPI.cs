@@ -0,0 +1,302 @@
+//
+// Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+//
+// SPDX-License-Identifier: MIT
+//
+// CoreSPI model, master mode, for the miv-rv32-bootloader Renode platform.
+//
+// Frames are shifted as soon as they are written to an enabled core, so the
+// receive FIFO fills immediately. Frames written while the core is disabled
+// are held in the transmit FIFO and shifted when the core is enabled, which is
+// how SPI_transfer_block() loads a command. The peripheral selected by the
+// lowest set bit of the SSEL register is selected on the first frame and
+// deselected after the frame written to TXLAST.
+//
+using System.Collections.Generic;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Core.Structure;
+using Antmicro.Renode.Logging;
+using Antmicro.Renode.Peripherals.Bus;
+
+namespace Antmicro.Renode.Peripherals.SPI
+{
+    public class MiV_CoreSPI : SimpleContainer<ISPIPeripheral>, IDoubleWordPeripheral, IBytePeripheral, IKnownSize
+    {
+        public MiV_CoreSPI(IMachine machine, int fifoDepth = 32) : base(machine)
+        {
+            this.fifoDepth = fifoDepth;
+            rxFifo = new Queue<byte>();
+            txFifo = new Queue<KeyValuePair<byte, bool>>();
+            IRQ = new GPIO();
+            Reset();
+        }
+
+        public override void Reset()
+        {
+            if(selected != null)
+            {
+                selected.FinishTransmission();
+                selected = null;
+            }
+            rxFifo.Clear();
+            txFifo.Clear();
+            ctrl1 = Ctrl1Master;
+            ctrl2 = 0;
+            intRaw = 0;
+            intMask = 0;
+            ssel = 0;
+            done = false;
+            rxOverflow = false;
+            IRQ.Unset();
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            uint value = 0;
+
+            switch((Registers)offset)
+            {
+                case Registers.Control1:
+                    value = ctrl1;
+                    break;
+
+                case Registers.ReceiveData:
+                    if(rxFifo.Count > 0)
+                    {
+                        value = rxFifo.Dequeue();
+                    }
+                    break;
+
+                case Registers.InterruptMasked:
+                    value = (uint)(intRaw & intMask);
+                    break;
+
+                case Registers.InterruptRaw:
+                    value = intRaw;
+                    break;
+
+                case Registers.Control2:
+                    value = ctrl2;
+                    break;
+
+                case Registers.Status:
+                    value = (done ? StatusDone : 0u)
+                          | (rxFifo.Count == 0 ? StatusRxEmpty : 0u)
+                          | (txFifo.Count == fifoDepth ? StatusTxFull : 0u)
+                          | (rxOverflow ? StatusRxOverflow : 0u)
+                          | (selected != null ? (StatusSsel | StatusActive) : 0u);
+                    break;
+
+                case Registers.SlaveSelect:
+                    value = ssel;
+                    break;
+
+                default:
+                    this.LogUnhandledRead(offset);
+                    break;
+            }
+
+            return value;
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+            switch((Registers)offset)
+            {
+                case Registers.Control1:
+                {
+                    var wasEnabled = (ctrl1 & Ctrl1Enable) != 0;
+
+                    ctrl1 = (byte)value;
+                    if(!wasEnabled && (ctrl1 & Ctrl1Enable) != 0)
+                    {
+                        while(txFifo.Count > 0)
+                        {
+                            var frame = txFifo.Dequeue();
+                            ShiftFrame(frame.Key, frame.Value);
+                        }
+                    }
+                    break;
+                }
+
+                case Registers.InterruptClear:
+                    intRaw &= (byte)~value;
+                    if((value & IntRxOverflow) != 0)
+                    {
+                        rxOverflow = false;
+                    }
+                    break;
+
+                case Registers.TransmitData:
+                    PushFrame((byte)value, false);
+                    break;
+
+                case Registers.InterruptMasked:
+                    intMask = (byte)value;
+                    break;
+
+                case Registers.Control2:
+                    ctrl2 = (byte)value;
+                    break;
+
+                case Registers.Command:
+                    if((value & CommandRxFifoReset) != 0)
+                    {
+                        rxFifo.Clear();
+                        rxOverflow = false;
+                    }
+                    if((value & CommandTxFifoReset) != 0)
+                    {
+                        txFifo.Clear();
+                    }
+                    break;
+
+                case Registers.SlaveSelect:
+                    ssel = (byte)value;
+                    break;
+
+                case Registers.TransmitLast:
+                    PushFrame((byte)value, true);
+                    break;
+
+                default:
+                    this.LogUnhandledWrite(offset, value);
+                    break;
+            }
+
+            UpdateInterrupt();
+        }
+
+        public byte ReadByte(long offset)
+        {
+            return (byte)ReadDoubleWord(offset);
+        }
+
+        public void WriteByte(long offset, byte value)
+        {
+            WriteDoubleWord(offset, value);
+        }
+
+        public long Size => 0x30;
+
+        public GPIO IRQ { get; private set; }
+
+        private void PushFrame(byte frame, bool last)
+        {
+            done = false;
+
+            if((ctrl1 & Ctrl1Enable) != 0)
+            {
+                ShiftFrame(frame, last);
+            }
+            else if(txFifo.Count < fifoDepth)
+            {
+                txFifo.Enqueue(new KeyValuePair<byte, bool>(frame, last));
+            }
+            else
+            {
+                this.Log(LogLevel.Warning, "Frame 0x{0:X2} written to a full transmit FIFO, dropped", frame);
+            }
+        }
+
+        private void ShiftFrame(byte frame, bool last)
+        {
+            byte miso = 0xFF;
+
+            if(selected == null)
+            {
+                selected = FindSelected();
+            }
+
+            if(selected != null)
+            {
+                miso = selected.Transmit(frame);
+            }
+
+            if(rxFifo.Count < fifoDepth)
+            {
+                rxFifo.Enqueue(miso);
+            }
+            else
+            {
+                rxOverflow = true;
+                intRaw |= IntRxOverflow;
+            }
+
+            if(last)
+            {
+                if(selected != null)
+                {
+                    selected.FinishTransmission();
+                    selected = null;
+                }
+                done = true;
+                intRaw |= IntTxDone;
+            }
+        }
+
+        private ISPIPeripheral FindSelected()
+        {
+            for(var line = 0; line < 8; ++line)
+            {
+                if((ssel & (1 << line)) != 0)
+                {
+                    ISPIPeripheral peripheral;
+
+                    if(TryGetByAddress(line, out peripheral))
+                    {
+                        return peripheral;
+                    }
+                    this.Log(LogLevel.Warning, "No peripheral attached to slave select {0}", line);
+                    return null;
+                }
+            }
+            return null;
+        }
+
+        private void UpdateInterrupt()
+        {
+            IRQ.Set((intRaw & intMask) != 0);
+        }
+
+        private readonly int fifoDepth;
+        private readonly Queue<byte> rxFifo;
+        private readonly Queue<KeyValuePair<byte, bool>> txFifo;
+        private ISPIPeripheral selected;
+        private byte ctrl1;
+        private byte ctrl2;
+        private byte intRaw;
+        private byte intMask;
+        private byte ssel;
+        private bool done;
+        private bool rxOverflow;
+
+        private const byte Ctrl1Enable = 0x01;
+        private const byte Ctrl1Master = 0x02;
+        private const byte IntTxDone = 0x01;
+        private const byte IntRxOverflow = 0x04;
+        private const uint CommandRxFifoReset = 0x01;
+        private const uint CommandTxFifoReset = 0x02;
+        private const uint StatusDone = 0x02;
+        private const uint StatusRxEmpty = 0x04;
+        private const uint StatusTxFull = 0x08;
+        private const uint StatusRxOverflow = 0x10;
+        private const uint StatusSsel = 0x40;
+        private const uint StatusActive = 0x80;
+
+        private enum Registers
+        {
+            Control1 = 0x00,
+            InterruptClear = 0x04,
+            ReceiveData = 0x08,
+            TransmitData = 0x0C,
+            InterruptMasked = 0x10,
+            InterruptRaw = 0x14,
+            Control2 = 0x18,
+            Command = 0x1C,
+            Status = 0x20,
+            SlaveSelect = 0x24,
+            TransmitLast = 0x28,
+        }
+    }
+}
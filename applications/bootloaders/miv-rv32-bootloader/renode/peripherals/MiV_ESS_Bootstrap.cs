@@ -0,0 +1,96 @@
+//
+// Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+//
+// SPDX-License-Identifier: MIT
+//
+// MIV_ESS bootstrap model for the miv-rv32-bootloader Renode platform.
+//
+// On the hardware, the MIV_ESS bootstrap holds the processor in reset after a
+// system reset request, copies the executable from the SPI flash or I2C EEPROM
+// into the TCM and then releases the processor, which starts from the TCM base
+// address. Boot() does the same from the Renode monitor:
+//
+//     bootstrap Boot
+//
+// The emulation should be paused while Boot() is called. The register at
+// offset 0 reads the number of boots performed, offset 4 the number of bytes
+// copied by the last boot.
+//
+using System.Linq;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Logging;
+using Antmicro.Renode.Peripherals.Bus;
+using Antmicro.Renode.Peripherals.CPU;
+using Antmicro.Renode.Peripherals.Memory;
+
+namespace Antmicro.Renode.Peripherals.Miscellaneous
+{
+    public class MiV_ESS_Bootstrap : IDoubleWordPeripheral, IKnownSize
+    {
+        public MiV_ESS_Bootstrap(IMachine machine, MappedMemory source, MappedMemory destination,
+                                 long sourceOffset = 0, int size = 0x8000, ulong bootAddress = 0x40000000)
+        {
+            this.machine = machine;
+            this.source = source;
+            this.destination = destination;
+            this.sourceOffset = sourceOffset;
+            this.size = size;
+            this.bootAddress = bootAddress;
+        }
+
+        public void Boot()
+        {
+            var image = source.ReadBytes(sourceOffset, size);
+
+            destination.WriteBytes(0, image, 0, image.Length);
+            foreach(var cpu in machine.SystemBus.GetCPUs().OfType<ICPU>())
+            {
+                cpu.Reset();
+                cpu.PC = bootAddress;
+            }
+
+            ++bootCount;
+            lastCopySize = (uint)image.Length;
+            this.Log(LogLevel.Info, "Copied {0} bytes from offset 0x{1:X} to the TCM, booting from 0x{2:X}",
+                     image.Length, sourceOffset, bootAddress);
+        }
+
+        public void Reset()
+        {
+            // The counters survive a machine reset so that they can be read
+            // back by the application that was booted.
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            switch(offset)
+            {
+                case 0x0:
+                    return bootCount;
+
+                case 0x4:
+                    return lastCopySize;
+
+                default:
+                    this.LogUnhandledRead(offset);
+                    return 0;
+            }
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+            this.LogUnhandledWrite(offset, value);
+        }
+
+        public long Size => 0x10;
+
+        private readonly IMachine machine;
+        private readonly MappedMemory source;
+        private readonly MappedMemory destination;
+        private readonly long sourceOffset;
+        private readonly int size;
+        private readonly ulong bootAddress;
+        private uint bootCount;
+        private uint lastCopySize;
+    }
+}
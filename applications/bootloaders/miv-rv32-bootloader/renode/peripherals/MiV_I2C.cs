@@ -0,0 +1,322 @@
+//
+// Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+//
+// SPDX-License-Identifier: MIT
+//
+// MIV_I2C model, master mode, for the miv-rv32-bootloader Renode platform.
+//
+// The driver builds a command with several read-modify-write accesses to the
+// COMMAND register and acknowledges the interrupt at the end of its ISR, so a
+// command is not executed when it is written. It is executed one byte time
+// later, computed from the PRESCALE register and the system clock as on the
+// hardware (SCL = clock / (5 * (PRESCALE + 1)), nine SCL periods per byte).
+// STATUS.IF is then set and the IRQ line asserted if CONTROL.IRQ_EN is set.
+//
+using System;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Core.Structure;
+using Antmicro.Renode.Logging;
+using Antmicro.Renode.Peripherals.Bus;
+using Antmicro.Renode.Time;
+
+namespace Antmicro.Renode.Peripherals.I2C
+{
+    public class MiV_I2C : SimpleContainer<II2CPeripheral>, IBytePeripheral, IWordPeripheral, IDoubleWordPeripheral, IKnownSize
+    {
+        public MiV_I2C(IMachine machine, long clockFrequency = 50000000) : base(machine)
+        {
+            this.clockFrequency = clockFrequency;
+            IRQ = new GPIO();
+            Reset();
+        }
+
+        public override void Reset()
+        {
+            if(active != null)
+            {
+                active.FinishTransmission();
+                active = null;
+            }
+            prescale = 0xFFFF;
+            control = 0;
+            transmit = 0;
+            receive = 0;
+            command = 0;
+            status = 0;
+            IRQ.Unset();
+        }
+
+        public byte ReadByte(long offset)
+        {
+            byte value = 0;
+
+            switch((Registers)offset)
+            {
+                case Registers.Prescale:
+                    value = (byte)prescale;
+                    break;
+
+                case Registers.Control:
+                    value = control;
+                    break;
+
+                case Registers.Transmit:
+                    value = transmit;
+                    break;
+
+                case Registers.Receive:
+                    value = receive;
+                    break;
+
+                case Registers.Command:
+                    value = command;
+                    break;
+
+                case Registers.Status:
+                    value = status;
+                    break;
+
+                default:
+                    this.LogUnhandledRead(offset);
+                    break;
+            }
+
+            return value;
+        }
+
+        public void WriteByte(long offset, byte value)
+        {
+            switch((Registers)offset)
+            {
+                case Registers.Prescale:
+                    if((control & ControlCoreEnable) == 0)
+                    {
+                        prescale = value;
+                    }
+                    break;
+
+                case Registers.Control:
+                    control = (byte)(value & ControlMask);
+                    UpdateInterrupt();
+                    break;
+
+                case Registers.Transmit:
+                    transmit = value;
+                    break;
+
+                case Registers.Command:
+                    WriteCommand(value);
+                    break;
+
+                default:
+                    this.LogUnhandledWrite(offset, value);
+                    break;
+            }
+        }
+
+        public ushort ReadWord(long offset)
+        {
+            return (offset == (long)Registers.Prescale) ? prescale : ReadByte(offset);
+        }
+
+        public void WriteWord(long offset, ushort value)
+        {
+            if(offset == (long)Registers.Prescale)
+            {
+                if((control & ControlCoreEnable) == 0)
+                {
+                    prescale = value;
+                }
+            }
+            else
+            {
+                WriteByte(offset, (byte)value);
+            }
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            return ReadWord(offset);
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+            WriteWord(offset, (ushort)value);
+        }
+
+        public long Size => 0x18;
+
+        public GPIO IRQ { get; private set; }
+
+        private void WriteCommand(byte value)
+        {
+            if((command & CommandStop) != 0 && (command & CommandStart) == 0 && (value & CommandStart) != 0)
+            {
+                // New start while the previous stop is still pending, as
+                // happens when a transfer is issued as soon as the driver
+                // reports completion. The core waits for the bus to be free
+                // before generating the start, so complete the stop first.
+                GenerateStop();
+                command &= unchecked((byte)~CommandStop);
+            }
+
+            command = (byte)((command & CommandExecuteMask) | (value & CommandMask));
+
+            if((value & CommandInterruptAck) != 0)
+            {
+                status &= unchecked((byte)~StatusInterruptFlag);
+                UpdateInterrupt();
+            }
+
+            if((command & CommandGoMask) != 0 && (control & ControlCoreEnable) != 0)
+            {
+                status |= StatusTransferInProgress;
+                ScheduleExecution();
+            }
+        }
+
+        private void ScheduleExecution()
+        {
+            if(executionScheduled)
+            {
+                return;
+            }
+
+            executionScheduled = true;
+
+            var sclPeriods = 9UL * 5UL * ((ulong)prescale + 1UL);
+            var microseconds = Math.Max(1UL, (sclPeriods * 1000000UL) / (ulong)clockFrequency);
+
+            machine.ScheduleAction(TimeInterval.FromMicroseconds(microseconds), _ =>
+            {
+                executionScheduled = false;
+                ExecuteCommand();
+            });
+        }
+
+        private void ExecuteCommand()
+        {
+            if((command & CommandGoMask) == 0 || (control & ControlCoreEnable) == 0)
+            {
+                return;
+            }
+
+            if((command & CommandWrite) != 0)
+            {
+                var nack = true;
+
+                if((command & CommandStart) != 0)
+                {
+                    // (Repeated) start followed by the address byte
+                    var address = transmit >> 1;
+                    II2CPeripheral target;
+
+                    status |= StatusBusy;
+                    if(TryGetByAddress(address, out target))
+                    {
+                        if(active != null && active != target)
+                        {
+                            active.FinishTransmission();
+                        }
+                        active = target;
+                        nack = false;
+                    }
+                    else
+                    {
+                        this.Log(LogLevel.Debug, "No target at address 0x{0:X2}", address);
+                        active = null;
+                    }
+                }
+                else if(active != null)
+                {
+                    active.Write(new byte[] { transmit });
+                    nack = false;
+                }
+
+                if(nack)
+                {
+                    status |= StatusReceivedAck;
+                }
+                else
+                {
+                    status &= unchecked((byte)~StatusReceivedAck);
+                }
+            }
+            else if((command & CommandRead) != 0)
+            {
+                receive = 0xFF;
+                if(active != null)
+                {
+                    var data = active.Read(1);
+                    if(data.Length > 0)
+                    {
+                        receive = data[0];
+                    }
+                }
+            }
+
+            if((command & CommandStop) != 0)
+            {
+                GenerateStop();
+            }
+
+            // Command bits self clear on completion, ACK and IACK are left as set.
+            command &= unchecked((byte)~CommandExecuteMask);
+            status &= unchecked((byte)~StatusTransferInProgress);
+            status |= StatusInterruptFlag;
+            UpdateInterrupt();
+        }
+
+        private void GenerateStop()
+        {
+            if(active != null)
+            {
+                active.FinishTransmission();
+                active = null;
+            }
+            status &= unchecked((byte)~StatusBusy);
+        }
+
+        private void UpdateInterrupt()
+        {
+            IRQ.Set((control & ControlInterruptEnable) != 0 && (status & StatusInterruptFlag) != 0);
+        }
+
+        private readonly long clockFrequency;
+        private II2CPeripheral active;
+        private bool executionScheduled;
+        private ushort prescale;
+        private byte control;
+        private byte transmit;
+        private byte receive;
+        private byte command;
+        private byte status;
+
+        private const byte ControlMask = 0xC0;
+        private const byte ControlCoreEnable = 0x80;
+        private const byte ControlInterruptEnable = 0x40;
+        private const byte CommandMask = 0xF9;
+        private const byte CommandInterruptAck = 0x01;
+        private const byte CommandWrite = 0x10;
+        private const byte CommandRead = 0x20;
+        private const byte CommandStop = 0x40;
+        private const byte CommandStart = 0x80;
+        private const byte CommandExecuteMask = CommandStart | CommandStop | CommandWrite | CommandRead;
+        // A start condition is only generated together with a WR command.
+        private const byte CommandGoMask = CommandStop | CommandWrite | CommandRead;
+        private const byte StatusInterruptFlag = 0x01;
+        private const byte StatusTransferInProgress = 0x02;
+        private const byte StatusBusy = 0x40;
+        private const byte StatusReceivedAck = 0x80;
+
+        private enum Registers
+        {
+            Prescale = 0x00,
+            Control = 0x04,
+            Transmit = 0x08,
+            Receive = 0x0C,
+            Command = 0x10,
+            Status = 0x14,
+        }
+    }
+}
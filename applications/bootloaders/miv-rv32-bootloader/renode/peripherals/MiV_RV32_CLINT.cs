@@ -0,0 +1,50 @@
+//
+// Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+//
+// SPDX-License-Identifier: MIT
+//
+// MIV_RV32 internal timer for the miv-rv32-bootloader Renode platform.
+//
+// This is the Renode CLINT model with the MTIME_PRESCALER register of the
+// MIV_RV32 v3.0 core added at offset 0x5000. MRV_systick_config() divides the
+// system clock by the value read from this register, which reads as zero on
+// the plain CLINT model. The frequency given to the model must be the system
+// clock frequency divided by the prescaler.
+//
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Peripherals.Bus;
+
+namespace Antmicro.Renode.Peripherals.IRQControllers
+{
+    public class MiV_RV32_CLINT : CoreLevelInterruptor, IDoubleWordPeripheral
+    {
+        public MiV_RV32_CLINT(IMachine machine, long frequency, int numberOfTargets = 1, uint prescaler = 100)
+            : base(machine, frequency, numberOfTargets)
+        {
+            this.prescaler = prescaler;
+        }
+
+        public new uint ReadDoubleWord(long offset)
+        {
+            if(offset == MtimePrescalerOffset)
+            {
+                return prescaler;
+            }
+            return base.ReadDoubleWord(offset);
+        }
+
+        public new void WriteDoubleWord(long offset, uint value)
+        {
+            if(offset == MtimePrescalerOffset)
+            {
+                // Read only on the hardware
+                return;
+            }
+            base.WriteDoubleWord(offset, value);
+        }
+
+        private readonly uint prescaler;
+
+        private const long MtimePrescalerOffset = 0x5000;
+    }
+}
@@ -14,7 +14,22 @@
 #include "drivers/fabric_ip/CoreUARTapb/core_uart_apb.h"
 #include "drivers/fabric_ip/miv_i2c/miv_i2c.h"
 #include "drivers/off_chip/spi_flash/spi_flash.h"
+#include "fw_slots/fw_slots.h"
 #include "ymodem/ymodem.h"
+#include "zmodem/zmodem.h"
+#include "elf_loader/elf_loader.h"
+#include "hex_parser/hex_parser.h"
+#include "mem_test/mem_test.h"
+
+/*
+ * The menu options added to the ESS bootloader do not fit in the 32K TCM with
+ * the rest of the bootloader when it is not optimized. Each build configuration
+ * defines BOOTLOADER_EXTENDED_MENU in its project settings: 0 for
+ * Bootloader-Debug, 1 for Bootloader-Release.
+ */
+#ifndef BOOTLOADER_EXTENDED_MENU
+#define BOOTLOADER_EXTENDED_MENU        1
+#endif
 
 #define FLASH_SECTOR_SIZE               65536   /* flash memory size */
 #define FLASH_SECTORS                   128    // There are 126 sectors of 64kB size, using 124
@@ -23,11 +38,9 @@
 
 #define FLASH_BLOCK_SEGMENTS            (FLASH_BLOCK_SIZE / FLASH_SEGMENT_SIZE)
 #define FLASH_BYTE_SIZE                 (FLASH_SECTOR_SIZE * FLASH_SECTORS)
-#define LAST_BLOCK_ADDR                 (FLASH_BYTE_SIZE - FLASH_BLOCK_SIZE)
 
 #ifdef __UNUSED_CODE
 static int test_flash(void);
-static void mem_test(uint8_t *address);
 static int read_program_from_flash(uint8_t *read_buf, uint32_t read_byte_length);
 static void Bootloader_JumpToApplication(uint32_t stack_location, uint32_t reset_vector);
 #endif
@@ -36,7 +49,22 @@ static int write_program_to_i2ceeprom(uint8_t *write_buf, uint32_t file_size);
 static int write_program_to_flash(uint8_t *write_buf, uint32_t file_size);
 static void copy_hex_to_i2ceeprom(void);
 static void copy_hex_to_spiflash(void);
+static void copy_hex_to_slot(void);
 static uint32_t rx_app_file(uint8_t *dest_address);
+#if BOOTLOADER_EXTENDED_MENU
+static uint32_t rx_elf_file(void);
+static void program_hex(uint8_t to_eeprom, uint8_t as_text);
+#endif
+static void eeprom_init(void);
+static void upload_flash(void);
+#if BOOTLOADER_EXTENDED_MENU
+static uint32_t rx_zmodem_file(void);
+static void program_zmodem(void);
+static void show_flash_stats(void);
+static mem_test_status_t test_lsram(mem_test_mode_t mode);
+#endif
+static void print_dec(uint32_t value);
+static void print_hex(uint32_t value);
 
 static uint8_t file_name[FILE_NAME_LENGTH + 1]; /* +1 for nul */
 
@@ -47,9 +75,19 @@ static uint8_t file_name[FILE_NAME_LENGTH + 1]; /* +1 for nul */
 #define LSRAM_BASE_ADDRESS_WRITE        0x89000000
 
 /*
- * Key value used to determine if valid data is contained in the SPI flash.
+ * Size of the LSRAM region tested before a download and by menu options 4 and
+ * 5. Define LSRAM_TEST_SIZE in the project settings to test a larger memory.
  */
-#define SPI_FLASH_VALID_CONTENT_KEY     0xB5006BB1
+#ifndef LSRAM_TEST_SIZE
+#define LSRAM_TEST_SIZE                 65536u
+#endif
+
+/*
+ * Size of the LSRAM. ELF images linked for the LSRAM must fit in it.
+ */
+#ifndef LSRAM_SIZE
+#define LSRAM_SIZE                      65536u
+#endif
 
 const uint8_t g_bootstrap_choice[] =
 "\r\n\r\n\
@@ -65,21 +103,28 @@ Choose the destination Non-Volatile memory: \r\n\
  Type 0 to show this menu\r\n\
  Type 1 copy .hex from LSRAM to SPI Flash \r\n\
  Type 2 copy .hex from LSRAM to MikroBus EEPROM \r\n\
- Type 3 Download .hex from the host PC over UART terminal using YMODEM\r\n\
- ";
-
-/*
- * Data structure stored at the beginning of SPI flash to indicate the size of
- * data stored inside the SPI flash. This is to avoid having to read the entire
- * flash content at boot time.
- * This data structure is one flash segment long (256 bytes).
- */
-typedef struct
-{
-    uint32_t validity_key;
-    uint32_t spi_content_byte_size;
-    uint32_t dummy[62];
-} flash_content_t;
+ Type 3 Download .hex from the host PC over UART terminal using YMODEM\r\n"
+#if BOOTLOADER_EXTENDED_MENU
+" Type 4 Quick LSRAM test (data and address bus, overwrites the LSRAM)\r\n\
+ Type 5 Full LSRAM test (March C-, overwrites the LSRAM)\r\n"
+#endif
+"\
+ Type 6 copy .hex from LSRAM to the inactive A/B slot of the SPI Flash\r\n"
+#if BOOTLOADER_EXTENDED_MENU
+" Type 7 Download .elf from the host PC over UART terminal using YMODEM\r\n\
+ Type 8 Program .hex/.srec into SPI Flash as it is received using YMODEM\r\n\
+ Type 9 Program .hex/.srec into MikroBus EEPROM as it is received using YMODEM\r\n\
+ Type f Program .hex/.srec sent as text into SPI Flash (XON/XOFF flow control)\r\n\
+ Type e Program .hex/.srec sent as text into MikroBus EEPROM (XON/XOFF flow control)\r\n"
+#endif
+"\
+ Type u Upload the SPI Flash boot image or an A/B slot to the host PC using YMODEM\r\n"
+#if BOOTLOADER_EXTENDED_MENU
+" Type z Download .hex from the host PC over UART terminal using ZMODEM (resumable)\r\n\
+ Type s Program .hex into SPI Flash as it is received using ZMODEM (resumable)\r\n\
+ Type w Show SPI Flash operation latencies and sector erase counts\r\n"
+#endif
+" ";
 
 /******************************************************************************
  * CoreUARTapb instance data.
@@ -91,16 +136,23 @@ UART_instance_t g_uart;
  * I2C instance data.
  *****************************************************************************/
 #define I2C_XFR_DATA_LEN                258u       // 2 byte address + 256 bytes data
+#define I2C_XFR_TIMEOUT_MS              100u       // 23ms transfer + 5ms EEPROM write cycle
 //#define I2C_XFR_DATA_LEN                16u
 uint8_t target_slave_addr = 0x50;
 uint8_t i2c_tx_buffer[I2C_XFR_DATA_LEN];
 miv_i2c_instance_t g_miv_i2c_inst;
 
+/******************************************************************************
+ * uDMA instance data. Used to speed up the full LSRAM test when the design
+ * includes the MIV_ESS uDMA.
+ *****************************************************************************/
+#if BOOTLOADER_EXTENDED_MENU && defined(MIV_ESS_uDMA_BASE_ADDR)
+miv_udma_instance_t g_udma;
+#endif
+
 //uint8_t  i2c_tx_buffer[7] = {0x0A,0x0B,0x0C,0x0A,0x0B,0x0C,0x0A};
 //uint16_t  write_length;//DATA_LENGTH;
 
-volatile uint32_t g_10ms_count;
-
 const uint8_t g_greeting_msg_spi[] =
         " ----> SPI Flash is chosen as destination memory \r\n";
 
@@ -120,25 +172,35 @@ const char * g_greeting_msg_i2c =
  */
 #define FLASH_EXECUTABLE_SIZE    32768u
 
+/*
+ * Size of the image in the LSRAM copied by menu options 1 and 6. The whole 32k
+ * chunk unless an ELF image was loaded, in which case only the part loaded
+ * from the file is copied.
+ */
+static uint32_t g_image_size = FLASH_EXECUTABLE_SIZE;
+
+#if BOOTLOADER_EXTENDED_MENU
+/*
+ * Where the segments of an ELF image are loaded. The bootloader runs from the
+ * TCM, so images linked for the TCM are staged in the LSRAM, like a binary
+ * image downloaded with menu option 3. Images linked for the LSRAM, with
+ * miv-rv32-ram.ld or miv-rv32-execute-in-place.ld, are placed there directly.
+ * Both are copied from LSRAM_BASE_ADDRESS_LOAD, so an image with segments in
+ * both which would be staged at the same place is rejected by the loader.
+ */
+static elf_loader_region_t g_elf_regions[] =
+{
+    { FW_SLOTS_EXEC_ADDR, FLASH_EXECUTABLE_SIZE, (uint8_t *)LSRAM_BASE_ADDRESS_LOAD, 0u },
+    { LSRAM_BASE_ADDRESS_LOAD, LSRAM_SIZE, (uint8_t *)LSRAM_BASE_ADDRESS_LOAD, 0u }
+};
+#endif
+
 /* MIV I2C interrupt handler */
 void MSYS_EI2_IRQHandler(void)
 {
     MIV_I2C_isr (&g_miv_i2c_inst);
 }
 
-
-void SysTick_Handler(void)
-{
-    g_10ms_count += 10;
-
-      /*
-       * For neatness, if we roll over, reset cleanly back to 0 so the count
-       * always goes up in proper 10s.
-       */
-     if(g_10ms_count < 10)
-         g_10ms_count = 0;
-
-}
 /*-------------------------------------------------------------------------*//**
  * main() function.
  */
@@ -174,6 +236,15 @@ int main()
             UART_send( &g_uart, rx_data, rx_size );
             rx_size = 0u;
 
+#if BOOTLOADER_EXTENDED_MENU
+            /* Other options may overwrite the data of an interrupted ZMODEM
+             * download, it cannot be resumed after them */
+            if (('0' != rx_data[0]) && ('z' != rx_data[0]) && ('s' != rx_data[0]))
+            {
+                zmodem_resume_clear();
+            }
+#endif
+
             switch(rx_data[0])
             {
             case '0':
@@ -188,10 +259,58 @@ int main()
             case '3':
                 file_size = rx_app_file((uint8_t *)LSRAM_BASE_ADDRESS_LOAD);
                 break;
+#if BOOTLOADER_EXTENDED_MENU
+            case '4':
+                test_lsram(MEM_TEST_QUICK);
+                break;
+            case '5':
+                test_lsram(MEM_TEST_FULL);
+                break;
+#endif
+            case '6':
+                copy_hex_to_slot();
+                break;
+#if BOOTLOADER_EXTENDED_MENU
+            case '7':
+                file_size = rx_elf_file();
+                break;
+            case '8':
+                program_hex(0u, 0u);
+                break;
+            case '9':
+                program_hex(1u, 0u);
+                break;
+            case 'f':
+                program_hex(0u, 1u);
+                break;
+            case 'e':
+                program_hex(1u, 1u);
+                break;
+#endif
+            case 'u':
+                upload_flash();
+                break;
+#if BOOTLOADER_EXTENDED_MENU
+            case 'z':
+                file_size = rx_zmodem_file();
+                break;
+            case 's':
+                program_zmodem();
+                break;
+            case 'w':
+                show_flash_stats();
+                break;
+#endif
             default:
                 UART_polled_tx_string( &g_uart, "Invalid selection. Try again...\r\n");
                 break;
             }
+
+            /* Keep the count of the erases the option performed, if any */
+            if (SPI_FLASH_SUCCESS != spi_flash_save_erase_counts())
+            {
+                UART_polled_tx_string(&g_uart, "Saving the SPI Flash erase counts failed\r\n");
+            }
         }
     }
 
@@ -207,23 +326,242 @@ static uint32_t rx_app_file(uint8_t *dest_address)
     uint8_t *g_bin_base = (uint8_t *)dest_address;
     uint32_t g_rx_size = 1024 * 1024 * 8;
 
-    MRV_systick_config(SYS_CLK_FREQ);
+    /*
+     * The download overwrites the LSRAM, so it can be tested first. The test
+     * is skipped when an interrupted download can be resumed, as it would
+     * destroy the blocks already received.
+     */
+    if (0u != ymodem_resume_offset(g_bin_base))
+    {
+        UART_polled_tx_string(&g_uart, "\r\nInterrupted download, ");
+        print_dec(ymodem_resume_offset(g_bin_base));
+        UART_polled_tx_string(&g_uart, " bytes received. Send the same file to resume.\r\n");
+    }
+#if BOOTLOADER_EXTENDED_MENU
+    else if (MEM_TEST_PASS != test_lsram(MEM_TEST_QUICK))
+    {
+        return 0u;
+    }
+#endif
 
     UART_polled_tx_string( &g_uart, "\r\n------------------------ Starting YModem file transfer ------------------------\r\n" );
     UART_polled_tx_string( &g_uart, "Please select file and initiate transfer on host computer.\r\n" );
 
     received = ymodem_receive(g_bin_base, g_rx_size, file_name);
+    g_image_size = FLASH_EXECUTABLE_SIZE;
 
     return received;
 }
 
+#if BOOTLOADER_EXTENDED_MENU
+static int32_t elf_write(void *context, uint32_t offset,
+                         const uint8_t *data, uint32_t length)
+{
+    (void)offset;
 
-void copy_hex_to_i2ceeprom(void)
+    return (int32_t)elf_loader_push((elf_loader_t *)context, data, length);
+}
+
+/*
+ * Receive an ELF image via ymodem and load its segments as they arrive
+ */
+static uint32_t rx_elf_file(void)
 {
-    uint8_t rx_size = 0u;
-    uint8_t rx_data[UART_RX_BUF_SIZE];
+    static elf_loader_t loader;
+    elf_loader_status_t status;
+    uint32_t received;
+    uint32_t idx;
+
+    /* The segments overwrite the LSRAM, so it can be tested first */
+    if (MEM_TEST_PASS != test_lsram(MEM_TEST_QUICK))
+    {
+        return 0u;
+    }
+
+    UART_polled_tx_string( &g_uart, "\r\n-------------------- Starting YModem ELF file transfer --------------------\r\n" );
+    UART_polled_tx_string( &g_uart, "Please select file and initiate transfer on host computer.\r\n" );
+
+    elf_loader_init(&loader, g_elf_regions,
+                    sizeof(g_elf_regions) / sizeof(g_elf_regions[0]));
+    received = ymodem_receive_stream(elf_write, &loader, 1024 * 1024 * 8, file_name);
+
+    status = (0u != received) ? elf_loader_finish(&loader) : loader.status;
+    if ((0u == received) && (ELF_LOADER_SUCCESS == status))
+    {
+        UART_polled_tx_string(&g_uart, "\r\nELF transfer failed\r\n");
+        return 0u;
+    }
+
+    if (ELF_LOADER_SUCCESS != status)
+    {
+        UART_polled_tx_string(&g_uart,
+                              (ELF_LOADER_NOT_ELF == status) ? "\r\nNot an ELF file\r\n" :
+                              (ELF_LOADER_UNSUPPORTED == status) ? "\r\nNot a RISC-V ELF32 executable, or too many segments\r\n" :
+                              (ELF_LOADER_BAD_ADDRESS == status) ? "\r\nSegment outside the TCM and LSRAM, or staged over another segment\r\n" :
+                              "\r\nELF file truncated\r\n");
+        return 0u;
+    }
+
+    /* Copy the loaded part of the image to non-volatile memory */
+    g_image_size = 0u;
+    for (idx = 0u; idx < (sizeof(g_elf_regions) / sizeof(g_elf_regions[0])); ++idx)
+    {
+        if (g_elf_regions[idx].end > g_image_size)
+        {
+            g_image_size = g_elf_regions[idx].end;
+        }
+    }
+    g_image_size = (g_image_size + 3u) & ~3u;
+
+    UART_polled_tx_string(&g_uart, "\r\n  ");
+    print_dec(loader.segment_count);
+    UART_polled_tx_string(&g_uart, " segments, ");
+    print_dec(loader.loaded);
+    UART_polled_tx_string(&g_uart, " bytes loaded, ");
+    print_dec(loader.zeroed);
+    UART_polled_tx_string(&g_uart, " bytes zero filled, entry point ");
+    print_hex(loader.entry);
+    UART_polled_tx_string(&g_uart, "\r\n  Image size ");
+    print_dec(g_image_size);
+    UART_polled_tx_string(&g_uart, " bytes\r\n");
+
+    return received;
+}
+#endif /* BOOTLOADER_EXTENDED_MENU */
+
+static void print_dec(uint32_t value)
+{
+    uint8_t digits[11];
+    uint8_t idx = sizeof(digits) - 1u;
+
+    digits[idx] = 0u;
+    do
+    {
+        --idx;
+        digits[idx] = (uint8_t)('0' + (value % 10u));
+        value /= 10u;
+    } while (0u != value);
+
+    UART_polled_tx_string(&g_uart, &digits[idx]);
+}
+
+static void print_hex(uint32_t value)
+{
+    static const uint8_t hex[] = "0123456789ABCDEF";
+    uint8_t digits[11];
+    uint8_t idx;
 
+    digits[0] = '0';
+    digits[1] = 'x';
+    for (idx = 0u; idx < 8u; ++idx)
+    {
+        digits[9u - idx] = hex[value & 0xFu];
+        value >>= 4;
+    }
+    digits[10] = 0u;
+
+    UART_polled_tx_string(&g_uart, digits);
+}
+
+#if BOOTLOADER_EXTENDED_MENU
+static uint64_t read_cycles(void)
+{
+    uint32_t high;
+    uint32_t low;
+
+    do
+    {
+        high = read_csr(mcycleh);
+        low = read_csr(mcycle);
+    } while (high != read_csr(mcycleh));
+
+    return (((uint64_t)high) << 32) | low;
+}
+
+/*
+ * Test the LSRAM and report the throughput, or the first failing address.
+ */
+static mem_test_status_t test_lsram(mem_test_mode_t mode)
+{
+    miv_udma_instance_t *udma = NULL;
+    mem_test_result_t result;
+    uint64_t cycles;
+    uint32_t time_us;
+
+#ifdef MIV_ESS_uDMA_BASE_ADDR
+    MIV_uDMA_init(&g_udma, MIV_ESS_uDMA_BASE_ADDR);
+    udma = &g_udma;
+#endif
+
+    /* The LSRAM content is lost, so is any interrupted download */
+    ymodem_resume_clear();
+
+    UART_polled_tx_string(&g_uart, (MEM_TEST_FULL == mode) ?
+                          "\r\nFull LSRAM test (March C-)" :
+                          "\r\nQuick LSRAM test (data and address bus)");
+    UART_polled_tx_string(&g_uart, " of ");
+    print_dec(LSRAM_TEST_SIZE);
+    UART_polled_tx_string(&g_uart, " bytes at ");
+    print_hex(LSRAM_BASE_ADDRESS_LOAD);
+    UART_polled_tx_string(&g_uart, "\r\n");
+
+    cycles = read_cycles();
+    mem_test_run((uint32_t *)LSRAM_BASE_ADDRESS_LOAD, LSRAM_TEST_SIZE,
+                 mode, udma, &result);
+    cycles = read_cycles() - cycles;
+
+    time_us = (uint32_t)((cycles * 1000000u) / SYS_CLK_FREQ);
+    if (0u == time_us)
+    {
+        time_us = 1u;
+    }
+
+    if (MEM_TEST_PASS == result.status)
+    {
+        UART_polled_tx_string(&g_uart, "  Pass: ");
+    }
+    else if (MEM_TEST_INVALID_REGION == result.status)
+    {
+        UART_polled_tx_string(&g_uart, "  Invalid test region\r\n");
+        return result.status;
+    }
+    else
+    {
+        UART_polled_tx_string(&g_uart,
+                              (MEM_TEST_DATA_BUS_FAIL == result.status) ? "  Data bus fault" :
+                              (MEM_TEST_ADDR_BUS_FAIL == result.status) ? "  Address bus fault" :
+                              (MEM_TEST_UDMA_FAIL == result.status) ? "  uDMA error" :
+                              "  March C- fault");
+        UART_polled_tx_string(&g_uart, " at ");
+        print_hex((uint32_t)result.fail_addr);
+        UART_polled_tx_string(&g_uart, ", expected ");
+        print_hex(result.expected);
+        UART_polled_tx_string(&g_uart, ", read ");
+        print_hex(result.actual);
+        UART_polled_tx_string(&g_uart, "\r\n  Fail: ");
+    }
+
+    print_dec(result.bytes_accessed);
+    UART_polled_tx_string(&g_uart, " bytes accessed in ");
+    print_dec(time_us);
+    UART_polled_tx_string(&g_uart, " us, ");
+    print_dec((uint32_t)(((uint64_t)result.bytes_accessed * 1000000u) /
+                         ((uint64_t)time_us * 1024u)));
+    UART_polled_tx_string(&g_uart, " KB/s\r\n");
+
+    return result.status;
+}
+#endif /* BOOTLOADER_EXTENDED_MENU */
+
+void copy_hex_to_i2ceeprom(void)
+{
     UART_polled_tx_string(&g_uart, g_greeting_msg_i2c);
+    eeprom_init();
+    write_program_to_i2ceeprom((uint8_t *)LSRAM_BASE_ADDRESS_LOAD, FLASH_EXECUTABLE_SIZE);
+}
+
+static void eeprom_init(void)
+{
     MIV_I2C_init(&g_miv_i2c_inst, MIV_I2C_BASE_ADDR);   //For ~100kHz I2C Clock
 
     MIV_I2C_config(&g_miv_i2c_inst, 0x0063);
@@ -241,17 +579,523 @@ void copy_hex_to_i2ceeprom(void)
                          MRV32_MSYS_EIE5_IRQn);
 
 #endif
-
-    MRV_systick_config(SYS_CLK_FREQ);
-    write_program_to_i2ceeprom((uint8_t *)LSRAM_BASE_ADDRESS_LOAD, FLASH_EXECUTABLE_SIZE);
 }
 
 void copy_hex_to_spiflash(void)
 {
     spi_flash_init(FLASH_CORE_SPI_BASE);
-    write_program_to_flash((uint8_t *)LSRAM_BASE_ADDRESS_LOAD, FLASH_EXECUTABLE_SIZE);
+    write_program_to_flash((uint8_t *)LSRAM_BASE_ADDRESS_LOAD, g_image_size);
+}
+
+/*
+ * Write the LSRAM content to the inactive A/B slot. The slot becomes the one
+ * booted by the bootstrap once the image is written and checked.
+ */
+static void copy_hex_to_slot(void)
+{
+    fw_slots_writer_t writer;
+    fw_slots_status_t status;
+
+    spi_flash_init(FLASH_CORE_SPI_BASE);
+
+    UART_polled_tx_string( &g_uart, "\r\n----------------------- Writing A/B slot from LSRAM memory ----------------------\r\n" );
+
+    status = fw_slots_write_begin(&writer, g_image_size);
+    if (FW_SLOTS_SUCCESS == status)
+    {
+        UART_polled_tx_string(&g_uart, (FW_SLOT_A == writer.slot) ?
+                              "  Writing slot A, sequence " :
+                              "  Writing slot B, sequence ");
+        print_dec(writer.sequence);
+        UART_polled_tx_string(&g_uart, "\r\n");
+
+        status = fw_slots_write(&writer,
+                                (const uint8_t *)LSRAM_BASE_ADDRESS_LOAD,
+                                g_image_size);
+    }
+    if (FW_SLOTS_SUCCESS == status)
+    {
+        status = fw_slots_write_commit(&writer);
+    }
+
+    if (FW_SLOTS_SUCCESS == status)
+    {
+        UART_polled_tx_string(&g_uart, "  Slot write success, booted from the next reset\r\n");
+    }
+    else
+    {
+        UART_polled_tx_string(&g_uart, "  Slot write failed, the previous image is kept\r\n");
+    }
+}
+
+#if BOOTLOADER_EXTENDED_MENU
+/*
+ * Destination of a .hex or .srec file. The record addresses are those of the
+ * TCM image, offset FW_SLOTS_EXEC_ADDR in the file is written at offset 0 of
+ * the SPI flash or EEPROM, where the MIV_ESS bootstrap loads it from.
+ */
+typedef struct
+{
+    uint8_t to_eeprom;
+    uint8_t as_text;
+    uint32_t erased;    /* 4kB flash blocks erased, one bit per block */
+} hex_dest_t;
+
+#define XON                             0x11u
+#define XOFF                            0x13u
+
+static int32_t hex_write(void *context, uint32_t address,
+                         const uint8_t *data, uint32_t length)
+{
+    hex_dest_t *dest = (hex_dest_t *)context;
+    uint8_t read_buffer[HEX_PARSER_PAGE_SIZE];
+    uint8_t flow;
+    uint32_t offset;
+    uint32_t block;
+    int32_t result = 0;
+
+    if ((address < FW_SLOTS_EXEC_ADDR) ||
+        ((address - FW_SLOTS_EXEC_ADDR) > (FLASH_EXECUTABLE_SIZE - length)))
+    {
+        return 1;
+    }
+    offset = address - FW_SLOTS_EXEC_ADDR;
+
+    /* Hold the sender while the UART is not read */
+    if (dest->as_text)
+    {
+        flow = XOFF;
+        UART_send(&g_uart, &flow, 1u);
+    }
+
+    if (dest->to_eeprom)
+    {
+        /* 2 byte word address followed by the data, within one EEPROM page */
+        i2c_tx_buffer[0] = (uint8_t)(offset >> 8);
+        i2c_tx_buffer[1] = (uint8_t)offset;
+        memcpy(&i2c_tx_buffer[2], data, length);
+        MIV_I2C_write(&g_miv_i2c_inst,
+                      target_slave_addr,
+                      i2c_tx_buffer,
+                      (uint16_t)(length + 2u),
+                      MIV_I2C_RELEASE_BUS,
+                      MIV_I2C_ACK_POLLING_ENABLE);
+        result = (MIV_I2C_SUCCESS ==
+                  MIV_I2C_wait_complete(&g_miv_i2c_inst, I2C_XFR_TIMEOUT_MS)) ? 0 : 1;
+    }
+    else
+    {
+        /* Erase each 4kB block the first time it is written to */
+        for (block = offset / FLASH_BLOCK_SIZE;
+             (0 == result) && (block <= ((offset + length - 1u) / FLASH_BLOCK_SIZE));
+             ++block)
+        {
+            if (0u == (dest->erased & (1u << block)))
+            {
+                if ((SPI_FLASH_SUCCESS != spi_flash_control_hw(SPI_FLASH_SECTOR_UNPROTECT,
+                                                               block * FLASH_BLOCK_SIZE, NULL)) ||
+                    (SPI_FLASH_SUCCESS != spi_flash_control_hw(SPI_FLASH_4KBLOCK_ERASE,
+                                                               block * FLASH_BLOCK_SIZE, NULL)))
+                {
+                    result = 1;
+                }
+                else
+                {
+                    dest->erased |= (1u << block);
+                }
+            }
+        }
+
+        if ((0 == result) &&
+            ((SPI_FLASH_SUCCESS != spi_flash_write(offset, (uint8_t *)data, length)) ||
+             (SPI_FLASH_SUCCESS != spi_flash_read(offset, read_buffer, length)) ||
+             (0 != memcmp(data, read_buffer, length))))
+        {
+            result = 1;
+        }
+    }
+
+    if (dest->as_text)
+    {
+        flow = XON;
+        UART_send(&g_uart, &flow, 1u);
+    }
+
+    return result;
+}
+
+static int32_t hex_ymodem_write(void *context, uint32_t offset,
+                                const uint8_t *data, uint32_t length)
+{
+    hex_parser_status_t status;
+
+    (void)offset;
+
+    /* Only stop the transfer on an error, not at the end of the file */
+    status = hex_parser_push((hex_parser_t *)context, data, length);
+
+    return ((HEX_PARSER_SUCCESS == status) || (HEX_PARSER_DONE == status)) ? 0 : 1;
+}
+
+/*
+ * Program a .hex or .srec file into the SPI flash or the EEPROM as its records
+ * are received, through YMODEM or sent as text. Only the pages holding data
+ * are written, address gaps are skipped.
+ */
+static void program_hex(uint8_t to_eeprom, uint8_t as_text)
+{
+    static hex_parser_t parser;
+    hex_dest_t dest;
+    hex_parser_status_t status;
+    uint8_t rx_data[UART_RX_BUF_SIZE];
+    size_t rx_size;
+
+    dest.to_eeprom = to_eeprom;
+    dest.as_text = as_text;
+    dest.erased = 0u;
+
+    if (to_eeprom)
+    {
+        UART_polled_tx_string(&g_uart, g_greeting_msg_i2c);
+        eeprom_init();
+    }
+    else
+    {
+        UART_polled_tx_string(&g_uart, g_greeting_msg_spi);
+        spi_flash_init(FLASH_CORE_SPI_BASE);
+    }
+
+    hex_parser_init(&parser, hex_write, &dest);
+
+    if (as_text)
+    {
+        UART_polled_tx_string(&g_uart, "Send the .hex or .srec file as text, with XON/XOFF flow control.\r\n");
+        UART_polled_tx_string(&g_uart, "Type any other key to abort.\r\n");
+        do
+        {
+            rx_size = UART_get_rx(&g_uart, rx_data, sizeof(rx_data));
+            status = hex_parser_push(&parser, rx_data, (uint32_t)rx_size);
+        } while (HEX_PARSER_SUCCESS == status);
+    }
+    else
+    {
+        UART_polled_tx_string( &g_uart, "\r\n------------------------ Starting YModem file transfer ------------------------\r\n" );
+        UART_polled_tx_string( &g_uart, "Please select file and initiate transfer on host computer.\r\n" );
+        if (0u != ymodem_receive_stream(hex_ymodem_write, &parser,
+                                        1024 * 1024 * 8, file_name))
+        {
+            hex_parser_finish(&parser);
+        }
+        else if (HEX_PARSER_SUCCESS == parser.status)
+        {
+            UART_polled_tx_string(&g_uart, "\r\nTransfer failed\r\n");
+            return;
+        }
+        status = parser.status;
+    }
+
+    if (HEX_PARSER_DONE != status)
+    {
+        UART_polled_tx_string(&g_uart,
+                              (HEX_PARSER_CHECKSUM_ERROR == status) ? "\r\nRecord checksum error" :
+                              (HEX_PARSER_WRITE_ERROR == status) ? "\r\nWrite failed or address outside the TCM image" :
+                              "\r\nNot a .hex or .srec file, or aborted");
+        UART_polled_tx_string(&g_uart, " after record ");
+        print_dec(parser.records);
+        UART_polled_tx_string(&g_uart, "\r\n");
+        return;
+    }
+
+    UART_polled_tx_string(&g_uart, "\r\n  ");
+    print_dec(parser.records);
+    UART_polled_tx_string(&g_uart, " records, ");
+    print_dec(parser.bytes);
+    UART_polled_tx_string(&g_uart, " bytes in ");
+    print_dec(parser.writes);
+    UART_polled_tx_string(&g_uart, " page writes\r\n");
+    UART_polled_tx_string(&g_uart, to_eeprom ? "MIV_I2C Write Complete!\r\n" :
+                                               "Flash write success\r\n");
+}
+
+static void print_zmodem_result(uint32_t received)
+{
+    const zmodem_stats_t *stats = zmodem_get_stats();
+
+    if (0u == received)
+    {
+        UART_polled_tx_string(&g_uart, "\r\nZModem transfer failed or cancelled\r\n");
+        return;
+    }
+
+    UART_polled_tx_string(&g_uart, "\r\n  ");
+    print_dec(received);
+    UART_polled_tx_string(&g_uart, " bytes received from offset ");
+    print_dec(stats->resumed_at);
+    UART_polled_tx_string(&g_uart, ", ");
+    print_dec(stats->crc_errors);
+    UART_polled_tx_string(&g_uart, " CRC errors, ");
+    print_dec(stats->repositions);
+    UART_polled_tx_string(&g_uart, " retransmission requests\r\n");
+}
+
+static int32_t lsram_write(void *context, uint32_t offset,
+                           const uint8_t *data, uint32_t length)
+{
+    memcpy((uint8_t *)context + offset, data, length);
+
+    return 0;
+}
+
+/*
+ * Put image received via zmodem into memory. The data is copied as it arrives,
+ * the sender does not wait for acknowledgements.
+ */
+static uint32_t rx_zmodem_file(void)
+{
+    uint8_t *dest_address = (uint8_t *)LSRAM_BASE_ADDRESS_LOAD;
+    uint32_t received;
+
+    /* As for YMODEM, the LSRAM test would destroy a resumable download */
+    if (0u != zmodem_resume_offset(lsram_write, dest_address))
+    {
+        UART_polled_tx_string(&g_uart, "\r\nInterrupted download, ");
+        print_dec(zmodem_resume_offset(lsram_write, dest_address));
+        UART_polled_tx_string(&g_uart, " bytes received. Send the same file to resume.\r\n");
+    }
+    else if (MEM_TEST_PASS != test_lsram(MEM_TEST_QUICK))
+    {
+        return 0u;
+    }
+
+    /* The blocks of an interrupted YMODEM download are overwritten */
+    ymodem_resume_clear();
+
+    UART_polled_tx_string( &g_uart, "\r\n------------------------ Starting ZModem file transfer ------------------------\r\n" );
+    UART_polled_tx_string( &g_uart, "Please select file and initiate transfer on host computer.\r\n" );
+
+    received = zmodem_receive(lsram_write, dest_address, LSRAM_SIZE, file_name,
+                              ZMODEM_STREAMING);
+    print_zmodem_result(received);
+    g_image_size = FLASH_EXECUTABLE_SIZE;
+
+    return received;
+}
+
+static int32_t flash_zmodem_write(void *context, uint32_t offset,
+                                  const uint8_t *data, uint32_t length)
+{
+    uint32_t count;
+
+    /*
+     * zmodem restarts at 0 when a different file is sent than the one
+     * interrupted, whose blocks must then be erased again
+     */
+    if (0u == offset)
+    {
+        ((hex_dest_t *)context)->erased = 0u;
+    }
+
+    /* hex_write() takes one flash page at a time */
+    while (0u != length)
+    {
+        count = HEX_PARSER_PAGE_SIZE - (offset & (HEX_PARSER_PAGE_SIZE - 1u));
+        if (count > length)
+        {
+            count = length;
+        }
+
+        if (0 != hex_write(context, FW_SLOTS_EXEC_ADDR + offset, data, count))
+        {
+            return 1;
+        }
+
+        offset += count;
+        data += count;
+        length -= count;
+    }
+
+    return 0;
+}
+
+/*
+ * Program an image into the SPI flash as it is received via zmodem. The sender
+ * waits for each block to be programmed before it sends the next one.
+ */
+static void program_zmodem(void)
+{
+    static hex_dest_t dest;
+    uint32_t received;
+
+    spi_flash_init(FLASH_CORE_SPI_BASE);
+
+    if (0u != zmodem_resume_offset(flash_zmodem_write, &dest))
+    {
+        UART_polled_tx_string(&g_uart, "\r\nInterrupted download, ");
+        print_dec(zmodem_resume_offset(flash_zmodem_write, &dest));
+        UART_polled_tx_string(&g_uart, " bytes programmed. Send the same file to resume.\r\n");
+    }
+    else
+    {
+        /* The blocks erased are kept when resuming the same file */
+        dest.to_eeprom = 0u;
+        dest.as_text = 0u;
+        dest.erased = 0u;
+    }
+
+    UART_polled_tx_string( &g_uart, "\r\n------------------------ Starting ZModem file transfer ------------------------\r\n" );
+    UART_polled_tx_string( &g_uart, "Please select file and initiate transfer on host computer.\r\n" );
+
+    received = zmodem_receive(flash_zmodem_write, &dest, FLASH_EXECUTABLE_SIZE,
+                              file_name, ZMODEM_BLOCK_SIZE);
+    print_zmodem_result(received);
+    if (0u != received)
+    {
+        UART_polled_tx_string(&g_uart, "Flash write success\r\n");
+    }
+}
+#endif /* BOOTLOADER_EXTENDED_MENU */
+
+static int32_t flash_read(void *context, uint32_t offset,
+                          uint8_t *data, uint32_t length)
+{
+    uint32_t address = *(const uint32_t *)context + offset;
+
+    return (SPI_FLASH_SUCCESS == spi_flash_read(address, data, length)) ? 0 : 1;
+}
+
+/*
+ * Send a region of the SPI flash to the host as a file via ymodem. The data is
+ * read from the flash as each packet is sent. The host may request YMODEM-G.
+ */
+static void upload_flash(void)
+{
+    fw_slot_desc_t desc;
+    fw_slot_id_t slot;
+    const char *name;
+    uint32_t address;
+    uint32_t length;
+    uint32_t sent;
+    uint8_t rx_data[UART_RX_BUF_SIZE];
+
+    spi_flash_init(FLASH_CORE_SPI_BASE);
+
+    UART_polled_tx_string(&g_uart, "\r\nType 0 boot image, a slot A image, b slot B image\r\n");
+    while (0u == UART_get_rx(&g_uart, rx_data, sizeof(rx_data)))
+    {
+    }
+
+    switch (rx_data[0])
+    {
+    case '0':
+        address = 0u;
+        length = FLASH_EXECUTABLE_SIZE;
+        name = "spi_flash_boot.bin";
+        break;
+    case 'a':
+    case 'b':
+        slot = ('a' == rx_data[0]) ? FW_SLOT_A : FW_SLOT_B;
+        if (!fw_slots_read_desc(slot, &desc))
+        {
+            UART_polled_tx_string(&g_uart, "No valid image in this slot\r\n");
+            return;
+        }
+        address = (FW_SLOT_A == slot) ? FW_SLOT_A_ADDR : FW_SLOT_B_ADDR;
+        length = desc.image_size;
+        name = (FW_SLOT_A == slot) ? "spi_flash_slot_a.bin" : "spi_flash_slot_b.bin";
+        break;
+    default:
+        UART_polled_tx_string(&g_uart, "Invalid selection\r\n");
+        return;
+    }
+
+    UART_polled_tx_string( &g_uart, "\r\n------------------------ Starting YModem file upload --------------------------\r\n" );
+    UART_polled_tx_string( &g_uart, "Please start receiving the file on host computer.\r\n" );
+
+    sent = ymodem_send(flash_read, &address, length, (const uint8_t *)name);
+    if (0u == sent)
+    {
+        UART_polled_tx_string(&g_uart, "\r\nUpload failed\r\n");
+        return;
+    }
+
+    UART_polled_tx_string(&g_uart, "\r\nUpload complete, ");
+    print_dec(sent);
+    UART_polled_tx_string(&g_uart, " bytes\r\n");
 }
 
+#if BOOTLOADER_EXTENDED_MENU
+/*
+ * Print the latency histograms of the SPI flash operations performed since
+ * the start, and the erase count of each 64KB sector that was erased.
+ */
+static void show_flash_stats(void)
+{
+    static const char * const op_names[SPI_FLASH_NB_LATENCIES] =
+    {
+        "Page program", "4KB block erase", "32KB block erase",
+        "64KB block erase", "Chip erase", "Busy wait"
+    };
+    const spi_flash_latency_t *latency;
+    uint32_t op;
+    uint32_t bucket;
+    uint32_t sector;
+    uint32_t count;
+
+    spi_flash_init(FLASH_CORE_SPI_BASE);
+
+    UART_polled_tx_string(&g_uart, "\r\n------------------------ SPI Flash operation latencies -------------------------\r\n");
+    for (op = 0u; op < SPI_FLASH_NB_LATENCIES; ++op)
+    {
+        latency = spi_flash_get_latency((spi_flash_latency_op_t)op);
+        if (0u == latency->count)
+        {
+            continue;
+        }
+
+        UART_polled_tx_string(&g_uart, op_names[op]);
+        UART_polled_tx_string(&g_uart, ": ");
+        print_dec(latency->count);
+        UART_polled_tx_string(&g_uart, " operations, mean ");
+        print_dec((uint32_t)(latency->total_us / latency->count));
+        UART_polled_tx_string(&g_uart, " us, max ");
+        print_dec(latency->max_us);
+        UART_polled_tx_string(&g_uart, " us\r\n");
+
+        for (bucket = 0u; bucket < SPI_FLASH_LATENCY_BUCKETS; ++bucket)
+        {
+            if (0u != latency->buckets[bucket])
+            {
+                UART_polled_tx_string(&g_uart, "  ");
+                print_dec((0u == bucket) ? 0u : (1u << bucket));
+                UART_polled_tx_string(&g_uart, (bucket < (SPI_FLASH_LATENCY_BUCKETS - 1u)) ?
+                                      " us to " : " us and more: ");
+                if (bucket < (SPI_FLASH_LATENCY_BUCKETS - 1u))
+                {
+                    print_dec((2u << bucket) - 1u);
+                    UART_polled_tx_string(&g_uart, " us: ");
+                }
+                print_dec(latency->buckets[bucket]);
+                UART_polled_tx_string(&g_uart, "\r\n");
+            }
+        }
+    }
+
+    UART_polled_tx_string(&g_uart, "\r\n-------------------------- SPI Flash sector erase counts -------------------------\r\n");
+    for (sector = 0u; sector < SPI_FLASH_NB_SECTORS; ++sector)
+    {
+        count = spi_flash_get_erase_count(sector);
+        if (0u != count)
+        {
+            UART_polled_tx_string(&g_uart, "  Sector at ");
+            print_hex(sector * SPI_FLASH_SECTOR_SIZE);
+            UART_polled_tx_string(&g_uart, ": ");
+            print_dec(count);
+            UART_polled_tx_string(&g_uart, " erases\r\n");
+        }
+    }
+}
+#endif /* BOOTLOADER_EXTENDED_MENU */
+
 /*
  *  Write to I2C EEPROM
  */
@@ -261,7 +1105,6 @@ static int write_program_to_i2ceeprom(uint8_t *write_buf, uint32_t file_size)
     uint32_t mem_val;               // read data word from source
     uint8_t page_no;                // I2C device page no. Each page is 256 Bytes. 256 x 64 = 16 Kb
     miv_i2c_status_t   status;
-    volatile uint8_t miv_i2c_status = 0u;
     UART_polled_tx_string(&g_uart,
                          (const uint8_t *)"\r\nWriting Data into EEPROM using MIV_I2C\n\r");
     for (page_no = 0; page_no <= 127 ; page_no++) //32kb = 128 pages of 256 bytes
@@ -289,9 +1132,12 @@ static int write_program_to_i2ceeprom(uint8_t *write_buf, uint32_t file_size)
                       I2C_XFR_DATA_LEN,
                       MIV_I2C_RELEASE_BUS,
                       MIV_I2C_ACK_POLLING_ENABLE);
-        do {
-            miv_i2c_status = g_miv_i2c_inst.master_status;
-        }while (MIV_I2C_IN_PROGRESS == miv_i2c_status);
+        status = MIV_I2C_wait_complete(&g_miv_i2c_inst, I2C_XFR_TIMEOUT_MS);
+        if (MIV_I2C_SUCCESS != status)
+        {
+            UART_polled_tx_string(&g_uart, (const uint8_t *)"\r\nMIV_I2C Write Failed!\n\r");
+            return 1;
+        }
     }
     UART_polled_tx_string(&g_uart, (const uint8_t *)"\r\nMIV_I2C Write Complete!\n\r");
     return 0u;
@@ -518,64 +1364,6 @@ static int write_program_to_flash(uint8_t *write_buf, uint32_t file_size)
         //show_progress();
     }
 
-    /*--------------------------------------------------------------------------
-     * Record the size written in the first SPI flash segment.
-     */
-    {
-        flash_content_t flash_content;
-
-        flash_content.validity_key = SPI_FLASH_VALID_CONTENT_KEY;
-        flash_content.spi_content_byte_size = file_size;
-
-        flash_address = LAST_BLOCK_ADDR;
-
-        /*----------------------------------------------------------------------
-         * at the start of each sector we need to make sure it is unprotected
-         * so we can erase blocks within it. The spi_flash_write() function
-         * unprotects the sector as well but we need to start erasing before the
-         * first write takes place.
-         */
-        if(0 == (flash_address % FLASH_SECTOR_SIZE))
-        {
-            result = spi_flash_control_hw(SPI_FLASH_SECTOR_UNPROTECT,
-                                          flash_address,
-                                          NULL);
-        }
-        /*----------------------------------------------------------------------
-         * At the start of each 4K block we issue an erase so that we are then
-         * free to write anything we want to the block. If we don't do this the
-         * write may fail as we can only effectively turn 1s to 0s when we
-         * write. For example if we have an erased location with 0xFF in it and
-         * we write 0xAA to it first and then later on write 0x55, the resulting
-         * value is 0x00...
-         */
-        if(0 == (flash_address % FLASH_BLOCK_SIZE))
-        {
-            result = spi_flash_control_hw(SPI_FLASH_4KBLOCK_ERASE,
-                                          flash_address,
-                                          NULL);
-        }
-        /*----------------------------------------------------------------------
-         * Write our values to the FLASH, read them back and compare.
-         * Placing a breakpoint on the while statement below will allow
-         * you break on any failures.
-         */
-        spi_flash_write( flash_address, (uint8_t *)(&flash_content), FLASH_SEGMENT_SIZE );
-
-        spi_flash_read ( flash_address, read_buffer, FLASH_SEGMENT_SIZE );
-
-        if( memcmp( (uint8_t *)&flash_content, read_buffer, FLASH_SEGMENT_SIZE ) )
-        {
-            while(1) // Breakpoint here will trap write faults
-            {
-
-            }
-        }
-
-        write_buf += FLASH_SEGMENT_SIZE;
-        flash_address += FLASH_SEGMENT_SIZE; /* Step to the next 256 byte chunk */
-    }
-
     /*--------------------------------------------------------------------------
      * One last look at the protection registers which should all be 0 now
      */
@@ -825,7 +1613,8 @@ static int read_program_from_flash(uint8_t *read_buf, uint32_t read_byte_length)
     uint32_t nb_segments_to_read;
     spi_flash_status_t result;
     struct device_Info DevInfo;
-    flash_content_t flash_content;
+    fw_slot_desc_t slot_desc;
+    fw_slot_id_t slot;
 
     UART_polled_tx_string( &g_uart, "\r\n------------------- Reading from SPI flash into DDR memory --------------------\r\n" );
     UART_polled_tx_string( &g_uart, "This will take several minutes to complete in order to read the full SPI flash \r\ncontent.\r\n" );
@@ -851,13 +1640,15 @@ static int read_program_from_flash(uint8_t *read_buf, uint32_t read_byte_length)
                                   &DevInfo);
 
     /*--------------------------------------------------------------------------
-     * Retrieve the size of the data previously written to SPI flash.
+     * Retrieve the location and size of the newest image written to an A/B
+     * slot of the SPI flash.
      */
-    spi_flash_read ( LAST_BLOCK_ADDR, (uint8_t *)&flash_content, FLASH_SEGMENT_SIZE );
+    slot = fw_slots_active(&slot_desc);
 
-    if(SPI_FLASH_VALID_CONTENT_KEY == flash_content.validity_key)
+    if(FW_SLOT_NONE != slot)
     {
-        read_byte_length = flash_content.spi_content_byte_size;
+        read_byte_length = slot_desc.image_size;
+        flash_address = (FW_SLOT_A == slot) ? FW_SLOT_A_ADDR : FW_SLOT_B_ADDR;
     }
     else
     {
@@ -892,23 +1683,6 @@ static int read_program_from_flash(uint8_t *read_buf, uint32_t read_byte_length)
     return(0);
 }
 
-/*
- * Simple sanity check
- */
-static void mem_test(uint8_t *address)
-{
-    volatile uint8_t value=2;
-    volatile uint32_t value32=3;
-    *address = 1;
-    value = *address;
-    value32 = (uint32_t)*address;
-
-    if((value32 == value) &&(value == 1))
-        UART_polled_tx_string( &g_uart, "  Read/Write success\r\n" );
-    else
-        UART_polled_tx_string( &g_uart, "  Read/Write fail\r\n" );
-}
-
 /*------------------------------------------------------------------------------
  * Call this function if you want to switch to another program
  * de-init any loaded drivers before calling this function
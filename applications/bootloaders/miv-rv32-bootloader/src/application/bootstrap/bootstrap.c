@@ -11,9 +11,12 @@
  */
 #include <string.h>
 #include "miv_rv32_hal/miv_rv32_hal.h"
+#include "miv_rv32_hal/miv_rv32_deadline.h"
 #include "drivers/fabric_ip/CoreUARTapb/core_uart_apb.h"
 #include "drivers/fabric_ip/miv_i2c/miv_i2c.h"
 #include "drivers/off_chip/spi_flash/spi_flash.h"
+#include "fw_slots/fw_slots.h"
+#include "boot_handoff/boot_handoff.h"
 
 #define FLASH_SECTOR_SIZE               65536   /* flash memory size */
 #define FLASH_SECTORS                   128    // There are 126 sectors of 64kB size, using 124
@@ -22,7 +25,6 @@
 
 #define FLASH_BLOCK_SEGMENTS            (FLASH_BLOCK_SIZE / FLASH_SEGMENT_SIZE)
 #define FLASH_BYTE_SIZE                 (FLASH_SECTOR_SIZE * FLASH_SECTORS)
-#define LAST_BLOCK_ADDR                 (FLASH_BYTE_SIZE - FLASH_BLOCK_SIZE)
 
 #ifdef __UNUSED_CODE
 static int test_flash(void);
@@ -42,11 +44,6 @@ static void copy_hex_to_spiflash(void);
 #define LSRAM_BASE_ADDRESS_LOAD         0x80000000
 #define LSRAM_BASE_ADDRESS_WRITE        0x89000000
 
-/*
- * Key value used to determine if valid data is contained in the SPI flash.
- */
-#define SPI_FLASH_VALID_CONTENT_KEY     0xB5006BB1
-
 const uint8_t g_bootstrap_choice[] =
 "\r\n\r\n\
 ======================================================================================\r\n\
@@ -63,19 +60,6 @@ Choose the destination Non-Volatile memory: \r\n\
  Type 2 copy .hex from LSRAM to MikroBus EEPROM \r\n\
  ";
 
-/*
- * Data structure stored at the beginning of SPI flash to indicate the size of
- * data stored inside the SPI flash. This is to avoid having to read the entire
- * flash content at boot time.
- * This data structure is one flash segment long (256 bytes).
- */
-typedef struct
-{
-    uint32_t validity_key;
-    uint32_t spi_content_byte_size;
-    uint32_t dummy[62];
-} flash_content_t;
-
 /******************************************************************************
  * CoreUARTapb instance data.
  *****************************************************************************/
@@ -86,13 +70,12 @@ UART_instance_t g_uart;
  * I2C instance data.
  *****************************************************************************/
 #define I2C_XFR_DATA_LEN                258u       // 2 byte address + 256 bytes data
+#define I2C_XFR_TIMEOUT_MS              100u       // 23ms transfer + 5ms EEPROM write cycle
 uint8_t target_slave_addr = 0x50;
 uint8_t i2c_tx_buffer[I2C_XFR_DATA_LEN];
 miv_i2c_instance_t g_miv_i2c_inst;
 
 
-volatile uint32_t g_10ms_count;
-
 const uint8_t g_greeting_msg_spi[] =
 " ----> SPI Flash is chosen as destination memory \r\n";
 
@@ -112,24 +95,21 @@ const char * g_greeting_msg_i2c =
  */
 #define FLASH_EXECUTABLE_SIZE    32768u
 
+/*
+ * Time given to press a key on the UART to stay in the menu instead of starting
+ * the image of the A/B slots. 0 removes the wait and always starts the slots.
+ */
+#ifndef BOOTSTRAP_MENU_KEY_MS
+#define BOOTSTRAP_MENU_KEY_MS    500u
+#endif
+
+static uint8_t menu_key_pressed(void);
+
 /* MIV I2C interrupt handler */
 void MSYS_EI2_IRQHandler(void)
 {
     MIV_I2C_isr (&g_miv_i2c_inst);
 }
-
-void SysTick_Handler(void)
-{
-    g_10ms_count += 10;
-
-      /*
-       * For neatness, if we roll over, reset cleanly back to 0 so the count
-       * always goes up in proper 10s.
-       */
-     if(g_10ms_count < 10)
-         g_10ms_count = 0;
-
-}
 /*-------------------------------------------------------------------------*//**
  * main() function.
  */
@@ -137,13 +117,45 @@ int main()
 {
     uint8_t rx_data[UART_RX_BUF_SIZE];
     size_t rx_size;
+    uint8_t menu_key;
     static uint32_t file_size = 0;
+
+    /**************************************************************************
+     * Start the hand-off block passed to the application, before anything
+     * else, to time the boot from the reset.
+     *************************************************************************/
+    boot_handoff_begin();
+
     /**************************************************************************
      * Initialize CoreUARTapb with its base address, baud value, and line
      * configuration.
      *************************************************************************/
     UART_init(&g_uart, COREUARTAPB0_BASE_ADDR,\
               BAUD_VALUE_115200, (DATA_8_BITS | NO_PARITY) );
+    boot_handoff_driver(BOOT_HANDOFF_UART, COREUARTAPB0_BASE_ADDR,
+                        BAUD_VALUE_115200 | ((DATA_8_BITS | NO_PARITY) << 16));
+
+    /**************************************************************************
+     * Start the newest valid image of the A/B slots of the SPI flash.
+     * fw_slots_boot() only returns when neither slot holds a valid image.
+     * A key pressed within BOOTSTRAP_MENU_KEY_MS skips the slots and opens the
+     * menu, for example to replace an image which starts but does not work.
+     * After a soft or watchdog reset, the copy of the image still held in the
+     * LSRAM is restarted without reading the flash.
+     *************************************************************************/
+    spi_flash_init(FLASH_CORE_SPI_BASE);
+    boot_handoff_driver(BOOT_HANDOFF_SPI_FLASH, FLASH_CORE_SPI_BASE, 0u);
+    menu_key = menu_key_pressed();
+    boot_handoff_phase(BOOT_HANDOFF_PHASE_INIT);
+    if (menu_key)
+    {
+        UART_polled_tx_string(&g_uart, "\r\nA/B slots not started\r\n");
+    }
+    else
+    {
+        fw_slots_boot();
+        UART_polled_tx_string(&g_uart, "\r\nNo valid image in the A/B slots of the SPI Flash\r\n");
+    }
 
     /**************************************************************************
      * Display greeting message message.
@@ -191,6 +203,29 @@ int main()
     return 0;
 }
 
+/*-------------------------------------------------------------------------*//**
+ * Returns 1 if a key was received on the UART within BOOTSTRAP_MENU_KEY_MS.
+ */
+static uint8_t menu_key_pressed(void)
+{
+#if BOOTSTRAP_MENU_KEY_MS > 0u
+    uint8_t key;
+    deadline_t deadline;
+
+    UART_polled_tx_string(&g_uart, "\r\nPress any key to open the menu\r\n");
+    deadline = deadline_in_ms(BOOTSTRAP_MENU_KEY_MS);
+    while (!deadline_expired(deadline))
+    {
+        if (UART_get_rx(&g_uart, &key, 1u) > 0u)
+        {
+            return 1u;
+        }
+    }
+#endif
+
+    return 0u;
+}
+
 void copy_hex_to_i2ceeprom(void)
 {
     uint8_t rx_size = 0u;
@@ -215,7 +250,6 @@ void copy_hex_to_i2ceeprom(void)
 
 #endif
 
-    MRV_systick_config(SYS_CLK_FREQ);
     write_program_to_i2ceeprom((uint8_t *)LSRAM_BASE_ADDRESS_LOAD, FLASH_EXECUTABLE_SIZE);
 }
 
@@ -234,7 +268,6 @@ static int write_program_to_i2ceeprom(uint8_t *write_buf, uint32_t file_size)
     uint32_t mem_val;               // read data word from source
     uint8_t page_no;                // I2C device page no. Each page is 256 Bytes. 256 x 64 = 16 Kb
     miv_i2c_status_t   status;
-    volatile uint8_t miv_i2c_status = 0u;
     UART_polled_tx_string(&g_uart,
                          (const uint8_t *)"\r\nWriting Data into EEPROM using MIV_I2C\n\r");
     for (page_no = 0; page_no <= 127 ; page_no++) //32kb = 128 pages of 256 bytes
@@ -262,9 +295,12 @@ static int write_program_to_i2ceeprom(uint8_t *write_buf, uint32_t file_size)
                       I2C_XFR_DATA_LEN,
                       MIV_I2C_RELEASE_BUS,
                       MIV_I2C_ACK_POLLING_ENABLE);
-        do {
-            miv_i2c_status = g_miv_i2c_inst.master_status;
-        }while (MIV_I2C_IN_PROGRESS == miv_i2c_status);
+        status = MIV_I2C_wait_complete(&g_miv_i2c_inst, I2C_XFR_TIMEOUT_MS);
+        if (MIV_I2C_SUCCESS != status)
+        {
+            UART_polled_tx_string(&g_uart, (const uint8_t *)"\r\nMIV_I2C Write Failed!\n\r");
+            return 1;
+        }
     }
     UART_polled_tx_string(&g_uart, (const uint8_t *)"\r\nMIV_I2C Write Complete!\n\r");
     return 0u;
@@ -491,64 +527,6 @@ static int write_program_to_flash(uint8_t *write_buf, uint32_t file_size)
         //show_progress();
     }
 
-    /*--------------------------------------------------------------------------
-     * Record the size written in the first SPI flash segment.
-     */
-    {
-        flash_content_t flash_content;
-
-        flash_content.validity_key = SPI_FLASH_VALID_CONTENT_KEY;
-        flash_content.spi_content_byte_size = file_size;
-
-        flash_address = LAST_BLOCK_ADDR;
-
-        /*----------------------------------------------------------------------
-         * at the start of each sector we need to make sure it is unprotected
-         * so we can erase blocks within it. The spi_flash_write() function
-         * unprotects the sector as well but we need to start erasing before the
-         * first write takes place.
-         */
-        if(0 == (flash_address % FLASH_SECTOR_SIZE))
-        {
-            result = spi_flash_control_hw(SPI_FLASH_SECTOR_UNPROTECT,
-                                          flash_address,
-                                          NULL);
-        }
-        /*----------------------------------------------------------------------
-         * At the start of each 4K block we issue an erase so that we are then
-         * free to write anything we want to the block. If we don't do this the
-         * write may fail as we can only effectively turn 1s to 0s when we
-         * write. For example if we have an erased location with 0xFF in it and
-         * we write 0xAA to it first and then later on write 0x55, the resulting
-         * value is 0x00...
-         */
-        if(0 == (flash_address % FLASH_BLOCK_SIZE))
-        {
-            result = spi_flash_control_hw(SPI_FLASH_4KBLOCK_ERASE,
-                                          flash_address,
-                                          NULL);
-        }
-        /*----------------------------------------------------------------------
-         * Write our values to the FLASH, read them back and compare.
-         * Placing a breakpoint on the while statement below will allow
-         * you break on any failures.
-         */
-        spi_flash_write( flash_address, (uint8_t *)(&flash_content), FLASH_SEGMENT_SIZE );
-
-        spi_flash_read ( flash_address, read_buffer, FLASH_SEGMENT_SIZE );
-
-        if( memcmp( (uint8_t *)&flash_content, read_buffer, FLASH_SEGMENT_SIZE ) )
-        {
-            while(1) // Breakpoint here will trap write faults
-            {
-
-            }
-        }
-
-        write_buf += FLASH_SEGMENT_SIZE;
-        flash_address += FLASH_SEGMENT_SIZE; /* Step to the next 256 byte chunk */
-    }
-
     /*--------------------------------------------------------------------------
      * One last look at the protection registers which should all be 0 now
      */
@@ -798,7 +776,8 @@ static int read_program_from_flash(uint8_t *read_buf, uint32_t read_byte_length)
     uint32_t nb_segments_to_read;
     spi_flash_status_t result;
     struct device_Info DevInfo;
-    flash_content_t flash_content;
+    fw_slot_desc_t slot_desc;
+    fw_slot_id_t slot;
 
     UART_polled_tx_string( &g_uart, "\r\n------------------- Reading from SPI flash into DDR memory --------------------\r\n" );
     UART_polled_tx_string( &g_uart, "This will take several minutes to complete in order to read the full SPI flash \r\ncontent.\r\n" );
@@ -824,13 +803,15 @@ static int read_program_from_flash(uint8_t *read_buf, uint32_t read_byte_length)
                                   &DevInfo);
 
     /*--------------------------------------------------------------------------
-     * Retrieve the size of the data previously written to SPI flash.
+     * Retrieve the location and size of the newest image written to an A/B
+     * slot of the SPI flash.
      */
-    spi_flash_read ( LAST_BLOCK_ADDR, (uint8_t *)&flash_content, FLASH_SEGMENT_SIZE );
+    slot = fw_slots_active(&slot_desc);
 
-    if(SPI_FLASH_VALID_CONTENT_KEY == flash_content.validity_key)
+    if(FW_SLOT_NONE != slot)
     {
-        read_byte_length = flash_content.spi_content_byte_size;
+        read_byte_length = slot_desc.image_size;
+        flash_address = (FW_SLOT_A == slot) ? FW_SLOT_A_ADDR : FW_SLOT_B_ADDR;
     }
     else
     {
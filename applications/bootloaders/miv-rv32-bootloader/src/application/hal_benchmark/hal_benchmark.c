@@ -0,0 +1,1053 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Mi-V HAL cycle count benchmark.
+ * Times the HAL and driver operations used on the bootloader's hot paths with
+ * the mcycle CSR and prints one CSV line per operation on CoreUARTapb0:
+ *
+ *   benchmark,unit,count,total_cycles,cycles_per_unit,min_cycles,max_cycles
+ *
+ * count is the number of units (calls, characters, bytes or words) timed.
+ * min_cycles and max_cycles are for one iteration of the benchmark loop. The
+ * cost of reading mcycle is measured first and removed from every sample.
+ * Lines starting with '#' are comments. The same image runs on hardware and on
+ * the Renode platform in the renode folder, so the output of two builds can be
+ * compared line by line after a change to hal.h, hw_reg_access.S or
+ * miv_rv32_entry.S.
+ */
+#include <string.h>
+#include "hal/hal.h"
+#include "miv_rv32_hal/miv_rv32_hal.h"
+#include "miv_rv32_hal/miv_rv32_string.h"
+#include "miv_rv32_hal/miv_rv32_arith.h"
+#include "drivers/fabric_ip/CoreUARTapb/core_uart_apb.h"
+#include "drivers/fabric_ip/CoreUARTapb/core_uart_apb_static.h"
+#include "drivers/fabric_ip/CoreGPIO/core_gpio.h"
+#include "drivers/fabric_ip/CoreGPIO/coregpio_regs.h"
+#include "drivers/fabric_ip/CoreSPI/core_spi.h"
+#include "drivers/fabric_ip/CoreSPI/core_spi_static.h"
+#include "drivers/fabric_ip/miv_i2c/miv_i2c.h"
+
+/*
+ * Number of iterations of each benchmark loop.
+ */
+#define BENCH_ITERATIONS        64u
+
+/*
+ * Number of mcycle ticks to wait for an interrupt before giving up. The
+ * software interrupt is not available on every platform.
+ */
+#define BENCH_IRQ_TIMEOUT       100000u
+
+#define BENCH_UART_STRING       "# uart_polled_tx_string timing line, 64 characters long......\r\n"
+#define BENCH_SPI_CMD_SIZE      4u
+#define BENCH_SPI_RX_SIZE       256u
+#define BENCH_I2C_TARGET        0x50u
+#define BENCH_I2C_RX_SIZE       64u
+#define BENCH_COPY_WORDS        1024u
+
+/*
+ * String function sweep: each call is timed BENCH_STRING_REPEAT times and the
+ * fastest is reported, in the TCM buffers of the startup loop benchmark and in
+ * the LSRAM, then the miv_rv32_string.S results are checked. BENCH_STRING_GUARD
+ * fills the destination bytes around those written.
+ */
+#define BENCH_STRING_REPEAT     8u
+#define BENCH_LSRAM_BASE_ADDR   0x80000000UL
+#define BENCH_LSRAM_DEST_ADDR   0x80002000UL
+#define BENCH_STRING_GUARD      0xA5u
+
+/*
+ * Multiply and divide table: each operation is timed BENCH_ARITH_REPEAT times
+ * and the fastest is reported, then the miv_rv32_arith results are checked.
+ */
+#define BENCH_ARITH_REPEAT      8u
+
+/*
+ * SPI flash read data command, used as a non destructive SPI_transfer_block()
+ * load.
+ */
+#define SPI_FLASH_READ_CMD      0x03u
+
+/*
+ * Field used to time HAL_set_32bit_reg_field(): bit 0 of the CoreGPIO output
+ * register.
+ */
+#define BENCH_FIELD_OFFSET      GPIO_OUT_REG_OFFSET
+#define BENCH_FIELD_MASK        0x00000001u
+#define BENCH_FIELD_SHIFT       0u
+
+extern void block_copy(void);
+extern void zeroize_block(void);
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t total;
+    uint32_t min;
+    uint32_t max;
+} bench_result_t;
+
+UART_instance_t g_uart;
+gpio_instance_t g_gpio_out;
+spi_instance_t g_spi;
+miv_i2c_instance_t g_miv_i2c_inst;
+
+static uint32_t g_mcycle_overhead = 0u;
+
+static volatile uint32_t g_irq_cycle;
+static volatile uint32_t g_irq_count;
+static volatile uint32_t g_i2c_isr_cycles;
+static volatile uint32_t g_i2c_isr_count;
+
+static uint8_t g_spi_cmd[BENCH_SPI_CMD_SIZE];
+static uint8_t g_spi_rx[BENCH_SPI_RX_SIZE];
+static uint8_t g_i2c_tx[2];
+static uint8_t g_i2c_rx[BENCH_I2C_RX_SIZE + 1u];
+static uint32_t g_copy_src[BENCH_COPY_WORDS];
+static uint32_t g_copy_dest[BENCH_COPY_WORDS];
+
+static const uint32_t g_string_sizes[] = { 1u, 4u, 7u, 16u, 31u, 64u, 256u, 1024u };
+static volatile uint32_t g_string_sink;
+
+static const uint32_t g_arith_operands[][2] =
+{
+    { 3u, 1000000u },
+    { 1000000u, 3u },
+    { 100u, 7u },
+    { 123456789u, 1000u },
+    { 1000000000u, 10u },
+    { 0xFFFFFFFFu, 3u },
+    { 100u, 0u },
+    { 0x80000000u, 0xFFFFFFFFu },
+    { 0x80000000u, 1u }
+};
+static const uint64_t g_arith_operands64[][2] =
+{
+    { 50000000u, 100u },
+    { 1099511627776ULL, 1000u },
+    { 281474976710655ULL, 305419896u },
+    { 0x123456789ABCDEF0ULL, 0x1234567890ULL },
+    { 1000u, 0u }
+};
+static volatile uint32_t g_arith_a;
+static volatile uint32_t g_arith_b;
+static volatile uint32_t g_arith_sink;
+static volatile uint64_t g_arith_a64;
+static volatile uint64_t g_arith_b64;
+static volatile uint64_t g_arith_sink64;
+
+static inline uint32_t read_mcycle(void)
+{
+    return (uint32_t)read_csr(mcycle);
+}
+
+/*------------------------------------------------------------------------------
+ * Interrupt handlers. Each records the cycle count on entry.
+ */
+void Software_IRQHandler(void)
+{
+    g_irq_cycle = read_mcycle();
+    ++g_irq_count;
+}
+
+void SysTick_Handler(void)
+{
+    g_irq_cycle = read_mcycle();
+    ++g_irq_count;
+}
+
+void MSYS_EI2_IRQHandler(void)
+{
+    uint32_t start = read_mcycle();
+
+    MIV_I2C_isr(&g_miv_i2c_inst);
+    g_i2c_isr_cycles += read_mcycle() - start - g_mcycle_overhead;
+    ++g_i2c_isr_count;
+}
+
+/*------------------------------------------------------------------------------
+ * CSV output.
+ */
+static void print_u32(uint32_t value)
+{
+    uint8_t digits[11];
+    uint8_t idx = sizeof(digits) - 1u;
+
+    digits[idx] = 0u;
+    do
+    {
+        --idx;
+        digits[idx] = (uint8_t)('0' + (value % 10u));
+        value /= 10u;
+    } while (0u != value);
+
+    UART_polled_tx_string(&g_uart, &digits[idx]);
+}
+
+static void print_u64(uint64_t value)
+{
+    uint8_t digits[21];
+    uint8_t idx = sizeof(digits) - 1u;
+
+    digits[idx] = 0u;
+    do
+    {
+        --idx;
+        digits[idx] = (uint8_t)('0' + (uint32_t)(value % 10u));
+        value /= 10u;
+    } while (0u != value);
+
+    UART_polled_tx_string(&g_uart, &digits[idx]);
+}
+
+static void print_line(const char * name,
+                       const char * unit,
+                       const bench_result_t * result)
+{
+    uint32_t per_unit = 0u;
+
+    if (0u != result->count)
+    {
+        per_unit = (uint32_t)(((uint64_t)result->total * 100u) / result->count);
+    }
+
+    UART_polled_tx_string(&g_uart, (const uint8_t *)name);
+    UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+    UART_polled_tx_string(&g_uart, (const uint8_t *)unit);
+    UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+    print_u32(result->count);
+    UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+    print_u32(result->total);
+    UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+    print_u32(per_unit / 100u);
+    UART_polled_tx_string(&g_uart, (const uint8_t *)".");
+    if ((per_unit % 100u) < 10u)
+    {
+        UART_polled_tx_string(&g_uart, (const uint8_t *)"0");
+    }
+    print_u32(per_unit % 100u);
+    UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+    print_u32(result->min);
+    UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+    print_u32(result->max);
+    UART_polled_tx_string(&g_uart, (const uint8_t *)"\r\n");
+}
+
+static void print_comment(const char * text)
+{
+    UART_polled_tx_string(&g_uart, (const uint8_t *)"# ");
+    UART_polled_tx_string(&g_uart, (const uint8_t *)text);
+    UART_polled_tx_string(&g_uart, (const uint8_t *)"\r\n");
+}
+
+static void result_init(bench_result_t * result)
+{
+    result->count = 0u;
+    result->total = 0u;
+    result->min = 0xFFFFFFFFu;
+    result->max = 0u;
+}
+
+static void result_add(bench_result_t * result, uint32_t cycles, uint32_t units)
+{
+    cycles = (cycles > g_mcycle_overhead) ? (cycles - g_mcycle_overhead) : 0u;
+
+    result->count += units;
+    result->total += cycles;
+    if (cycles < result->min)
+    {
+        result->min = cycles;
+    }
+    if (cycles > result->max)
+    {
+        result->max = cycles;
+    }
+}
+
+/*------------------------------------------------------------------------------
+ * Benchmarks.
+ */
+static void bench_mcycle_overhead(void)
+{
+    bench_result_t result;
+    uint32_t start;
+    uint32_t idx;
+
+    result_init(&result);
+    for (idx = 0u; idx < BENCH_ITERATIONS; ++idx)
+    {
+        start = read_mcycle();
+        result_add(&result, read_mcycle() - start, 1u);
+    }
+
+    /* Not removed from its own result */
+    g_mcycle_overhead = result.min;
+    print_line("mcycle_read", "call", &result);
+}
+
+/*
+ * Trap round trip: entry is from the instruction raising the interrupt to the
+ * first line of the C handler, exit from there back to the interrupted code.
+ * This includes the HAL dispatch code for the vector in use (generic trap
+ * handler in direct mode, per vector handler in vectored mode).
+ */
+static void bench_trap(const char * entry_name,
+                       const char * exit_name,
+                       uint8_t timer)
+{
+    bench_result_t entry;
+    bench_result_t exit;
+    uint32_t start;
+    uint32_t end;
+    uint32_t count;
+    uint32_t idx;
+
+    result_init(&entry);
+    result_init(&exit);
+
+    for (idx = 0u; idx < BENCH_ITERATIONS; ++idx)
+    {
+        count = g_irq_count;
+
+        if (timer)
+        {
+            MTIMECMPH = 0xFFFFFFFFu;
+            MTIMECMP = 0u;
+            start = read_mcycle();
+            MTIMECMPH = 0u;
+        }
+        else
+        {
+            start = read_mcycle();
+            MRV_raise_soft_irq();
+        }
+
+        while ((count == g_irq_count) &&
+               ((read_mcycle() - start) < BENCH_IRQ_TIMEOUT))
+        {
+            ;
+        }
+        end = read_mcycle();
+
+        if (count == g_irq_count)
+        {
+            print_comment(entry_name);
+            print_comment("interrupt not taken, skipped");
+            return;
+        }
+
+        result_add(&entry, g_irq_cycle - start, 1u);
+        result_add(&exit, end - g_irq_cycle, 1u);
+    }
+
+    print_line(entry_name, "trap", &entry);
+    print_line(exit_name, "trap", &exit);
+}
+
+static void bench_traps(void)
+{
+    MRV_enable_interrupts();
+
+    bench_trap("trap_soft_entry", "trap_soft_exit", 0u);
+    clear_csr(mie, MIP_MSIP);
+
+#if !defined(MIV_RV32_EXT_TIMER) && !defined(MIV_RV32_EXT_TIMECMP)
+    /*
+     * The timer handler sets MTIMECMP one systick period ahead, so configure a
+     * long period to get exactly one interrupt per iteration.
+     */
+    MRV_systick_config(SYS_CLK_FREQ);
+    bench_trap("trap_timer_entry", "trap_timer_exit", 1u);
+    clear_csr(mie, MIP_MTIP);
+#else
+    print_comment("trap_timer: external MTIME/MTIMECMP, skipped");
+#endif
+
+    MRV_disable_interrupts();
+}
+
+static void bench_mtime(void)
+{
+    bench_result_t result;
+    volatile uint64_t mtime;
+    uint32_t start;
+    uint32_t idx;
+
+    result_init(&result);
+    for (idx = 0u; idx < BENCH_ITERATIONS; ++idx)
+    {
+        start = read_mcycle();
+        mtime = MRV_read_mtime();
+        result_add(&result, read_mcycle() - start, 1u);
+    }
+    (void)mtime;
+
+    print_line("MRV_read_mtime", "call", &result);
+}
+
+static void bench_reg_access(void)
+{
+    bench_result_t set;
+    bench_result_t get;
+    bench_result_t field;
+    volatile uint32_t value;
+    uint32_t start;
+    uint32_t idx;
+
+    result_init(&set);
+    result_init(&get);
+    result_init(&field);
+
+    for (idx = 0u; idx < BENCH_ITERATIONS; ++idx)
+    {
+        start = read_mcycle();
+        HAL_set_32bit_reg(COREGPIO_OUT_BASE_ADDR, GPIO_OUT, 0u);
+        result_add(&set, read_mcycle() - start, 1u);
+
+        start = read_mcycle();
+        value = HAL_get_32bit_reg(COREGPIO_OUT_BASE_ADDR, GPIO_OUT);
+        result_add(&get, read_mcycle() - start, 1u);
+
+        start = read_mcycle();
+        HAL_set_32bit_reg_field(COREGPIO_OUT_BASE_ADDR, BENCH_FIELD, idx & 1u);
+        result_add(&field, read_mcycle() - start, 1u);
+    }
+    (void)value;
+
+    print_line("HAL_set_32bit_reg", "call", &set);
+    print_line("HAL_get_32bit_reg", "call", &get);
+    print_line("HAL_set_32bit_reg_field", "call", &field);
+}
+
+static void bench_gpio(void)
+{
+    bench_result_t result;
+    uint32_t start;
+    uint32_t idx;
+
+    GPIO_init(&g_gpio_out, COREGPIO_OUT_BASE_ADDR, GPIO_APB_32_BITS_BUS);
+    GPIO_config(&g_gpio_out, GPIO_0, GPIO_OUTPUT_MODE);
+
+    result_init(&result);
+    for (idx = 0u; idx < BENCH_ITERATIONS; ++idx)
+    {
+        start = read_mcycle();
+        GPIO_set_output(&g_gpio_out, GPIO_0, (uint8_t)(idx & 1u));
+        result_add(&result, read_mcycle() - start, 1u);
+    }
+
+    print_line("GPIO_set_output", "call", &result);
+}
+
+static void bench_uart(void)
+{
+    static const uint8_t line[] = BENCH_UART_STRING;
+    bench_result_t result;
+    uint32_t start;
+    uint32_t idx;
+
+    result_init(&result);
+    for (idx = 0u; idx < 4u; ++idx)
+    {
+        start = read_mcycle();
+        UART_polled_tx_string(&g_uart, line);
+        result_add(&result, read_mcycle() - start, sizeof(line) - 1u);
+    }
+
+    print_line("UART_polled_tx_string", "char", &result);
+
+    /* Same line through the instance specialized for its base address */
+    result_init(&result);
+    for (idx = 0u; idx < 4u; ++idx)
+    {
+        start = read_mcycle();
+        COREUARTAPB0_polled_tx_string(&g_uart, line);
+        result_add(&result, read_mcycle() - start, sizeof(line) - 1u);
+    }
+
+    print_line("COREUARTAPB0_polled_tx_string", "char", &result);
+}
+
+static void bench_spi(void)
+{
+    bench_result_t result;
+    uint32_t start;
+    uint32_t idx;
+
+    SPI_init(&g_spi, FLASH_CORE_SPI_BASE, 32u);
+    SPI_configure_master_mode(&g_spi);
+    SPI_set_slave_select(&g_spi, SPI_SLAVE_0);
+
+    g_spi_cmd[0] = SPI_FLASH_READ_CMD;
+    g_spi_cmd[1] = 0u;
+    g_spi_cmd[2] = 0u;
+    g_spi_cmd[3] = 0u;
+
+    result_init(&result);
+    for (idx = 0u; idx < (BENCH_ITERATIONS / 8u); ++idx)
+    {
+        start = read_mcycle();
+        SPI_transfer_block(&g_spi, g_spi_cmd, BENCH_SPI_CMD_SIZE,
+                           g_spi_rx, BENCH_SPI_RX_SIZE);
+        result_add(&result, read_mcycle() - start,
+                   BENCH_SPI_CMD_SIZE + BENCH_SPI_RX_SIZE);
+    }
+
+    print_line("SPI_transfer_block", "byte", &result);
+
+    result_init(&result);
+    for (idx = 0u; idx < (BENCH_ITERATIONS / 8u); ++idx)
+    {
+        start = read_mcycle();
+        FLASH_CORE_SPI_transfer_block(&g_spi, g_spi_cmd, BENCH_SPI_CMD_SIZE,
+                                      g_spi_rx, BENCH_SPI_RX_SIZE);
+        result_add(&result, read_mcycle() - start,
+                   BENCH_SPI_CMD_SIZE + BENCH_SPI_RX_SIZE);
+    }
+
+    SPI_clear_slave_select(&g_spi, SPI_SLAVE_0);
+    print_line("FLASH_CORE_SPI_transfer_block", "byte", &result);
+}
+
+/*
+ * MIV_I2C_isr() is timed inside MSYS_EI2_IRQHandler(). A write of the two
+ * byte memory address followed by a read is used so that the EEPROM content
+ * is left untouched. One interrupt is generated per byte on the bus, address
+ * bytes included.
+ */
+static void bench_i2c(void)
+{
+    bench_result_t result;
+    uint32_t bytes;
+
+    MIV_I2C_init(&g_miv_i2c_inst, MIV_I2C_BASE_ADDR);
+    MIV_I2C_config(&g_miv_i2c_inst, 0x0063u);
+
+    g_i2c_isr_cycles = 0u;
+    g_i2c_isr_count = 0u;
+    g_i2c_tx[0] = 0u;
+    g_i2c_tx[1] = 0u;
+
+    HAL_enable_interrupts();
+#ifndef MIV_LEGACY_RV32
+    MRV_enable_local_irq(MRV32_MSYS_EIE2_IRQn);
+#endif
+
+    /* MIV_I2C_write_read() stores one byte in front of the read buffer */
+    MIV_I2C_write_read(&g_miv_i2c_inst, BENCH_I2C_TARGET,
+                       g_i2c_tx, sizeof(g_i2c_tx),
+                       &g_i2c_rx[1], BENCH_I2C_RX_SIZE,
+                       MIV_I2C_RELEASE_BUS, MIV_I2C_ACK_POLLING_DISABLE);
+    while (MIV_I2C_IN_PROGRESS == g_miv_i2c_inst.master_status)
+    {
+        ;
+    }
+
+#ifndef MIV_LEGACY_RV32
+    MRV_disable_local_irq(MRV32_MSYS_EIE2_IRQn);
+#endif
+    HAL_disable_interrupts();
+
+    if (MIV_I2C_SUCCESS != g_miv_i2c_inst.master_status)
+    {
+        print_comment("MIV_I2C_isr: no I2C target, skipped");
+        return;
+    }
+
+    /* Address byte for the write and for the read, then the data */
+    bytes = 1u + sizeof(g_i2c_tx) + 1u + BENCH_I2C_RX_SIZE;
+
+    result_init(&result);
+    result.count = bytes;
+    result.total = g_i2c_isr_cycles;
+    result.min = g_i2c_isr_count;
+    result.max = g_i2c_isr_count;
+    print_comment("MIV_I2C_isr: min_cycles and max_cycles hold the number of interrupts");
+    print_line("MIV_I2C_isr", "byte", &result);
+}
+
+static void bench_startup_loops(void)
+{
+    bench_result_t copy;
+    bench_result_t zero;
+    uint32_t start;
+    uint32_t idx;
+
+    for (idx = 0u; idx < BENCH_COPY_WORDS; ++idx)
+    {
+        g_copy_src[idx] = idx;
+    }
+
+    result_init(&copy);
+    result_init(&zero);
+
+    for (idx = 0u; idx < (BENCH_ITERATIONS / 8u); ++idx)
+    {
+        register uint32_t * src __asm__("a4") = g_copy_src;
+        register uint32_t * dest __asm__("a5") = g_copy_dest;
+        register uint32_t * end __asm__("a6") = &g_copy_dest[BENCH_COPY_WORDS];
+
+        start = read_mcycle();
+        __asm__ volatile ("call block_copy"
+                          : "+r"(src), "+r"(dest), "+r"(end)
+                          :
+                          : "a7", "ra", "memory");
+        result_add(&copy, read_mcycle() - start, BENCH_COPY_WORDS);
+
+        dest = g_copy_dest;
+        end = &g_copy_dest[BENCH_COPY_WORDS];
+        start = read_mcycle();
+        __asm__ volatile ("call zeroize_block"
+                          : "+r"(dest), "+r"(end)
+                          :
+                          : "a7", "ra", "memory");
+        result_add(&zero, read_mcycle() - start, BENCH_COPY_WORDS);
+    }
+
+    print_line("block_copy", "word", &copy);
+    print_line("zeroize_block", "word", &zero);
+}
+
+/*
+ * Fastest of BENCH_STRING_REPEAT calls of memcpy(), memset() or memcmp()
+ * (function 0, 1 or 2), from newlib or from miv_rv32_string.S.
+ */
+static uint32_t time_string(uint32_t function,
+                            uint8_t miv,
+                            uint8_t * dest,
+                            const uint8_t * src,
+                            uint32_t size)
+{
+    uint32_t best = 0xFFFFFFFFu;
+    uint32_t start;
+    uint32_t cycles = 0u;
+    uint32_t idx;
+
+    for (idx = 0u; idx < BENCH_STRING_REPEAT; ++idx)
+    {
+        if (0u == function)
+        {
+            start = read_mcycle();
+            g_string_sink = (uint32_t)(miv ? miv_memcpy(dest, src, size) :
+                                             memcpy(dest, src, size));
+            cycles = read_mcycle() - start;
+        }
+        else if (1u == function)
+        {
+            start = read_mcycle();
+            g_string_sink = (uint32_t)(miv ? miv_memset(dest, 0x5A, size) :
+                                             memset(dest, 0x5A, size));
+            cycles = read_mcycle() - start;
+        }
+        else
+        {
+            /* Equal buffers, the worst case */
+            start = read_mcycle();
+            g_string_sink = (uint32_t)(miv ? miv_memcmp(dest, src, size) :
+                                             memcmp(dest, src, size));
+            cycles = read_mcycle() - start;
+        }
+
+        cycles = (cycles > g_mcycle_overhead) ? (cycles - g_mcycle_overhead) : 0u;
+        if (cycles < best)
+        {
+            best = cycles;
+        }
+    }
+
+    return best;
+}
+
+/*
+ * Sign of a memcmp() result.
+ */
+static int32_t memcmp_sign(int result)
+{
+    return (result > 0) ? 1 : ((result < 0) ? -1 : 0);
+}
+
+/*
+ * Checks miv_memcpy(), miv_memset() or miv_memcmp() (function 0, 1 or 2) on the
+ * buffers of a bench_string() row against newlib. For miv_memcpy() and
+ * miv_memset(), the bytes written, the returned pointer and the guard bytes
+ * before and after them. For miv_memcmp(), the sign of the result for equal
+ * data and for a difference in the last and in the first byte, with either
+ * buffer holding the byte above 0x7F.
+ */
+static uint8_t check_string(uint32_t function,
+                            uint8_t * dest,
+                            uint8_t * to,
+                            uint8_t * from,
+                            uint32_t size)
+{
+    uint8_t ok = 1u;
+    uint32_t idx;
+    uint32_t pos;
+    int newlib_result;
+
+    if (2u != function)
+    {
+        memset(dest, BENCH_STRING_GUARD, size + 2u);
+        if (0u == function)
+        {
+            /* Not periodic over a word, a misaligned copy shows */
+            for (idx = 0u; idx < size; ++idx)
+            {
+                from[idx] = (uint8_t)((idx * 13u) + 1u);
+            }
+            ok = (miv_memcpy(to, from, size) == to);
+        }
+        else
+        {
+            memset(from, 0x3C, size);
+            ok = (miv_memset(to, 0x3C, size) == to);
+        }
+
+        if ((0 != memcmp(to, from, size)) ||
+            ((to != dest) && (BENCH_STRING_GUARD != dest[0])) ||
+            (BENCH_STRING_GUARD != to[size]))
+        {
+            ok = 0u;
+        }
+    }
+    else
+    {
+        for (idx = 0u; idx < 5u; ++idx)
+        {
+            memset(to, 0x5A, size);
+            memset(from, 0x5A, size);
+            if (0u != idx)
+            {
+                pos = (idx < 3u) ? (size - 1u) : 0u;
+                to[pos] = (0u != (idx & 1u)) ? 0xF0u : 0x01u;
+                from[pos] = (0u != (idx & 1u)) ? 0x01u : 0xF0u;
+            }
+
+            newlib_result = memcmp(to, from, size);
+            if ((memcmp_sign(miv_memcmp(to, from, size)) != memcmp_sign(newlib_result)) ||
+                ((0u != idx) && (0 == newlib_result)))
+            {
+                ok = 0u;
+            }
+        }
+    }
+
+    return ok;
+}
+
+/*
+ * Second CSV table: cycles of one call of each string function, newlib's and
+ * miv_rv32_string.S's, for a sweep of sizes, with src and dest word aligned
+ * (offset 0) or src, dest for memset(), one byte past a word boundary
+ * (offset 1), and whether the miv_rv32_string.S results match newlib's.
+ */
+static void bench_string(void)
+{
+    static const char * const functions[] = { "memcpy", "memset", "memcmp" };
+    static const char * const memories[] = { "tcm", "lsram" };
+    uint8_t * dest[2];
+    uint8_t * src[2];
+    uint32_t function;
+    uint32_t memory;
+    uint32_t size_idx;
+    uint32_t offset;
+    uint32_t size;
+    uint8_t * to;
+    uint8_t * from;
+
+    dest[0] = (uint8_t *)g_copy_dest;
+    src[0] = (uint8_t *)g_copy_src;
+    dest[1] = (uint8_t *)BENCH_LSRAM_DEST_ADDR;
+    src[1] = (uint8_t *)BENCH_LSRAM_BASE_ADDR;
+
+    if ((void *)memcpy == (void *)miv_memcpy)
+    {
+        print_comment("string: linked with --wrap, the newlib columns are miv_rv32_string.S");
+    }
+    UART_polled_tx_string(&g_uart,
+        (const uint8_t *)"function,memory,bytes,offset,newlib_cycles,miv_cycles,result\r\n");
+
+    for (function = 0u; function < 3u; ++function)
+    {
+        for (memory = 0u; memory < 2u; ++memory)
+        {
+            for (size_idx = 0u; size_idx < (sizeof(g_string_sizes) / sizeof(g_string_sizes[0])); ++size_idx)
+            {
+                for (offset = 0u; offset < 2u; ++offset)
+                {
+                    size = g_string_sizes[size_idx];
+                    to = dest[memory] + ((1u == function) ? offset : 0u);
+                    from = src[memory] + ((1u == function) ? 0u : offset);
+
+                    /* memcmp() compares equal data, misaligned alike */
+                    miv_memset(dest[memory], 0x5A, size + 1u);
+                    miv_memset(src[memory], 0x5A, size + 1u);
+
+                    UART_polled_tx_string(&g_uart, (const uint8_t *)functions[function]);
+                    UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+                    UART_polled_tx_string(&g_uart, (const uint8_t *)memories[memory]);
+                    UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+                    print_u32(size);
+                    UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+                    print_u32(offset);
+                    UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+                    print_u32(time_string(function, 0u, to, from, size));
+                    UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+                    print_u32(time_string(function, 1u, to, from, size));
+                    UART_polled_tx_string(&g_uart,
+                        (const uint8_t *)(check_string(function, dest[memory], to, from, size) ?
+                                          ",ok\r\n" : ",FAIL\r\n"));
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Fastest of BENCH_ARITH_REPEAT evaluations of operation 0 to 4 of
+ * bench_arith() on the operands in g_arith_a and g_arith_b, or g_arith_a64 and
+ * g_arith_b64, with the C operator or with miv_rv32_arith. The operands are
+ * read after the first mcycle read so that the compiler cannot compute the
+ * result before it.
+ */
+static uint32_t time_arith(uint32_t operation, uint8_t miv)
+{
+    uint32_t best = 0xFFFFFFFFu;
+    uint32_t start = 0u;
+    uint32_t cycles = 0u;
+    uint32_t idx;
+
+    for (idx = 0u; idx < BENCH_ARITH_REPEAT; ++idx)
+    {
+        switch (operation)
+        {
+            case 0u:
+                start = read_mcycle();
+                g_arith_sink = miv ? miv_mulsi3(g_arith_a, g_arith_b) :
+                                     (g_arith_a * g_arith_b);
+                cycles = read_mcycle() - start;
+                break;
+
+            case 1u:
+                start = read_mcycle();
+                g_arith_sink = miv ? miv_udivsi3(g_arith_a, g_arith_b) :
+                                     (g_arith_a / g_arith_b);
+                cycles = read_mcycle() - start;
+                break;
+
+            case 2u:
+                start = read_mcycle();
+                g_arith_sink = (uint32_t)(miv ? miv_divsi3((int32_t)g_arith_a, (int32_t)g_arith_b) :
+                                                ((int32_t)g_arith_a / (int32_t)g_arith_b));
+                cycles = read_mcycle() - start;
+                break;
+
+            case 3u:
+                start = read_mcycle();
+                g_arith_sink = miv ? miv_udiv_const(g_arith_a, 10u) :
+                                     (g_arith_a / 10u);
+                cycles = read_mcycle() - start;
+                break;
+
+            default:
+                start = read_mcycle();
+                g_arith_sink64 = miv ? miv_udivdi3(g_arith_a64, g_arith_b64) :
+                                       (g_arith_a64 / g_arith_b64);
+                cycles = read_mcycle() - start;
+                break;
+        }
+
+        cycles = (cycles > g_mcycle_overhead) ? (cycles - g_mcycle_overhead) : 0u;
+        if (cycles < best)
+        {
+            best = cycles;
+        }
+    }
+
+    return best;
+}
+
+/*
+ * Checks the miv_rv32_arith results of operation 0 to 4 of bench_arith(), the
+ * quotient and the remainder for the divisions, on the operands in g_arith_a
+ * and g_arith_b, or g_arith_a64 and g_arith_b64, against the C operators. C
+ * leaves the division by zero and INT32_MIN / -1 undefined, their expected
+ * results are those documented in miv_rv32_arith.h.
+ */
+static uint8_t check_arith(uint32_t operation)
+{
+    const uint32_t a = g_arith_a;
+    const uint32_t b = g_arith_b;
+    const int32_t n = (int32_t)a;
+    const int32_t d = (int32_t)b;
+    const uint64_t a64 = g_arith_a64;
+    const uint64_t b64 = g_arith_b64;
+    uint8_t ok;
+
+    switch (operation)
+    {
+        case 0u:
+            ok = (miv_mulsi3(a, b) == (a * b));
+            break;
+
+        case 1u:
+            if (0u == b)
+            {
+                ok = (0xFFFFFFFFu == miv_udivsi3(a, b)) && (a == miv_umodsi3(a, b));
+            }
+            else
+            {
+                ok = ((a / b) == miv_udivsi3(a, b)) && ((a % b) == miv_umodsi3(a, b));
+            }
+            break;
+
+        case 2u:
+            if (0 == d)
+            {
+                ok = (((n < 0) ? 1 : -1) == miv_divsi3(n, d)) && (n == miv_modsi3(n, d));
+            }
+            else if ((INT32_MIN == n) && (-1 == d))
+            {
+                ok = (INT32_MIN == miv_divsi3(n, d)) && (0 == miv_modsi3(n, d));
+            }
+            else
+            {
+                ok = ((n / d) == miv_divsi3(n, d)) && ((n % d) == miv_modsi3(n, d));
+            }
+            break;
+
+        case 3u:
+            ok = ((a / 10u) == miv_udiv_const(a, 10u)) &&
+                 ((a % 10u) == miv_umod_const(a, 10u));
+            break;
+
+        default:
+            if (0u == b64)
+            {
+                ok = (UINT64_MAX == miv_udivdi3(a64, b64)) && (a64 == miv_umoddi3(a64, b64));
+            }
+            else
+            {
+                ok = ((a64 / b64) == miv_udivdi3(a64, b64)) &&
+                     ((a64 % b64) == miv_umoddi3(a64, b64));
+            }
+            break;
+    }
+
+    return ok;
+}
+
+/*
+ * Third CSV table: cycles of one multiplication or division with the C
+ * operator, a libgcc call on RV32I or an instruction with the M extension, and
+ * with miv_rv32_arith, and whether the miv_rv32_arith results match the C
+ * operators. div negates the first operand, udiv_10 divides it by the constant
+ * 10.
+ */
+static void bench_arith(void)
+{
+    static const char * const operations[] = { "mul", "udiv", "div", "udiv_10" };
+    uint32_t operation;
+    uint32_t idx;
+    uint32_t b;
+
+#ifdef __riscv_mul
+    print_comment("arith: M extension, the compiler columns are the mul and div instructions");
+#endif
+    UART_polled_tx_string(&g_uart,
+        (const uint8_t *)"operation,a,b,compiler_cycles,miv_cycles,result\r\n");
+
+    for (operation = 0u; operation < 4u; ++operation)
+    {
+        for (idx = 0u; idx < (sizeof(g_arith_operands) / sizeof(g_arith_operands[0])); ++idx)
+        {
+            g_arith_a = (2u == operation) ? (0u - g_arith_operands[idx][0]) :
+                                            g_arith_operands[idx][0];
+            b = (3u == operation) ? 10u : g_arith_operands[idx][1];
+            g_arith_b = b;
+
+            UART_polled_tx_string(&g_uart, (const uint8_t *)operations[operation]);
+            UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+            if (2u == operation)
+            {
+                UART_polled_tx_string(&g_uart, (const uint8_t *)"-");
+            }
+            print_u32(g_arith_operands[idx][0]);
+            UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+            if ((2u == operation) && (0u != (b & 0x80000000u)))
+            {
+                UART_polled_tx_string(&g_uart, (const uint8_t *)"-");
+                print_u32(0u - b);
+            }
+            else
+            {
+                print_u32(b);
+            }
+            UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+            print_u32(time_arith(operation, 0u));
+            UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+            print_u32(time_arith(operation, 1u));
+            UART_polled_tx_string(&g_uart,
+                (const uint8_t *)(check_arith(operation) ? ",ok\r\n" : ",FAIL\r\n"));
+        }
+    }
+
+    for (idx = 0u; idx < (sizeof(g_arith_operands64) / sizeof(g_arith_operands64[0])); ++idx)
+    {
+        g_arith_a64 = g_arith_operands64[idx][0];
+        g_arith_b64 = g_arith_operands64[idx][1];
+
+        UART_polled_tx_string(&g_uart, (const uint8_t *)"udiv64,");
+        print_u64(g_arith_operands64[idx][0]);
+        UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+        print_u64(g_arith_operands64[idx][1]);
+        UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+        print_u32(time_arith(4u, 0u));
+        UART_polled_tx_string(&g_uart, (const uint8_t *)",");
+        print_u32(time_arith(4u, 1u));
+        UART_polled_tx_string(&g_uart,
+            (const uint8_t *)(check_arith(4u) ? ",ok\r\n" : ",FAIL\r\n"));
+    }
+}
+
+/*-------------------------------------------------------------------------*//**
+ * main() function.
+ */
+int main(void)
+{
+    UART_init(&g_uart, COREUARTAPB0_BASE_ADDR,
+              BAUD_VALUE_115200, (DATA_8_BITS | NO_PARITY));
+
+    print_comment("Mi-V HAL cycle count benchmark");
+    UART_polled_tx_string(&g_uart, (const uint8_t *)"# SYS_CLK_FREQ=");
+    print_u32(SYS_CLK_FREQ);
+    UART_polled_tx_string(&g_uart, (const uint8_t *)" mtvec=");
+    print_u32((uint32_t)read_csr(mtvec));
+    UART_polled_tx_string(&g_uart, (const uint8_t *)"\r\n");
+    UART_polled_tx_string(&g_uart,
+        (const uint8_t *)"benchmark,unit,count,total_cycles,cycles_per_unit,min_cycles,max_cycles\r\n");
+
+    bench_mcycle_overhead();
+    bench_traps();
+    bench_mtime();
+    bench_reg_access();
+    bench_gpio();
+    bench_uart();
+    bench_spi();
+    bench_i2c();
+    bench_startup_loops();
+    bench_string();
+    bench_arith();
+
+    print_comment("done");
+
+    while (1u)
+    {
+        ;
+    }
+
+    return 0;
+}
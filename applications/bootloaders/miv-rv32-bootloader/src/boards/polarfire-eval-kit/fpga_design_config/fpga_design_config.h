@@ -69,6 +69,18 @@
 #define FLASH_CORE_SPI_BASE                     0x76000000UL
 #define MIV_I2C_BASE_ADDR                       0x7A000000UL
 
+/***************************************************************************//**
+ * Instances for which core_uart_apb_static.h and core_spi_static.h define
+ * driver functions specialized for their base address.
+ * Format of each entry is:
+ * X(<function prefix>, <base address>)
+ */
+#define CORE_UART_APB_INSTANCES(X) \
+    X(COREUARTAPB0, COREUARTAPB0_BASE_ADDR)
+
+#define CORE_SPI_INSTANCES(X) \
+    X(FLASH_CORE_SPI, FLASH_CORE_SPI_BASE)
+
 /***************************************************************************//**
  * Peripheral Interrupts are mapped to the corresponding Mi-V Soft processor
  * interrupt from the Libero design.
@@ -0,0 +1,217 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file boot_handoff.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Bootloader to application hand-off block.
+ *
+ * See boot_handoff.h for details of how to use this module.
+ */
+#include <string.h>
+#include "fw_slots/fw_slots.h"
+#include "boot_handoff.h"
+
+/*
+ * When HAL_HOST_SIMULATION is defined the block is in the host memory mapped
+ * at BOOT_HANDOFF_ADDR and the phases are timed with the host clock(), see
+ * hal_sim.h.
+ */
+#ifndef HAL_HOST_SIMULATION
+#include "miv_rv32_hal/miv_rv32_hal.h"
+
+#define HANDOFF                         ((boot_handoff_t *)BOOT_HANDOFF_ADDR)
+#define READ_CYCLES()                   ((uint32_t)read_csr(mcycle))
+#else
+#include <time.h>
+#include "hal/hal.h"
+#include "fpga_design_config/fpga_design_config.h"
+#include "hal_sim.h"
+
+#define HANDOFF                         ((boot_handoff_t *)HAL_SIM_translate(BOOT_HANDOFF_ADDR, \
+                                                                             HANDOFF_MAX_SIZE))
+#define READ_CYCLES()                   ((uint32_t)clock())
+#endif
+
+/* The block CRC covers every field but itself */
+#define HANDOFF_CRC_LENGTH              (sizeof(boot_handoff_t) - sizeof(uint32_t))
+
+/* Largest block of a later version accepted */
+#define HANDOFF_MAX_SIZE                1024u
+
+/*
+ * Check the block left at BOOT_HANDOFF_ADDR. Blocks of a later version are
+ * accepted, their CRC covers the size they give.
+ */
+static uint8_t
+handoff_valid
+(
+    const boot_handoff_t * handoff
+)
+{
+    if ((BOOT_HANDOFF_MAGIC != handoff->magic) ||
+        (handoff->version < BOOT_HANDOFF_VERSION) ||
+        (handoff->size < sizeof(boot_handoff_t)) ||
+        (handoff->size > HANDOFF_MAX_SIZE) ||
+        (0u != (handoff->size & 3u)))
+    {
+        return 0u;
+    }
+
+    return (*(const uint32_t *)((const uint8_t *)handoff + handoff->size - sizeof(uint32_t)) ==
+            fw_slots_crc32(0u, (const uint8_t *)handoff, handoff->size - sizeof(uint32_t))) ?
+           1u : 0u;
+}
+
+/***************************************************************************//**
+ * boot_handoff_begin()
+ * See "boot_handoff.h" for details of how to use this function.
+ */
+void
+boot_handoff_begin
+(
+    void
+)
+{
+    boot_handoff_t * handoff = HANDOFF;
+    uint32_t reset_cause = BOOT_HANDOFF_RESET_POWER_ON;
+    uint32_t boot_count = 1u;
+
+    if (handoff_valid(handoff))
+    {
+        boot_count = handoff->boot_count + 1u;
+        reset_cause = (BOOT_HANDOFF_RESET_POWER_ON != handoff->reset_request) ?
+                      handoff->reset_request : BOOT_HANDOFF_RESET_UNREQUESTED;
+    }
+
+    memset(handoff, 0, sizeof(boot_handoff_t));
+    handoff->magic = BOOT_HANDOFF_MAGIC;
+    handoff->version = BOOT_HANDOFF_VERSION;
+    handoff->size = sizeof(boot_handoff_t);
+    handoff->reset_cause = reset_cause;
+    handoff->boot_count = boot_count;
+    handoff->sys_clk_freq = SYS_CLK_FREQ;
+}
+
+/***************************************************************************//**
+ * boot_handoff_driver()
+ * See "boot_handoff.h" for details of how to use this function.
+ */
+void
+boot_handoff_driver
+(
+    boot_handoff_driver_t driver,
+    uint32_t base,
+    uint32_t config
+)
+{
+    HAL_ASSERT(driver < BOOT_HANDOFF_DRIVER_COUNT);
+
+    HANDOFF->drivers |= (1u << driver);
+    HANDOFF->driver[driver].base = base;
+    HANDOFF->driver[driver].config = config;
+}
+
+/***************************************************************************//**
+ * boot_handoff_phase()
+ * See "boot_handoff.h" for details of how to use this function.
+ */
+void
+boot_handoff_phase
+(
+    boot_handoff_phase_t phase
+)
+{
+    HAL_ASSERT(phase < BOOT_HANDOFF_PHASE_COUNT);
+
+    HANDOFF->phase_cycles[phase] = READ_CYCLES();
+}
+
+/***************************************************************************//**
+ * boot_handoff_image()
+ * See "boot_handoff.h" for details of how to use this function.
+ */
+void
+boot_handoff_image
+(
+    boot_handoff_source_t source,
+    uint8_t warm,
+    uint32_t size,
+    uint32_t crc
+)
+{
+    HANDOFF->image_source = source;
+    HANDOFF->image_warm = warm;
+    HANDOFF->image_size = size;
+    HANDOFF->image_crc = crc;
+}
+
+/***************************************************************************//**
+ * boot_handoff_seal()
+ * See "boot_handoff.h" for details of how to use this function.
+ */
+void
+boot_handoff_seal
+(
+    void
+)
+{
+    HANDOFF->crc = fw_slots_crc32(0u, (const uint8_t *)HANDOFF, HANDOFF_CRC_LENGTH);
+}
+
+/***************************************************************************//**
+ * boot_handoff_get()
+ * See "boot_handoff.h" for details of how to use this function.
+ */
+const boot_handoff_t *
+boot_handoff_get
+(
+    void
+)
+{
+    return handoff_valid(HANDOFF) ? HANDOFF : NULL;
+}
+
+/***************************************************************************//**
+ * boot_handoff_uart_attach()
+ * See "boot_handoff.h" for details of how to use this function.
+ */
+uint8_t
+boot_handoff_uart_attach
+(
+    UART_instance_t * this_uart
+)
+{
+    const boot_handoff_t * handoff = boot_handoff_get();
+
+    if ((NULL == handoff) || (0u == (handoff->drivers & (1u << BOOT_HANDOFF_UART))))
+    {
+        return 0u;
+    }
+
+    this_uart->base_address = (addr_t)handoff->driver[BOOT_HANDOFF_UART].base;
+    this_uart->status = 0u;
+
+    return 1u;
+}
+
+/***************************************************************************//**
+ * boot_handoff_request_reset()
+ * See "boot_handoff.h" for details of how to use this function.
+ */
+void
+boot_handoff_request_reset
+(
+    boot_handoff_reset_t reason
+)
+{
+    boot_handoff_t * handoff = HANDOFF;
+
+    if (handoff_valid(handoff))
+    {
+        handoff->reset_request = reason;
+        *(uint32_t *)((uint8_t *)handoff + handoff->size - sizeof(uint32_t)) =
+            fw_slots_crc32(0u, (const uint8_t *)handoff, handoff->size - sizeof(uint32_t));
+    }
+}
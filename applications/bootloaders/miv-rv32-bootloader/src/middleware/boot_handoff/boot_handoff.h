@@ -0,0 +1,219 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file boot_handoff.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Bootloader to application hand-off block.
+ *
+ * The bootloader fills a hand-off block at a fixed RAM address before it starts
+ * the application. The block tells the application:
+ *  - which peripherals the bootloader left initialised, with the parameters it
+ *    used, so that the application can use them without initialising them again,
+ *  - why the processor was reset,
+ *  - where the image was loaded from,
+ *  - how long each phase of the boot took, in processor cycles.
+ *
+ * The block is versioned. A newer bootloader may append fields: it increments
+ * BOOT_HANDOFF_VERSION and the size field gives the length of the block it
+ * wrote. An application only uses the fields of the version it was built with.
+ * The block is protected by a CRC-32: boot_handoff_get() returns NULL when the
+ * block was not written by the bootloader or has been overwritten since.
+ *
+ * The block stays in RAM across resets which do not clear the RAM. The next
+ * boot uses it to tell a reset requested by the application through
+ * boot_handoff_request_reset() from a power on and from any other reset.
+ */
+#ifndef BOOT_HANDOFF_H_
+#define BOOT_HANDOFF_H_
+
+#include "hal/cpu_types.h"
+#include "drivers/fabric_ip/CoreUARTapb/core_uart_apb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+ * Address of the hand-off block. It must be in RAM which the application image
+ * does not overwrite when it is loaded, after the fw_slots warm boot record by
+ * default.
+ */
+#ifndef BOOT_HANDOFF_ADDR
+#define BOOT_HANDOFF_ADDR               0x80008200u
+#endif
+
+#define BOOT_HANDOFF_MAGIC              0x46464F48u     /* "HOFF" */
+#define BOOT_HANDOFF_VERSION            1u
+
+typedef enum
+{
+    BOOT_HANDOFF_RESET_POWER_ON = 0,    /* No hand-off block in RAM */
+    BOOT_HANDOFF_RESET_SOFT,            /* Requested, MRV32_cpu_soft_reset() */
+    BOOT_HANDOFF_RESET_WATCHDOG,        /* Requested, MIV_WDOG_force_reset() */
+    BOOT_HANDOFF_RESET_UNREQUESTED      /* Watchdog timeout, reset button... */
+} boot_handoff_reset_t;
+
+typedef enum
+{
+    BOOT_HANDOFF_SOURCE_NONE = 0,
+    BOOT_HANDOFF_SOURCE_SLOT_A,         /* fw_slots slot A of the SPI flash */
+    BOOT_HANDOFF_SOURCE_SLOT_B          /* fw_slots slot B of the SPI flash */
+} boot_handoff_source_t;
+
+/*------------------------------------------------------------------------------
+ * Boot phases. phase_cycles holds the mcycle count at the end of each phase,
+ * counted from the reset.
+ */
+typedef enum
+{
+    BOOT_HANDOFF_PHASE_INIT = 0,        /* Peripherals initialised */
+    BOOT_HANDOFF_PHASE_LOAD,            /* Image in RAM and checked */
+    BOOT_HANDOFF_PHASE_START,           /* Image about to be started */
+    BOOT_HANDOFF_PHASE_COUNT
+} boot_handoff_phase_t;
+
+/*------------------------------------------------------------------------------
+ * Peripherals which can be left initialised. The meaning of base and config in
+ * the driver record of each:
+ *  - UART: CoreUARTapb base address, config = baud value | line config << 16.
+ *  - SPI_FLASH: CoreSPI base address passed to spi_flash_init().
+ *  - I2C: Mi-V I2C base address, config = MIV_I2C_config() clock setting.
+ *  - SYSTICK: config = ticks passed to MRV_systick_config().
+ */
+typedef enum
+{
+    BOOT_HANDOFF_UART = 0,
+    BOOT_HANDOFF_SPI_FLASH,
+    BOOT_HANDOFF_I2C,
+    BOOT_HANDOFF_SYSTICK,
+    BOOT_HANDOFF_DRIVER_COUNT
+} boot_handoff_driver_t;
+
+typedef struct
+{
+    uint32_t base;
+    uint32_t config;
+} boot_handoff_driver_info_t;
+
+/*------------------------------------------------------------------------------
+ * Hand-off block, version 1. drivers has bit (1 << boot_handoff_driver_t) set
+ * for each peripheral left initialised. image_warm is 1 when the image was
+ * started again from the copy left in RAM by the previous boot. crc is the
+ * CRC-32 of the first size - 4 bytes of the block.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t reset_cause;
+    uint32_t reset_request;
+    uint32_t boot_count;
+    uint32_t sys_clk_freq;
+    uint32_t image_source;
+    uint32_t image_warm;
+    uint32_t image_size;
+    uint32_t image_crc;
+    uint32_t phase_cycles[BOOT_HANDOFF_PHASE_COUNT];
+    uint32_t drivers;
+    boot_handoff_driver_info_t driver[BOOT_HANDOFF_DRIVER_COUNT];
+    uint32_t crc;
+} boot_handoff_t;
+
+/***************************************************************************//**
+ * boot_handoff_begin() is called by the bootloader as early as possible. It
+ * works out the reset cause from the block left by the previous boot, if any,
+ * then clears the block.
+ */
+void
+boot_handoff_begin
+(
+    void
+);
+
+/***************************************************************************//**
+ * boot_handoff_driver() records that the bootloader initialised a peripheral,
+ * and leaves it initialised for the application.
+ */
+void
+boot_handoff_driver
+(
+    boot_handoff_driver_t driver,
+    uint32_t base,
+    uint32_t config
+);
+
+/***************************************************************************//**
+ * boot_handoff_phase() records the end of a boot phase.
+ */
+void
+boot_handoff_phase
+(
+    boot_handoff_phase_t phase
+);
+
+/***************************************************************************//**
+ * boot_handoff_image() records the image about to be started.
+ */
+void
+boot_handoff_image
+(
+    boot_handoff_source_t source,
+    uint8_t warm,
+    uint32_t size,
+    uint32_t crc
+);
+
+/***************************************************************************//**
+ * boot_handoff_seal() computes the CRC-32 of the block. It is called last,
+ * just before the application is started.
+ */
+void
+boot_handoff_seal
+(
+    void
+);
+
+/***************************************************************************//**
+ * boot_handoff_get() returns the hand-off block of the current boot, or NULL
+ * if there is no valid block.
+ */
+const boot_handoff_t *
+boot_handoff_get
+(
+    void
+);
+
+/***************************************************************************//**
+ * boot_handoff_uart_attach() sets up a CoreUARTapb driver instance for the
+ * UART left initialised by the bootloader, without writing to the UART, and
+ * without flushing the characters it received. It replaces UART_init().
+ *
+ * @return
+ *      1 if the instance was set up, 0 if the bootloader did not leave the UART
+ *      initialised, in which case UART_init() must be called.
+ */
+uint8_t
+boot_handoff_uart_attach
+(
+    UART_instance_t * this_uart
+);
+
+/***************************************************************************//**
+ * boot_handoff_request_reset() records the reason of a reset the application
+ * is about to cause, so that the next boot reports it as reset_cause. It does
+ * not reset the processor.
+ */
+void
+boot_handoff_request_reset
+(
+    boot_handoff_reset_t reason
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOOT_HANDOFF_H_ */
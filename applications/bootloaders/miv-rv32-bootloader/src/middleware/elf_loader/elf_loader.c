@@ -0,0 +1,343 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file elf_loader.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Streaming ELF32 loader.
+ *
+ * See elf_loader.h for details of how to use this module.
+ */
+#include <string.h>
+#include "elf_loader.h"
+
+/*
+ * ELF32 header and program header field offsets, all fields little endian.
+ */
+#define EI_CLASS                        4u
+#define EI_DATA                         5u
+#define E_TYPE                          16u
+#define E_MACHINE                       18u
+#define E_ENTRY                         24u
+#define E_PHOFF                         28u
+#define E_PHENTSIZE                     42u
+#define E_PHNUM                         44u
+#define ELF32_EHDR_SIZE                 52u
+
+#define P_TYPE                          0u
+#define P_OFFSET                        4u
+#define P_PADDR                         12u
+#define P_FILESZ                        16u
+#define P_MEMSZ                         20u
+#define ELF32_PHDR_SIZE                 32u
+
+#define ELFCLASS32                      1u
+#define ELFDATA2LSB                     1u
+#define ET_EXEC                         2u
+#define EM_RISCV                        243u
+#define PT_LOAD                         1u
+
+static uint32_t
+read_u16
+(
+    const uint8_t * p
+)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t
+read_u32
+(
+    const uint8_t * p
+)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * Check the ELF header, once its 52 bytes are in the header buffer, and work
+ * out where the program headers end.
+ */
+static elf_loader_status_t
+parse_elf_header
+(
+    elf_loader_t * loader
+)
+{
+    const uint8_t * ehdr = loader->header;
+    uint32_t phoff = read_u32(&ehdr[E_PHOFF]);
+    uint32_t phnum = read_u16(&ehdr[E_PHNUM]);
+
+    if ((0x7Fu != ehdr[0]) || ('E' != ehdr[1]) ||
+        ('L' != ehdr[2]) || ('F' != ehdr[3]))
+    {
+        return ELF_LOADER_NOT_ELF;
+    }
+
+    if ((ELFCLASS32 != ehdr[EI_CLASS]) || (ELFDATA2LSB != ehdr[EI_DATA]) ||
+        (ET_EXEC != read_u16(&ehdr[E_TYPE])) ||
+        (EM_RISCV != read_u16(&ehdr[E_MACHINE])) ||
+        (ELF32_PHDR_SIZE != read_u16(&ehdr[E_PHENTSIZE])) ||
+        (0u == phnum) || (phoff < ELF32_EHDR_SIZE) ||
+        ((phnum * ELF32_PHDR_SIZE) > ELF_LOADER_HEADER_SIZE) ||
+        (phoff > (ELF_LOADER_HEADER_SIZE - (phnum * ELF32_PHDR_SIZE))))
+    {
+        return ELF_LOADER_UNSUPPORTED;
+    }
+
+    loader->entry = read_u32(&ehdr[E_ENTRY]);
+    loader->header_end = phoff + (phnum * ELF32_PHDR_SIZE);
+
+    return ELF_LOADER_SUCCESS;
+}
+
+/*
+ * Find the region of each PT_LOAD segment, once all the program headers are in
+ * the header buffer.
+ */
+static elf_loader_status_t
+parse_program_headers
+(
+    elf_loader_t * loader
+)
+{
+    const uint8_t * phdr = &loader->header[read_u32(&loader->header[E_PHOFF])];
+    const uint8_t * phdr_end = &loader->header[loader->header_end];
+    elf_loader_segment_t * segment;
+    elf_loader_region_t * region;
+    uint32_t paddr;
+    uint32_t idx;
+
+    for (; phdr < phdr_end; phdr += ELF32_PHDR_SIZE)
+    {
+        segment = &loader->segments[loader->segment_count];
+        segment->offset = read_u32(&phdr[P_OFFSET]);
+        segment->filesz = read_u32(&phdr[P_FILESZ]);
+        segment->memsz = read_u32(&phdr[P_MEMSZ]);
+        paddr = read_u32(&phdr[P_PADDR]);
+
+        if ((PT_LOAD != read_u32(&phdr[P_TYPE])) || (0u == segment->memsz))
+        {
+            continue;
+        }
+
+        if ((ELF_LOADER_MAX_SEGMENTS == loader->segment_count) ||
+            (segment->filesz > segment->memsz) ||
+            (segment->offset > (0xFFFFFFFFu - segment->filesz)))
+        {
+            return ELF_LOADER_UNSUPPORTED;
+        }
+
+        segment->region = NULL;
+        for (idx = 0u; idx < loader->region_count; ++idx)
+        {
+            region = &loader->regions[idx];
+            if ((paddr >= region->base) &&
+                ((paddr - region->base) < region->size) &&
+                (segment->memsz <= (region->size - (paddr - region->base))))
+            {
+                segment->region = region;
+                segment->dest = region->dest + (paddr - region->base);
+                break;
+            }
+        }
+
+        if (NULL == segment->region)
+        {
+            return ELF_LOADER_BAD_ADDRESS;
+        }
+
+        /* Regions can share their memory, segments must not overwrite each other */
+        for (idx = 0u; idx < loader->segment_count; ++idx)
+        {
+            if ((segment->dest < (loader->segments[idx].dest + loader->segments[idx].memsz)) &&
+                (loader->segments[idx].dest < (segment->dest + segment->memsz)))
+            {
+                return ELF_LOADER_BAD_ADDRESS;
+            }
+        }
+
+        ++loader->segment_count;
+    }
+
+    return ELF_LOADER_SUCCESS;
+}
+
+/*
+ * Copy the part of the file from offset to offset + length - 1 which belongs
+ * to segments.
+ */
+static void
+load_segments
+(
+    elf_loader_t * loader,
+    const uint8_t * data,
+    uint32_t offset,
+    uint32_t length
+)
+{
+    elf_loader_segment_t * segment;
+    uint32_t start;
+    uint32_t end;
+    uint32_t region_end;
+    uint32_t idx;
+
+    for (idx = 0u; idx < loader->segment_count; ++idx)
+    {
+        segment = &loader->segments[idx];
+
+        start = (offset > segment->offset) ? offset : segment->offset;
+        end = ((offset + length) < (segment->offset + segment->filesz)) ?
+              (offset + length) : (segment->offset + segment->filesz);
+
+        if (start < end)
+        {
+            memcpy(segment->dest + (start - segment->offset),
+                   data + (start - offset),
+                   end - start);
+            loader->loaded += end - start;
+
+            region_end = (uint32_t)(segment->dest - segment->region->dest) +
+                         (end - segment->offset);
+            if (region_end > segment->region->end)
+            {
+                segment->region->end = region_end;
+            }
+        }
+    }
+}
+
+/***************************************************************************//**
+ * elf_loader_init()
+ * See "elf_loader.h" for details of how to use this function.
+ */
+void
+elf_loader_init
+(
+    elf_loader_t * loader,
+    elf_loader_region_t * regions,
+    uint32_t region_count
+)
+{
+    uint32_t idx;
+
+    loader->regions = regions;
+    loader->region_count = region_count;
+    loader->status = ELF_LOADER_SUCCESS;
+    loader->position = 0u;
+    loader->header_end = 0u;
+    loader->entry = 0u;
+    loader->segment_count = 0u;
+    loader->loaded = 0u;
+    loader->zeroed = 0u;
+
+    for (idx = 0u; idx < region_count; ++idx)
+    {
+        regions[idx].end = 0u;
+    }
+}
+
+/***************************************************************************//**
+ * elf_loader_push()
+ * See "elf_loader.h" for details of how to use this function.
+ */
+elf_loader_status_t
+elf_loader_push
+(
+    elf_loader_t * loader,
+    const uint8_t * data,
+    uint32_t length
+)
+{
+    uint32_t wanted;
+    uint32_t count;
+
+    /* Gather the headers, the segments are known once they are complete */
+    while ((ELF_LOADER_SUCCESS == loader->status) && (0u != length) &&
+           ((0u == loader->header_end) || (loader->position < loader->header_end)))
+    {
+        wanted = (0u == loader->header_end) ? ELF32_EHDR_SIZE : loader->header_end;
+        count = wanted - loader->position;
+        if (count > length)
+        {
+            count = length;
+        }
+
+        memcpy(&loader->header[loader->position], data, count);
+        loader->position += count;
+        data += count;
+        length -= count;
+
+        if (loader->position == wanted)
+        {
+            if (0u == loader->header_end)
+            {
+                loader->status = parse_elf_header(loader);
+            }
+            else
+            {
+                loader->status = parse_program_headers(loader);
+
+                /* A segment can start in the headers */
+                if (ELF_LOADER_SUCCESS == loader->status)
+                {
+                    load_segments(loader, loader->header, 0u, loader->header_end);
+                }
+            }
+        }
+    }
+
+    if ((ELF_LOADER_SUCCESS == loader->status) && (0u != length))
+    {
+        load_segments(loader, data, loader->position, length);
+        loader->position += length;
+    }
+
+    return loader->status;
+}
+
+/***************************************************************************//**
+ * elf_loader_finish()
+ * See "elf_loader.h" for details of how to use this function.
+ */
+elf_loader_status_t
+elf_loader_finish
+(
+    elf_loader_t * loader
+)
+{
+    elf_loader_segment_t * segment;
+    uint32_t idx;
+
+    if (ELF_LOADER_SUCCESS != loader->status)
+    {
+        return loader->status;
+    }
+
+    if ((0u == loader->header_end) || (loader->position < loader->header_end))
+    {
+        loader->status = ELF_LOADER_TRUNCATED;
+        return loader->status;
+    }
+
+    for (idx = 0u; idx < loader->segment_count; ++idx)
+    {
+        if (loader->position < (loader->segments[idx].offset + loader->segments[idx].filesz))
+        {
+            loader->status = ELF_LOADER_TRUNCATED;
+            return loader->status;
+        }
+    }
+
+    for (idx = 0u; idx < loader->segment_count; ++idx)
+    {
+        segment = &loader->segments[idx];
+        memset(segment->dest + segment->filesz, 0, segment->memsz - segment->filesz);
+        loader->zeroed += segment->memsz - segment->filesz;
+    }
+
+    return loader->status;
+}
@@ -0,0 +1,159 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file elf_loader.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Streaming ELF32 loader.
+ *
+ * Loads the PT_LOAD segments of a RISC-V ELF32 executable while the file is
+ * being received, so that the file never needs to be held in memory as a
+ * whole. The file is passed to elf_loader_push() in order, in chunks of any
+ * size, for example as the packets of a YMODEM transfer arrive.
+ *
+ * The ELF header and the program headers are kept until they are complete.
+ * Each PT_LOAD segment is then copied to its physical address (p_paddr) as its
+ * bytes arrive. Sections, symbols and debug information, which follow the
+ * segments in the file, are received but ignored. The part of a segment which
+ * is not in the file (p_memsz - p_filesz, the .bss or .noinit sections) is
+ * zero filled by elf_loader_finish() instead of being transferred.
+ *
+ * The caller gives the memory regions segments may be loaded to. A region
+ * maps a range of physical addresses to the memory it is placed in, which can
+ * differ: the bootloader runs from the TCM, so images linked for the TCM are
+ * placed in the LSRAM, where they are staged for a copy to non-volatile
+ * memory. A segment which is not entirely inside one region, or which would be
+ * placed over the memory of another segment, is rejected.
+ *
+ * The ELF and program headers must be within the first ELF_LOADER_HEADER_SIZE
+ * bytes of the file, which is the case with the GNU linker.
+ */
+#ifndef ELF_LOADER_H_
+#define ELF_LOADER_H_
+
+#include "hal/cpu_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+ * Size of the buffer holding the ELF header and program headers.
+ */
+#ifndef ELF_LOADER_HEADER_SIZE
+#define ELF_LOADER_HEADER_SIZE          512u
+#endif
+
+/*------------------------------------------------------------------------------
+ * Maximum number of PT_LOAD segments.
+ */
+#ifndef ELF_LOADER_MAX_SEGMENTS
+#define ELF_LOADER_MAX_SEGMENTS         8u
+#endif
+
+typedef enum
+{
+    ELF_LOADER_SUCCESS = 0,
+    ELF_LOADER_NOT_ELF,
+    ELF_LOADER_UNSUPPORTED,
+    ELF_LOADER_BAD_ADDRESS,
+    ELF_LOADER_TRUNCATED
+} elf_loader_status_t;
+
+/*------------------------------------------------------------------------------
+ * Memory region segments can be loaded to.
+ * Physical addresses base to base + size - 1 are placed at dest. end is set by
+ * the loader to the offset in the region of the end of the last byte loaded
+ * from the file, zero filled memory excluded. It gives the size of the region
+ * to copy to non-volatile memory.
+ */
+typedef struct
+{
+    uint32_t base;
+    uint32_t size;
+    uint8_t * dest;
+    uint32_t end;
+} elf_loader_region_t;
+
+typedef struct
+{
+    uint32_t offset;
+    uint32_t filesz;
+    uint32_t memsz;
+    uint8_t * dest;
+    elf_loader_region_t * region;
+} elf_loader_segment_t;
+
+/*------------------------------------------------------------------------------
+ * State of a load. Initialised by elf_loader_init().
+ * entry, segment_count, loaded and zeroed are valid once elf_loader_finish()
+ * returned ELF_LOADER_SUCCESS: entry is the entry point of the image (e_entry),
+ * loaded the number of bytes copied from the file and zeroed the number of
+ * bytes zero filled.
+ */
+typedef struct
+{
+    elf_loader_region_t * regions;
+    uint32_t region_count;
+    elf_loader_status_t status;
+    uint32_t position;
+    uint32_t header_end;
+    uint32_t entry;
+    uint32_t segment_count;
+    uint32_t loaded;
+    uint32_t zeroed;
+    elf_loader_segment_t segments[ELF_LOADER_MAX_SEGMENTS];
+    uint8_t header[ELF_LOADER_HEADER_SIZE];
+} elf_loader_t;
+
+/***************************************************************************//**
+ * elf_loader_init() starts loading a new file.
+ *
+ * @param regions
+ *      Memory regions segments can be loaded to. Their end field is cleared.
+ *      The table must remain valid until the load completes.
+ *
+ * @param region_count
+ *      Number of entries in regions.
+ */
+void
+elf_loader_init
+(
+    elf_loader_t * loader,
+    elf_loader_region_t * regions,
+    uint32_t region_count
+);
+
+/***************************************************************************//**
+ * elf_loader_push() passes the next part of the file to the loader.
+ *
+ * @return
+ *      ELF_LOADER_SUCCESS, or the reason why the file cannot be loaded. Once an
+ *      error is returned, it is returned for all later calls, so the transfer
+ *      can be aborted.
+ */
+elf_loader_status_t
+elf_loader_push
+(
+    elf_loader_t * loader,
+    const uint8_t * data,
+    uint32_t length
+);
+
+/***************************************************************************//**
+ * elf_loader_finish() completes the load once the whole file was pushed. It
+ * checks that all segments were received and zero fills the part of each
+ * segment which is not in the file.
+ */
+elf_loader_status_t
+elf_loader_finish
+(
+    elf_loader_t * loader
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ELF_LOADER_H_ */
@@ -0,0 +1,652 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file fw_slots.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief A/B firmware slots in the SPI flash.
+ *
+ * See fw_slots.h for a description of the flash layout and of the update
+ * sequence.
+ */
+#include <string.h>
+#include "hal/hal.h"
+#include "drivers/off_chip/spi_flash/spi_flash.h"
+#include "boot_handoff/boot_handoff.h"
+#include "fw_slots.h"
+
+#define FLASH_SECTOR_SIZE               65536u
+
+/*
+ * Staging RAM and warm boot record. When HAL_HOST_SIMULATION is defined they
+ * are in the host memory mapped at their address, see hal_sim.h.
+ */
+#ifndef HAL_HOST_SIMULATION
+#define STAGING_RAM                     ((uint8_t *)FW_SLOTS_STAGING_ADDR)
+#define WARM_RECORD                     ((fw_slots_warm_t *)FW_SLOTS_WARM_ADDR)
+#else
+#include "hal_sim.h"
+
+#define STAGING_RAM                     ((uint8_t *)HAL_SIM_translate(FW_SLOTS_STAGING_ADDR, \
+                                                                      FW_SLOTS_MAX_IMAGE_SIZE))
+#define WARM_RECORD                     ((fw_slots_warm_t *)HAL_SIM_translate(FW_SLOTS_WARM_ADDR, \
+                                                                              sizeof(fw_slots_warm_t)))
+#endif
+
+/* The descriptor CRC covers every field but itself */
+#define DESC_CRC_LENGTH                 (sizeof(fw_slot_desc_t) - sizeof(uint32_t))
+#define WARM_CRC_LENGTH                 (sizeof(fw_slots_warm_t) - sizeof(uint32_t))
+
+/*
+ * Copy loop started from the staging RAM, see fw_slots_trampoline.S.
+ */
+typedef void (*fw_slots_trampoline_t)(uint32_t dest,
+                                      uint32_t src,
+                                      uint32_t size,
+                                      uint32_t entry);
+
+extern void fw_slots_trampoline(uint32_t dest,
+                                uint32_t src,
+                                uint32_t size,
+                                uint32_t entry);
+extern const uint8_t fw_slots_trampoline_end[];
+
+/*
+ * Nibble lookup table of the reflected CRC-32 polynomial 0xEDB88320. Two table
+ * lookups per byte instead of eight shift and xor steps, for 64 bytes of
+ * table.
+ */
+static const uint32_t g_crc32_nibble[16] =
+{
+    0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu,
+    0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+    0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu,
+    0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu
+};
+
+static const uint32_t g_desc_addr[2] =
+{
+    FW_SLOT_A_DESC_ADDR,
+    FW_SLOT_B_DESC_ADDR
+};
+
+static const uint32_t g_slot_addr[2] =
+{
+    FW_SLOT_A_ADDR,
+    FW_SLOT_B_ADDR
+};
+
+/***************************************************************************//**
+ * fw_slots_crc32()
+ * See "fw_slots.h" for details of how to use this function.
+ */
+uint32_t
+fw_slots_crc32
+(
+    uint32_t crc,
+    const uint8_t * buf,
+    uint32_t length
+)
+{
+    crc = ~crc;
+
+    while (0u != length)
+    {
+        crc ^= *buf;
+        crc = (crc >> 4) ^ g_crc32_nibble[crc & 0x0Fu];
+        crc = (crc >> 4) ^ g_crc32_nibble[crc & 0x0Fu];
+        ++buf;
+        --length;
+    }
+
+    return ~crc;
+}
+
+/*
+ * Erase a 4 KB block, unprotecting its sector first.
+ */
+static fw_slots_status_t
+erase_block
+(
+    uint32_t address
+)
+{
+    if (SPI_FLASH_SUCCESS != spi_flash_control_hw(SPI_FLASH_SECTOR_UNPROTECT,
+                                                  address - (address % FLASH_SECTOR_SIZE),
+                                                  NULL))
+    {
+        return FW_SLOTS_FLASH_ERROR;
+    }
+
+    if (SPI_FLASH_SUCCESS != spi_flash_control_hw(SPI_FLASH_4KBLOCK_ERASE,
+                                                  address,
+                                                  NULL))
+    {
+        return FW_SLOTS_FLASH_ERROR;
+    }
+
+    return FW_SLOTS_SUCCESS;
+}
+
+/*
+ * Write the pending page of the writer. A new erase block is erased when the
+ * first page of the block is written.
+ */
+static fw_slots_status_t
+flush_page
+(
+    fw_slots_writer_t * writer
+)
+{
+    uint32_t address = g_slot_addr[writer->slot] +
+                       (writer->written - writer->page_fill);
+    fw_slots_status_t status;
+
+    if (0u == writer->page_fill)
+    {
+        return FW_SLOTS_SUCCESS;
+    }
+
+    if (0u == (address % FW_SLOTS_ERASE_BLOCK_SIZE))
+    {
+        status = erase_block(address);
+        if (FW_SLOTS_SUCCESS != status)
+        {
+            return status;
+        }
+    }
+
+    if (SPI_FLASH_SUCCESS != spi_flash_write(address,
+                                             writer->page,
+                                             writer->page_fill))
+    {
+        return FW_SLOTS_FLASH_ERROR;
+    }
+
+    writer->page_fill = 0u;
+
+    return FW_SLOTS_SUCCESS;
+}
+
+/*
+ * Sequence comparison which survives the wrap around of the counter.
+ */
+static uint8_t
+is_newer
+(
+    uint32_t sequence,
+    uint32_t reference
+)
+{
+    return ((int32_t)(sequence - reference) > 0) ? 1u : 0u;
+}
+
+/***************************************************************************//**
+ * fw_slots_read_desc()
+ * See "fw_slots.h" for details of how to use this function.
+ */
+uint8_t
+fw_slots_read_desc
+(
+    fw_slot_id_t slot,
+    fw_slot_desc_t * desc
+)
+{
+    HAL_ASSERT((FW_SLOT_A == slot) || (FW_SLOT_B == slot));
+
+    if (SPI_FLASH_SUCCESS != spi_flash_read(g_desc_addr[slot],
+                                            (uint8_t *)desc,
+                                            sizeof(fw_slot_desc_t)))
+    {
+        return 0u;
+    }
+
+    if ((FW_SLOT_DESC_MAGIC != desc->magic) ||
+        (FW_SLOT_DESC_VERSION != desc->version) ||
+        (0u == desc->image_size) ||
+        (desc->image_size > FW_SLOTS_MAX_IMAGE_SIZE) ||
+        (desc->desc_crc != fw_slots_crc32(0u, (const uint8_t *)desc,
+                                          DESC_CRC_LENGTH)))
+    {
+        return 0u;
+    }
+
+    return 1u;
+}
+
+/***************************************************************************//**
+ * fw_slots_active()
+ * See "fw_slots.h" for details of how to use this function.
+ */
+fw_slot_id_t
+fw_slots_active
+(
+    fw_slot_desc_t * desc
+)
+{
+    fw_slot_desc_t desc_a;
+    fw_slot_desc_t desc_b;
+    uint8_t valid_a = fw_slots_read_desc(FW_SLOT_A, &desc_a);
+    uint8_t valid_b = fw_slots_read_desc(FW_SLOT_B, &desc_b);
+    fw_slot_id_t slot = FW_SLOT_NONE;
+
+    if (valid_a && valid_b)
+    {
+        slot = is_newer(desc_b.sequence, desc_a.sequence) ? FW_SLOT_B : FW_SLOT_A;
+    }
+    else if (valid_a)
+    {
+        slot = FW_SLOT_A;
+    }
+    else if (valid_b)
+    {
+        slot = FW_SLOT_B;
+    }
+
+    if ((0 != desc) && (FW_SLOT_NONE != slot))
+    {
+        memcpy(desc, (FW_SLOT_A == slot) ? &desc_a : &desc_b, sizeof(*desc));
+    }
+
+    return slot;
+}
+
+/*
+ * Read an image back from the flash and compare its CRC-32.
+ */
+static fw_slots_status_t
+check_image
+(
+    fw_slot_id_t slot,
+    uint32_t image_size,
+    uint32_t image_crc
+)
+{
+    uint8_t buf[FW_SLOTS_PAGE_SIZE];
+    uint32_t offset;
+    uint32_t chunk;
+    uint32_t crc = 0u;
+
+    for (offset = 0u; offset < image_size; offset += chunk)
+    {
+        chunk = image_size - offset;
+        if (chunk > sizeof(buf))
+        {
+            chunk = sizeof(buf);
+        }
+
+        if (SPI_FLASH_SUCCESS != spi_flash_read(g_slot_addr[slot] + offset,
+                                                buf, chunk))
+        {
+            return FW_SLOTS_FLASH_ERROR;
+        }
+        crc = fw_slots_crc32(crc, buf, chunk);
+    }
+
+    return (crc == image_crc) ? FW_SLOTS_SUCCESS : FW_SLOTS_CRC_ERROR;
+}
+
+/***************************************************************************//**
+ * fw_slots_verify()
+ * See "fw_slots.h" for details of how to use this function.
+ */
+fw_slots_status_t
+fw_slots_verify
+(
+    fw_slot_id_t slot
+)
+{
+    fw_slot_desc_t desc;
+
+    if (!fw_slots_read_desc(slot, &desc))
+    {
+        return FW_SLOTS_NO_VALID_SLOT;
+    }
+
+    return check_image(slot, desc.image_size, desc.image_crc);
+}
+
+/***************************************************************************//**
+ * fw_slots_write_begin()
+ * See "fw_slots.h" for details of how to use this function.
+ */
+fw_slots_status_t
+fw_slots_write_begin
+(
+    fw_slots_writer_t * writer,
+    uint32_t image_size
+)
+{
+    fw_slot_desc_t active_desc;
+    fw_slot_id_t active;
+
+    HAL_ASSERT(0 != writer);
+
+    if ((0u == image_size) || (image_size > FW_SLOTS_MAX_IMAGE_SIZE) ||
+        (image_size > FW_SLOT_SIZE))
+    {
+        return FW_SLOTS_INVALID_SIZE;
+    }
+
+    active = fw_slots_active(&active_desc);
+    if (FW_SLOT_NONE == active)
+    {
+        writer->slot = FW_SLOT_A;
+        writer->sequence = 1u;
+    }
+    else
+    {
+        writer->slot = (FW_SLOT_A == active) ? FW_SLOT_B : FW_SLOT_A;
+        writer->sequence = active_desc.sequence + 1u;
+    }
+
+    writer->image_size = image_size;
+    writer->written = 0u;
+    writer->crc = 0u;
+    writer->page_fill = 0u;
+
+    /* The slot stays unbootable until fw_slots_write_commit() */
+    return erase_block(g_desc_addr[writer->slot]);
+}
+
+/***************************************************************************//**
+ * fw_slots_write()
+ * See "fw_slots.h" for details of how to use this function.
+ */
+fw_slots_status_t
+fw_slots_write
+(
+    fw_slots_writer_t * writer,
+    const uint8_t * data,
+    uint32_t length
+)
+{
+    fw_slots_status_t status;
+    uint32_t chunk;
+
+    HAL_ASSERT(0 != writer);
+
+    if ((FW_SLOT_NONE == writer->slot) ||
+        (length > (writer->image_size - writer->written)))
+    {
+        return FW_SLOTS_WRITE_SEQUENCE_ERROR;
+    }
+
+    writer->crc = fw_slots_crc32(writer->crc, data, length);
+
+    while (0u != length)
+    {
+        chunk = FW_SLOTS_PAGE_SIZE - writer->page_fill;
+        if (chunk > length)
+        {
+            chunk = length;
+        }
+
+        memcpy(&writer->page[writer->page_fill], data, chunk);
+        writer->page_fill += chunk;
+        writer->written += chunk;
+        data += chunk;
+        length -= chunk;
+
+        if (FW_SLOTS_PAGE_SIZE == writer->page_fill)
+        {
+            status = flush_page(writer);
+            if (FW_SLOTS_SUCCESS != status)
+            {
+                return status;
+            }
+        }
+    }
+
+    return FW_SLOTS_SUCCESS;
+}
+
+/***************************************************************************//**
+ * fw_slots_write_commit()
+ * See "fw_slots.h" for details of how to use this function.
+ */
+fw_slots_status_t
+fw_slots_write_commit
+(
+    fw_slots_writer_t * writer
+)
+{
+    fw_slot_desc_t desc;
+    fw_slots_status_t status;
+
+    HAL_ASSERT(0 != writer);
+
+    if ((FW_SLOT_NONE == writer->slot) ||
+        (writer->written != writer->image_size))
+    {
+        return FW_SLOTS_WRITE_SEQUENCE_ERROR;
+    }
+
+    status = flush_page(writer);
+    if (FW_SLOTS_SUCCESS == status)
+    {
+        status = check_image(writer->slot, writer->image_size, writer->crc);
+    }
+    if (FW_SLOTS_SUCCESS != status)
+    {
+        writer->slot = FW_SLOT_NONE;
+        return status;
+    }
+
+    memset(&desc, 0, sizeof(desc));
+    desc.magic = FW_SLOT_DESC_MAGIC;
+    desc.version = FW_SLOT_DESC_VERSION;
+    desc.sequence = writer->sequence;
+    desc.image_size = writer->image_size;
+    desc.image_crc = writer->crc;
+    desc.desc_crc = fw_slots_crc32(0u, (const uint8_t *)&desc,
+                                   DESC_CRC_LENGTH);
+
+    /*
+     * The descriptor block was erased by fw_slots_write_begin(). Writing the
+     * descriptor is the single step which makes the new image bootable.
+     */
+    if (SPI_FLASH_SUCCESS != spi_flash_write(g_desc_addr[writer->slot],
+                                             (uint8_t *)&desc,
+                                             sizeof(desc)))
+    {
+        status = FW_SLOTS_FLASH_ERROR;
+    }
+    else if (!fw_slots_read_desc(writer->slot, &desc))
+    {
+        status = FW_SLOTS_CRC_ERROR;
+    }
+
+    writer->slot = FW_SLOT_NONE;
+
+    return status;
+}
+
+/*
+ * Read the image of a slot into the staging RAM and check it.
+ */
+static fw_slots_status_t
+stage_image
+(
+    fw_slot_id_t slot,
+    const fw_slot_desc_t * desc
+)
+{
+    uint8_t * staging = STAGING_RAM;
+
+    if (SPI_FLASH_SUCCESS != spi_flash_read(g_slot_addr[slot],
+                                            staging,
+                                            desc->image_size))
+    {
+        return FW_SLOTS_FLASH_ERROR;
+    }
+
+    if (desc->image_crc != fw_slots_crc32(0u, staging, desc->image_size))
+    {
+        return FW_SLOTS_CRC_ERROR;
+    }
+
+    return FW_SLOTS_SUCCESS;
+}
+
+/*
+ * Return the slot of the staged copy left by the previous boot if it is still
+ * the active image and still intact, FW_SLOT_NONE otherwise. desc receives the
+ * descriptor of the active slot.
+ */
+static fw_slot_id_t
+warm_slot
+(
+    fw_slot_desc_t * desc
+)
+{
+    const fw_slots_warm_t * warm = WARM_RECORD;
+
+    if ((FW_SLOTS_WARM_MAGIC != warm->magic) ||
+        (warm->record_crc != fw_slots_crc32(0u, (const uint8_t *)warm,
+                                            WARM_CRC_LENGTH)))
+    {
+        return FW_SLOT_NONE;
+    }
+
+    /* A newer image may have been committed since the record was written */
+    if ((warm->slot != (uint32_t)fw_slots_active(desc)) ||
+        (warm->sequence != desc->sequence) ||
+        (warm->image_size != desc->image_size) ||
+        (warm->image_crc != desc->image_crc))
+    {
+        return FW_SLOT_NONE;
+    }
+
+    if (warm->image_crc != fw_slots_crc32(0u,
+                                          STAGING_RAM,
+                                          warm->image_size))
+    {
+        return FW_SLOT_NONE;
+    }
+
+    return (fw_slot_id_t)warm->slot;
+}
+
+/*
+ * Record the staged image for the next warm boot and in the hand-off block, and
+ * start it. The image overwrites the code running now, so the final copy runs
+ * from the staging RAM, after the image.
+ */
+static void
+start_image
+(
+    fw_slot_id_t slot,
+    const fw_slot_desc_t * desc,
+    uint8_t warm_boot
+)
+{
+    fw_slots_warm_t * warm = WARM_RECORD;
+    uint32_t size;
+#ifndef HAL_HOST_SIMULATION
+    uint32_t trampoline_size;
+    uint8_t * trampoline;
+#endif
+
+    warm->magic = FW_SLOTS_WARM_MAGIC;
+    warm->slot = (uint32_t)slot;
+    warm->sequence = desc->sequence;
+    warm->image_size = desc->image_size;
+    warm->image_crc = desc->image_crc;
+    warm->record_crc = fw_slots_crc32(0u, (const uint8_t *)warm, WARM_CRC_LENGTH);
+
+    boot_handoff_image((FW_SLOT_A == slot) ? BOOT_HANDOFF_SOURCE_SLOT_A :
+                                             BOOT_HANDOFF_SOURCE_SLOT_B,
+                       warm_boot, desc->image_size, desc->image_crc);
+    boot_handoff_phase(BOOT_HANDOFF_PHASE_START);
+    boot_handoff_seal();
+
+    size = (desc->image_size + 3u) & ~3u;
+
+#ifndef HAL_HOST_SIMULATION
+    trampoline = (uint8_t *)(FW_SLOTS_STAGING_ADDR + size);
+    trampoline_size = (uint32_t)(fw_slots_trampoline_end -
+                                 (const uint8_t *)&fw_slots_trampoline);
+    memcpy(trampoline, (const void *)&fw_slots_trampoline, trampoline_size);
+
+    HAL_disable_interrupts();
+    __asm__ volatile ("fence.i" ::: "memory");
+
+    ((fw_slots_trampoline_t)trampoline)(FW_SLOTS_EXEC_ADDR,
+                                        FW_SLOTS_STAGING_ADDR,
+                                        size,
+                                        FW_SLOTS_EXEC_ADDR);
+#else
+    /* The host cannot run the copy, the harness provides fw_slots_trampoline() */
+    HAL_disable_interrupts();
+    fw_slots_trampoline(FW_SLOTS_EXEC_ADDR, FW_SLOTS_STAGING_ADDR, size,
+                        FW_SLOTS_EXEC_ADDR);
+#endif
+}
+
+/***************************************************************************//**
+ * fw_slots_boot()
+ * See "fw_slots.h" for details of how to use this function.
+ */
+fw_slots_status_t
+fw_slots_boot
+(
+    void
+)
+{
+    fw_slot_desc_t desc;
+    fw_slot_id_t slot;
+    fw_slot_id_t candidates[2];
+    uint32_t nb_candidates = 0u;
+    uint32_t idx;
+
+    /* Warm reset: the staged copy of the active image is still in RAM */
+    slot = warm_slot(&desc);
+    if (FW_SLOT_NONE != slot)
+    {
+        boot_handoff_phase(BOOT_HANDOFF_PHASE_LOAD);
+        start_image(slot, &desc, 1u);
+    }
+
+    slot = fw_slots_active(0);
+    if (FW_SLOT_NONE == slot)
+    {
+        return FW_SLOTS_NO_VALID_SLOT;
+    }
+
+    /* Newest slot first, then the other one if it is also valid */
+    candidates[nb_candidates++] = slot;
+    slot = (FW_SLOT_A == slot) ? FW_SLOT_B : FW_SLOT_A;
+    if (fw_slots_read_desc(slot, &desc))
+    {
+        candidates[nb_candidates++] = slot;
+    }
+
+    for (idx = 0u; idx < nb_candidates; ++idx)
+    {
+        if ((!fw_slots_read_desc(candidates[idx], &desc)) ||
+            (FW_SLOTS_SUCCESS != stage_image(candidates[idx], &desc)))
+        {
+            continue;
+        }
+
+        boot_handoff_phase(BOOT_HANDOFF_PHASE_LOAD);
+        start_image(candidates[idx], &desc, 0u);
+    }
+
+    return FW_SLOTS_NO_VALID_SLOT;
+}
+
+/***************************************************************************//**
+ * fw_slots_warm_invalidate()
+ * See "fw_slots.h" for details of how to use this function.
+ */
+void
+fw_slots_warm_invalidate
+(
+    void
+)
+{
+    ((volatile fw_slots_warm_t *)WARM_RECORD)->magic = 0u;
+}
@@ -0,0 +1,414 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file hex_parser.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Streaming Intel HEX and Motorola S-record parser.
+ *
+ * See hex_parser.h for details of how to use this module.
+ */
+#include <string.h>
+#include "hex_parser.h"
+
+#define FORMAT_NONE                     0u
+#define FORMAT_INTEL                    ':'
+#define FORMAT_SREC                     'S'
+
+/* S-record type not received yet */
+#define SREC_TYPE_PENDING               0xFFu
+
+#define INTEL_DATA                      0x00u
+#define INTEL_EOF                       0x01u
+#define INTEL_EXT_SEGMENT_ADDR          0x02u
+#define INTEL_START_SEGMENT_ADDR        0x03u
+#define INTEL_EXT_LINEAR_ADDR           0x04u
+#define INTEL_START_LINEAR_ADDR         0x05u
+
+static int32_t
+hex_value
+(
+    uint8_t c
+)
+{
+    if ((c >= '0') && (c <= '9'))
+    {
+        return (int32_t)(c - '0');
+    }
+    if ((c >= 'A') && (c <= 'F'))
+    {
+        return (int32_t)(c - 'A' + 10);
+    }
+    if ((c >= 'a') && (c <= 'f'))
+    {
+        return (int32_t)(c - 'a' + 10);
+    }
+
+    return -1;
+}
+
+static uint32_t
+read_be
+(
+    const uint8_t * p,
+    uint32_t length
+)
+{
+    uint32_t value = 0u;
+
+    while (0u != length)
+    {
+        value = (value << 8) | *p++;
+        --length;
+    }
+
+    return value;
+}
+
+/*
+ * Pass the page buffer to the write function.
+ */
+static void
+flush_page
+(
+    hex_parser_t * parser
+)
+{
+    if (0u != parser->page_fill)
+    {
+        if (0 != parser->write(parser->context, parser->page_addr,
+                               parser->page, parser->page_fill))
+        {
+            parser->status = HEX_PARSER_WRITE_ERROR;
+        }
+        ++parser->writes;
+        parser->page_fill = 0u;
+    }
+}
+
+/*
+ * Add the data of a record to the page buffer. The buffer is written when the
+ * data does not follow on from it, and when it reaches a page boundary.
+ */
+static void
+add_data
+(
+    hex_parser_t * parser,
+    uint32_t address,
+    const uint8_t * data,
+    uint32_t length
+)
+{
+    uint32_t room;
+    uint32_t count;
+
+    parser->bytes += length;
+
+    while ((HEX_PARSER_SUCCESS == parser->status) && (0u != length))
+    {
+        if ((0u != parser->page_fill) &&
+            (address != (parser->page_addr + parser->page_fill)))
+        {
+            flush_page(parser);
+        }
+
+        if (0u == parser->page_fill)
+        {
+            parser->page_addr = address;
+        }
+
+        room = HEX_PARSER_PAGE_SIZE - (address & (HEX_PARSER_PAGE_SIZE - 1u));
+        count = (length < room) ? length : room;
+
+        memcpy(&parser->page[parser->page_fill], data, count);
+        parser->page_fill += count;
+        address += count;
+        data += count;
+        length -= count;
+
+        if (0u == (address & (HEX_PARSER_PAGE_SIZE - 1u)))
+        {
+            flush_page(parser);
+        }
+    }
+}
+
+static void
+end_of_file
+(
+    hex_parser_t * parser
+)
+{
+    flush_page(parser);
+
+    if (HEX_PARSER_SUCCESS == parser->status)
+    {
+        parser->status = HEX_PARSER_DONE;
+    }
+}
+
+/*
+ * Intel HEX record: byte count, 16 bit address, type, data, checksum.
+ */
+static void
+intel_record
+(
+    hex_parser_t * parser
+)
+{
+    const uint8_t * rec = parser->record;
+    uint32_t length = rec[0];
+
+    switch (rec[3])
+    {
+    case INTEL_DATA:
+        add_data(parser, parser->upper + read_be(&rec[1], 2u), &rec[4], length);
+        break;
+
+    case INTEL_EOF:
+        end_of_file(parser);
+        break;
+
+    case INTEL_EXT_SEGMENT_ADDR:
+    case INTEL_EXT_LINEAR_ADDR:
+        if (2u != length)
+        {
+            parser->status = HEX_PARSER_SYNTAX_ERROR;
+        }
+        else
+        {
+            parser->upper = read_be(&rec[4], 2u) <<
+                            ((INTEL_EXT_LINEAR_ADDR == rec[3]) ? 16 : 4);
+        }
+        break;
+
+    case INTEL_START_SEGMENT_ADDR:
+    case INTEL_START_LINEAR_ADDR:
+        if (4u != length)
+        {
+            parser->status = HEX_PARSER_SYNTAX_ERROR;
+        }
+        else
+        {
+            parser->entry = (INTEL_START_LINEAR_ADDR == rec[3]) ?
+                            read_be(&rec[4], 4u) :
+                            ((read_be(&rec[4], 2u) << 4) + read_be(&rec[6], 2u));
+            parser->has_entry = 1u;
+        }
+        break;
+
+    default:
+        parser->status = HEX_PARSER_SYNTAX_ERROR;
+        break;
+    }
+}
+
+/*
+ * S-record: byte count, 2, 3 or 4 address bytes, data, checksum. The byte
+ * count includes the address and the checksum.
+ */
+static void
+srec_record
+(
+    hex_parser_t * parser
+)
+{
+    static const uint8_t address_size[10] = { 2u, 2u, 3u, 4u, 0u, 2u, 3u, 4u, 3u, 2u };
+    const uint8_t * rec = parser->record;
+    uint32_t addr_len = address_size[parser->srec_type];
+
+    if ((0u == addr_len) || (rec[0] < (addr_len + 1u)))
+    {
+        parser->status = HEX_PARSER_SYNTAX_ERROR;
+        return;
+    }
+
+    switch (parser->srec_type)
+    {
+    case 1u:
+    case 2u:
+    case 3u:
+        add_data(parser, read_be(&rec[1], addr_len), &rec[1u + addr_len],
+                 rec[0] - addr_len - 1u);
+        break;
+
+    case 7u:
+    case 8u:
+    case 9u:
+        parser->entry = read_be(&rec[1], addr_len);
+        parser->has_entry = 1u;
+        end_of_file(parser);
+        break;
+
+    default:
+        /* S0 header and S5, S6 record counts */
+        break;
+    }
+}
+
+/*
+ * Check the checksum of a complete record and decode it.
+ */
+static void
+end_of_record
+(
+    hex_parser_t * parser
+)
+{
+    uint32_t sum = 0u;
+    uint32_t idx;
+
+    for (idx = 0u; idx < parser->count; ++idx)
+    {
+        sum += parser->record[idx];
+    }
+
+    /* Intel HEX: two's complement, S-record: ones' complement of the sum */
+    if (((FORMAT_INTEL == parser->format) && (0u != (sum & 0xFFu))) ||
+        ((FORMAT_SREC == parser->format) && (0xFFu != (sum & 0xFFu))))
+    {
+        parser->status = HEX_PARSER_CHECKSUM_ERROR;
+    }
+    else
+    {
+        ++parser->records;
+        if (FORMAT_INTEL == parser->format)
+        {
+            intel_record(parser);
+        }
+        else
+        {
+            srec_record(parser);
+        }
+    }
+
+    parser->format = FORMAT_NONE;
+}
+
+/***************************************************************************//**
+ * hex_parser_init()
+ * See "hex_parser.h" for details of how to use this function.
+ */
+void
+hex_parser_init
+(
+    hex_parser_t * parser,
+    hex_parser_write_t write,
+    void * context
+)
+{
+    parser->write = write;
+    parser->context = context;
+    parser->status = HEX_PARSER_SUCCESS;
+    parser->format = FORMAT_NONE;
+    parser->has_entry = 0u;
+    parser->upper = 0u;
+    parser->records = 0u;
+    parser->bytes = 0u;
+    parser->writes = 0u;
+    parser->entry = 0u;
+    parser->page_fill = 0u;
+}
+
+/***************************************************************************//**
+ * hex_parser_push()
+ * See "hex_parser.h" for details of how to use this function.
+ */
+hex_parser_status_t
+hex_parser_push
+(
+    hex_parser_t * parser,
+    const uint8_t * data,
+    uint32_t length
+)
+{
+    uint8_t c;
+    int32_t value;
+    uint32_t total;
+
+    while ((HEX_PARSER_SUCCESS == parser->status) && (0u != length))
+    {
+        c = *data++;
+        --length;
+
+        if (FORMAT_NONE == parser->format)
+        {
+            if ((FORMAT_INTEL == c) || (FORMAT_SREC == c))
+            {
+                parser->format = c;
+                parser->srec_type = SREC_TYPE_PENDING;
+                parser->nibble = 0u;
+                parser->count = 0u;
+            }
+            else if ((c > ' ') && (0x1Au != c))
+            {
+                /* Not white space or end of file padding */
+                parser->status = HEX_PARSER_SYNTAX_ERROR;
+            }
+            continue;
+        }
+
+        if ((FORMAT_SREC == parser->format) && (SREC_TYPE_PENDING == parser->srec_type))
+        {
+            if ((c < '0') || (c > '9'))
+            {
+                parser->status = HEX_PARSER_SYNTAX_ERROR;
+            }
+            parser->srec_type = (uint8_t)(c - '0');
+            continue;
+        }
+
+        value = hex_value(c);
+        if ((value < 0) || (parser->count >= HEX_PARSER_MAX_RECORD))
+        {
+            parser->status = HEX_PARSER_SYNTAX_ERROR;
+            continue;
+        }
+
+        if (0u == parser->nibble)
+        {
+            parser->record[parser->count] = (uint8_t)(value << 4);
+            parser->nibble = 1u;
+            continue;
+        }
+
+        parser->record[parser->count] |= (uint8_t)value;
+        parser->nibble = 0u;
+        ++parser->count;
+
+        total = (FORMAT_INTEL == parser->format) ?
+                (parser->record[0] + 5u) : (parser->record[0] + 1u);
+        if (parser->count == total)
+        {
+            end_of_record(parser);
+        }
+    }
+
+    return parser->status;
+}
+
+/***************************************************************************//**
+ * hex_parser_finish()
+ * See "hex_parser.h" for details of how to use this function.
+ */
+hex_parser_status_t
+hex_parser_finish
+(
+    hex_parser_t * parser
+)
+{
+    if (HEX_PARSER_SUCCESS == parser->status)
+    {
+        if (FORMAT_NONE != parser->format)
+        {
+            parser->status = HEX_PARSER_SYNTAX_ERROR;
+        }
+        else
+        {
+            end_of_file(parser);
+        }
+    }
+
+    return parser->status;
+}
@@ -0,0 +1,144 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file hex_parser.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Streaming Intel HEX and Motorola S-record parser.
+ *
+ * Decodes an Intel HEX or S-record file passed to hex_parser_push() in chunks
+ * of any size, as it is received from the UART or through YMODEM. The format is
+ * recognised from the first character of each record, ':' or 'S'. Line ends
+ * and other white space between records are ignored.
+ *
+ * The checksum of each record is checked before its data is used. The data of
+ * contiguous records is gathered into a page buffer and passed to the write
+ * function of the caller in one call per page, so that a SPI flash or EEPROM
+ * page is programmed once. A write never crosses a HEX_PARSER_PAGE_SIZE
+ * boundary. Address gaps between records are skipped: the image is never
+ * expanded to a full binary and nothing is written to the gaps.
+ *
+ * Supported records:
+ *  - Intel HEX: data (00), end of file (01), extended segment address (02),
+ *    start segment address (03), extended linear address (04) and start
+ *    linear address (05).
+ *  - S-record: header (S0), data (S1, S2, S3), count (S5, S6) and termination
+ *    (S7, S8, S9).
+ */
+#ifndef HEX_PARSER_H_
+#define HEX_PARSER_H_
+
+#include "hal/cpu_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+ * Size and alignment of the writes, a power of two. 256 bytes is the page size
+ * of the SPI flash and of the MikroBus EEPROM.
+ */
+#ifndef HEX_PARSER_PAGE_SIZE
+#define HEX_PARSER_PAGE_SIZE            256u
+#endif
+
+/* Longest record: byte count, 2 address bytes, type, 255 data bytes, checksum */
+#define HEX_PARSER_MAX_RECORD           260u
+
+typedef enum
+{
+    HEX_PARSER_SUCCESS = 0,
+    HEX_PARSER_DONE,
+    HEX_PARSER_SYNTAX_ERROR,
+    HEX_PARSER_CHECKSUM_ERROR,
+    HEX_PARSER_WRITE_ERROR
+} hex_parser_status_t;
+
+/*------------------------------------------------------------------------------
+ * Write function of the caller. Programs length bytes of data at address, the
+ * address given by the records. Returns 0 on success, any other value stops
+ * the parser with HEX_PARSER_WRITE_ERROR.
+ */
+typedef int32_t (*hex_parser_write_t)(void * context,
+                                      uint32_t address,
+                                      const uint8_t * data,
+                                      uint32_t length);
+
+/*------------------------------------------------------------------------------
+ * State of a parse. Initialised by hex_parser_init().
+ * records, bytes and writes count the records decoded, the data bytes and the
+ * calls to the write function. entry is the start address given by the file,
+ * valid when has_entry is 1.
+ */
+typedef struct
+{
+    hex_parser_write_t write;
+    void * context;
+    hex_parser_status_t status;
+    uint8_t format;
+    uint8_t srec_type;
+    uint8_t nibble;
+    uint8_t has_entry;
+    uint32_t count;
+    uint32_t upper;
+    uint32_t records;
+    uint32_t bytes;
+    uint32_t writes;
+    uint32_t entry;
+    uint32_t page_addr;
+    uint32_t page_fill;
+    uint8_t page[HEX_PARSER_PAGE_SIZE];
+    uint8_t record[HEX_PARSER_MAX_RECORD];
+} hex_parser_t;
+
+/***************************************************************************//**
+ * hex_parser_init() starts parsing a new file.
+ *
+ * @param write
+ *      Function called to program the data of the file.
+ *
+ * @param context
+ *      Passed to write.
+ */
+void
+hex_parser_init
+(
+    hex_parser_t * parser,
+    hex_parser_write_t write,
+    void * context
+);
+
+/***************************************************************************//**
+ * hex_parser_push() passes the next characters of the file to the parser.
+ *
+ * @return
+ *      HEX_PARSER_SUCCESS while more records are expected, HEX_PARSER_DONE
+ *      once the end of file or termination record was decoded and all the
+ *      data written, or the error which stopped the parser. Characters pushed
+ *      after the end of the file are ignored.
+ */
+hex_parser_status_t
+hex_parser_push
+(
+    hex_parser_t * parser,
+    const uint8_t * data,
+    uint32_t length
+);
+
+/***************************************************************************//**
+ * hex_parser_finish() writes the data still held in the page buffer, for a
+ * file which ends without an end of file or termination record. Returns
+ * HEX_PARSER_SYNTAX_ERROR if the file ends in the middle of a record.
+ */
+hex_parser_status_t
+hex_parser_finish
+(
+    hex_parser_t * parser
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEX_PARSER_H_ */
@@ -0,0 +1,229 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file i2c_sched.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Periodic acquisition of I2C sensors from a timer interrupt.
+ *
+ * See i2c_sched.h for details of how to use this module.
+ */
+#include <stddef.h>
+#include "hal/hal.h"
+#include "miv_rv32_hal/miv_rv32_deadline.h"
+#include "i2c_sched.h"
+
+/*
+ * Start the read of the first due sensor, if any. Called from the timer and
+ * the MIV_I2C interrupts only, with the bus idle.
+ */
+static void
+start_next
+(
+    i2c_sched_t * sched
+)
+{
+    i2c_sched_sensor_t * sensor = sched->sensors;
+    uint32_t sample;
+
+    while ((NULL != sensor) && (0u == sensor->due))
+    {
+        sensor = sensor->next;
+    }
+
+    if (NULL == sensor)
+    {
+        return;
+    }
+
+    sensor->due = 0u;
+    sched->active = sensor;
+
+    /* From here the buffer of sample - 2 is overwritten */
+    sample = sensor->published + 1u;
+    sensor->reading = sample;
+    sensor->timestamp[sample & 1u] = DEADLINE_READ_MTIME();
+
+    MIV_I2C_write_read(sched->i2c,
+                       sensor->target_addr,
+                       &sensor->reg[2u - sensor->reg_size],
+                       sensor->reg_size,
+                       &sensor->buffer[sample & 1u][1],
+                       sensor->length,
+                       MIV_I2C_RELEASE_BUS,
+                       MIV_I2C_ACK_POLLING_DISABLE);
+}
+
+/*
+ * Transfer completion handler, called by MIV_I2C_isr().
+ */
+static void
+transfer_done
+(
+    miv_i2c_instance_t * this_i2c,
+    miv_i2c_status_t status
+)
+{
+    i2c_sched_t * sched = (i2c_sched_t *)this_i2c->p_user_data;
+    i2c_sched_sensor_t * sensor = sched->active;
+
+    if (NULL != sensor)
+    {
+        if (MIV_I2C_SUCCESS == status)
+        {
+            sensor->published = sensor->reading;
+        }
+        else
+        {
+            ++sensor->errors;
+        }
+        sched->active = NULL;
+    }
+
+    start_next(sched);
+}
+
+/***************************************************************************//**
+ * See i2c_sched.h for details of how to use this function.
+ */
+void
+i2c_sched_init
+(
+    i2c_sched_t * sched,
+    miv_i2c_instance_t * i2c,
+    uint32_t tick_ms
+)
+{
+    sched->i2c = i2c;
+    sched->tick_ms = (0u == tick_ms) ? 1u : tick_ms;
+    sched->sensors = NULL;
+    sched->active = NULL;
+
+    i2c->p_user_data = sched;
+    MIV_I2C_register_transfer_completion_handler(i2c, transfer_done);
+}
+
+/***************************************************************************//**
+ * See i2c_sched.h for details of how to use this function.
+ */
+i2c_sched_status_t
+i2c_sched_add_sensor
+(
+    i2c_sched_t * sched,
+    i2c_sched_sensor_t * sensor,
+    uint8_t target_addr,
+    uint16_t reg,
+    uint8_t reg_size,
+    uint8_t length,
+    uint32_t period_ms
+)
+{
+    i2c_sched_sensor_t ** link;
+    psr_t saved_psr;
+
+    if ((NULL == sched) || (NULL == sensor) ||
+        (reg_size < 1u) || (reg_size > 2u) ||
+        (length < 1u) || (length > I2C_SCHED_MAX_LENGTH))
+    {
+        return I2C_SCHED_INVALID_ARGUMENTS;
+    }
+
+    sensor->target_addr = target_addr;
+    sensor->reg[0] = (uint8_t)(reg >> 8);
+    sensor->reg[1] = (uint8_t)reg;
+    sensor->reg_size = reg_size;
+    sensor->length = length;
+    sensor->period = (period_ms + sched->tick_ms - 1u) / sched->tick_ms;
+    if (0u == sensor->period)
+    {
+        sensor->period = 1u;
+    }
+    sensor->countdown = 1u;
+    sensor->due = 0u;
+    sensor->next = NULL;
+    sensor->published = 0u;
+    sensor->reading = 0u;
+    sensor->errors = 0u;
+    sensor->overruns = 0u;
+
+    saved_psr = HAL_disable_interrupts();
+    link = &sched->sensors;
+    while (NULL != *link)
+    {
+        link = &(*link)->next;
+    }
+    *link = sensor;
+    HAL_restore_interrupts(saved_psr);
+
+    return I2C_SCHED_SUCCESS;
+}
+
+/***************************************************************************//**
+ * See i2c_sched.h for details of how to use this function.
+ */
+void
+i2c_sched_tick
+(
+    i2c_sched_t * sched
+)
+{
+    i2c_sched_sensor_t * sensor;
+
+    for (sensor = sched->sensors; NULL != sensor; sensor = sensor->next)
+    {
+        if (0u == --sensor->countdown)
+        {
+            sensor->countdown = sensor->period;
+            if (0u != sensor->due)
+            {
+                ++sensor->overruns;
+            }
+            sensor->due = 1u;
+        }
+    }
+
+    if (NULL == sched->active)
+    {
+        start_next(sched);
+    }
+}
+
+/***************************************************************************//**
+ * See i2c_sched.h for details of how to use this function.
+ */
+uint32_t
+i2c_sched_read
+(
+    const i2c_sched_sensor_t * sensor,
+    uint8_t * data,
+    uint64_t * timestamp
+)
+{
+    const volatile uint8_t * sample_data;
+    uint32_t sample;
+    uint8_t idx;
+
+    do
+    {
+        sample = sensor->published;
+        if (0u == sample)
+        {
+            return 0u;
+        }
+
+        sample_data = &sensor->buffer[sample & 1u][1];
+        for (idx = 0u; idx < sensor->length; ++idx)
+        {
+            data[idx] = sample_data[idx];
+        }
+        if (NULL != timestamp)
+        {
+            *timestamp = *(const volatile uint64_t *)&sensor->timestamp[sample & 1u];
+        }
+
+        /* The buffer is reused by the read of sample + 2 */
+    } while ((sensor->reading - sample) >= 2u);
+
+    return sample;
+}
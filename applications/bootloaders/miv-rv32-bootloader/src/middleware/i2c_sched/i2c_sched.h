@@ -0,0 +1,184 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file i2c_sched.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Periodic acquisition of I2C sensors from a timer interrupt.
+ *
+ * Each sensor is registered once with its target address, the register to
+ * read, the number of bytes and the sampling period. i2c_sched_tick(), called
+ * from a periodic timer interrupt, counts down the period of every sensor and
+ * starts the reads which are due with MIV_I2C_write_read(). Each read which
+ * completes starts the next due one from the MIV_I2C interrupt, through the
+ * driver's transfer completion handler, so the reads of a tick run back to
+ * back without the main loop. A sample is taken at most the duration of the
+ * reads registered before it after its tick, whatever the main loop is doing.
+ *
+ * Every sensor has two sample buffers. A read fills the buffer which does not
+ * hold the last sample, and that buffer becomes the last sample only once the
+ * read succeeded. i2c_sched_read() copies the last sample without disabling
+ * interrupts; it copies it again in the rare case the next read started to
+ * overwrite it meanwhile, which needs a sample period shorter than the copy.
+ *
+ * The MIV_I2C is dedicated to the scheduler once i2c_sched_init() is called:
+ * it uses the transfer completion handler and the p_user_data member of the
+ * instance, and the application must not start transactions of its own.
+ *
+ *      static i2c_sched_t g_sched;
+ *      static i2c_sched_sensor_t g_temperature;
+ *
+ *      i2c_sched_init(&g_sched, &g_miv_i2c_inst, 1u);
+ *      i2c_sched_add_sensor(&g_sched, &g_temperature, 0x48u, 0x0000u, 1u, 2u, 100u);
+ *      MRV_systick_config(SYS_CLK_FREQ / 1000u);
+ *
+ *      void SysTick_Handler(void)
+ *      {
+ *          i2c_sched_tick(&g_sched);
+ *      }
+ *
+ *      if (i2c_sched_read(&g_temperature, data, &timestamp) != last_sample) ...
+ */
+#ifndef I2C_SCHED_H_
+#define I2C_SCHED_H_
+
+#include <stdint.h>
+#include "drivers/fabric_ip/miv_i2c/miv_i2c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+ * Largest sample, in bytes.
+ */
+#ifndef I2C_SCHED_MAX_LENGTH
+#define I2C_SCHED_MAX_LENGTH            16u
+#endif
+
+typedef enum
+{
+    I2C_SCHED_SUCCESS = 0,
+    I2C_SCHED_INVALID_ARGUMENTS
+} i2c_sched_status_t;
+
+/*------------------------------------------------------------------------------
+ * Sensor, see i2c_sched_add_sensor(). The members are private to i2c_sched.c
+ * apart from the statistics, which may be read at any time.
+ */
+typedef struct i2c_sched_sensor i2c_sched_sensor_t;
+
+struct i2c_sched_sensor
+{
+    uint8_t                     target_addr;
+    uint8_t                     reg[2];     /* Most significant byte first */
+    uint8_t                     reg_size;
+    uint8_t                     length;
+    uint32_t                    period;     /* In ticks */
+
+    uint32_t                    countdown;  /* Ticks until the next sample is due */
+    uint8_t                     due;
+    i2c_sched_sensor_t *        next;
+
+    /*
+     * Sample n is in buffer[n & 1], after a spare byte which receives the byte
+     * read with the address acknowledge, see MIV_I2C_write_read().
+     */
+    uint8_t                     buffer[2][1u + I2C_SCHED_MAX_LENGTH];
+    uint64_t                    timestamp[2];   /* MTIME at the start of the read */
+    volatile uint32_t           published;  /* Number of the last sample */
+    volatile uint32_t           reading;    /* Number of the sample being read */
+
+    /* Statistics */
+    uint32_t                    errors;     /* Reads not acknowledged */
+    uint32_t                    overruns;   /* Samples skipped, the previous one
+                                               was still waiting for the bus */
+};
+
+/*------------------------------------------------------------------------------
+ * Scheduler of the sensors of a MIV_I2C.
+ */
+typedef struct
+{
+    miv_i2c_instance_t *        i2c;
+    uint32_t                    tick_ms;
+    i2c_sched_sensor_t *        sensors;    /* In the order they were added */
+    i2c_sched_sensor_t *        active;     /* Sensor being read, NULL if none */
+} i2c_sched_t;
+
+/***************************************************************************//**
+ * i2c_sched_init() initializes a scheduler for the MIV_I2C i2c, initialized
+ * and configured beforehand, with a tick every tick_ms milliseconds.
+ */
+void
+i2c_sched_init
+(
+    i2c_sched_t * sched,
+    miv_i2c_instance_t * i2c,
+    uint32_t tick_ms
+);
+
+/***************************************************************************//**
+ * i2c_sched_add_sensor() registers a sensor read every period_ms milliseconds,
+ * rounded up to a multiple of the tick. The first sample is taken at the next
+ * tick. When several reads are due at the same tick they run in the order the
+ * sensors were added, so add the sensors which need the least jitter first.
+ *
+ * @param reg
+ *      Register to read, sent before the read as reg_size bytes, 1 or 2, most
+ *      significant byte first.
+ *
+ * @param length
+ *      Bytes per sample, from 1 to I2C_SCHED_MAX_LENGTH.
+ *
+ * @return
+ *      I2C_SCHED_SUCCESS or I2C_SCHED_INVALID_ARGUMENTS.
+ */
+i2c_sched_status_t
+i2c_sched_add_sensor
+(
+    i2c_sched_t * sched,
+    i2c_sched_sensor_t * sensor,
+    uint8_t target_addr,
+    uint16_t reg,
+    uint8_t reg_size,
+    uint8_t length,
+    uint32_t period_ms
+);
+
+/***************************************************************************//**
+ * i2c_sched_tick() starts the reads which are due. Call it from the interrupt
+ * handler of a timer which fires every tick_ms milliseconds, such as
+ * SysTick_Handler() after MRV_systick_config(). It must not be interrupted by
+ * the MIV_I2C interrupt, which is the case on the Mi-V as interrupts do not
+ * nest.
+ */
+void
+i2c_sched_tick
+(
+    i2c_sched_t * sched
+);
+
+/***************************************************************************//**
+ * i2c_sched_read() copies the last sample of sensor, length bytes, to data and
+ * its MTIME timestamp to timestamp, which may be NULL. It never waits for the
+ * bus and can be called from the main loop at any time.
+ *
+ * @return
+ *      Number of the sample, incremented by each successful read, or 0 if
+ *      there is no sample yet, in which case nothing is copied.
+ */
+uint32_t
+i2c_sched_read
+(
+    const i2c_sched_sensor_t * sensor,
+    uint8_t * data,
+    uint64_t * timestamp
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* I2C_SCHED_H_ */
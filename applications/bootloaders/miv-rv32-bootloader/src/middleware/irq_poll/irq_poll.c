@@ -0,0 +1,178 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file irq_poll.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Hybrid interrupt and polling service of busy peripherals.
+ *
+ * See irq_poll.h for details of how to use this module.
+ */
+#include <stddef.h>
+#include "hal/hal.h"
+#include "irq_poll.h"
+
+/*
+ * Append poll to the back of list. Called with interrupts disabled.
+ */
+static void
+append
+(
+    irq_poll_list_t * list,
+    irq_poll_t * poll
+)
+{
+    poll->next = NULL;
+    if (NULL == list->head)
+    {
+        list->head = poll;
+    }
+    else
+    {
+        list->tail->next = poll;
+    }
+    list->tail = poll;
+}
+
+/***************************************************************************//**
+ * See irq_poll.h for details of how to use this function.
+ */
+void
+irq_poll_list_init
+(
+    irq_poll_list_t * list,
+    void (*wakeup)(irq_poll_list_t * list),
+    void * context
+)
+{
+    list->head = NULL;
+    list->tail = NULL;
+    list->wakeup = wakeup;
+    list->context = context;
+}
+
+/***************************************************************************//**
+ * See irq_poll.h for details of how to use this function.
+ */
+void
+irq_poll_init
+(
+    irq_poll_t * poll,
+    irq_poll_list_t * list,
+    irq_poll_fn_t poll_fn,
+    irq_poll_set_irq_t set_irq,
+    void * context,
+    uint32_t budget
+)
+{
+    poll->list = list;
+    poll->poll = poll_fn;
+    poll->set_irq = set_irq;
+    poll->context = context;
+    poll->budget = (0u == budget) ? 1u : budget;
+    poll->scheduled = 0u;
+    poll->next = NULL;
+    poll->irqs = 0u;
+    poll->polls = 0u;
+    poll->items = 0u;
+    poll->exhausted = 0u;
+}
+
+/***************************************************************************//**
+ * See irq_poll.h for details of how to use this function.
+ */
+void
+irq_poll_schedule
+(
+    irq_poll_t * poll
+)
+{
+    irq_poll_list_t * list = poll->list;
+    uint8_t was_empty;
+    psr_t saved_psr;
+
+    poll->set_irq(poll, 0u);
+    ++poll->irqs;
+
+    saved_psr = HAL_disable_interrupts();
+    if (0u != poll->scheduled)
+    {
+        /* Taken before the interrupt was masked */
+        HAL_restore_interrupts(saved_psr);
+        return;
+    }
+    was_empty = (NULL == list->head) ? 1u : 0u;
+    poll->scheduled = 1u;
+    append(list, poll);
+    HAL_restore_interrupts(saved_psr);
+
+    if ((0u != was_empty) && (NULL != list->wakeup))
+    {
+        list->wakeup(list);
+    }
+}
+
+/***************************************************************************//**
+ * See irq_poll.h for details of how to use this function.
+ */
+uint8_t
+irq_poll_run
+(
+    irq_poll_list_t * list
+)
+{
+    irq_poll_t * poll;
+    irq_poll_t * last;
+    uint32_t items;
+    psr_t saved_psr;
+
+    /* Peripherals scheduled while the list runs wait for the next call */
+    saved_psr = HAL_disable_interrupts();
+    last = list->tail;
+    HAL_restore_interrupts(saved_psr);
+
+    while (NULL != last)
+    {
+        saved_psr = HAL_disable_interrupts();
+        poll = list->head;
+        list->head = poll->next;
+        if (NULL == list->head)
+        {
+            list->tail = NULL;
+        }
+        HAL_restore_interrupts(saved_psr);
+
+        items = poll->poll(poll, poll->budget);
+        ++poll->polls;
+        poll->items += items;
+        if (items >= poll->budget)
+        {
+            ++poll->exhausted;
+        }
+
+        saved_psr = HAL_disable_interrupts();
+        if (0u == items)
+        {
+            poll->scheduled = 0u;
+        }
+        else
+        {
+            append(list, poll);
+        }
+        HAL_restore_interrupts(saved_psr);
+
+        if (0u == items)
+        {
+            /* Idle, the next item interrupts */
+            poll->set_irq(poll, 1u);
+        }
+
+        if (poll == last)
+        {
+            last = NULL;
+        }
+    }
+
+    return (NULL != list->head) ? 1u : 0u;
+}
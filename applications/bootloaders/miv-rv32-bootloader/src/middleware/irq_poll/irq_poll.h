@@ -0,0 +1,203 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file irq_poll.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Hybrid interrupt and polling service of busy peripherals.
+ *
+ * A peripheral which interrupts for every frame, character or edge costs a
+ * full trap entry and exit, in miv_rv32_entry.S, for each of them. Under a
+ * burst of traffic the processor spends more time saving and restoring
+ * registers than moving data. With irq_poll, the interrupt handler of the
+ * peripheral only calls irq_poll_schedule(), which masks the interrupt of the
+ * peripheral and schedules its poll function. irq_poll_run(), called from the
+ * main loop or from a task, then calls the poll function of each scheduled
+ * peripheral, which services it as its interrupt handler would and returns
+ * the number of items it handled:
+ *  - as long as the poll function finds items, the peripheral stays
+ *    scheduled and no interrupt is taken, however fast the items arrive,
+ *  - once it finds none, the interrupt is unmasked and the next item
+ *    interrupts again.
+ *
+ * Each call to the poll function is given a budget, the number of items it
+ * should handle at most, so that a busy peripheral does not starve the others
+ * scheduled on the same list. At low load an interrupt is followed by one
+ * poll which handles the item and one which finds nothing, so the latency is
+ * that of the main loop, as with a handler which only sets a flag.
+ *
+ * The poll function must check the peripheral itself, it is not told which
+ * events occurred. The interrupt must be level sensitive, as those of
+ * CoreSPI, MIV_I2C and the MIV_ESS peripherals are, so that an item which
+ * arrives between the last poll and the unmasking interrupts as soon as it
+ * is unmasked.
+ *
+ * How the interrupt is masked is up to the set_irq function given to
+ * irq_poll_init(): the interrupt enable bits of the peripheral, its MIE bit
+ * with MRV_disable_local_irq() and MRV_enable_local_irq(), or its PLIC enable
+ * with MRV_PLIC_disable_irq() and MRV_PLIC_enable_irq().
+ *
+ *      static uint32_t spi_slave_poll(irq_poll_t * poll, uint32_t budget)
+ *      {
+ *          uint32_t frames = g_spi_slave.stream_stats.rx_frames;
+ *
+ *          SPI_isr(&g_spi_slave);
+ *          return g_spi_slave.stream_stats.rx_frames - frames;
+ *      }
+ *
+ *      static void spi_slave_set_irq(irq_poll_t * poll, uint8_t enable)
+ *      {
+ *          if (enable)
+ *          {
+ *              MRV_enable_local_irq(MRV32_MSYS_EIE2_IRQn);
+ *          }
+ *          else
+ *          {
+ *              MRV_disable_local_irq(MRV32_MSYS_EIE2_IRQn);
+ *          }
+ *      }
+ *
+ *      void MSYS_EI2_IRQHandler(void)
+ *      {
+ *          irq_poll_schedule(&g_spi_slave_poll);
+ *      }
+ *
+ *      irq_poll_init(&g_spi_slave_poll, &g_poll_list, spi_slave_poll,
+ *                    spi_slave_set_irq, NULL, 64u);
+ *
+ *      for (;;)
+ *      {
+ *          irq_poll_run(&g_poll_list);
+ *          ...
+ *      }
+ */
+#ifndef IRQ_POLL_H_
+#define IRQ_POLL_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct irq_poll irq_poll_t;
+typedef struct irq_poll_list irq_poll_list_t;
+
+/*------------------------------------------------------------------------------
+ * Services the peripheral of poll, handling at most about budget items, and
+ * returns the number of items handled, 0 if the peripheral is idle.
+ */
+typedef uint32_t (*irq_poll_fn_t)(irq_poll_t * poll, uint32_t budget);
+
+/*------------------------------------------------------------------------------
+ * Masks the interrupt of the peripheral of poll when enable is 0, unmasks it
+ * otherwise. Called from the interrupt handler and from irq_poll_run().
+ */
+typedef void (*irq_poll_set_irq_t)(irq_poll_t * poll, uint8_t enable);
+
+/*------------------------------------------------------------------------------
+ * Peripheral serviced by polling while it is busy, see irq_poll_init(). The
+ * members are private to irq_poll.c apart from the statistics, which may be
+ * read at any time.
+ */
+struct irq_poll
+{
+    irq_poll_list_t *           list;
+    irq_poll_fn_t               poll;
+    irq_poll_set_irq_t          set_irq;
+    void *                      context;    /* For the poll and set_irq functions */
+    uint32_t                    budget;
+
+    volatile uint8_t            scheduled;
+    irq_poll_t *                next;
+
+    /* Statistics */
+    uint32_t                    irqs;       /* Interrupts taken */
+    uint32_t                    polls;      /* Calls to the poll function */
+    uint32_t                    items;      /* Items handled by the poll function */
+    uint32_t                    exhausted;  /* Polls which used up their budget */
+};
+
+/*------------------------------------------------------------------------------
+ * Scheduled peripherals, run by irq_poll_run().
+ */
+struct irq_poll_list
+{
+    irq_poll_t *                head;
+    irq_poll_t *                tail;
+
+    /* Called by irq_poll_schedule() when the list stops being empty, to wake
+     * the task or the main loop which runs it. May be NULL. */
+    void                        (*wakeup)(irq_poll_list_t * list);
+    void *                      context;    /* For the wakeup function */
+};
+
+/***************************************************************************//**
+ * irq_poll_list_init() initializes an empty list.
+ *
+ * @param wakeup
+ *      Function called from interrupt handlers when a peripheral is scheduled
+ *      on the empty list, for example to notify the task running the list, or
+ *      NULL.
+ */
+void
+irq_poll_list_init
+(
+    irq_poll_list_t * list,
+    void (*wakeup)(irq_poll_list_t * list),
+    void * context
+);
+
+/***************************************************************************//**
+ * irq_poll_init() initializes poll for a peripheral serviced by poll_fn from
+ * list. The interrupt of the peripheral is not changed; it should be enabled
+ * once poll is initialized.
+ *
+ * @param budget
+ *      Items the poll function should handle at most in one call, at least 1.
+ */
+void
+irq_poll_init
+(
+    irq_poll_t * poll,
+    irq_poll_list_t * list,
+    irq_poll_fn_t poll_fn,
+    irq_poll_set_irq_t set_irq,
+    void * context,
+    uint32_t budget
+);
+
+/***************************************************************************//**
+ * irq_poll_schedule() masks the interrupt of the peripheral of poll and
+ * schedules its poll function. Call it from the interrupt handler of the
+ * peripheral, in place of servicing the peripheral.
+ */
+void
+irq_poll_schedule
+(
+    irq_poll_t * poll
+);
+
+/***************************************************************************//**
+ * irq_poll_run() calls the poll function of each scheduled peripheral once, in
+ * the order they were scheduled. A peripheral whose poll function returns 0
+ * is idle: it leaves the list and its interrupt is unmasked. The others stay
+ * scheduled, at the back of the list. Call it from the main loop or from a
+ * task, not from an interrupt handler.
+ *
+ * @return
+ *      1 if peripherals are still scheduled and irq_poll_run() should be
+ *      called again without waiting for an interrupt, 0 otherwise.
+ */
+uint8_t
+irq_poll_run
+(
+    irq_poll_list_t * list
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IRQ_POLL_H_ */
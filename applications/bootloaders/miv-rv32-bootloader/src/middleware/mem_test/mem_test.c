@@ -0,0 +1,475 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file mem_test.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief RAM qualification tests.
+ *
+ * See mem_test.h for a description of the tests.
+ */
+#include "hal/hal.h"
+#include "mem_test.h"
+
+/*
+ * Data backgrounds used by the March C- test. Each march runs with the
+ * background as "0" and its complement as "1".
+ */
+#define MARCH_SOLID_BACKGROUND          0x00000000u
+#define MARCH_CHECKERBOARD_BACKGROUND   0x55555555u
+
+/*
+ * Patterns used by the address bus test.
+ */
+#define ADDR_TEST_PATTERN               0xAAAAAAAAu
+#define ADDR_TEST_ANTIPATTERN           0x55555555u
+
+/*
+ * Number of words filled by the processor before the uDMA takes over.
+ */
+#define UDMA_SEED_WORDS                 64u
+
+/*
+ * Read a word, check it and optionally write the next value. Used to unroll
+ * the march elements.
+ */
+#define MARCH_R(p, i, expect)                                                  \
+    do {                                                                       \
+        uint32_t value_ = (p)[i];                                              \
+        if ((expect) != value_)                                                \
+        {                                                                      \
+            return record_fail(result, MEM_TEST_MARCH_FAIL, &(p)[i],           \
+                               (expect), value_);                              \
+        }                                                                      \
+    } while (0)
+
+#define MARCH_RW(p, i, expect, write)                                          \
+    do {                                                                       \
+        MARCH_R(p, i, expect);                                                 \
+        (p)[i] = (write);                                                      \
+    } while (0)
+
+static mem_test_status_t
+record_fail
+(
+    mem_test_result_t * result,
+    mem_test_status_t status,
+    volatile uint32_t * addr,
+    uint32_t expected,
+    uint32_t actual
+)
+{
+    result->status = status;
+    result->fail_addr = (uintptr_t)addr;
+    result->expected = expected;
+    result->actual = actual;
+
+    return status;
+}
+
+/*------------------------------------------------------------------------------
+ * Walking ones on the first word of the region.
+ */
+static mem_test_status_t
+data_bus_test
+(
+    volatile uint32_t * base,
+    mem_test_result_t * result
+)
+{
+    uint32_t pattern;
+    uint32_t value;
+
+    for (pattern = 1u; 0u != pattern; pattern <<= 1)
+    {
+        *base = pattern;
+        value = *base;
+        result->bytes_accessed += 8u;
+
+        if (pattern != value)
+        {
+            return record_fail(result, MEM_TEST_DATA_BUS_FAIL, base,
+                               pattern, value);
+        }
+    }
+
+    return MEM_TEST_PASS;
+}
+
+/*------------------------------------------------------------------------------
+ * Checks that each power of two word offset selects a distinct word. A word
+ * reading back the wrong value points at an address line which is stuck or
+ * shorted to another one.
+ */
+static mem_test_status_t
+addr_bus_test
+(
+    volatile uint32_t * base,
+    uint32_t words,
+    mem_test_result_t * result
+)
+{
+    uint32_t offset;
+    uint32_t test_offset;
+    uint32_t value;
+
+    for (offset = 1u; offset < words; offset <<= 1)
+    {
+        base[offset] = ADDR_TEST_PATTERN;
+        result->bytes_accessed += 4u;
+    }
+
+    /* Address lines stuck high */
+    base[0] = ADDR_TEST_ANTIPATTERN;
+    result->bytes_accessed += 4u;
+    for (offset = 1u; offset < words; offset <<= 1)
+    {
+        value = base[offset];
+        result->bytes_accessed += 4u;
+        if (ADDR_TEST_PATTERN != value)
+        {
+            return record_fail(result, MEM_TEST_ADDR_BUS_FAIL, &base[offset],
+                               ADDR_TEST_PATTERN, value);
+        }
+    }
+    base[0] = ADDR_TEST_PATTERN;
+    result->bytes_accessed += 4u;
+
+    /* Address lines stuck low or shorted */
+    for (test_offset = 1u; test_offset < words; test_offset <<= 1)
+    {
+        base[test_offset] = ADDR_TEST_ANTIPATTERN;
+        result->bytes_accessed += 4u;
+
+        for (offset = 0u; offset < words; offset = (0u == offset) ? 1u : (offset << 1))
+        {
+            if (offset != test_offset)
+            {
+                value = base[offset];
+                result->bytes_accessed += 4u;
+                if (ADDR_TEST_PATTERN != value)
+                {
+                    return record_fail(result, MEM_TEST_ADDR_BUS_FAIL,
+                                       &base[offset], ADDR_TEST_PATTERN, value);
+                }
+            }
+        }
+
+        base[test_offset] = ADDR_TEST_PATTERN;
+        result->bytes_accessed += 4u;
+    }
+
+    return MEM_TEST_PASS;
+}
+
+/*------------------------------------------------------------------------------
+ * March elements.
+ */
+static void
+cpu_fill
+(
+    volatile uint32_t * p,
+    uint32_t words,
+    uint32_t value
+)
+{
+    while (words >= 8u)
+    {
+        p[0] = value;
+        p[1] = value;
+        p[2] = value;
+        p[3] = value;
+        p[4] = value;
+        p[5] = value;
+        p[6] = value;
+        p[7] = value;
+        p += 8;
+        words -= 8u;
+    }
+
+    while (0u != words)
+    {
+        *p = value;
+        ++p;
+        --words;
+    }
+}
+
+/*
+ * The region is seeded by the processor, then copied onto itself in blocks
+ * which double in size up to MEM_TEST_UDMA_MAX_WORDS.
+ */
+static mem_test_status_t
+udma_fill
+(
+    miv_udma_instance_t * udma,
+    volatile uint32_t * base,
+    uint32_t words,
+    uint32_t value,
+    mem_test_result_t * result
+)
+{
+    uint32_t done;
+    uint32_t block;
+    uint32_t status;
+
+    done = (words < UDMA_SEED_WORDS) ? words : UDMA_SEED_WORDS;
+    cpu_fill(base, done, value);
+    result->bytes_accessed += done * 4u;
+
+    while (done < words)
+    {
+        block = done;
+        if (block > (words - done))
+        {
+            block = words - done;
+        }
+        if (block > MEM_TEST_UDMA_MAX_WORDS)
+        {
+            block = MEM_TEST_UDMA_MAX_WORDS;
+        }
+
+        MIV_uDMA_config(udma,
+                        (addr_t)(uintptr_t)base,
+                        (addr_t)(uintptr_t)&base[done],
+                        block,
+                        0u);
+        MIV_uDMA_start(udma);
+        do
+        {
+            status = MIV_uDMA_read_status(udma);
+        } while (0u != (status & MIV_uDMA_STATUS_BUSY));
+        MIV_uDMA_reset(udma);
+
+        if (0u != (status & MIV_uDMA_STATUS_ERROR))
+        {
+            return record_fail(result, MEM_TEST_UDMA_FAIL, &base[done],
+                               value, status);
+        }
+
+        done += block;
+        result->bytes_accessed += block * 8u;
+    }
+
+    return MEM_TEST_PASS;
+}
+
+/* Ascending read of expect and write of write */
+static mem_test_status_t
+march_up
+(
+    volatile uint32_t * p,
+    uint32_t words,
+    uint32_t expect,
+    uint32_t write,
+    mem_test_result_t * result
+)
+{
+    while (words >= 8u)
+    {
+        MARCH_RW(p, 0, expect, write);
+        MARCH_RW(p, 1, expect, write);
+        MARCH_RW(p, 2, expect, write);
+        MARCH_RW(p, 3, expect, write);
+        MARCH_RW(p, 4, expect, write);
+        MARCH_RW(p, 5, expect, write);
+        MARCH_RW(p, 6, expect, write);
+        MARCH_RW(p, 7, expect, write);
+        p += 8;
+        words -= 8u;
+    }
+
+    while (0u != words)
+    {
+        MARCH_RW(p, 0, expect, write);
+        ++p;
+        --words;
+    }
+
+    return MEM_TEST_PASS;
+}
+
+/* Descending read of expect and write of write */
+static mem_test_status_t
+march_down
+(
+    volatile uint32_t * base,
+    uint32_t words,
+    uint32_t expect,
+    uint32_t write,
+    mem_test_result_t * result
+)
+{
+    volatile uint32_t * p = base + words;
+
+    while (words >= 8u)
+    {
+        p -= 8;
+        MARCH_RW(p, 7, expect, write);
+        MARCH_RW(p, 6, expect, write);
+        MARCH_RW(p, 5, expect, write);
+        MARCH_RW(p, 4, expect, write);
+        MARCH_RW(p, 3, expect, write);
+        MARCH_RW(p, 2, expect, write);
+        MARCH_RW(p, 1, expect, write);
+        MARCH_RW(p, 0, expect, write);
+        words -= 8u;
+    }
+
+    while (0u != words)
+    {
+        --p;
+        MARCH_RW(p, 0, expect, write);
+        --words;
+    }
+
+    return MEM_TEST_PASS;
+}
+
+/* Read only element */
+static mem_test_status_t
+march_verify
+(
+    volatile uint32_t * p,
+    uint32_t words,
+    uint32_t expect,
+    mem_test_result_t * result
+)
+{
+    while (words >= 8u)
+    {
+        MARCH_R(p, 0, expect);
+        MARCH_R(p, 1, expect);
+        MARCH_R(p, 2, expect);
+        MARCH_R(p, 3, expect);
+        MARCH_R(p, 4, expect);
+        MARCH_R(p, 5, expect);
+        MARCH_R(p, 6, expect);
+        MARCH_R(p, 7, expect);
+        p += 8;
+        words -= 8u;
+    }
+
+    while (0u != words)
+    {
+        MARCH_R(p, 0, expect);
+        ++p;
+        --words;
+    }
+
+    return MEM_TEST_PASS;
+}
+
+/*------------------------------------------------------------------------------
+ * March C-: {any(w0); up(r0,w1); up(r1,w0); down(r0,w1); down(r1,w0); any(r0)}
+ */
+static mem_test_status_t
+march_c_minus
+(
+    volatile uint32_t * base,
+    uint32_t words,
+    uint32_t background,
+    miv_udma_instance_t * udma,
+    mem_test_result_t * result
+)
+{
+    uint32_t zero = background;
+    uint32_t one = ~background;
+    mem_test_status_t status = MEM_TEST_PASS;
+
+    if (0 != udma)
+    {
+        status = udma_fill(udma, base, words, zero, result);
+    }
+    else
+    {
+        cpu_fill(base, words, zero);
+        result->bytes_accessed += words * 4u;
+    }
+
+    if (MEM_TEST_PASS == status)
+    {
+        status = march_up(base, words, zero, one, result);
+    }
+    if (MEM_TEST_PASS == status)
+    {
+        status = march_up(base, words, one, zero, result);
+    }
+    if (MEM_TEST_PASS == status)
+    {
+        status = march_down(base, words, zero, one, result);
+    }
+    if (MEM_TEST_PASS == status)
+    {
+        status = march_down(base, words, one, zero, result);
+    }
+    if (MEM_TEST_PASS == status)
+    {
+        status = march_verify(base, words, zero, result);
+    }
+
+    if (MEM_TEST_PASS == status)
+    {
+        /* Four read/write elements and one read element */
+        result->bytes_accessed += words * 4u * 9u;
+    }
+
+    return status;
+}
+
+/***************************************************************************//**
+ * mem_test_run()
+ * See "mem_test.h" for details of how to use this function.
+ */
+mem_test_status_t
+mem_test_run
+(
+    uint32_t * base,
+    uint32_t size,
+    mem_test_mode_t mode,
+    miv_udma_instance_t * udma,
+    mem_test_result_t * result
+)
+{
+    volatile uint32_t * region = (volatile uint32_t *)base;
+    uint32_t words = size / 4u;
+    mem_test_status_t status;
+
+    HAL_ASSERT(0 != result);
+
+    result->status = MEM_TEST_PASS;
+    result->fail_addr = 0u;
+    result->expected = 0u;
+    result->actual = 0u;
+    result->bytes_accessed = 0u;
+
+    if ((0 == base) || (0u != ((uintptr_t)base & 3u)) ||
+        (0u == words) || (0u != (size & 3u)))
+    {
+        result->status = MEM_TEST_INVALID_REGION;
+        return MEM_TEST_INVALID_REGION;
+    }
+
+    status = data_bus_test(region, result);
+
+    if (MEM_TEST_PASS == status)
+    {
+        status = addr_bus_test(region, words, result);
+    }
+
+    if ((MEM_TEST_PASS == status) && (MEM_TEST_FULL == mode))
+    {
+        status = march_c_minus(region, words, MARCH_SOLID_BACKGROUND,
+                               udma, result);
+        if (MEM_TEST_PASS == status)
+        {
+            status = march_c_minus(region, words,
+                                   MARCH_CHECKERBOARD_BACKGROUND, udma, result);
+        }
+    }
+
+    result->status = status;
+
+    return status;
+}
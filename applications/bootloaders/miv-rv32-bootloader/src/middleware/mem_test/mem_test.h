@@ -0,0 +1,119 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file mem_test.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief RAM qualification tests.
+ *
+ * Word-wide memory tests used by the bootloader to check the LSRAM or DDR
+ * before an image is loaded into it. Two levels of test are provided:
+ *
+ *  - MEM_TEST_QUICK: walking ones data bus test on the first word of the
+ *    region followed by an address bus test on the power of two word offsets.
+ *    This detects stuck, shorted and open data or address lines, and touches
+ *    only log2(size) + 32 words.
+ *
+ *  - MEM_TEST_FULL: the quick test followed by a March C- test over the whole
+ *    region, run once with a solid and once with a checkerboard data
+ *    background:
+ *        {any(w0); up(r0,w1); up(r1,w0); down(r0,w1); down(r1,w0); any(r0)}
+ *    March C- detects stuck-at, transition, address decoder and unlinked
+ *    coupling faults. It takes 10 accesses per word.
+ *
+ * All accesses are 32-bit and the march elements are unrolled eight words at a
+ * time. The initial any(w0) element can optionally be performed by the MIV_ESS
+ * uDMA, which then fills the region by copying it onto itself in doubling
+ * blocks. The uDMA must be able to reach the region through its AHBL master.
+ *
+ * The tests are destructive: the content of the region is lost.
+ */
+#ifndef MEM_TEST_H_
+#define MEM_TEST_H_
+
+#include "hal/cpu_types.h"
+#include "drivers/fabric_ip/miv_udma/miv_udma.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+ * Largest uDMA transfer issued by a fill, in 32-bit words.
+ */
+#ifndef MEM_TEST_UDMA_MAX_WORDS
+#define MEM_TEST_UDMA_MAX_WORDS         0x10000u
+#endif
+
+typedef enum
+{
+    MEM_TEST_QUICK = 0,
+    MEM_TEST_FULL
+} mem_test_mode_t;
+
+typedef enum
+{
+    MEM_TEST_PASS = 0,
+    MEM_TEST_DATA_BUS_FAIL,
+    MEM_TEST_ADDR_BUS_FAIL,
+    MEM_TEST_MARCH_FAIL,
+    MEM_TEST_UDMA_FAIL,
+    MEM_TEST_INVALID_REGION
+} mem_test_status_t;
+
+/*------------------------------------------------------------------------------
+ * Outcome of a test.
+ * fail_addr, expected and actual describe the first failing word, they are
+ * only valid when status is not MEM_TEST_PASS. bytes_accessed counts the bytes
+ * read or written by the processor or the uDMA in the test steps which
+ * completed, so that the caller can work out the throughput from the time
+ * mem_test_run() took.
+ */
+typedef struct
+{
+    mem_test_status_t status;
+    uintptr_t fail_addr;
+    uint32_t expected;
+    uint32_t actual;
+    uint32_t bytes_accessed;
+} mem_test_result_t;
+
+/***************************************************************************//**
+ * mem_test_run() tests a RAM region.
+ *
+ * @param base
+ *      Start of the region. Must be 32-bit aligned.
+ *
+ * @param size
+ *      Size of the region in bytes. Must be a non zero multiple of 4.
+ *
+ * @param mode
+ *      MEM_TEST_QUICK or MEM_TEST_FULL.
+ *
+ * @param udma
+ *      Initialised uDMA instance used to fill the region, or NULL to fill it
+ *      with the processor. The uDMA is polled, its interrupt is not used. Only
+ *      used by MEM_TEST_FULL.
+ *
+ * @param result
+ *      Filled with the outcome of the test.
+ *
+ * @return
+ *      The status also stored in result.
+ */
+mem_test_status_t
+mem_test_run
+(
+    uint32_t * base,
+    uint32_t size,
+    mem_test_mode_t mode,
+    miv_udma_instance_t * udma,
+    mem_test_result_t * result
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEM_TEST_H_ */
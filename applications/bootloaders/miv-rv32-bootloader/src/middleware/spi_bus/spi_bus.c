@@ -0,0 +1,329 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file spi_bus.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Sharing of a CoreSPI master between several devices.
+ *
+ * See spi_bus.h for details of how to use this module.
+ */
+#include <stddef.h>
+#include "hal/hal.h"
+#include "drivers/fabric_ip/CoreSPI/corespi_regs.h"
+#include "spi_bus.h"
+
+/* spi_bus_xfer_t state */
+#define SPI_BUS_XFER_DONE               0u
+#define SPI_BUS_XFER_QUEUED             1u
+#define SPI_BUS_XFER_RUNNING            2u
+
+/*
+ * Insert xfer after the transactions of the same or a higher priority.
+ * Called with interrupts disabled.
+ */
+static void
+enqueue
+(
+    spi_bus_t * bus,
+    spi_bus_xfer_t * xfer
+)
+{
+    spi_bus_xfer_t * prev = NULL;
+    spi_bus_xfer_t * cur = bus->queue;
+
+    while ((NULL != cur) && (cur->priority >= xfer->priority))
+    {
+        prev = cur;
+        cur = cur->next;
+    }
+
+    xfer->next = cur;
+    xfer->state = SPI_BUS_XFER_QUEUED;
+
+    if (NULL == prev)
+    {
+        bus->queue = xfer;
+    }
+    else
+    {
+        prev->next = xfer;
+    }
+}
+
+/*
+ * Only the slave select of the device is set, so SSEL is written rather than
+ * read, modified and written. Nothing is written when the device is already
+ * selected.
+ */
+static void
+perform
+(
+    spi_bus_t * bus,
+    spi_bus_xfer_t * xfer
+)
+{
+    if (bus->selected != xfer->device)
+    {
+        HAL_set_8bit_reg(bus->spi->base_addr, SSEL,
+                         (uint_fast8_t)(1u << (uint32_t)xfer->device->slave));
+        bus->selected = xfer->device;
+        ++bus->selects;
+    }
+
+    SPI_transfer_block(bus->spi,
+                       xfer->cmd_buffer,
+                       xfer->cmd_size,
+                       xfer->rx_buffer,
+                       xfer->rx_size);
+    ++bus->transfers;
+}
+
+/*
+ * Run the queue until it is empty. The caller has set bus->running, it is
+ * cleared in the same critical section as the last check of the queue so that
+ * a transaction submitted meanwhile is not left behind.
+ */
+static void
+drain
+(
+    spi_bus_t * bus
+)
+{
+    spi_bus_xfer_t * xfer;
+    spi_bus_done_t done;
+    psr_t saved_psr;
+
+    for (;;)
+    {
+        saved_psr = HAL_disable_interrupts();
+        xfer = bus->queue;
+        if (NULL == xfer)
+        {
+            bus->running = 0u;
+            HAL_restore_interrupts(saved_psr);
+            break;
+        }
+        bus->queue = xfer->next;
+        xfer->state = SPI_BUS_XFER_RUNNING;
+        HAL_restore_interrupts(saved_psr);
+
+        perform(bus, xfer);
+
+        /* The owner may reuse xfer as soon as it is marked done */
+        done = xfer->done;
+        xfer->state = SPI_BUS_XFER_DONE;
+        if (NULL != done)
+        {
+            done(xfer);
+        }
+    }
+}
+
+/***************************************************************************//**
+ * See spi_bus.h for details of how to use this function.
+ */
+void
+spi_bus_init
+(
+    spi_bus_t * bus,
+    spi_instance_t * spi,
+    addr_t base_addr,
+    uint16_t fifo_depth,
+    uint8_t mode,
+    uint32_t clock_hz
+)
+{
+    /* Master mode, all slaves deselected */
+    SPI_init(spi, base_addr, fifo_depth);
+
+    bus->spi = spi;
+    bus->mode = mode;
+    bus->clock_hz = clock_hz;
+    bus->selected = NULL;
+    bus->queue = NULL;
+    bus->running = 0u;
+    bus->wait_transfer = NULL;
+    bus->transfers = 0u;
+    bus->selects = 0u;
+}
+
+/***************************************************************************//**
+ * See spi_bus.h for details of how to use this function.
+ */
+spi_bus_status_t
+spi_bus_add_device
+(
+    spi_bus_t * bus,
+    spi_bus_device_t * device,
+    spi_slave_t slave,
+    uint8_t modes,
+    uint32_t max_clock_hz,
+    uint8_t priority
+)
+{
+    if ((NULL == bus) || (NULL == device) || (slave >= SPI_MAX_NB_OF_SLAVES))
+    {
+        return SPI_BUS_INVALID_ARGUMENTS;
+    }
+
+    if (0u == (modes & bus->mode))
+    {
+        return SPI_BUS_UNSUPPORTED_MODE;
+    }
+
+    if ((0u != max_clock_hz) && (bus->clock_hz > max_clock_hz))
+    {
+        return SPI_BUS_CLOCK_TOO_FAST;
+    }
+
+    device->bus = bus;
+    device->slave = slave;
+    device->modes = modes;
+    device->max_clock_hz = max_clock_hz;
+    device->priority = priority;
+
+    return SPI_BUS_SUCCESS;
+}
+
+/***************************************************************************//**
+ * See spi_bus.h for details of how to use this function.
+ */
+void
+spi_bus_xfer_init
+(
+    spi_bus_xfer_t * xfer,
+    spi_bus_device_t * device,
+    const uint8_t * cmd_buffer,
+    uint16_t cmd_size,
+    uint8_t * rx_buffer,
+    uint16_t rx_size
+)
+{
+    xfer->device = device;
+    xfer->cmd_buffer = cmd_buffer;
+    xfer->cmd_size = cmd_size;
+    xfer->rx_buffer = rx_buffer;
+    xfer->rx_size = rx_size;
+    xfer->priority = device->priority;
+    xfer->done = NULL;
+    xfer->context = NULL;
+    xfer->state = SPI_BUS_XFER_DONE;
+    xfer->next = NULL;
+}
+
+/***************************************************************************//**
+ * See spi_bus.h for details of how to use this function.
+ */
+spi_bus_status_t
+spi_bus_submit
+(
+    spi_bus_xfer_t * xfer
+)
+{
+    spi_bus_status_t status = SPI_BUS_SUCCESS;
+    psr_t saved_psr;
+
+    if ((NULL == xfer) || (NULL == xfer->device) || (NULL == xfer->device->bus))
+    {
+        return SPI_BUS_INVALID_ARGUMENTS;
+    }
+
+    saved_psr = HAL_disable_interrupts();
+    if (SPI_BUS_XFER_DONE != xfer->state)
+    {
+        status = SPI_BUS_ALREADY_QUEUED;
+    }
+    else
+    {
+        enqueue(xfer->device->bus, xfer);
+    }
+    HAL_restore_interrupts(saved_psr);
+
+    return status;
+}
+
+/***************************************************************************//**
+ * See spi_bus.h for details of how to use this function.
+ */
+spi_bus_status_t
+spi_bus_run
+(
+    spi_bus_t * bus
+)
+{
+    psr_t saved_psr;
+
+    saved_psr = HAL_disable_interrupts();
+    if (0u != bus->running)
+    {
+        HAL_restore_interrupts(saved_psr);
+        return SPI_BUS_BUSY;
+    }
+    bus->running = 1u;
+    HAL_restore_interrupts(saved_psr);
+
+    drain(bus);
+
+    return SPI_BUS_SUCCESS;
+}
+
+/***************************************************************************//**
+ * See spi_bus.h for details of how to use this function.
+ */
+uint8_t
+spi_bus_done
+(
+    const spi_bus_xfer_t * xfer
+)
+{
+    return (SPI_BUS_XFER_DONE == xfer->state) ? 1u : 0u;
+}
+
+/***************************************************************************//**
+ * See spi_bus.h for details of how to use this function.
+ */
+spi_bus_status_t
+spi_bus_transfer
+(
+    spi_bus_device_t * device,
+    const uint8_t * cmd_buffer,
+    uint16_t cmd_size,
+    uint8_t * rx_buffer,
+    uint16_t rx_size
+)
+{
+    spi_bus_xfer_t xfer;
+    spi_bus_t * bus;
+    psr_t saved_psr;
+
+    if ((NULL == device) || (NULL == device->bus))
+    {
+        return SPI_BUS_INVALID_ARGUMENTS;
+    }
+    bus = device->bus;
+
+    spi_bus_xfer_init(&xfer, device, cmd_buffer, cmd_size, rx_buffer, rx_size);
+
+    if (NULL != bus->wait_transfer)
+    {
+        return bus->wait_transfer(&xfer);
+    }
+
+    /* Queue and claim the bus together, xfer must not stay queued on a bus
+     * this call cannot run. */
+    saved_psr = HAL_disable_interrupts();
+    if (0u != bus->running)
+    {
+        HAL_restore_interrupts(saved_psr);
+        return SPI_BUS_BUSY;
+    }
+    enqueue(bus, &xfer);
+    bus->running = 1u;
+    HAL_restore_interrupts(saved_psr);
+
+    drain(bus);
+
+    return SPI_BUS_SUCCESS;
+}
@@ -0,0 +1,411 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file udma_service.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Sharing of the MIV_ESS uDMA between several clients.
+ *
+ * See udma_service.h for details of how to use this module.
+ */
+#include <stddef.h>
+#include "hal/hal.h"
+#include "miv_rv32_hal/miv_rv32_deadline.h"
+#include "udma_service.h"
+
+/* udma_request_t state */
+#define UDMA_REQUEST_DONE               0u
+#define UDMA_REQUEST_QUEUED             1u
+
+/*
+ * Give the uDMA the next chunk of the oldest request of the first client of
+ * the highest priority class with requests, if any. The client stays first of
+ * its class until the chunk is done. Called with interrupts disabled and the
+ * uDMA idle.
+ */
+static void
+start_next
+(
+    udma_service_t * service
+)
+{
+    udma_client_t * client = NULL;
+    udma_request_t * request;
+    uint32_t priority = UDMA_SERVICE_NB_PRIORITIES;
+    uint64_t now;
+    uint64_t wait;
+
+    while ((NULL == client) && (priority > 0u))
+    {
+        --priority;
+        client = service->ready[priority];
+    }
+
+    if (NULL == client)
+    {
+        return;
+    }
+
+    request = client->head;
+    now = DEADLINE_READ_MTIME();
+
+    if (0u == request->done_words)
+    {
+        wait = now - request->submit_time;
+        client->wait_total += wait;
+        if (wait > client->wait_max)
+        {
+            client->wait_max = wait;
+        }
+    }
+
+    service->chunk_words = request->words - request->done_words;
+    if (service->chunk_words > UDMA_SERVICE_CHUNK_WORDS)
+    {
+        service->chunk_words = UDMA_SERVICE_CHUNK_WORDS;
+    }
+    service->active = request;
+    service->chunk_start = now;
+
+    MIV_uDMA_config(service->udma,
+                    request->src_addr + (request->done_words * 4u),
+                    request->dest_addr + (request->done_words * 4u),
+                    service->chunk_words,
+                    MIV_uDMA_CTRL_IRQ_CONFIG);
+    MIV_uDMA_start(service->udma);
+}
+
+/*
+ * Account for the chunk of the active request which just ended. Returns the
+ * request if it is complete, NULL if it has chunks left. Either way its client
+ * goes to the back of its class if it has requests left, so that the clients
+ * of a class take turns. Called with interrupts disabled.
+ */
+static udma_request_t *
+end_chunk
+(
+    udma_service_t * service,
+    uint8_t failed
+)
+{
+    udma_request_t * request = service->active;
+    udma_client_t * client = request->client;
+    uint8_t priority = client->priority;
+
+    service->active = NULL;
+    service->busy += DEADLINE_READ_MTIME() - service->chunk_start;
+    ++service->chunks;
+
+    if (0u == failed)
+    {
+        request->done_words += service->chunk_words;
+        client->words += service->chunk_words;
+    }
+    else
+    {
+        ++client->errors;
+    }
+
+    if ((0u == failed) && (request->done_words < request->words))
+    {
+        request = NULL;
+    }
+    else
+    {
+        client->head = request->next;
+        ++client->requests;
+        --service->queued;
+    }
+
+    /* The client was first of its class */
+    service->ready[priority] = client->next;
+    client->next = NULL;
+    if (NULL == service->ready[priority])
+    {
+        service->ready_tail[priority] = NULL;
+    }
+
+    if (NULL != client->head)
+    {
+        if (NULL == service->ready[priority])
+        {
+            service->ready[priority] = client;
+        }
+        else
+        {
+            service->ready_tail[priority]->next = client;
+        }
+        service->ready_tail[priority] = client;
+    }
+
+    return request;
+}
+
+/***************************************************************************//**
+ * See udma_service.h for details of how to use this function.
+ */
+void
+udma_service_init
+(
+    udma_service_t * service,
+    miv_udma_instance_t * udma,
+    addr_t base_addr
+)
+{
+    uint32_t priority;
+
+    MIV_uDMA_init(udma, base_addr);
+    MIV_uDMA_reset(udma);
+
+    service->udma = udma;
+    service->clients = NULL;
+    for (priority = 0u; priority < UDMA_SERVICE_NB_PRIORITIES; ++priority)
+    {
+        service->ready[priority] = NULL;
+        service->ready_tail[priority] = NULL;
+    }
+    service->active = NULL;
+    service->chunk_words = 0u;
+    service->chunk_start = 0u;
+    service->queued = 0u;
+
+    udma_service_clear_stats(service);
+}
+
+/***************************************************************************//**
+ * See udma_service.h for details of how to use this function.
+ */
+udma_service_status_t
+udma_service_add_client
+(
+    udma_service_t * service,
+    udma_client_t * client,
+    uint8_t priority,
+    udma_service_done_t done
+)
+{
+    psr_t saved_psr;
+
+    if ((NULL == service) || (NULL == client) ||
+        (priority >= UDMA_SERVICE_NB_PRIORITIES))
+    {
+        return UDMA_SERVICE_INVALID_ARGUMENTS;
+    }
+
+    client->service = service;
+    client->priority = priority;
+    client->done = done;
+    client->head = NULL;
+    client->tail = NULL;
+    client->next = NULL;
+    client->requests = 0u;
+    client->errors = 0u;
+    client->words = 0u;
+    client->wait_total = 0u;
+    client->wait_max = 0u;
+
+    saved_psr = HAL_disable_interrupts();
+    client->link = service->clients;
+    service->clients = client;
+    HAL_restore_interrupts(saved_psr);
+
+    return UDMA_SERVICE_SUCCESS;
+}
+
+/***************************************************************************//**
+ * See udma_service.h for details of how to use this function.
+ */
+udma_service_status_t
+udma_service_submit
+(
+    udma_client_t * client,
+    udma_request_t * request,
+    addr_t src_addr,
+    addr_t dest_addr,
+    uint32_t words,
+    void * context
+)
+{
+    udma_service_t * service;
+    psr_t saved_psr;
+
+    if ((NULL == client) || (NULL == client->service) || (NULL == request) ||
+        (0u == words) || (0u != ((src_addr | dest_addr) & 3u)))
+    {
+        return UDMA_SERVICE_INVALID_ARGUMENTS;
+    }
+    service = client->service;
+
+    saved_psr = HAL_disable_interrupts();
+    if (UDMA_REQUEST_QUEUED == request->state)
+    {
+        HAL_restore_interrupts(saved_psr);
+        return UDMA_SERVICE_ALREADY_QUEUED;
+    }
+
+    request->client = client;
+    request->src_addr = src_addr;
+    request->dest_addr = dest_addr;
+    request->words = words;
+    request->context = context;
+    request->done_words = 0u;
+    request->submit_time = DEADLINE_READ_MTIME();
+    request->state = UDMA_REQUEST_QUEUED;
+    request->next = NULL;
+
+    if (NULL == client->head)
+    {
+        client->head = request;
+
+        /* The client now has requests, it takes the last turn of its class */
+        if (NULL == service->ready[client->priority])
+        {
+            service->ready[client->priority] = client;
+        }
+        else
+        {
+            service->ready_tail[client->priority]->next = client;
+        }
+        service->ready_tail[client->priority] = client;
+    }
+    else
+    {
+        client->tail->next = request;
+    }
+    client->tail = request;
+
+    ++service->queued;
+    if (service->queued > service->max_queued)
+    {
+        service->max_queued = service->queued;
+    }
+
+    if (NULL == service->active)
+    {
+        start_next(service);
+    }
+    HAL_restore_interrupts(saved_psr);
+
+    return UDMA_SERVICE_SUCCESS;
+}
+
+/***************************************************************************//**
+ * See udma_service.h for details of how to use this function.
+ */
+uint8_t
+udma_service_done
+(
+    const udma_request_t * request
+)
+{
+    return (UDMA_REQUEST_DONE == request->state) ? 1u : 0u;
+}
+
+/***************************************************************************//**
+ * See udma_service.h for details of how to use this function.
+ */
+void
+udma_service_isr
+(
+    udma_service_t * service
+)
+{
+    udma_request_t * request;
+    udma_service_done_t done;
+    udma_service_status_t status;
+    uint8_t failed;
+    psr_t saved_psr;
+
+    failed = (0u != (MIV_uDMA_read_status(service->udma) & MIV_uDMA_STATUS_ERROR)) ? 1u : 0u;
+    MIV_uDMA_reset(service->udma);
+
+    if (NULL == service->active)
+    {
+        return;
+    }
+
+    saved_psr = HAL_disable_interrupts();
+    request = end_chunk(service, failed);
+    start_next(service);
+    HAL_restore_interrupts(saved_psr);
+
+    if (NULL != request)
+    {
+        /* The owner may reuse request as soon as it is marked done */
+        done = request->client->done;
+        status = (0u != failed) ? UDMA_SERVICE_TRANSFER_ERROR : UDMA_SERVICE_SUCCESS;
+        request->state = UDMA_REQUEST_DONE;
+        if (NULL != done)
+        {
+            done(request, status);
+        }
+    }
+}
+
+/***************************************************************************//**
+ * See udma_service.h for details of how to use this function.
+ */
+void
+udma_service_get_stats
+(
+    udma_service_t * service,
+    udma_service_stats_t * stats
+)
+{
+    psr_t saved_psr;
+    uint64_t now;
+
+    saved_psr = HAL_disable_interrupts();
+    now = DEADLINE_READ_MTIME();
+    stats->elapsed = now - service->stats_start;
+    stats->busy = service->busy;
+    if (NULL != service->active)
+    {
+        stats->busy += now - service->chunk_start;
+    }
+    stats->chunks = service->chunks;
+    stats->max_queued = service->max_queued;
+    HAL_restore_interrupts(saved_psr);
+
+    stats->utilization = 0u;
+    if (0u != stats->elapsed)
+    {
+        stats->utilization = (uint32_t)((stats->busy * 100u) / stats->elapsed);
+    }
+}
+
+/***************************************************************************//**
+ * See udma_service.h for details of how to use this function.
+ */
+void
+udma_service_clear_stats
+(
+    udma_service_t * service
+)
+{
+    udma_client_t * client;
+    psr_t saved_psr;
+
+    saved_psr = HAL_disable_interrupts();
+    service->stats_start = DEADLINE_READ_MTIME();
+    service->busy = 0u;
+    service->chunks = 0u;
+    service->max_queued = service->queued;
+
+    if (NULL != service->active)
+    {
+        /* Only count the rest of the chunk in progress */
+        service->chunk_start = service->stats_start;
+    }
+
+    for (client = service->clients; NULL != client; client = client->link)
+    {
+        client->requests = 0u;
+        client->errors = 0u;
+        client->words = 0u;
+        client->wait_total = 0u;
+        client->wait_max = 0u;
+    }
+    HAL_restore_interrupts(saved_psr);
+}
@@ -0,0 +1,278 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file udma_service.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Sharing of the MIV_ESS uDMA between several clients.
+ *
+ * The uDMA performs one transfer at a time and must be configured again for
+ * each one. The service lets several clients, for example a memory copy
+ * offload, the drain of a SPI receive buffer and the application, queue their
+ * transfers without knowing about each other:
+ *  - each client is registered once with a priority class and a function
+ *    called when each of its transfers is done,
+ *  - the requests of a client are performed in the order they were submitted,
+ *  - the uDMA serves the highest priority class which has requests. The
+ *    clients of a class take turns, one chunk each, so a client which queues
+ *    many or large transfers does not hold up the others of its class,
+ *  - transfers longer than UDMA_SERVICE_CHUNK_WORDS are split into chunks, so
+ *    a high priority request waits for at most one chunk.
+ *
+ * The service is driven by the uDMA interrupt: udma_service_isr() must be
+ * called from the handler of the MIV_ESS interrupt the uDMA is wired to,
+ * MSYS_EI1_IRQHandler() in the MIV_ESS reference configuration:
+ *
+ *      void MSYS_EI1_IRQHandler(void)
+ *      {
+ *          udma_service_isr(&g_udma_service);
+ *      }
+ *
+ *      udma_service_init(&g_udma_service, &g_udma, MIV_ESS_uDMA_BASE_ADDR);
+ *      udma_service_add_client(&g_udma_service, &g_copy_client,
+ *                              UDMA_SERVICE_PRIORITY_NORMAL, copy_done);
+ *      MRV_enable_local_irq(MRV32_MSYS_EIE1_IRQn);
+ *      HAL_enable_interrupts();
+ *
+ *      udma_service_submit(&g_copy_client, &request, src, dest, words, NULL);
+ *
+ * The service measures the time the uDMA is busy and, for each client, the
+ * time its requests wait before their first chunk starts. A busy uDMA with
+ * long waits means the uDMA is the bottleneck and transfers should be fewer
+ * or smaller; an idle uDMA with short waits means the processor does not
+ * submit requests fast enough to keep it busy.
+ */
+#ifndef UDMA_SERVICE_H_
+#define UDMA_SERVICE_H_
+
+#include <stdint.h>
+#include "hal/cpu_types.h"
+#include "drivers/fabric_ip/miv_udma/miv_udma.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+ * Largest transfer given to the uDMA at once, in 32-bit words.
+ */
+#ifndef UDMA_SERVICE_CHUNK_WORDS
+#define UDMA_SERVICE_CHUNK_WORDS        1024u
+#endif
+
+/*------------------------------------------------------------------------------
+ * Priority classes, higher values are served first.
+ */
+#define UDMA_SERVICE_PRIORITY_LOW       0u
+#define UDMA_SERVICE_PRIORITY_NORMAL    1u
+#define UDMA_SERVICE_PRIORITY_HIGH      2u
+#define UDMA_SERVICE_NB_PRIORITIES      3u
+
+typedef enum
+{
+    UDMA_SERVICE_SUCCESS = 0,
+    UDMA_SERVICE_INVALID_ARGUMENTS,
+    UDMA_SERVICE_ALREADY_QUEUED,
+    UDMA_SERVICE_TRANSFER_ERROR
+} udma_service_status_t;
+
+typedef struct udma_service udma_service_t;
+typedef struct udma_client udma_client_t;
+typedef struct udma_request udma_request_t;
+
+/*------------------------------------------------------------------------------
+ * Called from udma_service_isr() once request is done, with
+ * UDMA_SERVICE_SUCCESS or UDMA_SERVICE_TRANSFER_ERROR. It may submit another
+ * request.
+ */
+typedef void (*udma_service_done_t)(udma_request_t * request,
+                                    udma_service_status_t status);
+
+/*------------------------------------------------------------------------------
+ * Transfer of words 32-bit words from src_addr to dest_addr. The structure
+ * belongs to the service from udma_service_submit() until the done function
+ * of the client is called, or until udma_service_done() returns 1.
+ */
+struct udma_request
+{
+    udma_client_t *             client;
+    addr_t                      src_addr;
+    addr_t                      dest_addr;
+    uint32_t                    words;
+    void *                      context;    /* For the done function */
+
+    uint32_t                    done_words;
+    uint64_t                    submit_time;    /* MTIME */
+    volatile uint8_t            state;
+    udma_request_t *            next;
+};
+
+/*------------------------------------------------------------------------------
+ * User of the uDMA, see udma_service_add_client(). The members are private to
+ * udma_service.c apart from the statistics, which may be read at any time.
+ */
+struct udma_client
+{
+    udma_service_t *            service;
+    uint8_t                     priority;
+    udma_service_done_t         done;
+
+    udma_request_t *            head;       /* Oldest request */
+    udma_request_t *            tail;
+    udma_client_t *             next;       /* Next client of the class with requests */
+    udma_client_t *             link;       /* Next client of the service */
+
+    /* Statistics */
+    uint32_t                    requests;   /* Completed */
+    uint32_t                    errors;
+    uint32_t                    words;      /* Transferred */
+    uint64_t                    wait_total; /* MTIME ticks from submit to first chunk */
+    uint64_t                    wait_max;
+};
+
+/*------------------------------------------------------------------------------
+ * Statistics of the service, see udma_service_get_stats().
+ */
+typedef struct
+{
+    uint64_t                    elapsed;    /* MTIME ticks since the statistics were cleared */
+    uint64_t                    busy;       /* MTIME ticks with a chunk in progress */
+    uint32_t                    utilization;    /* busy / elapsed, in percent */
+    uint32_t                    chunks;
+    uint32_t                    max_queued; /* Most requests queued at once */
+} udma_service_stats_t;
+
+/*------------------------------------------------------------------------------
+ * uDMA shared by several clients.
+ */
+struct udma_service
+{
+    miv_udma_instance_t *       udma;
+    udma_client_t *             clients;
+    udma_client_t *             ready[UDMA_SERVICE_NB_PRIORITIES];  /* Clients with requests, */
+    udma_client_t *             ready_tail[UDMA_SERVICE_NB_PRIORITIES]; /* in turn order */
+    udma_request_t * volatile   active;     /* Request of the chunk in progress */
+    uint32_t                    chunk_words;
+    uint64_t                    chunk_start;
+
+    /* Statistics */
+    uint64_t                    stats_start;
+    uint64_t                    busy;
+    uint32_t                    chunks;
+    uint32_t                    queued;
+    uint32_t                    max_queued;
+};
+
+/***************************************************************************//**
+ * udma_service_init() initializes the uDMA at base_addr and the service which
+ * manages it, with no client. The uDMA interrupt must be enabled by the
+ * application.
+ */
+void
+udma_service_init
+(
+    udma_service_t * service,
+    miv_udma_instance_t * udma,
+    addr_t base_addr
+);
+
+/***************************************************************************//**
+ * udma_service_add_client() registers client with service.
+ *
+ * @param priority
+ *      UDMA_SERVICE_PRIORITY_LOW, UDMA_SERVICE_PRIORITY_NORMAL or
+ *      UDMA_SERVICE_PRIORITY_HIGH.
+ *
+ * @param done
+ *      Function called when each request of the client is done, or NULL.
+ *
+ * @return
+ *      UDMA_SERVICE_SUCCESS or UDMA_SERVICE_INVALID_ARGUMENTS.
+ */
+udma_service_status_t
+udma_service_add_client
+(
+    udma_service_t * service,
+    udma_client_t * client,
+    uint8_t priority,
+    udma_service_done_t done
+);
+
+/***************************************************************************//**
+ * udma_service_submit() queues the transfer of words 32-bit words from src_addr
+ * to dest_addr for client, and starts it if the uDMA is idle. It can be called
+ * from an interrupt handler or a done function.
+ *
+ * @param request
+ *      Request filled in by this function, owned by the service until it is
+ *      done. It must be zero initialized before its first use, as a static
+ *      variable is.
+ *
+ * @param src_addr, dest_addr
+ *      Addresses seen by the AHBL master of the uDMA, 32-bit aligned.
+ *
+ * @param context
+ *      Stored in request for the done function.
+ *
+ * @return
+ *      UDMA_SERVICE_SUCCESS, UDMA_SERVICE_INVALID_ARGUMENTS or
+ *      UDMA_SERVICE_ALREADY_QUEUED if request is still queued.
+ */
+udma_service_status_t
+udma_service_submit
+(
+    udma_client_t * client,
+    udma_request_t * request,
+    addr_t src_addr,
+    addr_t dest_addr,
+    uint32_t words,
+    void * context
+);
+
+/***************************************************************************//**
+ * udma_service_done() returns 1 once request was performed, 0 while it is
+ * queued or in progress.
+ */
+uint8_t
+udma_service_done
+(
+    const udma_request_t * request
+);
+
+/***************************************************************************//**
+ * udma_service_isr() completes the chunk in progress and starts the next one.
+ * Call it from the uDMA interrupt handler.
+ */
+void
+udma_service_isr
+(
+    udma_service_t * service
+);
+
+/***************************************************************************//**
+ * udma_service_get_stats() returns the statistics of service since
+ * udma_service_init() or udma_service_clear_stats().
+ */
+void
+udma_service_get_stats
+(
+    udma_service_t * service,
+    udma_service_stats_t * stats
+);
+
+/***************************************************************************//**
+ * udma_service_clear_stats() clears the statistics of service and of its
+ * clients.
+ */
+void
+udma_service_clear_stats
+(
+    udma_service_t * service
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UDMA_SERVICE_H_ */
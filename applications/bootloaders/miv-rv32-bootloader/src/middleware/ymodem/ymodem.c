@@ -32,11 +32,11 @@
 #else
 #include "drivers/fabric_ip/CoreUARTapb/core_uart_apb.h"
 #endif
+#include "miv_rv32_hal/miv_rv32_deadline.h"
 #include "ymodem.h"
 
 
 extern UART_instance_t g_uart;
-extern volatile uint32_t g_10ms_count;
 
 /***************************************************************************//**
  * Calculate CRC for block of data.
@@ -180,13 +180,7 @@ void sf2bl_ymodem_deinit(void)
 static void _sleep(uint32_t seconds_delay)
 
 {
-    uint32_t start_time;
-
-    start_time = g_10ms_count; /* record starting point */
-    seconds_delay *= 1000;     /* Convert to ms */
-
-    while((g_10ms_count - start_time) < seconds_delay)
-        ;
+    deadline_wait(deadline_in_ms(seconds_delay * 1000u));
 }
 
 
@@ -196,7 +190,7 @@ static void _sleep(uint32_t seconds_delay)
  */
 static int32_t _getchar(int32_t timeout)
 {
-    uint32_t start_time;
+    deadline_t deadline;
     uint8_t  rx_byte;
     int32_t  done;
     int32_t received;
@@ -228,8 +222,7 @@ static int32_t _getchar(int32_t timeout)
     }
     else if(timeout > 0) /* time limited mode */
     {
-        start_time = g_10ms_count; /* record starting point */
-        timeout *= 1000;           /* Convert timeout to ms */
+        deadline = deadline_in_ms((uint32_t)timeout * 1000u);
         while(!done)
         {
 #ifndef RTG4_DEMO
@@ -248,7 +241,7 @@ static int32_t _getchar(int32_t timeout)
                 }
             }
 
-           if((g_10ms_count) >= start_time + timeout)
+           if(deadline_expired(deadline))
            {
                 /* Timed out so exit with ret_value == -1 */
                 done = 1;
@@ -348,6 +341,192 @@ static uint32_t str_to_u32(uint8_t *str)
 }
 
 
+/*
+ * Resumable downloads.
+ *
+ * The receiver keeps a bitmap of the 1K blocks of the file which were received
+ * with a good CRC and stored. It survives an aborted or timed out transfer, as
+ * long as the same buffer is passed to ymodem_receive() again. A sender which
+ * supports resuming adds a "+resume" field after the file size in the header
+ * packet. If the header matches the interrupted transfer (same buffer, file
+ * name, size and header content), the receiver replies to it with:
+ *
+ *   ACK 'R' <offset as 8 hex digits> 'C'
+ *
+ * instead of ACK 'C'. The sender then starts the data packets at that offset,
+ * the first missing block, with sequence number 1. An offset equal to the file
+ * size means that only EOT is needed. Senders which do not announce "+resume"
+ * always get ACK 'C' and send the whole file.
+ */
+static struct
+{
+    uint8_t  *buf;
+    uint8_t  file_name[FILE_NAME_LENGTH + 1];
+    uint32_t size;
+    uint16_t header_crc;
+    uint32_t blocks;
+    uint32_t bitmap[(YMODEM_RESUME_MAX_BLOCKS + 31) / 32];
+} g_resume;
+
+
+/***************************************************************************//**
+ *
+ */
+void ymodem_resume_clear(void)
+{
+    g_resume.buf = 0;
+    g_resume.blocks = 0;
+}
+
+
+/***************************************************************************//**
+ * Returns the offset of the first block missing from the interrupted transfer
+ * to buf, or 0 if there is none.
+ */
+uint32_t ymodem_resume_offset(const uint8_t *buf)
+{
+    uint32_t block;
+
+    if((0 == g_resume.blocks) || (buf != g_resume.buf))
+    {
+        return 0;
+    }
+
+    for(block = 0; block < g_resume.blocks; block++)
+    {
+        if(0 == (g_resume.bitmap[block / 32] & (1UL << (block % 32))))
+        {
+            break;
+        }
+    }
+
+    if(block == g_resume.blocks)
+    {
+        return g_resume.size;
+    }
+
+    return block * YMODEM_RESUME_BLOCK_SIZE;
+}
+
+
+/***************************************************************************//**
+ * Starts tracking a transfer described by a header packet, unless it is the
+ * interrupted transfer. Returns 0 if the file is too large to be tracked.
+ */
+static int32_t resume_start(uint8_t *buf, const uint8_t *name, uint32_t size,
+                            uint16_t header_crc)
+{
+    uint32_t index;
+
+    if((g_resume.buf == buf) && (g_resume.size == size) &&
+       (g_resume.header_crc == header_crc) && (0 != g_resume.blocks) &&
+       (0 == strcmp((const char *)g_resume.file_name, (const char *)name)))
+    {
+        return 1;
+    }
+
+    ymodem_resume_clear();
+
+    if(size > (YMODEM_RESUME_MAX_BLOCKS * YMODEM_RESUME_BLOCK_SIZE))
+    {
+        return 0;
+    }
+
+    for(index = 0; index < (sizeof(g_resume.bitmap) / sizeof(g_resume.bitmap[0])); index++)
+    {
+        g_resume.bitmap[index] = 0;
+    }
+
+    strcpy((char *)g_resume.file_name, (const char *)name);
+    g_resume.size = size;
+    g_resume.header_crc = header_crc;
+    g_resume.blocks = (size + YMODEM_RESUME_BLOCK_SIZE - 1) / YMODEM_RESUME_BLOCK_SIZE;
+    g_resume.buf = buf;
+
+    return 1;
+}
+
+
+/***************************************************************************//**
+ * Marks the blocks completed by a packet stored from offset start to offset
+ * end of the file.
+ */
+static void resume_mark(uint32_t start, uint32_t end)
+{
+    uint32_t block;
+    uint32_t last;
+
+    if(0 == g_resume.blocks)
+    {
+        return;
+    }
+
+    /* The last block is complete at the end of the file, before the padding */
+    last = (end >= g_resume.size) ? g_resume.blocks : (end / YMODEM_RESUME_BLOCK_SIZE);
+
+    for(block = start / YMODEM_RESUME_BLOCK_SIZE; block < last; block++)
+    {
+        g_resume.bitmap[block / 32] |= (1UL << (block % 32));
+    }
+}
+
+
+/***************************************************************************//**
+ * Returns 1 if the "+resume" field follows the file size in a header packet.
+ */
+static int32_t header_has_resume(const uint8_t *field, const uint8_t *end)
+{
+    const uint32_t token_length = sizeof(YMODEM_RESUME_TOKEN) - 1;
+
+    while((field < end) && *field)
+    {
+        if((' ' == field[-1]) && ((uint32_t)(end - field) >= token_length) &&
+           (0 == memcmp(field, YMODEM_RESUME_TOKEN, token_length)) &&
+           ((field + token_length == end) || (0 == field[token_length]) ||
+            (' ' == field[token_length])))
+        {
+            return 1;
+        }
+        ++field;
+    }
+
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ */
+static void _putdata(const uint8_t *data, uint32_t length)
+{
+#ifndef RTG4_DEMO
+    MSS_UART_polled_tx(g_my_uart, data, length);
+#else
+    UART_send( &g_uart, data, length );
+#endif
+}
+
+
+/***************************************************************************//**
+ *
+ */
+static void put_hex_u32(uint32_t value)
+{
+    static const uint8_t hex[] = "0123456789ABCDEF";
+    int32_t shift;
+
+    for(shift = 28; shift >= 0; shift -= 4)
+    {
+        _putchar(hex[(value >> shift) & 0xf]);
+    }
+}
+
+
+/* Packet buffer, shared by the receiver and the sender. Static as 1K is a lot
+ * to put on our stack: */
+static uint8_t g_packet_data[PACKET_1K_SIZE + PACKET_OVERHEAD];
+
+
 /***************************************************************************//**
  * Returns 0 on success, 1 on corrupt packet, -1 on error (timeout):
  * *length will be set to the length of
@@ -461,12 +640,13 @@ static int32_t receive_packet(uint8_t *data, int32_t *length)
 
 
 /***************************************************************************//**
- *
+ * Receives a file to buf, or passes it to write when buf is NULL.
  */
 /* Returns the length of the file received, or 0 on error: */
-uint32_t ymodem_receive(uint8_t *buf, uint32_t length, uint8_t *file_name)
+static uint32_t receive_file(uint8_t *buf, ymodem_write_t write, void *context,
+                             uint32_t length, uint8_t *file_name)
 {
-    static uint8_t packet_data[PACKET_1K_SIZE + PACKET_OVERHEAD]; /* Declare as static as 1K is a lot to put on our stack */
+    uint8_t *packet_data = g_packet_data;
     uint8_t file_size[FILE_SIZE_LENGTH + 1];
     uint8_t *file_ptr;
     int32_t  packet_length;
@@ -478,10 +658,12 @@ uint32_t ymodem_receive(uint8_t *buf, uint32_t length, uint8_t *file_name)
     uint32_t packets_received;
     uint32_t errors;
     int32_t  first_try = 1;
-    uint8_t *buf_ptr;
+    uint32_t position;
+    uint32_t count;
     uint32_t size = 0;
     uint32_t return_val = 0; /* Default to abnormal exit */
     uint32_t temp;
+    uint32_t offset;
     int32_t  rx_status;
 
     file_name[0] = 0;
@@ -500,7 +682,8 @@ uint32_t ymodem_receive(uint8_t *buf, uint32_t length, uint8_t *file_name)
         first_try        = 0;
         packets_received = 0;
         file_done        = 0;
-        buf_ptr          = buf;
+        position         = 0;
+        offset           = 0;
 
         while(0 == file_done)
         {
@@ -526,6 +709,7 @@ uint32_t ymodem_receive(uint8_t *buf, uint32_t length, uint8_t *file_name)
                      */
                     file_done = 1;
                     return_val = 1; /* Signal normal exit */
+                    ymodem_resume_clear(); /* Nothing left to resume */
                     break;
 
                 default:  /* normal packet */
@@ -539,6 +723,13 @@ uint32_t ymodem_receive(uint8_t *buf, uint32_t length, uint8_t *file_name)
                          */
                         if((1 == packets_received) && (0 == (packet_data[PACKET_SEQNO_INDEX] & 0xff)))
                         {
+                            if(0 != offset)
+                            {
+                                /* The resume reply was lost, repeat it */
+                                _putchar(ACK);
+                                _putchar(RES);
+                                put_hex_u32(offset);
+                            }
                         _putchar(CRC); /* Repeated packet 0 error */
                         }
                         else
@@ -599,7 +790,24 @@ uint32_t ymodem_receive(uint8_t *buf, uint32_t length, uint8_t *file_name)
                                 }
                                 else
                                 {
+                                    offset = 0;
+                                    if((0 != buf) &&
+                                       resume_start(buf, file_name, size,
+                                                    sf2bl_crc16(packet_data + PACKET_HEADER, packet_length)) &&
+                                       header_has_resume(file_ptr, packet_data + PACKET_HEADER + packet_length))
+                                    {
+                                        offset = ymodem_resume_offset(buf);
+                                    }
+
+                                    position = offset;
+
                                     _putchar(ACK);
+                                    if(0 != offset)
+                                    {
+                                        /* Resume: data packets start at offset */
+                                        _putchar(RES);
+                                        put_hex_u32(offset);
+                                    }
                                     _putchar(crc_nak ? CRC : NAK);
                                     crc_nak = 0;
                                 }
@@ -617,7 +825,20 @@ uint32_t ymodem_receive(uint8_t *buf, uint32_t length, uint8_t *file_name)
                             /* This shouldn't happen, but we check anyway in case the
                              * sender lied in its filename packet:
                              */
-                            if((buf_ptr + packet_length) - buf > length)
+                            count = (uint32_t)packet_length;
+                            if((0 == buf) && (0 != size))
+                            {
+                                /* Only pass on the file, not the padding of its last packet */
+                                count = (position >= size) ? 0 : (size - position);
+                                if(count > (uint32_t)packet_length)
+                                {
+                                    count = (uint32_t)packet_length;
+                                }
+                            }
+
+                            if(((position + count) > length) ||
+                               ((0 == buf) && (0 != count) &&
+                                (0 != write(context, position, packet_data + PACKET_HEADER, count))))
                             {
                                 _putchar(CAN);
                                 _putchar(CAN);
@@ -629,12 +850,17 @@ uint32_t ymodem_receive(uint8_t *buf, uint32_t length, uint8_t *file_name)
                             }
                             else
                             {
-                                for (index=0; index < packet_length; index++)
+                                if(0 != buf)
                                 {
-                                    buf_ptr[index] = packet_data[PACKET_HEADER + index];
+                                    for (index=0; index < packet_length; index++)
+                                    {
+                                        buf[position + index] = packet_data[PACKET_HEADER + index];
+                                    }
+
+                                    resume_mark(position, position + count);
                                 }
 
-                                buf_ptr += packet_length;
+                                position += count;
                                 _putchar(ACK);
                             }
                         }
@@ -672,4 +898,271 @@ uint32_t ymodem_receive(uint8_t *buf, uint32_t length, uint8_t *file_name)
     return(return_val == 1 ?  size : 0 );
 }
 
+
+/***************************************************************************//**
+ *
+ */
+uint32_t ymodem_receive(uint8_t *buf, uint32_t length, uint8_t *file_name)
+{
+    return receive_file(buf, 0, 0, length, file_name);
+}
+
+
+/***************************************************************************//**
+ * Passes the file to write as it is received, in order. Resuming is not
+ * offered, write cannot go back to the blocks already received.
+ */
+uint32_t ymodem_receive_stream(ymodem_write_t write, void *context,
+                               uint32_t length, uint8_t *file_name)
+{
+    return receive_file(0, write, context, length, file_name);
+}
+
+/*
+ * Sender.
+ *
+ * The receiver starts the transfer with 'C', or with 'G' for YMODEM-G. In
+ * YMODEM-G the data packets are streamed without waiting for an ACK, the
+ * receiver cancels the transfer with CAN CAN on the first error. This is only
+ * safe over an error free link, such as a USB-UART at a rate the receiver can
+ * keep up with, but removes the turnaround time of each packet.
+ */
+
+
+/***************************************************************************//**
+ * Waits for a reply of the receiver. Returns ACK, NAK, CRC, YMG or CAN (for CAN
+ * CAN), or -1 on timeout. Other characters are ignored as line noise.
+ */
+static int32_t wait_reply(int32_t timeout)
+{
+    int32_t rx_char;
+
+    for(;;)
+    {
+        rx_char = _getchar(timeout);
+        switch(rx_char)
+        {
+        case ACK:
+        case NAK:
+        case CRC:
+        case YMG:
+        case -1:
+            return rx_char;
+
+        case CAN:
+            if(CAN == _getchar(PACKET_TIMEOUT))
+            {
+                return CAN;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+
+/***************************************************************************//**
+ * Completes the packet of packet_size data bytes already in g_packet_data and
+ * sends it.
+ */
+static void send_packet(uint8_t seqno, uint32_t packet_size)
+{
+    uint16_t crc;
+
+    g_packet_data[0] = (PACKET_1K_SIZE == packet_size) ? STX : SOH;
+    g_packet_data[PACKET_SEQNO_INDEX] = seqno;
+    g_packet_data[PACKET_SEQNO_COMP_INDEX] = (uint8_t)(seqno ^ 0xffU);
+
+    crc = sf2bl_crc16(g_packet_data + PACKET_HEADER, packet_size);
+    g_packet_data[PACKET_HEADER + packet_size] = (uint8_t)(crc >> 8);
+    g_packet_data[PACKET_HEADER + packet_size + 1] = (uint8_t)crc;
+
+    _putdata(g_packet_data, packet_size + PACKET_OVERHEAD);
+}
+
+
+/***************************************************************************//**
+ * Sends a packet until the receiver replies with one of the expected replies.
+ * An ACK followed by expected is also accepted, the receiver ACKs a header
+ * packet before it asks for the data with 'C' or 'G'. Returns 1 on success,
+ * 0 on cancel or after MAX_ERRORS attempts.
+ */
+static int32_t send_until(uint8_t seqno, uint32_t packet_size, int32_t expected)
+{
+    uint32_t errors;
+    int32_t  reply;
+
+    for(errors = 0; errors < MAX_ERRORS; errors++)
+    {
+        send_packet(seqno, packet_size);
+
+        reply = wait_reply(SEND_TIMEOUT);
+        if((ACK == reply) && (ACK != expected))
+        {
+            reply = wait_reply(SEND_TIMEOUT);
+        }
+
+        if(expected == reply)
+        {
+            return 1;
+        }
+
+        if(CAN == reply)
+        {
+            return 0;
+        }
+    }
+
+    return 0;
+}
+
+
+/***************************************************************************//**
+ * Waits for the receiver to ask for a file. Returns CRC, YMG, or -1 on timeout
+ * or cancel.
+ */
+static int32_t wait_start(void)
+{
+    uint32_t seconds;
+    int32_t  reply;
+
+    for(seconds = 0; seconds < SEND_START_TIMEOUT; seconds++)
+    {
+        reply = wait_reply(1);
+        if((CRC == reply) || (YMG == reply))
+        {
+            return reply;
+        }
+
+        if(CAN == reply)
+        {
+            break;
+        }
+    }
+
+    return -1;
+}
+
+
+/***************************************************************************//**
+ * Sends a file of length bytes named file_name as a YMODEM batch of one file,
+ * reading its data with read as each packet is sent. Returns the length sent,
+ * or 0 on error.
+ */
+uint32_t ymodem_send(ymodem_read_t read, void *context, uint32_t length,
+                     const uint8_t *file_name)
+{
+    uint8_t  *data = g_packet_data + PACKET_HEADER;
+    uint32_t offset;
+    uint32_t count;
+    uint32_t packet_size;
+    uint32_t index;
+    uint32_t errors;
+    uint8_t  seqno;
+    int32_t  mode;
+    int32_t  reply;
+
+    mode = wait_start();
+    if(mode < 0)
+    {
+        return 0;
+    }
+
+    /* Header packet: file name, nul, file size in decimal, nul */
+    memset(data, 0, PACKET_SIZE);
+    for(index = 0; file_name[index] && (index < FILE_NAME_LENGTH); index++)
+    {
+        data[index] = file_name[index];
+    }
+
+    ++index; /* Step over nul */
+
+    count = 1;
+    while((length / count) >= 10)
+    {
+        count *= 10;
+    }
+
+    for(; count != 0; count /= 10)
+    {
+        data[index++] = (uint8_t)('0' + ((length / count) % 10));
+    }
+
+    if(!send_until(0, PACKET_SIZE, mode))
+    {
+        return 0;
+    }
+
+    seqno = 1;
+    for(offset = 0; offset < length; offset += count)
+    {
+        count = length - offset;
+        packet_size = (count > PACKET_SIZE) ? PACKET_1K_SIZE : PACKET_SIZE;
+        if(count > packet_size)
+        {
+            count = packet_size;
+        }
+
+        if(0 != read(context, offset, data, count))
+        {
+            _putchar(CAN);
+            _putchar(CAN);
+            _sleep(1);
+            return 0;
+        }
+
+        /* Pad the last packet */
+        memset(data + count, CPMEOF, packet_size - count);
+
+        if(YMG == mode)
+        {
+            send_packet(seqno, packet_size);
+
+            /* Nothing is expected back but a cancel */
+            if((CAN == _getchar(0)) && (CAN == _getchar(PACKET_TIMEOUT)))
+            {
+                return 0;
+            }
+        }
+        else if(!send_until(seqno, packet_size, ACK))
+        {
+            _putchar(CAN);
+            _putchar(CAN);
+            _sleep(1);
+            return 0;
+        }
+
+        ++seqno;
+    }
+
+    /* Some receivers NAK the first EOT to make sure it is not line noise */
+    for(errors = 0; errors < MAX_ERRORS; errors++)
+    {
+        _putchar(EOT);
+        reply = wait_reply(SEND_TIMEOUT);
+        if((ACK == reply) || (CAN == reply))
+        {
+            break;
+        }
+    }
+
+    if(ACK != reply)
+    {
+        return 0;
+    }
+
+    /* Empty header packet closes the batch. The file is complete even if the
+     * receiver does not answer it. */
+    if(wait_start() >= 0)
+    {
+        memset(data, 0, PACKET_SIZE);
+        send_packet(0, PACKET_SIZE);
+        (void)wait_reply(SEND_TIMEOUT);
+    }
+
+    return length;
+}
+
 #endif /* SF2BL_COMMS_OPTION == SF2BL_COMMS_YMODEM */
@@ -47,13 +47,43 @@
 #define NAK (0x15)      /* receiver error; retry */
 #define CAN (0x18)      /* two of these in succession aborts transfer */
 #define CRC (0x43)      /* use in place of first NAK for CRC mode */
+#define RES (0x52)      /* 'R', resume offset reply to a "+resume" header */
+#define YMG (0x47)      /* 'G', start of a YMODEM-G transfer, no ACKs */
+#define CPMEOF (0x1A)   /* padding of the last data packet */
+
+/* Resumable downloads, see ymodem_receive(): */
+#define YMODEM_RESUME_TOKEN      "+resume"
+#define YMODEM_RESUME_BLOCK_SIZE (1024)
+#ifndef YMODEM_RESUME_MAX_BLOCKS
+#define YMODEM_RESUME_MAX_BLOCKS (64)      /* 64 KB of 1K blocks, the LSRAM */
+#endif
 
 /* Number of consecutive receive errors before giving up: */
 #define MAX_ERRORS    (5)
 
+/* Sender timeouts in seconds, for the receiver to start and for each reply: */
+#define SEND_START_TIMEOUT (60)
+#define SEND_TIMEOUT       (10)
+
+/* Receives the data of a file at offset, returns 0 to continue, other values
+ * to cancel the transfer: */
+typedef int32_t (*ymodem_write_t)(void *context, uint32_t offset,
+                                  const uint8_t *data, uint32_t length);
+
+/* Places length bytes of the file from offset in data, returns 0 to continue,
+ * other values to cancel the transfer: */
+typedef int32_t (*ymodem_read_t)(void *context, uint32_t offset,
+                                 uint8_t *data, uint32_t length);
+
 void sf2bl_ymodem_init(void);
 void sf2bl_ymodem_deinit(void);
 uint32_t ymodem_receive(uint8_t *buf, uint32_t length, uint8_t *file_name);
+uint32_t ymodem_receive_stream(ymodem_write_t write, void *context,
+                               uint32_t length, uint8_t *file_name);
+uint32_t ymodem_resume_offset(const uint8_t *buf);
+void ymodem_resume_clear(void);
+uint32_t ymodem_send(ymodem_read_t read, void *context, uint32_t length,
+                     const uint8_t *file_name);
 uint16_t sf2bl_crc16(const uint8_t *buf, uint32_t count);
 void _putchar(int32_t data);
 void _putstring(uint8_t *string);
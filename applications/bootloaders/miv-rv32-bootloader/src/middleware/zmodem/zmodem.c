@@ -0,0 +1,902 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file zmodem.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief ZMODEM file receiver.
+ *
+ * See zmodem.h for details of how to use this module.
+ */
+#include <string.h>
+#include "drivers/fabric_ip/CoreUARTapb/core_uart_apb.h"
+#include "miv_rv32_hal/miv_rv32_deadline.h"
+#include "zmodem.h"
+
+extern UART_instance_t g_uart;
+
+/* Framing */
+#define ZPAD                            '*'
+#define ZDLE                            0x18u
+#define ZBIN                            'A'
+#define ZHEX                            'B'
+#define ZBIN32                          'C'
+
+/* Data subpacket ends, following a ZDLE */
+#define ZCRCE                           'h'     /* End of frame, header follows */
+#define ZCRCG                           'i'     /* Frame continues */
+#define ZCRCQ                           'j'     /* Frame continues, ZACK expected */
+#define ZCRCW                           'k'     /* End of frame, ZACK expected */
+#define ZRUB0                           'l'     /* Escaped 0x7F */
+#define ZRUB1                           'm'     /* Escaped 0xFF */
+
+/* Frame types */
+#define ZRQINIT                         0u
+#define ZRINIT                          1u
+#define ZSINIT                          2u
+#define ZACK                            3u
+#define ZFILE                           4u
+#define ZSKIP                           5u
+#define ZNAK                            6u
+#define ZABORT                          7u
+#define ZFIN                            8u
+#define ZRPOS                           9u
+#define ZDATA                           10u
+#define ZEOF                            11u
+#define ZFERR                           12u
+
+/* ZRINIT capabilities, in ZF0 */
+#define CANFDX                          0x01u   /* Full duplex */
+#define CANOVIO                         0x02u   /* Receives during disk I/O */
+#define CANFC32                         0x20u   /* 32 bit CRC */
+
+#define XON                             0x11u
+#define XOFF                            0x13u
+
+/* get_byte() and get_escaped() results other than a byte */
+#define ZM_TIMEOUT                      (-1)
+#define ZM_ERROR                        (-2)
+#define ZM_CANCELLED                    (-3)
+
+/* Flags a subpacket end returned by get_escaped() */
+#define GOT_FRAME_END                   0x100
+
+/* Wait for the next byte of a header or of a block, in milliseconds */
+#define ZMODEM_TIMEOUT                  1000u
+
+/* Consecutive errors once the transfer has started before it is cancelled */
+#define ZMODEM_MAX_ERRORS               10u
+
+/* Bytes skipped while looking for a header, those the sender streamed after a
+ * block with an error included, before the request is sent again */
+#define ZMODEM_MAX_GARBAGE              32768u
+
+/* Consecutive CAN bytes from the sender which cancel the transfer */
+#define ZMODEM_CAN_COUNT                5u
+
+/*
+ * Interrupted transfer, resumed when the same file is sent again to the same
+ * destination.
+ */
+static struct
+{
+    ymodem_write_t write;
+    const void * context;
+    uint32_t size;
+    uint32_t position;
+    uint8_t file_name[FILE_NAME_LENGTH + 1];
+} g_resume;
+
+static zmodem_stats_t g_stats;
+
+/* Block buffer, with room for the subpacket end included in its CRC */
+static uint8_t g_block[ZMODEM_BLOCK_SIZE + 1u];
+
+/* The data subpackets which follow the last header use a 32 bit CRC */
+static uint8_t g_crc32;
+
+/* Bytes received since the end of the last header, reset by get_header() */
+static uint32_t g_garbage;
+
+/*
+ * CRC-16/XMODEM of one byte, the CRC of the YMODEM packets.
+ */
+static uint16_t
+crc16_update
+(
+    uint16_t crc,
+    uint8_t c
+)
+{
+    uint32_t bit;
+
+    crc ^= (uint16_t)((uint16_t)c << 8);
+    for (bit = 0u; bit < 8u; ++bit)
+    {
+        crc = (0u != (crc & 0x8000u)) ? (uint16_t)((crc << 1) ^ 0x1021u) :
+                                        (uint16_t)(crc << 1);
+    }
+
+    return crc;
+}
+
+/*
+ * CRC-32 of one byte, reflected polynomial 0xEDB88320. The CRC starts at
+ * 0xFFFFFFFF and is inverted at the end.
+ */
+static uint32_t
+crc32_update
+(
+    uint32_t crc,
+    uint8_t c
+)
+{
+    static const uint32_t nibble[16] =
+    {
+        0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu,
+        0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+        0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu,
+        0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu
+    };
+
+    crc ^= c;
+    crc = (crc >> 4) ^ nibble[crc & 0x0Fu];
+    crc = (crc >> 4) ^ nibble[crc & 0x0Fu];
+
+    return crc;
+}
+
+/*
+ * Next byte from the UART, or ZM_TIMEOUT.
+ */
+static int32_t
+get_byte
+(
+    uint32_t timeout_ms
+)
+{
+    deadline_t deadline = deadline_in_ms(timeout_ms);
+    uint8_t rx_byte;
+
+    do
+    {
+        if (0u != UART_get_rx(&g_uart, &rx_byte, 1u))
+        {
+            ++g_garbage;
+            return (int32_t)rx_byte;
+        }
+    } while (!deadline_expired(deadline));
+
+    ++g_stats.timeouts;
+
+    return ZM_TIMEOUT;
+}
+
+/*
+ * Next byte of a binary header or of a data subpacket, with the ZDLE escapes
+ * removed. The end of a subpacket is returned with GOT_FRAME_END set.
+ */
+static int32_t
+get_escaped
+(
+    void
+)
+{
+    int32_t c;
+    uint32_t cans = 1u;
+
+    do
+    {
+        c = get_byte(ZMODEM_TIMEOUT);
+        if (c < 0)
+        {
+            return c;
+        }
+    } while ((XON == (c & 0x7F)) || (XOFF == (c & 0x7F)));
+
+    if (ZDLE != c)
+    {
+        return c;
+    }
+
+    for (;;)
+    {
+        c = get_byte(ZMODEM_TIMEOUT);
+        if (c < 0)
+        {
+            return c;
+        }
+
+        switch (c)
+        {
+        case ZDLE:
+            if (++cans >= ZMODEM_CAN_COUNT)
+            {
+                return ZM_CANCELLED;
+            }
+            break;
+
+        case ZCRCE:
+        case ZCRCG:
+        case ZCRCQ:
+        case ZCRCW:
+            return c | GOT_FRAME_END;
+
+        case ZRUB0:
+            return 0x7F;
+
+        case ZRUB1:
+            return 0xFF;
+
+        case XON:
+        case XON | 0x80:
+        case XOFF:
+        case XOFF | 0x80:
+            break;
+
+        default:
+            return (0x40 == (c & 0x60)) ? (c ^ 0x40) : ZM_ERROR;
+        }
+    }
+}
+
+static int32_t
+hex_digit
+(
+    void
+)
+{
+    int32_t c = get_byte(ZMODEM_TIMEOUT);
+
+    if (c < 0)
+    {
+        return c;
+    }
+
+    c &= 0x7F;
+    if ((c >= '0') && (c <= '9'))
+    {
+        return c - '0';
+    }
+    if ((c >= 'a') && (c <= 'f'))
+    {
+        return c - 'a' + 10;
+    }
+
+    return ZM_ERROR;
+}
+
+/*
+ * Wait for a header. Returns its frame type and places its four data bytes in
+ * hdr, or returns ZM_TIMEOUT, ZM_ERROR or ZM_CANCELLED.
+ */
+static int32_t
+get_header
+(
+    uint8_t * hdr
+)
+{
+    uint8_t raw[7];
+    uint32_t crc32;
+    uint32_t count;
+    uint32_t idx;
+    uint16_t crc16;
+    uint32_t cans = 0u;
+    uint8_t pad = 0u;
+    int32_t high;
+    int32_t low;
+    int32_t c;
+
+    g_garbage = 0u;
+
+    /* ZPAD ZDLE format, after any data the sender streamed before our request.
+     * The escapes in that data can look like the start of a header. */
+    for (;;)
+    {
+        if (g_garbage > ZMODEM_MAX_GARBAGE)
+        {
+            return ZM_ERROR;
+        }
+
+        c = get_byte(ZMODEM_TIMEOUT);
+        if (c < 0)
+        {
+            return c;
+        }
+
+        if (ZPAD == (c & 0x7F))
+        {
+            pad = 1u;
+            cans = 0u;
+        }
+        else if ((ZDLE == c) && pad)
+        {
+            c = get_byte(ZMODEM_TIMEOUT);
+            if (c < 0)
+            {
+                return c;
+            }
+            if ((ZBIN == c) || (ZHEX == c) || (ZBIN32 == c))
+            {
+                break;
+            }
+            pad = 0u;
+        }
+        else
+        {
+            pad = 0u;
+            cans = (ZDLE == c) ? (cans + 1u) : 0u;
+            if (cans >= ZMODEM_CAN_COUNT)
+            {
+                return ZM_CANCELLED;
+            }
+        }
+    }
+
+    if (ZHEX == c)
+    {
+        /* Frame type, four data bytes and the CRC-16 as hex digits */
+        for (idx = 0u; idx < sizeof(raw); ++idx)
+        {
+            high = hex_digit();
+            low = (high < 0) ? high : hex_digit();
+            if (low < 0)
+            {
+                return low;
+            }
+            raw[idx] = (uint8_t)((high << 4) | low);
+        }
+
+        crc16 = 0u;
+        for (idx = 0u; idx < sizeof(raw); ++idx)
+        {
+            crc16 = crc16_update(crc16, raw[idx]);
+        }
+
+        /* CR LF, the following XON is skipped with the garbage */
+        if (0x0D == (get_byte(ZMODEM_TIMEOUT) & 0x7F))
+        {
+            (void)get_byte(ZMODEM_TIMEOUT);
+        }
+    }
+    else
+    {
+        /* Frame type, four data bytes and a CRC-16 or CRC-32, escaped */
+        count = (ZBIN32 == c) ? 9u : 7u;
+        crc16 = 0u;
+        crc32 = 0xFFFFFFFFu;
+        for (idx = 0u; idx < count; ++idx)
+        {
+            c = get_escaped();
+            if (c < 0)
+            {
+                return c;
+            }
+            if (c >= GOT_FRAME_END)
+            {
+                return ZM_ERROR;
+            }
+            if (idx < 5u)
+            {
+                raw[idx] = (uint8_t)c;
+            }
+            crc16 = crc16_update(crc16, (uint8_t)c);
+            crc32 = crc32_update(crc32, (uint8_t)c);
+        }
+
+        /* A CRC-32 followed by its own bytes, sent LSB first, leaves this
+         * residue */
+        if (9u == count)
+        {
+            crc16 = (0xDEBB20E3u == crc32) ? 0u : 1u;
+        }
+        g_crc32 = (9u == count) ? 1u : 0u;
+    }
+
+    if (0u != crc16)
+    {
+        ++g_stats.crc_errors;
+        return ZM_ERROR;
+    }
+
+    memcpy(hdr, &raw[1], 4u);
+
+    return (int32_t)raw[0];
+}
+
+/*
+ * Receive a data subpacket into g_block. Returns its end, ZCRCE to ZCRCW, or
+ * ZM_TIMEOUT, ZM_ERROR or ZM_CANCELLED.
+ */
+static int32_t
+get_data
+(
+    uint32_t * length
+)
+{
+    uint32_t crc32 = 0xFFFFFFFFu;
+    uint16_t crc16 = 0u;
+    uint32_t count = 0u;
+    uint32_t idx;
+    int32_t end;
+    int32_t c;
+
+    for (;;)
+    {
+        c = get_escaped();
+        if (c < 0)
+        {
+            return c;
+        }
+
+        if (c >= GOT_FRAME_END)
+        {
+            break;
+        }
+
+        if (count >= ZMODEM_BLOCK_SIZE)
+        {
+            return ZM_ERROR;
+        }
+
+        g_block[count] = (uint8_t)c;
+        ++count;
+    }
+
+    /* The CRC covers the data, the subpacket end and the CRC itself */
+    end = c & 0xFF;
+    g_block[count] = (uint8_t)end;
+    for (idx = 0u; idx <= count; ++idx)
+    {
+        if (g_crc32)
+        {
+            crc32 = crc32_update(crc32, g_block[idx]);
+        }
+        else
+        {
+            crc16 = crc16_update(crc16, g_block[idx]);
+        }
+    }
+
+    for (idx = 0u; idx < (g_crc32 ? 4u : 2u); ++idx)
+    {
+        c = get_escaped();
+        if (c < 0)
+        {
+            return c;
+        }
+        if (c >= GOT_FRAME_END)
+        {
+            return ZM_ERROR;
+        }
+        crc16 = crc16_update(crc16, (uint8_t)c);
+        crc32 = crc32_update(crc32, (uint8_t)c);
+    }
+
+    if ((g_crc32 && (0xDEBB20E3u != crc32)) || (!g_crc32 && (0u != crc16)))
+    {
+        ++g_stats.crc_errors;
+        return ZM_ERROR;
+    }
+
+    *length = count;
+
+    return end;
+}
+
+/*
+ * Send a hex header. value holds ZP0 in its low byte to ZP3 (ZF0) in its high
+ * byte: a file offset, or the ZRINIT buffer size and capabilities.
+ */
+static void
+send_header
+(
+    uint8_t type,
+    uint32_t value
+)
+{
+    static const uint8_t hex[16] = "0123456789abcdef";
+    uint8_t frame[22];
+    uint8_t raw[7];
+    uint16_t crc = 0u;
+    uint32_t size;
+    uint32_t idx;
+
+    raw[0] = type;
+    for (idx = 1u; idx < 5u; ++idx)
+    {
+        raw[idx] = (uint8_t)value;
+        value >>= 8;
+    }
+    for (idx = 0u; idx < 5u; ++idx)
+    {
+        crc = crc16_update(crc, raw[idx]);
+    }
+    raw[5] = (uint8_t)(crc >> 8);
+    raw[6] = (uint8_t)crc;
+
+    frame[0] = ZPAD;
+    frame[1] = ZPAD;
+    frame[2] = ZDLE;
+    frame[3] = ZHEX;
+    for (idx = 0u; idx < sizeof(raw); ++idx)
+    {
+        frame[4u + (2u * idx)] = hex[raw[idx] >> 4];
+        frame[5u + (2u * idx)] = hex[raw[idx] & 0x0Fu];
+    }
+    frame[18] = 0x0D;
+    frame[19] = 0x8A;
+    size = 20u;
+
+    /* Restart a sender stopped by an XOFF, except at the end of the session */
+    if ((ZFIN != type) && (ZACK != type))
+    {
+        frame[size++] = XON;
+    }
+
+    UART_send(&g_uart, frame, size);
+}
+
+/*
+ * Cancel the transfer, leaving the resume record for a later attempt.
+ */
+static void
+cancel
+(
+    void
+)
+{
+    static const uint8_t canit[16] =
+    {
+        CAN, CAN, CAN, CAN, CAN, CAN, CAN, CAN,
+        0x08u, 0x08u, 0x08u, 0x08u, 0x08u, 0x08u, 0x08u, 0x08u
+    };
+
+    UART_send(&g_uart, canit, sizeof(canit));
+}
+
+static uint32_t
+str_to_u32
+(
+    const uint8_t * str,
+    const uint8_t * end
+)
+{
+    uint32_t value = 0u;
+
+    while ((str < end) && (*str >= '0') && (*str <= '9'))
+    {
+        value = (value * 10u) + (uint32_t)(*str - '0');
+        ++str;
+    }
+
+    return value;
+}
+
+/*
+ * Take the name and size from the ZFILE subpacket and return the offset to
+ * start the file at.
+ */
+static uint32_t
+start_file
+(
+    ymodem_write_t write,
+    const void * context,
+    uint32_t block_length,
+    uint8_t * file_name,
+    uint32_t * size
+)
+{
+    const uint8_t * end = &g_block[block_length];
+    const uint8_t * field = g_block;
+    uint32_t idx = 0u;
+
+    while ((field < end) && (0u != *field) && (idx < FILE_NAME_LENGTH))
+    {
+        file_name[idx++] = *field++;
+    }
+    file_name[idx] = 0u;
+
+    while ((field < end) && (0u != *field))
+    {
+        ++field;
+    }
+
+    /* The size is 0 when the sender does not give it */
+    *size = str_to_u32(field + 1, end);
+
+    if ((write == g_resume.write) && (context == g_resume.context) &&
+        (*size == g_resume.size) &&
+        (0 == strcmp((const char *)file_name, (const char *)g_resume.file_name)))
+    {
+        return g_resume.position;
+    }
+
+    g_resume.write = write;
+    g_resume.context = context;
+    g_resume.size = *size;
+    g_resume.position = 0u;
+    strcpy((char *)g_resume.file_name, (const char *)file_name);
+
+    return 0u;
+}
+
+/*
+ * Receive the data subpackets which follow a ZDATA header at position and pass
+ * them to write. Returns 0 when the frame ended normally, ZM_CANCELLED when
+ * write failed or the sender cancelled, another negative value to request the
+ * data again from the new position.
+ */
+static int32_t
+receive_frame
+(
+    ymodem_write_t write,
+    void * context,
+    uint32_t length,
+    uint32_t * position
+)
+{
+    uint32_t count;
+    int32_t end;
+
+    for (;;)
+    {
+        end = get_data(&count);
+        if (end < 0)
+        {
+            return end;
+        }
+
+        if ((count > (length - *position)) ||
+            ((0u != count) && (0 != write(context, *position, g_block, count))))
+        {
+            return ZM_CANCELLED;
+        }
+        *position += count;
+        g_resume.position = *position;
+
+        if ((ZCRCQ == end) || (ZCRCW == end))
+        {
+            send_header(ZACK, *position);
+        }
+
+        if ((ZCRCE == end) || (ZCRCW == end))
+        {
+            return 0;
+        }
+    }
+}
+
+/***************************************************************************//**
+ * zmodem_receive()
+ * See "zmodem.h" for details of how to use this function.
+ */
+uint32_t
+zmodem_receive
+(
+    ymodem_write_t write,
+    void * context,
+    uint32_t length,
+    uint8_t * file_name,
+    uint32_t window
+)
+{
+    uint8_t hdr[4];
+    uint32_t rx_init;
+    uint32_t position = 0u;
+    uint32_t size = 0u;
+    uint32_t received = 0u;
+    uint32_t errors = 0u;
+    uint32_t frame_length;
+    uint8_t started = 0u;
+    uint8_t in_file = 0u;
+    uint8_t file_done = 0u;
+    int32_t type;
+
+    memset(&g_stats, 0, sizeof(g_stats));
+    file_name[0] = 0u;
+
+    /* Without a window the sender streams the whole file. With one, it waits
+     * for a ZACK after each window, which is only sent once it is written. */
+    rx_init = (window & 0xFFFFu) |
+              ((uint32_t)(CANFDX | CANFC32 |
+                          ((ZMODEM_STREAMING == window) ? CANOVIO : 0u)) << 24);
+    send_header(ZRINIT, rx_init);
+
+    for (;;)
+    {
+        type = get_header(hdr);
+
+        if (type >= 0)
+        {
+            started = 1u;
+        }
+
+        switch (type)
+        {
+        case ZM_CANCELLED:
+            return 0u;
+
+        case ZM_TIMEOUT:
+        case ZM_ERROR:
+            /* Wait as long as needed for the sender to start */
+            if (started && (++errors >= ZMODEM_MAX_ERRORS))
+            {
+                cancel();
+                return 0u;
+            }
+            if (in_file)
+            {
+                ++g_stats.repositions;
+                send_header(ZRPOS, position);
+            }
+            else
+            {
+                send_header(ZRINIT, rx_init);
+            }
+            break;
+
+        case ZRQINIT:
+            send_header(ZRINIT, rx_init);
+            break;
+
+        case ZSINIT:
+            /* The sender's escape requirements and attention string are
+             * not used, all control characters are accepted escaped */
+            if (get_data(&frame_length) >= 0)
+            {
+                send_header(ZACK, 0u);
+            }
+            else
+            {
+                send_header(ZNAK, 0u);
+            }
+            break;
+
+        case ZFILE:
+            if (get_data(&frame_length) < 0)
+            {
+                send_header(ZNAK, 0u);
+                break;
+            }
+
+            if (file_done)
+            {
+                /* One file per session */
+                send_header(ZSKIP, 0u);
+                break;
+            }
+
+            position = start_file(write, context, frame_length, file_name, &size);
+            if (size > length)
+            {
+                send_header(ZSKIP, 0u);
+                break;
+            }
+
+            g_stats.resumed_at = position;
+            in_file = 1u;
+            errors = 0u;
+            send_header(ZRPOS, position);
+            break;
+
+        case ZDATA:
+            if (!in_file)
+            {
+                send_header(ZRINIT, rx_init);
+                break;
+            }
+
+            /* Data from another offset was sent before our last ZRPOS */
+            if ((uint32_t)hdr[0] + ((uint32_t)hdr[1] << 8) +
+                ((uint32_t)hdr[2] << 16) + ((uint32_t)hdr[3] << 24) != position)
+            {
+                break;
+            }
+
+            type = receive_frame(write, context, length, &position);
+            if (ZM_CANCELLED == type)
+            {
+                cancel();
+                return 0u;
+            }
+            if (type < 0)
+            {
+                if (++errors >= ZMODEM_MAX_ERRORS)
+                {
+                    cancel();
+                    return 0u;
+                }
+                ++g_stats.repositions;
+                send_header(ZRPOS, position);
+            }
+            else
+            {
+                errors = 0u;
+            }
+            break;
+
+        case ZEOF:
+            /* Ignored when data is missing, the sender is asked for it
+             * when the wait for the next header times out */
+            if (in_file &&
+                ((uint32_t)hdr[0] + ((uint32_t)hdr[1] << 8) +
+                 ((uint32_t)hdr[2] << 16) + ((uint32_t)hdr[3] << 24) == position))
+            {
+                in_file = 0u;
+                file_done = 1u;
+                received = position;
+                zmodem_resume_clear();
+                send_header(ZRINIT, rx_init);
+            }
+            else if (file_done)
+            {
+                /* Our ZRINIT was lost */
+                send_header(ZRINIT, rx_init);
+            }
+            break;
+
+        case ZFIN:
+            send_header(ZFIN, 0u);
+
+            /* "OO", over and out */
+            (void)get_byte(ZMODEM_TIMEOUT);
+            (void)get_byte(ZMODEM_TIMEOUT);
+            return received;
+
+        case ZABORT:
+        case ZFERR:
+            send_header(ZFIN, 0u);
+            return 0u;
+
+        default:
+            /* ZCOMMAND and others are not supported */
+            cancel();
+            return 0u;
+        }
+    }
+}
+
+/***************************************************************************//**
+ * zmodem_resume_offset()
+ * See "zmodem.h" for details of how to use this function.
+ */
+uint32_t
+zmodem_resume_offset
+(
+    ymodem_write_t write,
+    const void * context
+)
+{
+    return ((write == g_resume.write) && (context == g_resume.context)) ?
+           g_resume.position : 0u;
+}
+
+/***************************************************************************//**
+ * zmodem_resume_clear()
+ * See "zmodem.h" for details of how to use this function.
+ */
+void
+zmodem_resume_clear
+(
+    void
+)
+{
+    g_resume.write = 0;
+    g_resume.context = 0;
+    g_resume.position = 0u;
+}
+
+/***************************************************************************//**
+ * zmodem_get_stats()
+ * See "zmodem.h" for details of how to use this function.
+ */
+const zmodem_stats_t *
+zmodem_get_stats
+(
+    void
+)
+{
+    return &g_stats;
+}
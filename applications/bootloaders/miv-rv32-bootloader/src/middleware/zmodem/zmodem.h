@@ -0,0 +1,135 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file zmodem.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief ZMODEM file receiver.
+ *
+ * ZMODEM receiver for the bootloader UART, an alternative to YMODEM for large
+ * images:
+ *  - the sender streams the file without waiting for an acknowledgement of
+ *    each block. The receiver only answers at the end of the file, or at the
+ *    end of each window when a window is set,
+ *  - a block received with a CRC error, or missed, is requested again from its
+ *    file offset with ZRPOS. The sender goes back to that offset, the blocks
+ *    before it are not sent again,
+ *  - data blocks are protected by a 32 bit CRC,
+ *  - a transfer which was interrupted is resumed from the last offset written,
+ *    when the same file is sent again to the same destination.
+ *
+ * The file is passed to a ymodem_write_t function as it is received, in order,
+ * so it can be copied to RAM or programmed into the SPI flash as for
+ * ymodem_receive_stream().
+ *
+ * The receiver uses the g_uart CoreUARTapb instance of the application, as the
+ * YMODEM receiver does, and times out with MTIME deadlines, see
+ * miv_rv32_deadline.h. Only one file is received per session, any other file
+ * offered is skipped.
+ */
+#ifndef ZMODEM_H_
+#define ZMODEM_H_
+
+#include <stdint.h>
+#include "ymodem/ymodem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+ * Largest data subpacket accepted. ZMODEM senders send at most 1024 bytes per
+ * subpacket.
+ */
+#define ZMODEM_BLOCK_SIZE               1024u
+
+/*------------------------------------------------------------------------------
+ * window value of zmodem_receive() for a destination which can be written
+ * while the next block is received, RAM for example.
+ */
+#define ZMODEM_STREAMING                0u
+
+/*------------------------------------------------------------------------------
+ * Counts of the last transfer, see zmodem_get_stats().
+ */
+typedef struct
+{
+    uint32_t resumed_at;    /* File offset the transfer started from */
+    uint32_t crc_errors;    /* Headers and blocks with a CRC error */
+    uint32_t timeouts;      /* Waits for the sender which timed out */
+    uint32_t repositions;   /* ZRPOS sent to get the sender back to an offset */
+} zmodem_stats_t;
+
+/***************************************************************************//**
+ * zmodem_receive() receives one file from a ZMODEM sender and passes it to
+ * write as it is received.
+ *
+ * @param write
+ *      Function called with each block of the file, at increasing offsets. A
+ *      non zero return value cancels the transfer.
+ *
+ * @param context
+ *      Passed to write.
+ *
+ * @param length
+ *      Largest file accepted. Larger files are skipped.
+ *
+ * @param file_name
+ *      Receives the name of the file, FILE_NAME_LENGTH + 1 bytes.
+ *
+ * @param window
+ *      ZMODEM_STREAMING when write returns before the UART receiver can
+ *      overflow. Otherwise the number of bytes the sender may send before it
+ *      waits for an acknowledgement; the receiver only acknowledges them once
+ *      they are written. Use ZMODEM_BLOCK_SIZE for a destination as slow as a
+ *      flash page program.
+ *
+ * @return
+ *      The length of the file received, or 0 on error or cancellation.
+ */
+uint32_t
+zmodem_receive
+(
+    ymodem_write_t write,
+    void * context,
+    uint32_t length,
+    uint8_t * file_name,
+    uint32_t window
+);
+
+/***************************************************************************//**
+ * zmodem_resume_offset() returns the number of bytes of an interrupted file
+ * already passed to write with context, 0 if there is no transfer to resume.
+ */
+uint32_t
+zmodem_resume_offset
+(
+    ymodem_write_t write,
+    const void * context
+);
+
+/***************************************************************************//**
+ * zmodem_resume_clear() forgets the interrupted transfer, if any. It is called
+ * when the data already written is lost.
+ */
+void
+zmodem_resume_clear
+(
+    void
+);
+
+/***************************************************************************//**
+ * zmodem_get_stats() returns the counts of the last transfer.
+ */
+const zmodem_stats_t *
+zmodem_get_stats
+(
+    void
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZMODEM_H_ */
@@ -22,6 +22,7 @@
 #define NULL_BLOCK_HANDLER     ( ( spi_block_rx_handler_t ) 0u )
 #define NULL_SLAVE_TX_UPDATE_HANDLER ( ( spi_slave_frame_tx_handler_t ) 0u )
 #define NULL_SLAVE_CMD_HANDLER  NULL_BLOCK_HANDLER
+#define NULL_STREAM_HANDLER    ( ( spi_stream_handler_t ) 0u )
 
 #define SPI_ALL_INTS (0xFFu) /* For clearing all active interrupts */
 
@@ -47,6 +48,17 @@ enum {
 static void fill_slave_tx_fifo( spi_instance_t * this_spi );
 static void read_slave_rx_fifo( spi_instance_t * this_spi );
 static void recover_from_rx_overflow( const spi_instance_t * this_spi );
+static void transfer_block_wide( spi_instance_t * this_spi,
+                                 const uint8_t * cmd_buffer,
+                                 uint16_t cmd_byte_size,
+                                 uint8_t * rx_buffer,
+                                 uint16_t rx_byte_size );
+static void fill_slave_stream_tx_fifo( spi_instance_t * this_spi );
+static void service_slave_stream( spi_instance_t * this_spi, uint32_t events );
+static void copy_from_ring( uint8_t * dst, const uint8_t * ring, uint32_t mask,
+                            uint32_t idx, uint32_t size );
+static void copy_to_ring( uint8_t * ring, uint32_t mask, uint32_t idx,
+                          const uint8_t * src, uint32_t size );
 
 /*******************************************************************************
  * SPI_init()
@@ -78,6 +90,7 @@ void SPI_init
 
         /* Configure CoreSPI instance attributes */
         this_spi->base_addr = (addr_t)base_addr;
+        this_spi->frame_bytes = 1u;
 
         /* Store FIFO depth or fall back to minimum if out of range */
         if( ( SPI_MAX_FIFO_DEPTH  >= fifo_depth ) && ( SPI_MIN_FIFO_DEPTH  <= fifo_depth ) )
@@ -111,6 +124,30 @@ void SPI_init
     }
 }
 
+/***************************************************************************//**
+ * SPI_set_frame_width()
+ * See "core_spi.h" for details of how to use this function.
+ */
+void SPI_set_frame_width
+(
+    spi_instance_t * this_spi,
+    uint8_t frame_width
+)
+{
+    HAL_ASSERT( NULL_INSTANCE != this_spi );
+    HAL_ASSERT( ( SPI_FRAME_WIDTH_8 == frame_width ) ||
+                ( SPI_FRAME_WIDTH_16 == frame_width ) ||
+                ( SPI_FRAME_WIDTH_32 == frame_width ) );
+
+    if( ( NULL_INSTANCE != this_spi ) &&
+        ( ( SPI_FRAME_WIDTH_8 == frame_width ) ||
+          ( SPI_FRAME_WIDTH_16 == frame_width ) ||
+          ( SPI_FRAME_WIDTH_32 == frame_width ) ) )
+    {
+        this_spi->frame_bytes = (uint8_t)( frame_width / 8u );
+    }
+}
+
 /***************************************************************************//**
  * SPI_configure_slave_mode()
  * See "core_spi.h" for details of how to use this function.
@@ -306,7 +343,11 @@ void SPI_transfer_block
 
     HAL_ASSERT( NULL_INSTANCE != this_spi );
 
-    if( NULL_INSTANCE != this_spi )
+    if( ( NULL_INSTANCE != this_spi ) && ( this_spi->frame_bytes > 1u ) )
+    {
+        transfer_block_wide( this_spi, cmd_buffer, cmd_byte_size, rx_buffer, rx_byte_size );
+    }
+    else if( NULL_INSTANCE != this_spi )
     {
         /* This function is only intended to be used with an SPI master. */
         if( ( DISABLE != HAL_get_8bit_reg_field(this_spi->base_addr, CTRL1_MASTER ) ) &&
@@ -700,6 +741,184 @@ void SPI_set_slave_block_buffers
     }
 }
 
+/***************************************************************************//**
+ * SPI_set_slave_stream_buffers()
+ * See "core_spi.h" for details of how to use this function.
+ */
+void SPI_set_slave_stream_buffers
+(
+    spi_instance_t * this_spi,
+    uint8_t * rx_ring,
+    uint32_t rx_ring_size,
+    uint32_t rx_watermark,
+    uint8_t * tx_ring,
+    uint32_t tx_ring_size,
+    uint32_t tx_watermark,
+    spi_stream_handler_t stream_handler
+)
+{
+    HAL_ASSERT( NULL_INSTANCE != this_spi );
+    /* Ring sizes must be powers of two, 0 for no ring */
+    HAL_ASSERT( 0u == ( rx_ring_size & ( rx_ring_size - 1u ) ) );
+    HAL_ASSERT( 0u == ( tx_ring_size & ( tx_ring_size - 1u ) ) );
+    HAL_ASSERT( ( NULL_BUFF != rx_ring ) || ( 0u == rx_ring_size ) );
+    HAL_ASSERT( ( NULL_BUFF != tx_ring ) || ( 0u == tx_ring_size ) );
+
+    if( ( NULL_INSTANCE != this_spi ) &&
+        ( 0u == ( rx_ring_size & ( rx_ring_size - 1u ) ) ) &&
+        ( 0u == ( tx_ring_size & ( tx_ring_size - 1u ) ) ) &&
+        ( ( NULL_BUFF != rx_ring ) || ( 0u == rx_ring_size ) ) &&
+        ( ( NULL_BUFF != tx_ring ) || ( 0u == tx_ring_size ) ) )
+    {
+        /* This function is only intended to be used with an SPI slave. */
+        if( DISABLE == HAL_get_8bit_reg_field(this_spi->base_addr, CTRL1_MASTER ) )
+        {
+            /* Disable the Core SPI while we configure */
+            HAL_set_8bit_reg_field( this_spi->base_addr, CTRL1_ENABLE, DISABLE );
+
+            /* Make sure correct mode is selected */
+            this_spi->slave_xfer_mode = SPI_SLAVE_XFER_STREAM;
+
+            /* Disable frame and block handlers as they are mutually exclusive with streaming. */
+            this_spi->frame_rx_handler = NULL_FRAME_HANDLER;
+            this_spi->slave_tx_frame_handler = NULL_SLAVE_TX_UPDATE_HANDLER;
+            this_spi->block_rx_handler = NULL_BLOCK_HANDLER;
+
+            /* Assign the rings, an empty ring has a mask of 0 and is never used */
+            this_spi->stream_rx_ring = ( 0u != rx_ring_size ) ? rx_ring : NULL_BUFF;
+            this_spi->stream_rx_mask = rx_ring_size - 1u;
+            this_spi->stream_rx_head = 0u;
+            this_spi->stream_rx_tail = 0u;
+            this_spi->stream_rx_watermark = rx_watermark;
+
+            this_spi->stream_tx_ring = ( 0u != tx_ring_size ) ? tx_ring : NULL_BUFF;
+            this_spi->stream_tx_mask = tx_ring_size - 1u;
+            this_spi->stream_tx_head = 0u;
+            this_spi->stream_tx_tail = 0u;
+            this_spi->stream_tx_watermark = tx_watermark;
+
+            this_spi->stream_handler = stream_handler;
+            memset( &this_spi->stream_stats, 0, sizeof(spi_stream_stats_t) );
+
+            /* Flush the receive and transmit FIFOs */
+            HAL_set_8bit_reg( this_spi->base_addr, CMD, CMD_TXFIFORST_MASK | CMD_RXFIFORST_MASK );
+
+            /* Clear all interrupts */
+            HAL_set_8bit_reg( this_spi->base_addr, INTCLR, SPI_ALL_INTS );
+
+            /* Preload the transmit FIFO, 0s as the transmit ring is empty. */
+            fill_slave_stream_tx_fifo( this_spi );
+
+            /*
+             * Disable TXDATA and TXDONE interrupts, a frame is sent for every
+             * frame received so the transmit FIFO is refilled in rx handling.
+             */
+            HAL_set_8bit_reg_field( this_spi->base_addr, CTRL2_INTTXDATA,   DISABLE );
+            HAL_set_8bit_reg_field( this_spi->base_addr, CTRL1_INTTXDONE,   DISABLE );
+
+            /* Enable Rx, FIFO error and SSEND interrupts */
+            HAL_set_8bit_reg_field( this_spi->base_addr, CTRL1_INTRXOVFLOW, ENABLE );
+            HAL_set_8bit_reg_field( this_spi->base_addr, CTRL1_INTTXURUN,   ENABLE );
+            HAL_set_8bit_reg_field( this_spi->base_addr, CTRL2_INTRXDATA,   ENABLE );
+            HAL_set_8bit_reg_field( this_spi->base_addr, CTRL2_INTSSEND,    ENABLE );
+
+            /* No command phase in a stream */
+            HAL_set_8bit_reg_field( this_spi->base_addr, CTRL2_INTCMD,      DISABLE );
+
+            /* Now enable the CoreSPI */
+            HAL_set_8bit_reg_field( this_spi->base_addr, CTRL1_ENABLE, ENABLE );
+        }
+    }
+}
+
+/***************************************************************************//**
+ * SPI_stream_read()
+ * See "core_spi.h" for details of how to use this function.
+ */
+uint32_t SPI_stream_read
+(
+    spi_instance_t * this_spi,
+    uint8_t * buffer,
+    uint32_t size
+)
+{
+    uint32_t tail;
+    uint32_t count = 0u;
+
+    HAL_ASSERT( NULL_INSTANCE != this_spi );
+
+    if( ( NULL_INSTANCE != this_spi ) && ( NULL_BUFF != this_spi->stream_rx_ring ) )
+    {
+        tail = this_spi->stream_rx_tail;
+        count = this_spi->stream_rx_head - tail;
+        if( count > size )
+        {
+            count = size;
+        }
+
+        copy_from_ring( buffer, this_spi->stream_rx_ring, this_spi->stream_rx_mask,
+                        tail, count );
+
+        /* Only release the bytes once they are copied */
+        this_spi->stream_rx_tail = tail + count;
+    }
+
+    return( count );
+}
+
+/***************************************************************************//**
+ * SPI_stream_write()
+ * See "core_spi.h" for details of how to use this function.
+ */
+uint32_t SPI_stream_write
+(
+    spi_instance_t * this_spi,
+    const uint8_t * buffer,
+    uint32_t size
+)
+{
+    uint32_t head;
+    uint32_t count = 0u;
+
+    HAL_ASSERT( NULL_INSTANCE != this_spi );
+
+    if( ( NULL_INSTANCE != this_spi ) && ( NULL_BUFF != this_spi->stream_tx_ring ) )
+    {
+        head = this_spi->stream_tx_head;
+        count = ( this_spi->stream_tx_mask + 1u ) - ( head - this_spi->stream_tx_tail );
+        if( count > size )
+        {
+            count = size;
+        }
+
+        copy_to_ring( this_spi->stream_tx_ring, this_spi->stream_tx_mask, head,
+                      buffer, count );
+
+        /* Only publish the bytes once they are copied */
+        this_spi->stream_tx_head = head + count;
+    }
+
+    return( count );
+}
+
+/***************************************************************************//**
+ * SPI_get_stream_stats()
+ * See "core_spi.h" for details of how to use this function.
+ */
+void SPI_get_stream_stats
+(
+    const spi_instance_t * this_spi,
+    spi_stream_stats_t * stats
+)
+{
+    HAL_ASSERT( NULL_INSTANCE != this_spi );
+
+    if( NULL_INSTANCE != this_spi )
+    {
+        *stats = this_spi->stream_stats;
+    }
+}
+
 /***************************************************************************//**
  * SPI_set_cmd_handler()
  * See "core_spi.h" for details of how to use this function.
@@ -913,6 +1132,10 @@ void SPI_isr
                     }
                 }
             }
+            else if( SPI_SLAVE_XFER_STREAM == this_spi->slave_xfer_mode ) /* Ring streaming mode. */
+            {
+                service_slave_stream( this_spi, 0u );
+            }
             else /* Slave transfer mode not set up so discard anything in RX FIFO */
             {
                 HAL_set_8bit_reg( this_spi->base_addr, CMD, CMD_RXFIFORST_MASK );
@@ -941,7 +1164,8 @@ void SPI_isr
                 /* Reload slave tx frame into Tx data register. */
                 HAL_set_32bit_reg( this_spi->base_addr, TXLAST, this_spi->slave_tx_frame );
             }
-            else if( SPI_SLAVE_XFER_BLOCK != this_spi->slave_xfer_mode )
+            else if( ( SPI_SLAVE_XFER_BLOCK != this_spi->slave_xfer_mode ) &&
+                     ( SPI_SLAVE_XFER_STREAM != this_spi->slave_xfer_mode ) )
             {
                 /* Slave transfer mode not set up so discard anything in TX FIFO */
                 HAL_set_8bit_reg( this_spi->base_addr, CMD, CMD_TXFIFORST_MASK );
@@ -958,6 +1182,10 @@ void SPI_isr
         /* Handle receive overflow. */
         if( ENABLE == HAL_get_8bit_reg_field(this_spi->base_addr, INTMASK_RXOVERFLOW))
         {
+            if( SPI_SLAVE_XFER_STREAM == this_spi->slave_xfer_mode )
+            {
+                ++this_spi->stream_stats.fifo_overflows;
+            }
             HAL_set_8bit_reg(this_spi->base_addr, CMD, CMD_RXFIFORST_MASK);
             HAL_set_8bit_reg_field(this_spi->base_addr, INTCLR_RXOVERFLOW, ENABLE);
         }
@@ -966,6 +1194,12 @@ void SPI_isr
         if( ENABLE == HAL_get_8bit_reg_field( this_spi->base_addr, INTMASK_TXUNDERRUN ) )
         {
             HAL_set_8bit_reg( this_spi->base_addr, CMD, CMD_TXFIFORST_MASK );
+            if( SPI_SLAVE_XFER_STREAM == this_spi->slave_xfer_mode )
+            {
+                /* The stream relies on a full transmit FIFO, refill it */
+                ++this_spi->stream_stats.fifo_underruns;
+                fill_slave_stream_tx_fifo( this_spi );
+            }
             HAL_set_8bit_reg_field( this_spi->base_addr, INTCLR_TXUNDERRUN, ENABLE );
         }
 
@@ -1033,6 +1267,19 @@ void SPI_isr
 
                 HAL_set_8bit_reg_field( this_spi->base_addr, INTCLR_RXDATA, ENABLE );
             }
+            else if( SPI_SLAVE_XFER_STREAM == this_spi->slave_xfer_mode )
+            {
+                /*
+                 * The stream carries on in the next transaction, only collect
+                 * the last frames and report the end of this one.
+                 */
+                service_slave_stream( this_spi, SPI_STREAM_SSEND );
+                HAL_set_8bit_reg_field( this_spi->base_addr, INTCLR_RXDATA, ENABLE );
+            }
+            else
+            {
+                /* Nothing to do for frame transfers */
+            }
 
             HAL_set_8bit_reg_field( this_spi->base_addr, INTCLR_SSEND, ENABLE );
         }
@@ -1111,6 +1358,282 @@ static void read_slave_rx_fifo
     }
 }
 
+/***************************************************************************//**
+ * Fill the transmit FIFO from the transmit ring, then with 0s, until it is full
+ * (used for slave streaming).
+ */
+static void fill_slave_stream_tx_fifo
+(
+    spi_instance_t * this_spi
+)
+{
+    uint32_t tail = this_spi->stream_tx_tail;
+    uint32_t level = this_spi->stream_tx_head - tail;
+
+    while( !HAL_get_8bit_reg_field( this_spi->base_addr, STATUS_TXFULL ) )
+    {
+        if( 0u != level )
+        {
+            HAL_set_32bit_reg( this_spi->base_addr, TXDATA,
+                               (uint32_t)this_spi->stream_tx_ring[tail & this_spi->stream_tx_mask] );
+            ++tail;
+            --level;
+            ++this_spi->stream_stats.tx_frames;
+        }
+        else
+        {
+            HAL_set_32bit_reg( this_spi->base_addr, TXDATA, 0x00u );
+        }
+    }
+
+    this_spi->stream_tx_tail = tail;
+}
+
+/***************************************************************************//**
+ * Move the received frames to the receive ring and send one frame from the
+ * transmit ring for each of them, then call the stream handler with events
+ * and the watermark events (used for slave streaming).
+ *
+ * Each frame received was clocked against a frame of the transmit FIFO, so
+ * writing as many frames as were read keeps the FIFO full without reading
+ * STATUS_TXFULL for every frame. The ring indexes are kept in locals and only
+ * written back once, the handler sees the updated rings.
+ */
+static void service_slave_stream
+(
+    spi_instance_t * this_spi,
+    uint32_t events
+)
+{
+    uint32_t rx_frame;
+    uint32_t rx_head = this_spi->stream_rx_head;
+    uint32_t rx_free;
+    uint32_t tx_tail = this_spi->stream_tx_tail;
+    uint32_t tx_level;
+    uint32_t nb_frames = 0u;
+    uint32_t nb_stored;
+    uint32_t nb_sent;
+
+    rx_free = ( NULL_BUFF != this_spi->stream_rx_ring ) ?
+              ( this_spi->stream_rx_mask + 1u ) - ( rx_head - this_spi->stream_rx_tail ) : 0u;
+
+    while( 0u == HAL_get_8bit_reg_field( this_spi->base_addr, STATUS_RXEMPTY ) )
+    {
+        /* Read irrespective to clear the RX IRQ */
+        rx_frame = HAL_get_32bit_reg( this_spi->base_addr, RXDATA );
+        if( 0u != rx_free )
+        {
+            this_spi->stream_rx_ring[rx_head & this_spi->stream_rx_mask] = (uint8_t)rx_frame;
+            ++rx_head;
+            --rx_free;
+        }
+        ++nb_frames;
+    }
+
+    nb_stored = rx_head - this_spi->stream_rx_head;
+    this_spi->stream_rx_head = rx_head;
+    this_spi->stream_stats.rx_frames += nb_stored;
+    if( ( nb_stored != nb_frames ) && ( NULL_BUFF != this_spi->stream_rx_ring ) )
+    {
+        this_spi->stream_stats.rx_overflows += nb_frames - nb_stored;
+        events |= SPI_STREAM_RX_OVERFLOW;
+    }
+
+    /* Replace the frames shifted out */
+    tx_level = this_spi->stream_tx_head - tx_tail;
+    nb_sent = ( nb_frames < tx_level ) ? nb_frames : tx_level;
+    while( 0u != nb_frames )
+    {
+        --nb_frames;
+        if( 0u != tx_level )
+        {
+            HAL_set_32bit_reg( this_spi->base_addr, TXDATA,
+                               (uint32_t)this_spi->stream_tx_ring[tx_tail & this_spi->stream_tx_mask] );
+            ++tx_tail;
+            --tx_level;
+        }
+        else
+        {
+            HAL_set_32bit_reg( this_spi->base_addr, TXDATA, 0x00u );
+            if( NULL_BUFF != this_spi->stream_tx_ring )
+            {
+                ++this_spi->stream_stats.tx_underruns;
+            }
+        }
+    }
+    this_spi->stream_tx_tail = tx_tail;
+    this_spi->stream_stats.tx_frames += nb_sent;
+
+    if( ( 0u != this_spi->stream_rx_watermark ) &&
+        ( ( rx_head - this_spi->stream_rx_tail ) >= this_spi->stream_rx_watermark ) )
+    {
+        events |= SPI_STREAM_RX_WATERMARK;
+    }
+    if( ( 0u != this_spi->stream_tx_watermark ) &&
+        ( ( this_spi->stream_tx_head - tx_tail ) <= this_spi->stream_tx_watermark ) )
+    {
+        events |= SPI_STREAM_TX_WATERMARK;
+    }
+
+    if( ( 0u != events ) && ( NULL_STREAM_HANDLER != this_spi->stream_handler ) )
+    {
+        this_spi->stream_handler( this_spi, events );
+    }
+}
+
+/***************************************************************************//**
+ * Copy size bytes out of a ring starting at free running index idx, in at
+ * most two pieces.
+ */
+static void copy_from_ring
+(
+    uint8_t * dst,
+    const uint8_t * ring,
+    uint32_t mask,
+    uint32_t idx,
+    uint32_t size
+)
+{
+    uint32_t offset = idx & mask;
+    uint32_t first = ( mask + 1u ) - offset;
+
+    if( first > size )
+    {
+        first = size;
+    }
+    memcpy( dst, &ring[offset], first );
+    memcpy( &dst[first], ring, size - first );
+}
+
+/***************************************************************************//**
+ * Copy size bytes into a ring starting at free running index idx, in at most
+ * two pieces.
+ */
+static void copy_to_ring
+(
+    uint8_t * ring,
+    uint32_t mask,
+    uint32_t idx,
+    const uint8_t * src,
+    uint32_t size
+)
+{
+    uint32_t offset = idx & mask;
+    uint32_t first = ( mask + 1u ) - offset;
+
+    if( first > size )
+    {
+        first = size;
+    }
+    memcpy( &ring[offset], src, first );
+    memcpy( ring, &src[first], size - first );
+}
+
+/***************************************************************************//**
+ * SPI_transfer_block() for 16 and 32 bit frames. The command and the response
+ * are seen as one stream of bytes, cmd_byte_size bytes sent followed by
+ * rx_byte_size bytes received, cut into frames of frame_bytes bytes, the first
+ * byte in the most significant bits. Frame n holds bytes n * frame_bytes to
+ * n * frame_bytes + frame_bytes - 1 of the stream, so a frame may carry both
+ * the end of the command and the start of the response.
+ *
+ * As for 8 bit frames, no more frames than the FIFO can hold are in flight,
+ * and the last frame is written through TXLAST.
+ */
+static void transfer_block_wide
+(
+    spi_instance_t * this_spi,
+    const uint8_t * cmd_buffer,
+    uint16_t cmd_byte_size,
+    uint8_t * rx_buffer,
+    uint16_t rx_byte_size
+)
+{
+    uint32_t frame_bytes = this_spi->frame_bytes;
+    uint32_t total_bytes = (uint32_t)cmd_byte_size + (uint32_t)rx_byte_size;
+    uint32_t nb_frames = ( total_bytes + frame_bytes - 1u ) / frame_bytes;
+    uint32_t tx_pos = 0u;               /* Stream position of next frame sent */
+    uint32_t rx_pos = 0u;               /* Stream position of next frame received */
+    uint32_t last_pos = ( nb_frames - 1u ) * frame_bytes;
+    uint32_t transit = 0u;
+    uint8_t started = 0u;
+    uint32_t frame;
+    uint32_t pos;
+    uint32_t idx;
+
+    /* This function is only intended to be used with an SPI master. */
+    if( ( DISABLE == HAL_get_8bit_reg_field( this_spi->base_addr, CTRL1_MASTER ) ) ||
+        ( 0u == total_bytes ) )
+    {
+        return;
+    }
+
+    /* Flush the receive and transmit FIFOs */
+    HAL_set_8bit_reg( this_spi->base_addr, CMD, (uint32_t)( CMD_TXFIFORST_MASK | CMD_RXFIFORST_MASK ) );
+
+    /* Recover from receiver overflow because of previous slave */
+    if( ENABLE == HAL_get_8bit_reg_field( this_spi->base_addr, STATUS_RXOVFLOW ) )
+    {
+         recover_from_rx_overflow( this_spi );
+    }
+
+    /* Disable the Core SPI for a little bit, while we load the TX FIFO */
+    HAL_set_8bit_reg_field( this_spi->base_addr, CTRL1_ENABLE, DISABLE );
+
+    while( rx_pos < total_bytes )
+    {
+        if( ( tx_pos < total_bytes ) && ( transit < this_spi->fifo_depth ) )
+        {
+            /* Pack the command bytes of this frame, 0s past the command */
+            frame = 0u;
+            for( idx = 0u; idx < frame_bytes; ++idx )
+            {
+                pos = tx_pos + idx;
+                frame = ( frame << 8 ) | ( ( pos < cmd_byte_size ) ? (uint32_t)cmd_buffer[pos] : 0u );
+            }
+
+            if( tx_pos == last_pos )
+            {
+                HAL_set_32bit_reg( this_spi->base_addr, TXLAST, frame );
+            }
+            else
+            {
+                HAL_set_32bit_reg( this_spi->base_addr, TXDATA, frame );
+            }
+            tx_pos += frame_bytes;
+            ++transit;
+
+            /* Start once the FIFO is loaded, or the whole transfer is */
+            if( !started &&
+                ( ( transit == this_spi->fifo_depth ) || ( tx_pos >= total_bytes ) ) )
+            {
+                HAL_set_8bit_reg_field( this_spi->base_addr, CTRL1_ENABLE, ENABLE );
+                started = 1u;
+            }
+        }
+        else if( !HAL_get_8bit_reg_field( this_spi->base_addr, STATUS_RXEMPTY ) )
+        {
+            /* Unpack the response bytes of this frame, last byte first */
+            frame = HAL_get_32bit_reg( this_spi->base_addr, RXDATA );
+            for( idx = frame_bytes; idx > 0u; --idx )
+            {
+                pos = rx_pos + idx - 1u;
+                if( ( pos >= cmd_byte_size ) && ( pos < total_bytes ) )
+                {
+                    rx_buffer[pos - cmd_byte_size] = (uint8_t)frame;
+                }
+                frame >>= 8;
+            }
+            rx_pos += frame_bytes;
+            --transit;
+        }
+        else
+        {
+            /* Waiting for the next frame */
+        }
+    }
+}
+
 /***************************************************************************//**
  * This function is to recover the CoreSPI from receiver overflow.
  * It temporarily disables the CoreSPI from interacting with external world, flushes
@@ -83,14 +83,20 @@
     �   SPI master block transfer control
     �   SPI slave frame transfer control
     �   SPI slave block transfer control
+    �   SPI slave streaming
   Frame transfers allow CoreSPI to write or read up to 32 bits of data in a
   single SPI transaction. For example, a frame transfer of 12 bits might be used
   to read the result of an ADC conversion from a SPI analog to digital converter.
 
   Block transfers allow CoreSPI to write and/or read a number of bytes in a single
-  SPI transaction. With the driver as is, block transfer transactions allow data
-  transfers in multiples of 8 bits (8, 16, 24, 32, 40�) and the CoreSPI instance
-  has to be configured for 8 bit frames. For other frame sizes, the
+  SPI transaction. Block transfer transactions allow data transfers in multiples
+  of 8 bits (8, 16, 24, 32, 40�) with a CoreSPI instance configured for 8 bit
+  frames. A CoreSPI instance configured for 16 or 32 bit frames can also be used
+  for block transfers once SPI_set_frame_width() has told the driver its frame
+  size: each frame then carries two or four bytes of the block, most
+  significant byte first, so that the bytes are sent in the same order and each
+  TXDATA and RXDATA access moves two or four bytes. The transaction is padded
+  with 0s to a whole number of frames. For other frame sizes, the
   SPI_transfer_block() code can act as a template for developing a frame block
   transfer function.
   Block transfers are typically used with byte oriented devices like SPI
@@ -240,6 +246,29 @@
   for the command handler function to execute and call the
   SPI_set_cmd_response() function.
 
+  SPI slave streaming
+  The following functions are used as a part of the SPI slave streaming:
+    �   SPI_set_slave_stream_buffers()
+    �   SPI_stream_read()
+    �   SPI_stream_write()
+    �   SPI_get_stream_stats()
+
+  Streaming suits a remote master which sends or reads a continuous flow of
+  8 bit frames, for example a sensor pushing samples, rather than separate
+  command and response transactions. SPI_set_slave_stream_buffers() gives the
+  driver a receive ring and a transmit ring once. SPI_isr() moves every frame
+  received into the receive ring and replaces every frame sent with the next
+  byte of the transmit ring, across any number of master transactions. The
+  application reads what was received with SPI_stream_read() and queues what
+  will be sent with SPI_stream_write(), as many bytes at a time as it wants,
+  without reconfiguring the driver between transactions.
+
+  An optional handler is called from SPI_isr() while the receive ring holds at
+  least a watermark number of bytes or the transmit ring holds no more than
+  its watermark, and when the slave select is de-asserted. Frames received
+  while the receive ring is full, and zero frames sent while the transmit ring
+  is empty, are counted instead of stopping the stream.
+
  *//*=========================================================================*/
 #ifndef CORE_SPI_H_
 #define CORE_SPI_H_
@@ -325,6 +354,14 @@ typedef void (*spi_frame_rx_handler_t)( uint32_t rx_frame );
  */
 typedef void (*spi_block_rx_handler_t)( uint8_t * rx_buff, uint32_t rx_size );
 
+/***************************************************************************//**
+ These constants are the frame widths of a CoreSPI instance which
+ SPI_transfer_block() can use, see SPI_set_frame_width().
+ */
+#define SPI_FRAME_WIDTH_8                8u
+#define SPI_FRAME_WIDTH_16               16u
+#define SPI_FRAME_WIDTH_32               32u
+
 /***************************************************************************//**
  This enumeration is used to select a specific SPI slave device (0 to 7). It is
  used as a parameter to the SPI_configure_master_mode(), SPI_set_slave_select(),
@@ -351,9 +388,54 @@ typedef enum __spi_sxfer_mode_t
 {
     SPI_SLAVE_XFER_NONE  = 0, /* Not configured yet */
     SPI_SLAVE_XFER_BLOCK = 1, /* Block transfers, with SSEND delimiting end of block */
-    SPI_SLAVE_XFER_FRAME = 2  /* Single frame transfers */
+    SPI_SLAVE_XFER_FRAME = 2, /* Single frame transfers */
+    SPI_SLAVE_XFER_STREAM = 3 /* Continuous transfers through ring buffers */
 } spi_sxfer_mode_t;
 
+/***************************************************************************//**
+ These constants are the events passed to the slave stream handler. Several
+ events can be passed in the same call.
+
+ SPI_STREAM_RX_WATERMARK: the receive ring holds at least rx_watermark bytes.
+ SPI_STREAM_TX_WATERMARK: the transmit ring holds tx_watermark bytes or fewer.
+ SPI_STREAM_RX_OVERFLOW:  frames were dropped because the receive ring was full.
+ SPI_STREAM_SSEND:        the master de-asserted the slave select.
+ */
+#define SPI_STREAM_RX_WATERMARK         0x01u
+#define SPI_STREAM_TX_WATERMARK         0x02u
+#define SPI_STREAM_RX_OVERFLOW          0x04u
+#define SPI_STREAM_SSEND                0x08u
+
+/***************************************************************************//**
+  This defines the function prototype that must be followed by the SPI slave
+  stream handler functions. These functions are registered with the SPI driver
+  through the SPI_set_slave_stream_buffers() function.
+
+  Declaring and Implementing Slave Stream Handler Functions:
+     Slave stream handler functions should follow the following prototype:
+         void slave_stream_handler( spi_instance_t * this_spi, uint32_t events );
+     The events parameter is a combination of the SPI_STREAM_xxx constants.
+     The handler is called from SPI_isr(). It can call SPI_stream_read() and
+     SPI_stream_write() but would typically signal the application, which
+     then reads or writes a batch of data outside of the interrupt handler.
+ */
+typedef void (*spi_stream_handler_t)( spi_instance_t * this_spi, uint32_t events );
+
+/***************************************************************************//**
+ This structure holds the counters of the slave streaming, see
+ SPI_get_stream_stats(). They count from the SPI_set_slave_stream_buffers()
+ call.
+ */
+typedef struct __spi_stream_stats_t
+{
+    uint32_t rx_frames;         /*!< Frames stored in the receive ring. */
+    uint32_t tx_frames;         /*!< Frames taken from the transmit ring. */
+    uint32_t rx_overflows;      /*!< Frames dropped, receive ring full. */
+    uint32_t tx_underruns;      /*!< Zero frames sent, transmit ring empty. */
+    uint32_t fifo_overflows;    /*!< CoreSPI receive FIFO overflows. */
+    uint32_t fifo_underruns;    /*!< CoreSPI transmit FIFO underruns. */
+} spi_stream_stats_t;
+
 /***************************************************************************//**
   There is one instance of this structure for each of the core SPIs. Instances
   of this structure are used to identify a specific SPI. A pointer to an
@@ -400,9 +482,24 @@ struct spi_instance{
 
     /* Per instance specific hardware information that the driver needs to know */
     uint16_t fifo_depth;                 /*!< Depth of RX and TX FIFOs in frames. */
+    uint8_t frame_bytes;                 /*!< Bytes per frame of block transfers, 1, 2 or 4. */
 
     /* How we are expecting to deal with slave transfers */
     spi_sxfer_mode_t slave_xfer_mode;    /*!< Current slave mode transfer configuration. */
+
+    /* Slave stream rings. The indexes run freely, masked by size - 1: */
+    uint8_t * stream_rx_ring;                   /*!< Receive ring, filled by SPI_isr(). */
+    uint32_t stream_rx_mask;                    /*!< Receive ring size - 1. */
+    volatile uint32_t stream_rx_head;           /*!< Written by SPI_isr(). */
+    volatile uint32_t stream_rx_tail;           /*!< Written by SPI_stream_read(). */
+    uint32_t stream_rx_watermark;
+    uint8_t * stream_tx_ring;                   /*!< Transmit ring, emptied by SPI_isr(). */
+    uint32_t stream_tx_mask;                    /*!< Transmit ring size - 1. */
+    volatile uint32_t stream_tx_head;           /*!< Written by SPI_stream_write(). */
+    volatile uint32_t stream_tx_tail;           /*!< Written by SPI_isr(). */
+    uint32_t stream_tx_watermark;
+    spi_stream_handler_t stream_handler;        /*!< Optional watermark and SSEND handler. */
+    spi_stream_stats_t stream_stats;
 };
 
 /*==============================================================================
@@ -453,6 +550,41 @@ void SPI_init
     uint16_t fifo_depth
 );
 
+/***************************************************************************//**
+  The SPI_set_frame_width() function tells the driver the frame width the
+  CoreSPI instance was configured with in the hardware design. SPI_init()
+  assumes 8 bit frames. With 16 or 32 bit frames, SPI_transfer_block() packs
+  two or four bytes in each frame.
+
+  The frame width cannot be changed by software. Slave block and stream
+  transfers only support 8 bit frames.
+
+  @param this_spi
+  The this_spi parameter is a pointer to a spi_instance_t structure identifying
+  the CoreSPI hardware block to operate on.
+
+  @param frame_width
+  The frame_width parameter is SPI_FRAME_WIDTH_8, SPI_FRAME_WIDTH_16 or
+  SPI_FRAME_WIDTH_32. Other values are ignored.
+
+  @return
+  This function does not return any value.
+
+  Example:
+  @code
+    #define SPI0_BASE_ADDR 0xC2000000
+
+    spi_instance_t g_spi0;
+    SPI_init( &g_spi0, SPI0_BASE_ADDR, 8 );
+    SPI_set_frame_width( &g_spi0, SPI_FRAME_WIDTH_32 );
+  @endcode
+ */
+void SPI_set_frame_width
+(
+    spi_instance_t * this_spi,
+    uint8_t frame_width
+);
+
 /***************************************************************************//**
   The SPI_configure_slave_mode() function is used when a CoreSPI instance is
   to be configured as a SPI slave.
@@ -671,6 +803,12 @@ uint32_t SPI_transfer_frame
   the slave and stored in the rx_buffer. A value �0� indicates that no data is
   to be read from the slave.
 
+  With 16 or 32 bit frames, see SPI_set_frame_width(), the bytes are packed
+  into frames most significant byte first, and the last frame is padded with
+  0s. The slave therefore sees up to three extra 0 bytes at the end of the
+  transaction when cmd_byte_size + rx_byte_size is not a multiple of the frame
+  size; the bytes received for them are discarded.
+
   @return
   This function does not return any value.
 
@@ -935,6 +1073,180 @@ void SPI_set_slave_block_buffers
     spi_block_rx_handler_t block_rx_handler
 );
 
+/***************************************************************************//**
+  The SPI_set_slave_stream_buffers() function is used to configure an SPI slave
+  for streaming. It replaces any block or frame configuration. The rings stay
+  in use until another slave transfer configuration function, or
+  SPI_configure_master_mode(), is called.
+
+  Each frame received is stored in the receive ring and each frame sent is
+  taken from the transmit ring. The frames are moved by SPI_isr(), which must
+  be called from the CoreSPI interrupt handler. The bytes written to the
+  transmit ring are sent after the frames already in the CoreSPI transmit FIFO,
+  which is kept full; the first fifo_depth frames sent after this call are the
+  start of the transmit ring, or 0s if it is empty.
+
+  @param this_spi
+  The this_spi parameter is a pointer to a spi_instance_t structure identifying
+  the CoreSPI hardware block to operate on. This parameter must point to
+  a g_core_spi global data structure defined within the application code.
+
+  @param rx_ring
+  The rx_ring parameter is a pointer to the receive ring. This parameter can be
+  set to �0� if the SPI slave only transmits, the frames received are then
+  discarded.
+
+  @param rx_ring_size
+  The rx_ring_size parameter is the size of the receive ring in bytes. It must
+  be a power of two, or 0 if rx_ring is 0.
+
+  @param rx_watermark
+  The rx_watermark parameter is the number of bytes in the receive ring from
+  which the handler is called with SPI_STREAM_RX_WATERMARK. Set it to 0 for no
+  receive watermark events.
+
+  @param tx_ring
+  The tx_ring parameter is a pointer to the transmit ring. This parameter can
+  be set to �0� if the SPI slave only receives, 0s are then sent.
+
+  @param tx_ring_size
+  The tx_ring_size parameter is the size of the transmit ring in bytes. It must
+  be a power of two, or 0 if tx_ring is 0.
+
+  @param tx_watermark
+  The tx_watermark parameter is the number of bytes in the transmit ring at or
+  below which the handler is called with SPI_STREAM_TX_WATERMARK. Set it to 0
+  for no transmit watermark events.
+
+  @param stream_handler
+  The stream_handler parameter is a pointer to a function called from SPI_isr()
+  with the events which occurred. This parameter can be set to �0�.
+
+  @return
+  This function does not return any value.
+
+  Example:
+  @code
+    Slave receiving a continuous stream of sensor samples:
+
+    #define SPI0_BASE_ADDR 0xC2000000
+
+    spi_instance_t g_spi0;
+    uint8_t g_rx_ring[1024];
+    volatile uint8_t g_data_ready = 0;
+
+    void stream_handler( spi_instance_t * this_spi, uint32_t events )
+    {
+        g_data_ready = 1;
+    }
+
+    void receive_samples( void )
+    {
+        uint8_t samples[256];
+        uint32_t nb_bytes;
+
+        SPI_init( &g_spi0, SPI0_BASE_ADDR, 8 );
+        SPI_configure_slave_mode( &g_spi0 );
+        SPI_set_slave_stream_buffers( &g_spi0, g_rx_ring, sizeof(g_rx_ring),
+                                      sizeof(samples), 0, 0, 0,
+                                      stream_handler );
+        for(;;)
+        {
+            if( g_data_ready )
+            {
+                g_data_ready = 0;
+                do
+                {
+                    nb_bytes = SPI_stream_read( &g_spi0, samples, sizeof(samples) );
+                    process_samples( samples, nb_bytes );
+                } while( nb_bytes == sizeof(samples) );
+            }
+        }
+    }
+  @endcode
+ */
+void SPI_set_slave_stream_buffers
+(
+    spi_instance_t * this_spi,
+    uint8_t * rx_ring,
+    uint32_t rx_ring_size,
+    uint32_t rx_watermark,
+    uint8_t * tx_ring,
+    uint32_t tx_ring_size,
+    uint32_t tx_watermark,
+    spi_stream_handler_t stream_handler
+);
+
+/***************************************************************************//**
+  The SPI_stream_read() function copies up to size bytes from the receive ring
+  of a streaming SPI slave into buffer, and frees them in the ring. It must
+  only be called from one context at a time.
+
+  @param this_spi
+  The this_spi parameter is a pointer to a spi_instance_t structure identifying
+  the CoreSPI hardware block to operate on.
+
+  @param buffer
+  The buffer parameter is a pointer to the buffer the bytes are copied to.
+
+  @param size
+  The size parameter is the size of buffer.
+
+  @return
+  The number of bytes copied, 0 if the receive ring is empty.
+ */
+uint32_t SPI_stream_read
+(
+    spi_instance_t * this_spi,
+    uint8_t * buffer,
+    uint32_t size
+);
+
+/***************************************************************************//**
+  The SPI_stream_write() function copies up to size bytes from buffer into the
+  transmit ring of a streaming SPI slave, to be sent to the master. It must
+  only be called from one context at a time.
+
+  @param this_spi
+  The this_spi parameter is a pointer to a spi_instance_t structure identifying
+  the CoreSPI hardware block to operate on.
+
+  @param buffer
+  The buffer parameter is a pointer to the bytes to send.
+
+  @param size
+  The size parameter is the number of bytes to send.
+
+  @return
+  The number of bytes copied, less than size if the transmit ring is full.
+ */
+uint32_t SPI_stream_write
+(
+    spi_instance_t * this_spi,
+    const uint8_t * buffer,
+    uint32_t size
+);
+
+/***************************************************************************//**
+  The SPI_get_stream_stats() function copies the streaming counters of a SPI
+  slave into stats.
+
+  @param this_spi
+  The this_spi parameter is a pointer to a spi_instance_t structure identifying
+  the CoreSPI hardware block to operate on.
+
+  @param stats
+  The stats parameter is a pointer to the structure the counters are copied to.
+
+  @return
+  This function does not return any value.
+ */
+void SPI_get_stream_stats
+(
+    const spi_instance_t * this_spi,
+    spi_stream_stats_t * stats
+);
+
 /***************************************************************************//**
   The SPI_isr() function is the top level interrupt handler function for the
   CoreSPI driver. You must call SPI_isr() from the system level
@@ -0,0 +1,262 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file core_spi_static.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief CoreSPI block transfers specialized for the instances of the FPGA
+ * design.
+ *
+ * SPI_transfer_block() accesses the CoreSPI registers through
+ * this_spi->base_addr and the out of line functions of hw_reg_access.S, up to
+ * three times per frame in its polling loops, which costs a call, a load of
+ * the base address and an addition for each access. The base addresses of a
+ * Libero design are fixed, so they can be compile time constants instead.
+ *
+ * CORE_SPI_STATIC_INSTANCE(NAME, BASE_ADDR) defines, for the CoreSPI at
+ * BASE_ADDR, the static inline function NAME_transfer_block(), which takes the
+ * same parameters as SPI_transfer_block() and performs the same register
+ * accesses. this_spi must have been initialized by SPI_init() with BASE_ADDR
+ * and configured as a master. Transfers with frames wider than 8 bits, see
+ * SPI_set_frame_size(), and the recovery from a receive overflow are left to
+ * SPI_transfer_block().
+ *
+ * If CORE_SPI_INSTANCES is defined when this file is included, the function is
+ * defined for each instance it lists. fpga_design_config.h lists the CoreSPI
+ * instances of the design, for example:
+ *
+ *      #define CORE_SPI_INSTANCES(X) \
+ *          X(FLASH_CORE_SPI, FLASH_CORE_SPI_BASE)
+ *
+ * so that including it first is enough:
+ *
+ *      #include "fpga_design_config/fpga_design_config.h"
+ *      #include "drivers/fabric_ip/CoreSPI/core_spi_static.h"
+ *
+ *      SPI_init(&g_flash_spi, FLASH_CORE_SPI_BASE, 32u);
+ *      SPI_configure_master_mode(&g_flash_spi);
+ *      FLASH_CORE_SPI_transfer_block(&g_flash_spi, cmd, 1u, id, 3u);
+ *
+ * The transfer loops are inlined at each call site, so a function of the
+ * application which wraps NAME_transfer_block() should be used when it is
+ * called from many places.
+ */
+#ifndef CORE_SPI_STATIC_H_
+#define CORE_SPI_STATIC_H_
+
+#include "core_spi.h"
+#ifndef LEGACY_DIR_STRUCTURE
+#include "hal/hal_inline.h"
+#else
+#include "hal_inline.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Registers used below. The names of corespi_regs.h clash with those of the
+ * other cores' register files, which may be included in the same file.
+ */
+#define SPI_STATIC_RXDATA_REG_OFFSET        0x08u
+#define SPI_STATIC_TXDATA_REG_OFFSET        0x0Cu
+#define SPI_STATIC_CMD_REG_OFFSET           0x1Cu
+#define SPI_STATIC_TXLAST_REG_OFFSET        0x28u
+#define SPI_STATIC_CMD_FIFORST_MASK         0x03u
+
+#define SPI_STATIC_CTRL1_ENABLE_OFFSET      0x00u
+#define SPI_STATIC_CTRL1_ENABLE_MASK        0x01u
+#define SPI_STATIC_CTRL1_ENABLE_SHIFT       0u
+
+#define SPI_STATIC_CTRL1_MASTER_OFFSET      0x00u
+#define SPI_STATIC_CTRL1_MASTER_MASK        0x02u
+#define SPI_STATIC_CTRL1_MASTER_SHIFT       1u
+
+#define SPI_STATIC_STATUS_RXEMPTY_OFFSET    0x20u
+#define SPI_STATIC_STATUS_RXEMPTY_MASK      0x04u
+#define SPI_STATIC_STATUS_RXEMPTY_SHIFT     2u
+
+#define SPI_STATIC_STATUS_RXOVFLOW_OFFSET   0x20u
+#define SPI_STATIC_STATUS_RXOVFLOW_MASK     0x10u
+#define SPI_STATIC_STATUS_RXOVFLOW_SHIFT    4u
+
+/*------------------------------------------------------------------------------
+ * Body of the specialized function, inlined with a constant base_addr. Same
+ * stages as the 8-bit path of SPI_transfer_block(), see core_spi.c.
+ */
+HAL_ALWAYS_INLINE void
+SPI_STATIC_transfer_block
+(
+    spi_instance_t * this_spi,
+    addr_t base_addr,
+    const uint8_t * cmd_buffer,
+    uint16_t cmd_byte_size,
+    uint8_t * rx_buffer,
+    uint16_t rx_byte_size
+)
+{
+    const uint32_t fifo_depth = this_spi->fifo_depth;
+    uint32_t transfer_size;
+    uint32_t transfer_idx = 0u;
+    uint32_t tx_idx = 0u;
+    uint32_t rx_idx = 0u;
+    uint32_t transit = 0u;
+
+    if ((0u == HAL_INLINE_get_8bit_reg_field(base_addr, SPI_STATIC_CTRL1_MASTER)) ||
+        (0u == ((uint32_t)cmd_byte_size + (uint32_t)rx_byte_size)))
+    {
+        return;
+    }
+
+    /* The last frame is written to TXLAST to end the slave select */
+    transfer_size = ((uint32_t)cmd_byte_size + (uint32_t)rx_byte_size) - 1u;
+    HAL_INLINE_set_8bit_reg(base_addr, SPI_STATIC_CMD, SPI_STATIC_CMD_FIFORST_MASK);
+
+    if (0u != HAL_INLINE_get_8bit_reg_field(base_addr, SPI_STATIC_STATUS_RXOVFLOW))
+    {
+        SPI_transfer_block(this_spi, cmd_buffer, cmd_byte_size, rx_buffer, rx_byte_size);
+        return;
+    }
+
+    /* Load the transmit FIFO with the core disabled */
+    HAL_INLINE_set_8bit_reg_field(base_addr, SPI_STATIC_CTRL1_ENABLE, 0u);
+    while ((tx_idx < transfer_size) && (tx_idx < fifo_depth))
+    {
+        HAL_INLINE_set_32bit_reg(base_addr, SPI_STATIC_TXDATA,
+                                 (tx_idx < cmd_byte_size) ? cmd_buffer[tx_idx] : 0u);
+        ++transit;
+        ++tx_idx;
+    }
+    if ((tx_idx == transfer_size) && (tx_idx < fifo_depth))
+    {
+        HAL_INLINE_set_32bit_reg(base_addr, SPI_STATIC_TXLAST,
+                                 (tx_idx < cmd_byte_size) ? cmd_buffer[tx_idx] : 0u);
+        ++transit;
+        ++tx_idx;
+    }
+    HAL_INLINE_set_8bit_reg_field(base_addr, SPI_STATIC_CTRL1_ENABLE, 1u);
+
+    /* Remaining command bytes, the received frames are discarded */
+    while (tx_idx < cmd_byte_size)
+    {
+        if (transit < fifo_depth)
+        {
+            if (tx_idx == transfer_size)
+            {
+                HAL_INLINE_set_32bit_reg(base_addr, SPI_STATIC_TXLAST, cmd_buffer[tx_idx]);
+            }
+            else
+            {
+                HAL_INLINE_set_32bit_reg(base_addr, SPI_STATIC_TXDATA, cmd_buffer[tx_idx]);
+            }
+            ++tx_idx;
+            ++transit;
+        }
+        if (0u == HAL_INLINE_get_8bit_reg_field(base_addr, SPI_STATIC_STATUS_RXEMPTY))
+        {
+            (void)HAL_INLINE_get_32bit_reg(base_addr, SPI_STATIC_RXDATA);
+            ++transfer_idx;
+            --transit;
+        }
+    }
+
+    /* Dummy frames while the frames received for the command drain */
+    while (transfer_idx < cmd_byte_size)
+    {
+        if ((transit < fifo_depth) && (tx_idx < transfer_size))
+        {
+            HAL_INLINE_set_32bit_reg(base_addr, SPI_STATIC_TXDATA, 0u);
+            ++tx_idx;
+            ++transit;
+        }
+        if (0u == HAL_INLINE_get_8bit_reg_field(base_addr, SPI_STATIC_STATUS_RXEMPTY))
+        {
+            (void)HAL_INLINE_get_32bit_reg(base_addr, SPI_STATIC_RXDATA);
+            ++transfer_idx;
+            --transit;
+        }
+    }
+
+    /* Dummy frames pushing the response through */
+    while (tx_idx < transfer_size)
+    {
+        if (transit < fifo_depth)
+        {
+            HAL_INLINE_set_32bit_reg(base_addr, SPI_STATIC_TXDATA, 0u);
+            ++tx_idx;
+            ++transit;
+        }
+        if (0u == HAL_INLINE_get_8bit_reg_field(base_addr, SPI_STATIC_STATUS_RXEMPTY))
+        {
+            rx_buffer[rx_idx] = (uint8_t)HAL_INLINE_get_32bit_reg(base_addr, SPI_STATIC_RXDATA);
+            ++rx_idx;
+            ++transfer_idx;
+            --transit;
+        }
+    }
+
+    /* Last frame, if it did not fit in the FIFO */
+    while (tx_idx == transfer_size)
+    {
+        if (transit < fifo_depth)
+        {
+            HAL_INLINE_set_32bit_reg(base_addr, SPI_STATIC_TXLAST, 0u);
+            ++tx_idx;
+            ++transit;
+        }
+        if (0u == HAL_INLINE_get_8bit_reg_field(base_addr, SPI_STATIC_STATUS_RXEMPTY))
+        {
+            rx_buffer[rx_idx] = (uint8_t)HAL_INLINE_get_32bit_reg(base_addr, SPI_STATIC_RXDATA);
+            ++rx_idx;
+            ++transfer_idx;
+            --transit;
+        }
+    }
+
+    /* Rest of the response */
+    while (transfer_idx <= transfer_size)
+    {
+        if (0u == HAL_INLINE_get_8bit_reg_field(base_addr, SPI_STATIC_STATUS_RXEMPTY))
+        {
+            rx_buffer[rx_idx] = (uint8_t)HAL_INLINE_get_32bit_reg(base_addr, SPI_STATIC_RXDATA);
+            ++rx_idx;
+            ++transfer_idx;
+        }
+    }
+}
+
+/***************************************************************************//**
+ * CORE_SPI_STATIC_INSTANCE() defines the function specialized for the CoreSPI
+ * NAME at BASE_ADDR, see the top of this file.
+ */
+#define CORE_SPI_STATIC_INSTANCE(NAME, BASE_ADDR) \
+    static inline void \
+    NAME##_transfer_block(spi_instance_t * this_spi, const uint8_t * cmd_buffer, \
+                          uint16_t cmd_byte_size, uint8_t * rx_buffer, \
+                          uint16_t rx_byte_size) \
+    { \
+        HAL_ASSERT(this_spi->base_addr == (addr_t)(BASE_ADDR)) \
+        if (this_spi->frame_bytes > 1u) \
+        { \
+            SPI_transfer_block(this_spi, cmd_buffer, cmd_byte_size, \
+                               rx_buffer, rx_byte_size); \
+        } \
+        else \
+        { \
+            SPI_STATIC_transfer_block(this_spi, (addr_t)(BASE_ADDR), \
+                                      cmd_buffer, cmd_byte_size, \
+                                      rx_buffer, rx_byte_size); \
+        } \
+    }
+
+#ifdef CORE_SPI_INSTANCES
+CORE_SPI_INSTANCES(CORE_SPI_STATIC_INSTANCE)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CORE_SPI_STATIC_H_ */
@@ -0,0 +1,175 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file core_uart_apb_static.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief CoreUARTapb transmit and receive functions specialized for the
+ * instances of the FPGA design.
+ *
+ * The functions of core_uart_apb.c access the CoreUARTapb registers through
+ * this_uart->base_address and the out of line functions of hw_reg_access.S,
+ * which costs a call, a load of the base address and an addition for every
+ * register access. The base addresses of a Libero design are fixed, so they
+ * can be compile time constants instead.
+ *
+ * CORE_UART_APB_STATIC_INSTANCE(NAME, BASE_ADDR) defines, for the CoreUARTapb
+ * at BASE_ADDR, the static inline functions:
+ *  - NAME_send(), as UART_send(),
+ *  - NAME_polled_tx_string(), as UART_polled_tx_string(),
+ *  - NAME_get_rx(), as UART_get_rx().
+ * They take the same parameters as the functions they replace. this_uart must
+ * have been initialized by UART_init() with BASE_ADDR; only its software state,
+ * the sticky receive status read by UART_get_rx_status(), is used.
+ *
+ * If CORE_UART_APB_INSTANCES is defined when this file is included, the
+ * functions are defined for each instance it lists. fpga_design_config.h lists
+ * the CoreUARTapb instances of the design, for example:
+ *
+ *      #define CORE_UART_APB_INSTANCES(X) \
+ *          X(COREUARTAPB0, COREUARTAPB0_BASE_ADDR)
+ *
+ * so that including it first is enough:
+ *
+ *      #include "fpga_design_config/fpga_design_config.h"
+ *      #include "drivers/fabric_ip/CoreUARTapb/core_uart_apb_static.h"
+ *
+ *      UART_init(&g_uart, COREUARTAPB0_BASE_ADDR, BAUD_VALUE_115200,
+ *                (DATA_8_BITS | NO_PARITY));
+ *      COREUARTAPB0_polled_tx_string(&g_uart, (const uint8_t *)"Hello\r\n");
+ *
+ * Each caller gets its own copy of the register accesses, so specializing
+ * trades code size at the call sites for the size of the generic functions,
+ * which are not linked in if nothing else uses them.
+ */
+#ifndef CORE_UART_APB_STATIC_H_
+#define CORE_UART_APB_STATIC_H_
+
+#include <stddef.h>
+#include "core_uart_apb.h"
+#ifndef LEGACY_DIR_STRUCTURE
+#include "hal/hal_inline.h"
+#else
+#include "hal_inline.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Registers used below. The names of coreuartapb_regs.h clash with those of
+ * the other cores' register files, which may be included in the same file.
+ */
+#define UART_STATIC_TXDATA_REG_OFFSET       0x00u
+#define UART_STATIC_RXDATA_REG_OFFSET       0x04u
+#define UART_STATIC_STATUS_REG_OFFSET       0x10u
+#define UART_STATIC_STATUS_TXRDY_MASK       0x01u
+#define UART_STATIC_STATUS_RXFULL_MASK      0x02u
+
+/*------------------------------------------------------------------------------
+ * Bodies of the specialized functions, inlined with a constant base_addr.
+ */
+HAL_ALWAYS_INLINE void
+UART_STATIC_send
+(
+    addr_t base_addr,
+    const uint8_t * tx_buffer,
+    size_t tx_size
+)
+{
+    size_t char_idx;
+
+    for (char_idx = 0u; char_idx < tx_size; ++char_idx)
+    {
+        /* Wait for UART to become ready to transmit. */
+        while (0u == (HAL_INLINE_get_8bit_reg(base_addr, UART_STATIC_STATUS) &
+                      UART_STATIC_STATUS_TXRDY_MASK))
+        {
+            ;
+        }
+        HAL_INLINE_set_8bit_reg(base_addr, UART_STATIC_TXDATA, tx_buffer[char_idx]);
+    }
+}
+
+HAL_ALWAYS_INLINE void
+UART_STATIC_polled_tx_string
+(
+    addr_t base_addr,
+    const uint8_t * p_sz_string
+)
+{
+    while (0u != *p_sz_string)
+    {
+        /* Wait for UART to become ready to transmit. */
+        while (0u == (HAL_INLINE_get_8bit_reg(base_addr, UART_STATIC_STATUS) &
+                      UART_STATIC_STATUS_TXRDY_MASK))
+        {
+            ;
+        }
+        HAL_INLINE_set_8bit_reg(base_addr, UART_STATIC_TXDATA, *p_sz_string);
+        ++p_sz_string;
+    }
+}
+
+HAL_ALWAYS_INLINE size_t
+UART_STATIC_get_rx
+(
+    UART_instance_t * this_uart,
+    addr_t base_addr,
+    uint8_t * rx_buffer,
+    size_t buff_size
+)
+{
+    uint8_t new_status;
+    size_t rx_idx = 0u;
+
+    new_status = HAL_INLINE_get_8bit_reg(base_addr, UART_STATIC_STATUS);
+    this_uart->status |= new_status;
+    while ((0u != (new_status & UART_STATIC_STATUS_RXFULL_MASK)) &&
+           (rx_idx < buff_size))
+    {
+        rx_buffer[rx_idx] = HAL_INLINE_get_8bit_reg(base_addr, UART_STATIC_RXDATA);
+        ++rx_idx;
+        new_status = HAL_INLINE_get_8bit_reg(base_addr, UART_STATIC_STATUS);
+        this_uart->status |= new_status;
+    }
+    return rx_idx;
+}
+
+/***************************************************************************//**
+ * CORE_UART_APB_STATIC_INSTANCE() defines the functions specialized for the
+ * CoreUARTapb NAME at BASE_ADDR, see the top of this file.
+ */
+#define CORE_UART_APB_STATIC_INSTANCE(NAME, BASE_ADDR) \
+    static inline void \
+    NAME##_send(UART_instance_t * this_uart, const uint8_t * tx_buffer, size_t tx_size) \
+    { \
+        (void)this_uart; \
+        HAL_ASSERT(this_uart->base_address == (addr_t)(BASE_ADDR)) \
+        UART_STATIC_send((addr_t)(BASE_ADDR), tx_buffer, tx_size); \
+    } \
+    static inline void \
+    NAME##_polled_tx_string(UART_instance_t * this_uart, const uint8_t * p_sz_string) \
+    { \
+        (void)this_uart; \
+        HAL_ASSERT(this_uart->base_address == (addr_t)(BASE_ADDR)) \
+        UART_STATIC_polled_tx_string((addr_t)(BASE_ADDR), p_sz_string); \
+    } \
+    static inline size_t \
+    NAME##_get_rx(UART_instance_t * this_uart, uint8_t * rx_buffer, size_t buff_size) \
+    { \
+        HAL_ASSERT(this_uart->base_address == (addr_t)(BASE_ADDR)) \
+        return UART_STATIC_get_rx(this_uart, (addr_t)(BASE_ADDR), rx_buffer, buff_size); \
+    }
+
+#ifdef CORE_UART_APB_INSTANCES
+CORE_UART_APB_INSTANCES(CORE_UART_APB_STATIC_INSTANCE)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CORE_UART_APB_STATIC_H_ */
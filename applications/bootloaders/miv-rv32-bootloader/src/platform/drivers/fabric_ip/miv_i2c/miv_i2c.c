@@ -8,6 +8,7 @@
  * Please refer to miv_i2c.h file for more information.
  */
 
+#include "miv_rv32_hal/miv_rv32_deadline.h"
 #include "miv_i2c.h"
 
 #ifdef __cplusplus
@@ -428,6 +429,7 @@ MIV_I2C_isr
     uint8_t i2c_ack_status;
     uint8_t i2c_al_status;
     uint8_t hold_bus;
+    miv_i2c_status_t previous_status = this_i2c->master_status;
 
     /* Read the I2C master state */
     i2c_state = this_i2c->master_state;
@@ -735,6 +737,14 @@ MIV_I2C_isr
     /* Toggle the IACK bit to clear interrupt */
     HAL_set_8bit_reg_field(this_i2c->base_addr, CMD_IACK, 0x01u);
     HAL_set_8bit_reg_field(this_i2c->base_addr, CMD_IACK, 0x00u);
+
+    /* Report the end of the transaction once the interrupt is cleared */
+    if ((MIV_I2C_IN_PROGRESS == previous_status) &&
+        (MIV_I2C_IN_PROGRESS != this_i2c->master_status) &&
+        (0 != this_i2c->transfer_completion_handler))
+    {
+        this_i2c->transfer_completion_handler(this_i2c, this_i2c->master_status);
+    }
 }
 
 /*
@@ -753,6 +763,66 @@ MIV_I2C_get_status
     return i2c_status;
 }
 
+/*
+ * Please refer to miv_i2c.h for more info
+ */
+miv_i2c_status_t
+MIV_I2C_wait_complete
+(
+    miv_i2c_instance_t *this_i2c,
+    uint32_t timeout_ms
+)
+{
+    deadline_t deadline = deadline_in_ms(timeout_ms);
+    miv_i2c_status_t i2c_status;
+    psr_t processor_state;
+
+    this_i2c->master_timeout_ms = timeout_ms;
+
+    do {
+        i2c_status = this_i2c->master_status;
+    } while ((MIV_I2C_IN_PROGRESS == i2c_status) &&
+             ((MIV_I2C_NO_TIMEOUT == timeout_ms) || !deadline_expired(deadline)));
+
+    if (MIV_I2C_IN_PROGRESS == i2c_status)
+    {
+        processor_state = HAL_disable_interrupts();
+
+        /* The transaction may have completed since the status was read */
+        if (MIV_I2C_IN_PROGRESS == this_i2c->master_status)
+        {
+            HAL_set_8bit_reg_field(this_i2c->base_addr, CMD_STO, 0x01u);
+            HAL_set_8bit_reg_field(this_i2c->base_addr, CMD_WR, 0x01u);
+
+            this_i2c->master_status = MIV_I2C_TIMED_OUT;
+            this_i2c->transaction   = MIV_I2C_NO_TRANSACTION;
+            this_i2c->master_state  = MIV_I2C_IDLE;
+        }
+        i2c_status = this_i2c->master_status;
+
+        HAL_restore_interrupts(processor_state);
+    }
+
+    return i2c_status;
+}
+
+/*
+ * Please refer to miv_i2c.h for more info
+ */
+void
+MIV_I2C_register_transfer_completion_handler
+(
+    miv_i2c_instance_t *this_i2c,
+    miv_i2c_transfer_completion_t completion_handler
+)
+{
+    psr_t processor_state;
+
+    processor_state = HAL_disable_interrupts();
+    this_i2c->transfer_completion_handler = completion_handler;
+    HAL_restore_interrupts(processor_state);
+}
+
 #ifdef __cplusplus
 }
 #endif
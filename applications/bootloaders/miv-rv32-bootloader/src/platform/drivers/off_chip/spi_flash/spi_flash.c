@@ -15,6 +15,7 @@
 *
 *******************************************************************************/
 
+#include <stddef.h>
 #include <string.h>
 
 #ifndef LEGACY_DIR_STRUCTURE
@@ -24,6 +25,8 @@
 #include "hal.h"
 #endif
 #include "drivers/fabric_ip/CoreSPI/core_spi.h"
+#include "miv_rv32_hal/miv_rv32_deadline.h"
+#include "spi_bus/spi_bus.h"
 #include "spi_flash.h"
 
 #define READ_ARRAY_OPCODE         0x1B
@@ -54,6 +57,19 @@
 #define BLOCK_ALIGN_MASK_32K     0xFFFF8000
 #define BLOCK_ALIGN_MASK_64K     0xFFFF0000
 
+/*
+ * Longest time the device may stay busy, in milliseconds. A 64KB block erase
+ * takes up to 3 seconds, a chip erase several minutes. The operation is
+ * reported as failed if the device is still busy after that.
+ */
+#ifndef SPI_FLASH_READY_TIMEOUT_MS
+#define SPI_FLASH_READY_TIMEOUT_MS          3000u
+#endif
+
+#ifndef SPI_FLASH_CHIP_ERASE_TIMEOUT_MS
+#define SPI_FLASH_CHIP_ERASE_TIMEOUT_MS     480000u
+#endif
+
 /*
  * Maximum bytes required for command including opcode,
  * address and any dummy bytes.
@@ -62,13 +78,72 @@
 #define ATMEL_MAX_CMD_BYTES 6
 #define ATMEL_MAX_WRITE_BYTES (ATMEL_MAX_CMD_BYTES + NB_BYTES_PER_PAGE)
 
+/*
+ * SPI modes supported by the flash, and mode of the CoreSPI initialized by
+ * spi_flash_init().
+ */
+#define SPI_FLASH_SPI_MODES       (SPI_BUS_MODE_0 | SPI_BUS_MODE_3)
+
+#ifndef SPI_FLASH_BUS_MODE
+#define SPI_FLASH_BUS_MODE        SPI_BUS_MODE_0
+#endif
+
+/*
+ * Frame width of the CoreSPI initialized by spi_flash_init(). With 16 or 32
+ * bit frames, each APB access moves 2 or 4 bytes. The read, program and erase
+ * commands are 4 bytes long so their data stays aligned on frames; a page
+ * program which does not end on a frame is padded with 0xFF, which leaves the
+ * flash unchanged. Single byte commands such as write enable are followed by
+ * 0 bytes, the flash must ignore them.
+ */
+#ifndef SPI_FLASH_FRAME_WIDTH
+#define SPI_FLASH_FRAME_WIDTH     SPI_FRAME_WIDTH_8
+#endif
+
+#define MAX_FRAME_BYTES           4
+
+/*
+ * Erase count record, written alternately to the two 4KB blocks at
+ * SPI_FLASH_ERASE_COUNT_ADDR so that a reset during a save leaves the previous
+ * record intact. check is the complement of the sum of the preceding words.
+ */
+#define ERASE_COUNT_MAGIC         0x53415245u     /* "ERAS" */
+#define ERASE_COUNT_BLOCK_SIZE    0x1000u
+#define ERASE_COUNT_BLOCK_ADDR(block) \
+    (SPI_FLASH_ERASE_COUNT_ADDR + ((uint32_t)(block) * ERASE_COUNT_BLOCK_SIZE))
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t counts[SPI_FLASH_NB_SECTORS];
+    uint32_t check;
+} erase_count_record_t;
+
+/* g_erase_count_state values */
+#define ERASE_COUNTS_NOT_LOADED   0u
+#define ERASE_COUNTS_CLEAN        1u
+#define ERASE_COUNTS_DIRTY        2u
+
+static erase_count_record_t g_erase_counts;
+static uint8_t g_erase_count_state = ERASE_COUNTS_NOT_LOADED;
+static uint8_t g_erase_count_block;     /* Block of the last record read or written */
+
+static spi_flash_latency_t g_latency[SPI_FLASH_NB_LATENCIES];
+
 spi_instance_t g_flash_core_spi;
 
+/*
+ * Bus of spi_flash_init(), unused when the flash is attached to a bus shared
+ * with other devices.
+ */
+static spi_bus_t g_flash_spi_bus;
+static spi_bus_device_t g_flash_device;
 
-#define SPI_INSTANCE    &g_flash_core_spi
-#define SPI_SLAVE       0
+#define SPI_INSTANCE    &g_flash_device
+#define SPI_SLAVE       SPI_SLAVE_0
 
-#define SPI_TRANS_BLOCK SPI_transfer_block
+#define SPI_TRANS_BLOCK spi_bus_transfer
 
 /*
  * Our maximum write to the SPI FLASH device will be a 6 byte command
@@ -78,10 +153,14 @@ spi_instance_t g_flash_core_spi;
  * as a template for writing a block transfer routine that allowed transfers
  * from two separate buffers without deselecting the slave.
  */
-static uint8_t flash_write_buffer[ATMEL_MAX_WRITE_BYTES];
+static uint8_t flash_write_buffer[ATMEL_MAX_WRITE_BYTES + MAX_FRAME_BYTES - 1];
 
 static uint8_t wait_ready( void );
+static uint8_t wait_ready_for( uint32_t timeout_ms );
 static uint8_t wait_ready_erase( void );
+static uint8_t wait_done( spi_flash_latency_op_t op, uint64_t start, uint32_t timeout_ms );
+static void record_latency( spi_flash_latency_op_t op, uint64_t start );
+static void count_erase( uint32_t address, uint32_t size );
 
 /******************************************************************************
  *For more details please refer the spi_flash.h file
@@ -89,12 +168,31 @@ static uint8_t wait_ready_erase( void );
 spi_flash_status_t spi_flash_init( uint32_t base_addr )
 {
     /*--------------------------------------------------------------------------
-     * Configure MSS_SPI.
+     * Configure CoreSPI, the flash is the only device on the bus.
      */
+    spi_bus_init( &g_flash_spi_bus, &g_flash_core_spi, base_addr, 32,
+                  SPI_FLASH_BUS_MODE, 0 );
+    SPI_set_frame_width( &g_flash_core_spi, SPI_FLASH_FRAME_WIDTH );
+
+    return( spi_flash_attach( &g_flash_spi_bus, SPI_SLAVE ) );
+}
 
-    SPI_init(SPI_INSTANCE, base_addr, 32);
-    SPI_configure_master_mode( SPI_INSTANCE );
-    SPI_set_slave_select( SPI_INSTANCE, SPI_SLAVE );
+/******************************************************************************
+ *For more details please refer the spi_flash.h file
+ ******************************************************************************/
+spi_flash_status_t spi_flash_attach( spi_bus_t * bus, spi_slave_t slave )
+{
+    /* Erases and page programs are long sequences of transactions, let the
+     * other devices of the bus go first. */
+    if( SPI_BUS_SUCCESS != spi_bus_add_device( bus,
+                                               &g_flash_device,
+                                               slave,
+                                               SPI_FLASH_SPI_MODES,
+                                               0,
+                                               SPI_BUS_PRIORITY_LOW ) )
+    {
+        return( SPI_FLASH_INVALID_ARGUMENTS );
+    }
 
     return( SPI_FLASH_SUCCESS );
 }
@@ -111,6 +209,7 @@ spi_flash_control_hw
 )
 {
     uint8_t x;
+    uint64_t start;
     switch(operation){
         case SPI_FLASH_READ_DEVICE_ID:
         {
@@ -230,9 +329,13 @@ spi_flash_control_hw
             if(wait_ready())
                 return SPI_FLASH_UNSUCCESS;
 
+            start = DEADLINE_READ_MTIME();
             SPI_TRANS_BLOCK( SPI_INSTANCE, &cmd_buffer, 1, 0, 0 );
-            if(wait_ready())
+            if(wait_done(SPI_FLASH_LATENCY_CHIP_ERASE, start,
+                         SPI_FLASH_CHIP_ERASE_TIMEOUT_MS))
                 return SPI_FLASH_UNSUCCESS;
+
+            count_erase(0, SPI_FLASH_SIZE);
         }
         break;
         case SPI_FLASH_RESET:
@@ -274,11 +377,14 @@ spi_flash_control_hw
 
             wait_ready_erase();
 
+            start = DEADLINE_READ_MTIME();
             SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 4, 0, 0 );
-            if(wait_ready())
+            if(wait_done(SPI_FLASH_LATENCY_4KBLOCK_ERASE, start,
+                         SPI_FLASH_READY_TIMEOUT_MS))
                 return SPI_FLASH_UNSUCCESS;
 
             wait_ready_erase();
+            count_erase(address, 0x1000);
 
         }
         break;
@@ -301,9 +407,13 @@ spi_flash_control_hw
             if(wait_ready())
                 return SPI_FLASH_UNSUCCESS;
 
+            start = DEADLINE_READ_MTIME();
             SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 4, 0, 0 );
-            if(wait_ready())
+            if(wait_done(SPI_FLASH_LATENCY_32KBLOCK_ERASE, start,
+                         SPI_FLASH_READY_TIMEOUT_MS))
                 return SPI_FLASH_UNSUCCESS;
+
+            count_erase(address, 0x8000);
         }
         break;
         case SPI_FLASH_64KBLOCK_ERASE:
@@ -326,13 +436,17 @@ spi_flash_control_hw
 
             if(wait_ready())
                 return SPI_FLASH_UNSUCCESS;
+            start = DEADLINE_READ_MTIME();
             SPI_TRANS_BLOCK( SPI_INSTANCE,
                                     cmd_buffer,
                                     sizeof(cmd_buffer),
                                     0,
                                     0 );
-            if(wait_ready())
+            if(wait_done(SPI_FLASH_LATENCY_64KBLOCK_ERASE, start,
+                         SPI_FLASH_READY_TIMEOUT_MS))
                 return SPI_FLASH_UNSUCCESS;
+
+            count_erase(address, 0x10000);
         }
         break;
         case SPI_FLASH_GET_STATUS:
@@ -423,13 +537,16 @@ spi_flash_read
  */
 static void write_cmd_data
 (
-    spi_instance_t * this_spi,
+    spi_bus_device_t * this_spi,
     const uint8_t * cmd_buffer,
     uint16_t cmd_byte_size,
     uint8_t * data_buffer,
     uint16_t data_byte_size
 )
 {
+    uint16_t frame_bytes = this_spi->bus->spi->frame_bytes;
+    uint16_t total_size = cmd_byte_size + data_byte_size;
+
     /*
      * Construct our combined command and data block
      */
@@ -439,7 +556,11 @@ static void write_cmd_data
     if( data_byte_size )
         memcpy( &flash_write_buffer[cmd_byte_size], data_buffer, data_byte_size );
 
-    SPI_TRANS_BLOCK( this_spi, flash_write_buffer, cmd_byte_size + data_byte_size, 0, 0 );
+    /* Fill the last frame with erased bytes rather than the 0s of the driver */
+    while( total_size % frame_bytes )
+        flash_write_buffer[total_size++] = 0xFF;
+
+    SPI_TRANS_BLOCK( this_spi, flash_write_buffer, total_size, 0, 0 );
 }
 
 /******************************************************************************
@@ -458,6 +579,7 @@ spi_flash_write
     uint32_t in_buffer_idx;
     uint32_t nb_bytes_to_write;
     uint32_t target_addr;
+    uint64_t start;
 
     /* Send Write Enable command */
     cmd_buffer[0] = WRITE_ENABLE_CMD;
@@ -514,6 +636,7 @@ spi_flash_write
         cmd_buffer[2] = (target_addr >> 8 ) & 0xFF;
         cmd_buffer[3] = target_addr & 0xFF;
 
+        start = DEADLINE_READ_MTIME();
         write_cmd_data
           (
             SPI_INSTANCE,
@@ -523,6 +646,10 @@ spi_flash_write
             nb_bytes_to_write
           );
 
+        if(wait_done(SPI_FLASH_LATENCY_PAGE_PROGRAM, start,
+                     SPI_FLASH_READY_TIMEOUT_MS))
+            return SPI_FLASH_UNSUCCESS;
+
         target_addr += nb_bytes_to_write;
         in_buffer_idx += nb_bytes_to_write;
         wait_ready_erase();
@@ -540,33 +667,260 @@ spi_flash_write
 
 
 /******************************************************************************
- * This function waits for the SPI operation to complete
+ * This function waits for the SPI operation to complete. It returns the busy
+ * bit, still set if the device did not complete within timeout_ms.
  ******************************************************************************/
-static uint8_t wait_ready( void )
+static uint8_t wait_ready_for( uint32_t timeout_ms )
 {
-    uint32_t count = 0;
+    uint64_t start = DEADLINE_READ_MTIME();
+    deadline_t deadline = deadline_in_ms(timeout_ms);
     uint8_t ready_bit;
     uint8_t command = READ_STATUS;
-#if 1
+
     do {
         SPI_TRANS_BLOCK(SPI_INSTANCE, &command, 1, &ready_bit, 1);
         ready_bit = ready_bit & READY_BIT_MASK;
-        count++;
-    } while((ready_bit & READY_BIT_MASK) /*&& (count <= 0x7FFFFFFF)*/);
-#endif
+    } while((ready_bit & READY_BIT_MASK) && !deadline_expired(deadline));
+
+    record_latency(SPI_FLASH_LATENCY_BUSY_WAIT, start);
     return (ready_bit);
 }
 
+static uint8_t wait_ready( void )
+{
+    return wait_ready_for(SPI_FLASH_READY_TIMEOUT_MS);
+}
+
 static uint8_t wait_ready_erase( void )
 {
-    uint32_t count = 0;
+    uint64_t start = DEADLINE_READ_MTIME();
+    deadline_t deadline = deadline_in_ms(SPI_FLASH_READY_TIMEOUT_MS);
     uint8_t ready_bit;
     uint8_t command = 0x70 ; // FLAG_READ_STATUS;
-#if 1
+
     do {
         SPI_TRANS_BLOCK(SPI_INSTANCE, &command, 1, &ready_bit, 1);
-        count++;
-    } while((ready_bit & 0x80) == 0);
-#endif
+    } while(((ready_bit & 0x80) == 0) && !deadline_expired(deadline));
+
+    record_latency(SPI_FLASH_LATENCY_BUSY_WAIT, start);
     return (ready_bit);
 }
+
+/******************************************************************************
+ * This function waits for the program or erase started at MTIME start to
+ * complete and records its duration if it did.
+ ******************************************************************************/
+static uint8_t wait_done( spi_flash_latency_op_t op, uint64_t start, uint32_t timeout_ms )
+{
+    uint8_t busy = wait_ready_for(timeout_ms);
+
+    if(!busy)
+        record_latency(op, start);
+
+    return (busy);
+}
+
+/******************************************************************************
+ * This function adds the time elapsed since MTIME start to the latency
+ * histogram of op.
+ ******************************************************************************/
+static void record_latency( spi_flash_latency_op_t op, uint64_t start )
+{
+    spi_flash_latency_t * latency;
+    uint64_t elapsed_us;
+    uint32_t us;
+    uint32_t value;
+    uint32_t bucket = 0;
+
+    if(op >= SPI_FLASH_NB_LATENCIES)
+        return;
+
+    elapsed_us = ((DEADLINE_READ_MTIME() - start) * 1000000u) / DEADLINE_MTIME_FREQ;
+    us = (elapsed_us > 0xFFFFFFFFu) ? 0xFFFFFFFFu : (uint32_t)elapsed_us;
+
+    /* Bucket n counts the durations from 2^n to 2^(n+1) - 1 microseconds */
+    value = us;
+    while((value > 1u) && (bucket < (SPI_FLASH_LATENCY_BUCKETS - 1u)))
+    {
+        value >>= 1;
+        ++bucket;
+    }
+
+    latency = &g_latency[op];
+    ++latency->count;
+    ++latency->buckets[bucket];
+    latency->total_us += us;
+    if(us > latency->max_us)
+        latency->max_us = us;
+}
+
+/******************************************************************************
+ * For more details please refer the spi_flash.h file
+ ******************************************************************************/
+const spi_flash_latency_t *
+spi_flash_get_latency
+(
+    spi_flash_latency_op_t op
+)
+{
+    if(op >= SPI_FLASH_NB_LATENCIES)
+        return NULL;
+
+    return &g_latency[op];
+}
+
+/******************************************************************************
+ * For more details please refer the spi_flash.h file
+ ******************************************************************************/
+void
+spi_flash_clear_latency
+(
+    void
+)
+{
+    memset(g_latency, 0, sizeof(g_latency));
+}
+
+static uint32_t erase_count_check( void )
+{
+    const uint32_t * word = (const uint32_t *)&g_erase_counts;
+    uint32_t nb_words = offsetof(erase_count_record_t, check) / sizeof(uint32_t);
+    uint32_t sum = 0;
+
+    while(nb_words--)
+        sum += *word++;
+
+    return (~sum);
+}
+
+/******************************************************************************
+ * This function counts an erase of size bytes at address in the sectors it
+ * covers. The counts are loaded from the flash the first time.
+ ******************************************************************************/
+static void count_erase( uint32_t address, uint32_t size )
+{
+    uint32_t sector;
+
+    if(ERASE_COUNTS_NOT_LOADED == g_erase_count_state)
+        (void)spi_flash_load_erase_counts();
+
+    if(ERASE_COUNTS_NOT_LOADED == g_erase_count_state)
+        return;
+
+    for(sector = address / SPI_FLASH_SECTOR_SIZE;
+        (sector < SPI_FLASH_NB_SECTORS) && ((sector * SPI_FLASH_SECTOR_SIZE) < (address + size));
+        ++sector)
+    {
+        ++g_erase_counts.counts[sector];
+    }
+
+    g_erase_count_state = ERASE_COUNTS_DIRTY;
+}
+
+/******************************************************************************
+ * For more details please refer the spi_flash.h file
+ ******************************************************************************/
+spi_flash_status_t
+spi_flash_load_erase_counts
+(
+    void
+)
+{
+    uint8_t block;
+    uint8_t found = 0;
+    uint32_t sequence = 0;
+
+    g_erase_count_state = ERASE_COUNTS_NOT_LOADED;
+
+    for(block = 0; block < 2; ++block)
+    {
+        if(spi_flash_read(ERASE_COUNT_BLOCK_ADDR(block),
+                          (uint8_t *)&g_erase_counts,
+                          sizeof(g_erase_counts)))
+        {
+            memset(&g_erase_counts, 0, sizeof(g_erase_counts));
+            return SPI_FLASH_UNSUCCESS;
+        }
+
+        if((ERASE_COUNT_MAGIC == g_erase_counts.magic) &&
+           (erase_count_check() == g_erase_counts.check) &&
+           (!found || ((int32_t)(g_erase_counts.sequence - sequence) > 0)))
+        {
+            found = 1;
+            sequence = g_erase_counts.sequence;
+            g_erase_count_block = block;
+        }
+    }
+
+    if(!found)
+    {
+        /* Blank area, the first save goes to block 0 */
+        memset(&g_erase_counts, 0, sizeof(g_erase_counts));
+        g_erase_count_block = 1;
+    }
+    else if(0 == g_erase_count_block)
+    {
+        /* Block 1 was read last */
+        if(spi_flash_read(ERASE_COUNT_BLOCK_ADDR(0),
+                          (uint8_t *)&g_erase_counts,
+                          sizeof(g_erase_counts)))
+        {
+            memset(&g_erase_counts, 0, sizeof(g_erase_counts));
+            return SPI_FLASH_UNSUCCESS;
+        }
+    }
+
+    g_erase_count_state = ERASE_COUNTS_CLEAN;
+    return SPI_FLASH_SUCCESS;
+}
+
+/******************************************************************************
+ * For more details please refer the spi_flash.h file
+ ******************************************************************************/
+spi_flash_status_t
+spi_flash_save_erase_counts
+(
+    void
+)
+{
+    uint8_t block;
+    uint32_t address;
+
+    if(ERASE_COUNTS_DIRTY != g_erase_count_state)
+        return SPI_FLASH_SUCCESS;
+
+    /* The erase of the block is counted in the record written to it */
+    block = g_erase_count_block ^ 1u;
+    address = ERASE_COUNT_BLOCK_ADDR(block);
+    if(spi_flash_control_hw(SPI_FLASH_4KBLOCK_ERASE, address, NULL))
+        return SPI_FLASH_UNSUCCESS;
+
+    g_erase_counts.magic = ERASE_COUNT_MAGIC;
+    ++g_erase_counts.sequence;
+    g_erase_counts.check = erase_count_check();
+
+    if(spi_flash_write(address, (uint8_t *)&g_erase_counts, sizeof(g_erase_counts)))
+        return SPI_FLASH_UNSUCCESS;
+
+    g_erase_count_block = block;
+    g_erase_count_state = ERASE_COUNTS_CLEAN;
+    return SPI_FLASH_SUCCESS;
+}
+
+/******************************************************************************
+ * For more details please refer the spi_flash.h file
+ ******************************************************************************/
+uint32_t
+spi_flash_get_erase_count
+(
+    uint32_t sector
+)
+{
+    if(ERASE_COUNTS_NOT_LOADED == g_erase_count_state)
+        (void)spi_flash_load_erase_counts();
+
+    if(sector >= SPI_FLASH_NB_SECTORS)
+        return 0;
+
+    return g_erase_counts.counts[sector];
+}
@@ -25,6 +25,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include "spi_bus/spi_bus.h"
 
 /*******************************************************************************
  * Possible return values from functions on SPI FLASH.
@@ -66,6 +67,52 @@ struct device_Info{
     uint8_t mem_cap;
 };
 
+/*******************************************************************************
+ * Flash size and the 64KB sectors erase counts are kept for. The counts are
+ * saved by spi_flash_save_erase_counts() in the two 4KB blocks at
+ * SPI_FLASH_ERASE_COUNT_ADDR, below the A/B slot descriptors of fw_slots.h
+ * which occupy the last two blocks of the flash. Nothing else may be stored
+ * there.
+ ******************************************************************************/
+#ifndef SPI_FLASH_SIZE
+#define SPI_FLASH_SIZE                  0x800000u
+#endif
+
+#define SPI_FLASH_SECTOR_SIZE           0x10000u
+#define SPI_FLASH_NB_SECTORS            (SPI_FLASH_SIZE / SPI_FLASH_SECTOR_SIZE)
+
+#ifndef SPI_FLASH_ERASE_COUNT_ADDR
+#define SPI_FLASH_ERASE_COUNT_ADDR      (SPI_FLASH_SIZE - 0x4000u)
+#endif
+
+/*******************************************************************************
+ * Operations whose durations are recorded, from the command to the device
+ * becoming ready again. SPI_FLASH_LATENCY_BUSY_WAIT records every wait for the
+ * device to become ready, including those after which it was already ready.
+ ******************************************************************************/
+typedef enum {
+    SPI_FLASH_LATENCY_PAGE_PROGRAM = 0,
+    SPI_FLASH_LATENCY_4KBLOCK_ERASE,
+    SPI_FLASH_LATENCY_32KBLOCK_ERASE,
+    SPI_FLASH_LATENCY_64KBLOCK_ERASE,
+    SPI_FLASH_LATENCY_CHIP_ERASE,
+    SPI_FLASH_LATENCY_BUSY_WAIT,
+    SPI_FLASH_NB_LATENCIES
+} spi_flash_latency_op_t;
+
+/*
+ * buckets[n] counts the durations from 2^n to 2^(n+1) - 1 microseconds,
+ * buckets[0] those under 2 us and the last bucket all longer ones.
+ */
+#define SPI_FLASH_LATENCY_BUCKETS       24u
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t buckets[SPI_FLASH_LATENCY_BUCKETS];
+} spi_flash_latency_t;
+
 /*******************************************************************************
  * This function initialzes the SPI peripheral for data transfer
  ******************************************************************************/
@@ -75,6 +122,18 @@ spi_flash_init
     uint32_t base_addr
 );
 
+/*******************************************************************************
+ * This function connects the driver to the flash on the slave select slave of
+ * a CoreSPI shared with other devices, see spi_bus.h. It is used in place of
+ * spi_flash_init(), after spi_bus_init() was called for the bus.
+ ******************************************************************************/
+spi_flash_status_t
+spi_flash_attach
+(
+    spi_bus_t * bus,
+    spi_slave_t slave
+);
+
 /******************************************************************************
  * This function performs the various operations on the serial Flash
  * based on the command passed as first parameter.
@@ -267,4 +326,64 @@ spi_flash_write
     size_t size_in_bytes
 );
 
+/*******************************************************************************
+ * This function returns the latency histogram of an operation, measured with
+ * MTIME since the start or since spi_flash_clear_latency(). It returns NULL
+ * for an invalid operation. The histograms are kept in RAM only.
+ ******************************************************************************/
+const spi_flash_latency_t *
+spi_flash_get_latency
+(
+    spi_flash_latency_op_t op
+);
+
+/*******************************************************************************
+ * This function clears the latency histograms of all operations.
+ ******************************************************************************/
+void
+spi_flash_clear_latency
+(
+    void
+);
+
+/*******************************************************************************
+ * This function returns the number of times the 64KB sector was erased, whole
+ * or in part, 0 for a sector beyond SPI_FLASH_NB_SECTORS. The counts saved in
+ * the flash are loaded the first time they are needed; erases are then counted
+ * in RAM until spi_flash_save_erase_counts() is called.
+ ******************************************************************************/
+uint32_t
+spi_flash_get_erase_count
+(
+    uint32_t sector
+);
+
+/*******************************************************************************
+ * This function reads the last saved erase counts from the flash, discarding
+ * the erases counted in RAM since. The counts start from 0 if none were saved.
+ *
+ * @return              SPI_FLASH_SUCCESS or SPI_FLASH_UNSUCCESS if the flash
+ *                      could not be read.
+ ******************************************************************************/
+spi_flash_status_t
+spi_flash_load_erase_counts
+(
+    void
+);
+
+/*******************************************************************************
+ * This function saves the erase counts to the flash if any erase was counted
+ * since they were loaded or last saved. Each save erases one of the two blocks
+ * at SPI_FLASH_ERASE_COUNT_ADDR, so call it once a series of erases is done,
+ * for example at the end of a firmware update, rather than after each one.
+ *
+ * @return              SPI_FLASH_SUCCESS or SPI_FLASH_UNSUCCESS if the flash
+ *                      could not be erased or written.
+ ******************************************************************************/
+spi_flash_status_t
+spi_flash_save_erase_counts
+(
+    void
+);
+
 #endif
@@ -17,7 +17,12 @@
 extern "C" {
 #endif
 
+#ifndef HAL_HOST_SIMULATION
 typedef unsigned int size_t;
+#else
+/* Use the host's size_t when building against the platform/hal_sim models */
+#include <stddef.h>
+#endif
 
 /*------------------------------------------------------------------------------
  * addr_t: address type.
@@ -0,0 +1,107 @@
+/***************************************************************************//**
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file hal_inline.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Inline peripheral register accesses for base addresses known at
+ * compile time.
+ *
+ * The HAL_set_xxx() and HAL_get_xxx() macros of hal.h call the functions of
+ * hw_reg_access.S with the address of the register, which the driver computes
+ * at run time from the base address stored in its instance. The macros below
+ * access the register directly instead. When BASE_ADDR is a constant, such as
+ * the base addresses of fpga_design_config.h, the compiler folds base address
+ * and register offset into the immediate of the load or store, for example:
+ *
+ *      lui     a5, 0x71000
+ *      lbu     a4, 16(a5)
+ *
+ * They are meant for the statically specialized driver instances, see
+ * core_uart_apb_static.h and core_spi_static.h.
+ *
+ * When HAL_HOST_SIMULATION is defined they use the hal.h macros, so that the
+ * register models of hal_sim see the accesses.
+ */
+#ifndef HAL_INLINE_H_
+#define HAL_INLINE_H_
+
+#include "hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************//**
+ * Functions which take the base address of the peripheral as a parameter and
+ * must be inlined into their caller for the constant base address to be
+ * folded, whatever the optimization level.
+ */
+#define HAL_ALWAYS_INLINE   static inline __attribute__((always_inline))
+
+#ifndef HAL_HOST_SIMULATION
+
+/***************************************************************************//**
+ * HAL_INLINE_set_32bit_reg() and HAL_INLINE_get_32bit_reg() write and read a
+ * 32 bits wide register, as HAL_set_32bit_reg() and HAL_get_32bit_reg() do.
+ */
+#define HAL_INLINE_set_32bit_reg(BASE_ADDR, REG_NAME, VALUE) \
+          (*((volatile uint32_t *)((BASE_ADDR) + (REG_NAME##_REG_OFFSET))) = (uint32_t)(VALUE))
+
+#define HAL_INLINE_get_32bit_reg(BASE_ADDR, REG_NAME) \
+          (*((volatile uint32_t *)((BASE_ADDR) + (REG_NAME##_REG_OFFSET))))
+
+/***************************************************************************//**
+ * HAL_INLINE_set_8bit_reg() and HAL_INLINE_get_8bit_reg() write and read an
+ * 8 bits wide register, as HAL_set_8bit_reg() and HAL_get_8bit_reg() do.
+ */
+#define HAL_INLINE_set_8bit_reg(BASE_ADDR, REG_NAME, VALUE) \
+          (*((volatile uint8_t *)((BASE_ADDR) + (REG_NAME##_REG_OFFSET))) = (uint8_t)(VALUE))
+
+#define HAL_INLINE_get_8bit_reg(BASE_ADDR, REG_NAME) \
+          (*((volatile uint8_t *)((BASE_ADDR) + (REG_NAME##_REG_OFFSET))))
+
+/***************************************************************************//**
+ * HAL_INLINE_set_8bit_reg_field() and HAL_INLINE_get_8bit_reg_field() write
+ * and read a field of an 8 bits wide register, as HAL_set_8bit_reg_field()
+ * and HAL_get_8bit_reg_field() do. The write is a read-modify-write of the
+ * register.
+ */
+#define HAL_INLINE_set_8bit_reg_field(BASE_ADDR, FIELD_NAME, VALUE) \
+          (*((volatile uint8_t *)((BASE_ADDR) + FIELD_OFFSET(FIELD_NAME))) = \
+              (uint8_t)((*((volatile uint8_t *)((BASE_ADDR) + FIELD_OFFSET(FIELD_NAME))) & \
+                         ~FIELD_MASK(FIELD_NAME)) | \
+                        (((uint32_t)(VALUE) << FIELD_SHIFT(FIELD_NAME)) & FIELD_MASK(FIELD_NAME))))
+
+#define HAL_INLINE_get_8bit_reg_field(BASE_ADDR, FIELD_NAME) \
+          ((uint8_t)((*((volatile uint8_t *)((BASE_ADDR) + FIELD_OFFSET(FIELD_NAME))) & \
+                      FIELD_MASK(FIELD_NAME)) >> FIELD_SHIFT(FIELD_NAME)))
+
+#else
+
+#define HAL_INLINE_set_32bit_reg(BASE_ADDR, REG_NAME, VALUE) \
+          HAL_set_32bit_reg((BASE_ADDR), REG_NAME, (VALUE))
+
+#define HAL_INLINE_get_32bit_reg(BASE_ADDR, REG_NAME) \
+          HAL_get_32bit_reg((BASE_ADDR), REG_NAME)
+
+#define HAL_INLINE_set_8bit_reg(BASE_ADDR, REG_NAME, VALUE) \
+          HAL_set_8bit_reg((BASE_ADDR), REG_NAME, (VALUE))
+
+#define HAL_INLINE_get_8bit_reg(BASE_ADDR, REG_NAME) \
+          HAL_get_8bit_reg((BASE_ADDR), REG_NAME)
+
+#define HAL_INLINE_set_8bit_reg_field(BASE_ADDR, FIELD_NAME, VALUE) \
+          HAL_set_8bit_reg_field((BASE_ADDR), FIELD_NAME, (VALUE))
+
+#define HAL_INLINE_get_8bit_reg_field(BASE_ADDR, FIELD_NAME) \
+          HAL_get_8bit_reg_field((BASE_ADDR), FIELD_NAME)
+
+#endif /* HAL_HOST_SIMULATION */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_INLINE_H_ */
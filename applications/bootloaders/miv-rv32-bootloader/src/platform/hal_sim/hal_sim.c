@@ -0,0 +1,376 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file hal_sim.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Host simulation of the hardware register access layer.
+ *
+ * Implements the functions declared in hal/hw_reg_access.h and hal/hal.h by
+ * dispatching each access to a register model. Field accesses are performed as
+ * a read followed by a write, exactly as hw_reg_access.S does, so that the
+ * access counts match the real hardware.
+ */
+#include <string.h>
+#include "hal/hal.h"
+#include "hal_sim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HAL_SIM_MAX_MEMORY_REGIONS      8u
+
+typedef struct
+{
+    addr_t      target_addr;
+    uint8_t *   host_addr;
+    uint32_t    size;
+} hal_sim_memory_t;
+
+static hal_sim_model_t * g_models = NULL;
+
+static hal_sim_memory_t g_memory[HAL_SIM_MAX_MEMORY_REGIONS];
+static uint32_t g_nb_memory = 0u;
+
+static hal_sim_counters_t g_counters;
+
+static hal_sim_irq_handler_t g_irq_handler[HAL_SIM_NB_IRQ_LINES];
+static uint8_t g_irq_enabled[HAL_SIM_NB_IRQ_LINES];
+static uint8_t g_irq_level[HAL_SIM_NB_IRQ_LINES];
+
+static psr_t g_mstatus = 0u;
+
+static uint64_t g_mtime = 0u;
+
+/*------------------------------------------------------------------------------
+ * Locate the model decoding reg_addr. The most recently used model is moved to
+ * the head of the list as drivers tend to hammer a single peripheral.
+ */
+static hal_sim_model_t * find_model(addr_t reg_addr)
+{
+    hal_sim_model_t * model = g_models;
+    hal_sim_model_t * prev = NULL;
+
+    while (NULL != model)
+    {
+        if ((reg_addr >= model->base_addr) &&
+            ((reg_addr - model->base_addr) < model->size))
+        {
+            if (NULL != prev)
+            {
+                prev->next = model->next;
+                model->next = g_models;
+                g_models = model;
+            }
+            return model;
+        }
+        prev = model;
+        model = model->next;
+    }
+
+    return NULL;
+}
+
+static uint32_t sim_read(addr_t reg_addr, uint8_t width)
+{
+    uint32_t value = 0u;
+    hal_sim_model_t * model = find_model(reg_addr);
+
+    if (NULL != model)
+    {
+        ++model->reads;
+        ++g_counters.reads;
+        value = model->read(model, reg_addr - model->base_addr, width);
+    }
+    else
+    {
+        uint8_t * mem = (uint8_t *)HAL_SIM_translate(reg_addr, width);
+
+        if (NULL != mem)
+        {
+            memcpy(&value, mem, width);
+        }
+        else
+        {
+            ++g_counters.unmapped;
+        }
+    }
+
+    return value;
+}
+
+static void sim_write(addr_t reg_addr, uint32_t value, uint8_t width)
+{
+    hal_sim_model_t * model = find_model(reg_addr);
+
+    if (NULL != model)
+    {
+        ++model->writes;
+        ++g_counters.writes;
+        model->write(model, reg_addr - model->base_addr, value, width);
+    }
+    else
+    {
+        uint8_t * mem = (uint8_t *)HAL_SIM_translate(reg_addr, width);
+
+        if (NULL != mem)
+        {
+            memcpy(mem, &value, width);
+        }
+        else
+        {
+            ++g_counters.unmapped;
+        }
+    }
+}
+
+/***************************************************************************//**
+ * See hal_sim.h for details of how to use these functions.
+ */
+void HAL_SIM_register(hal_sim_model_t * model)
+{
+    model->reads = 0u;
+    model->writes = 0u;
+    model->next = g_models;
+    g_models = model;
+}
+
+int HAL_SIM_map_memory(addr_t target_addr, void * host_addr, uint32_t size)
+{
+    if (g_nb_memory >= HAL_SIM_MAX_MEMORY_REGIONS)
+    {
+        return -1;
+    }
+
+    g_memory[g_nb_memory].target_addr = target_addr;
+    g_memory[g_nb_memory].host_addr = (uint8_t *)host_addr;
+    g_memory[g_nb_memory].size = size;
+    ++g_nb_memory;
+
+    return 0;
+}
+
+void * HAL_SIM_translate(addr_t target_addr, uint32_t size)
+{
+    uint32_t idx;
+
+    for (idx = 0u; idx < g_nb_memory; ++idx)
+    {
+        uint32_t offset = target_addr - g_memory[idx].target_addr;
+
+        if ((target_addr >= g_memory[idx].target_addr) &&
+            (offset < g_memory[idx].size) &&
+            (size <= (g_memory[idx].size - offset)))
+        {
+            return &g_memory[idx].host_addr[offset];
+        }
+    }
+
+    return NULL;
+}
+
+void HAL_SIM_step(void)
+{
+    hal_sim_model_t * model;
+    uint8_t line;
+
+    ++g_counters.steps;
+
+    for (model = g_models; NULL != model; model = model->next)
+    {
+        if (NULL != model->step)
+        {
+            model->step(model);
+        }
+    }
+
+    for (line = 0u; line < HAL_SIM_NB_IRQ_LINES; ++line)
+    {
+        if ((0u != (g_mstatus & HAL_SIM_MSTATUS_MIE)) &&
+            g_irq_level[line] && g_irq_enabled[line] &&
+            (NULL != g_irq_handler[line]))
+        {
+            /* Handlers run with interrupts disabled, as on the hart. */
+            psr_t saved = g_mstatus;
+
+            g_mstatus &= ~HAL_SIM_MSTATUS_MIE;
+            ++g_counters.irqs;
+            g_irq_handler[line]();
+            g_mstatus = saved;
+        }
+    }
+}
+
+void HAL_SIM_set_irq_handler(uint8_t line, hal_sim_irq_handler_t handler)
+{
+    if (line < HAL_SIM_NB_IRQ_LINES)
+    {
+        g_irq_handler[line] = handler;
+    }
+}
+
+void HAL_SIM_enable_irq(uint8_t line)
+{
+    if (line < HAL_SIM_NB_IRQ_LINES)
+    {
+        g_irq_enabled[line] = 1u;
+    }
+}
+
+void HAL_SIM_disable_irq(uint8_t line)
+{
+    if (line < HAL_SIM_NB_IRQ_LINES)
+    {
+        g_irq_enabled[line] = 0u;
+    }
+}
+
+void HAL_SIM_set_irq(uint8_t line, uint8_t level)
+{
+    if (line < HAL_SIM_NB_IRQ_LINES)
+    {
+        g_irq_level[line] = level;
+    }
+}
+
+uint64_t HAL_SIM_read_mtime(void)
+{
+    return ++g_mtime;
+}
+
+void HAL_SIM_advance_mtime(uint64_t ticks)
+{
+    g_mtime += ticks;
+}
+
+void HAL_SIM_reset_counters(void)
+{
+    hal_sim_model_t * model;
+
+    memset(&g_counters, 0, sizeof(g_counters));
+
+    for (model = g_models; NULL != model; model = model->next)
+    {
+        model->reads = 0u;
+        model->writes = 0u;
+    }
+}
+
+hal_sim_counters_t HAL_SIM_get_counters(void)
+{
+    return g_counters;
+}
+
+/*------------------------------------------------------------------------------
+ * hw_reg_access.h
+ */
+void HW_set_32bit_reg(addr_t reg_addr, uint32_t value)
+{
+    sim_write(reg_addr, value, 4u);
+}
+
+uint32_t HW_get_32bit_reg(addr_t reg_addr)
+{
+    return sim_read(reg_addr, 4u);
+}
+
+void HW_set_32bit_reg_field(addr_t reg_addr,
+                            int_fast8_t shift,
+                            uint32_t mask,
+                            uint32_t value)
+{
+    uint32_t reg = sim_read(reg_addr, 4u);
+
+    reg = (reg & ~mask) | ((value << shift) & mask);
+    sim_write(reg_addr, reg, 4u);
+}
+
+uint32_t HW_get_32bit_reg_field(addr_t reg_addr,
+                                int_fast8_t shift,
+                                uint32_t mask)
+{
+    return (sim_read(reg_addr, 4u) & mask) >> shift;
+}
+
+void HW_set_16bit_reg(addr_t reg_addr, uint_fast16_t value)
+{
+    sim_write(reg_addr, (uint32_t)value & 0xFFFFu, 2u);
+}
+
+uint16_t HW_get_16bit_reg(addr_t reg_addr)
+{
+    return (uint16_t)sim_read(reg_addr, 2u);
+}
+
+void HW_set_16bit_reg_field(addr_t reg_addr,
+                            int_fast8_t shift,
+                            uint_fast16_t mask,
+                            uint_fast16_t value)
+{
+    uint32_t reg = sim_read(reg_addr, 2u);
+
+    reg = (reg & ~(uint32_t)mask) | (((uint32_t)value << shift) & mask);
+    sim_write(reg_addr, reg & 0xFFFFu, 2u);
+}
+
+uint16_t HW_get_16bit_reg_field(addr_t reg_addr,
+                                int_fast8_t shift,
+                                uint_fast16_t mask)
+{
+    return (uint16_t)((sim_read(reg_addr, 2u) & mask) >> shift);
+}
+
+void HW_set_8bit_reg(addr_t reg_addr, uint_fast8_t value)
+{
+    sim_write(reg_addr, (uint32_t)value & 0xFFu, 1u);
+}
+
+uint8_t HW_get_8bit_reg(addr_t reg_addr)
+{
+    return (uint8_t)sim_read(reg_addr, 1u);
+}
+
+void HW_set_8bit_reg_field(addr_t reg_addr,
+                           int_fast8_t shift,
+                           uint_fast8_t mask,
+                           uint_fast8_t value)
+{
+    uint32_t reg = sim_read(reg_addr, 1u);
+
+    reg = (reg & ~(uint32_t)mask) | (((uint32_t)value << shift) & mask);
+    sim_write(reg_addr, reg & 0xFFu, 1u);
+}
+
+uint8_t HW_get_8bit_reg_field(addr_t reg_addr,
+                              int_fast8_t shift,
+                              uint_fast8_t mask)
+{
+    return (uint8_t)((sim_read(reg_addr, 1u) & mask) >> shift);
+}
+
+/*------------------------------------------------------------------------------
+ * hal.h interrupt control, replaces hal_irq.c
+ */
+void HAL_enable_interrupts(void)
+{
+    g_mstatus |= HAL_SIM_MSTATUS_MIE;
+}
+
+psr_t HAL_disable_interrupts(void)
+{
+    psr_t psr = g_mstatus;
+
+    g_mstatus &= ~HAL_SIM_MSTATUS_MIE;
+    return psr;
+}
+
+void HAL_restore_interrupts(psr_t saved_psr)
+{
+    g_mstatus = saved_psr;
+}
+
+#ifdef __cplusplus
+}
+#endif
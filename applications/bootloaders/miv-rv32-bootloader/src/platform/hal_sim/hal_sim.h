@@ -0,0 +1,195 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file hal_sim.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Host simulation of the hardware register access layer.
+ *
+ * This is a drop-in replacement for hw_reg_access.S and hal_irq.c that allows
+ * the unmodified fabric IP drivers to be compiled for, and run on, a host PC.
+ * Every HW_set_xxx()/HW_get_xxx() access is routed to the register model that
+ * was registered for the address range being accessed, and is counted so that
+ * the number of bus accesses performed by a driver operation can be measured.
+ *
+ * Only compile the hal_sim directory with HAL_HOST_SIMULATION defined and
+ * without hal/hw_reg_access.S, hal/hal_irq.c and the miv_rv32_hal directory.
+ * See README.md in this directory.
+ */
+#ifndef HAL_SIM_H_
+#define HAL_SIM_H_
+
+#include <stddef.h>
+#include "hal/cpu_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+ * Number of simulated interrupt lines. The line numbers are arbitrary, they
+ * are only used to connect a register model to a handler.
+ */
+#define HAL_SIM_NB_IRQ_LINES            8u
+
+#define HAL_SIM_IRQ_MIV_I2C             0u
+#define HAL_SIM_IRQ_MIV_UDMA            1u
+#define HAL_SIM_IRQ_CORE_SPI0           2u
+#define HAL_SIM_IRQ_CORE_SPI1           3u
+#define HAL_SIM_IRQ_TIMER               4u      /* Raised by the test bench */
+
+/*------------------------------------------------------------------------------
+ * Value of the simulated mstatus MIE bit, as returned by
+ * HAL_disable_interrupts().
+ */
+#define HAL_SIM_MSTATUS_MIE             0x08u
+
+/*------------------------------------------------------------------------------
+ * Rate of the simulated MTIME counter, one tick per microsecond.
+ */
+#define HAL_SIM_MTIME_FREQ              1000000u
+
+typedef struct hal_sim_model hal_sim_model_t;
+
+/*------------------------------------------------------------------------------
+ * Register model callbacks.
+ * offset is relative to the model base address and width is the access width
+ * in bytes (1, 2 or 4).
+ */
+typedef uint32_t (*hal_sim_read_t)(hal_sim_model_t * model,
+                                   uint32_t offset,
+                                   uint8_t width);
+
+typedef void (*hal_sim_write_t)(hal_sim_model_t * model,
+                                uint32_t offset,
+                                uint32_t value,
+                                uint8_t width);
+
+/* Called from HAL_SIM_step() to let the model progress in time. */
+typedef void (*hal_sim_step_t)(hal_sim_model_t * model);
+
+struct hal_sim_model
+{
+    const char *        name;
+    addr_t              base_addr;
+    uint32_t            size;
+    hal_sim_read_t      read;
+    hal_sim_write_t     write;
+    hal_sim_step_t      step;
+    void *              state;
+
+    /* Number of accesses made to this model since the last counter reset. */
+    uint32_t            reads;
+    uint32_t            writes;
+
+    hal_sim_model_t *   next;
+};
+
+/*------------------------------------------------------------------------------
+ * Global access counters.
+ */
+typedef struct
+{
+    uint32_t reads;             /* Register reads, all models              */
+    uint32_t writes;            /* Register writes, all models             */
+    uint32_t unmapped;          /* Accesses to an address with no model    */
+    uint32_t irqs;              /* Interrupt handlers invoked              */
+    uint32_t steps;             /* Calls to HAL_SIM_step()                 */
+} hal_sim_counters_t;
+
+typedef void (*hal_sim_irq_handler_t)(void);
+
+/***************************************************************************//**
+ * HAL_SIM_register() adds a register model to the simulated memory map.
+ * The model structure must remain valid for the life of the simulation.
+ */
+void
+HAL_SIM_register
+(
+    hal_sim_model_t * model
+);
+
+/***************************************************************************//**
+ * HAL_SIM_map_memory() makes size bytes of host memory visible at address
+ * target_addr of the simulated memory map. HW_get_32bit_reg()/HW_set_32bit_reg()
+ * accesses to mapped memory are not counted as register accesses, and bus
+ * masters such as the uDMA model use HAL_SIM_translate() to reach it.
+ *
+ * @return 0 on success, -1 if the memory map table is full.
+ */
+int
+HAL_SIM_map_memory
+(
+    addr_t target_addr,
+    void * host_addr,
+    uint32_t size
+);
+
+/***************************************************************************//**
+ * HAL_SIM_translate() returns the host address corresponding to the simulated
+ * address target_addr, or NULL if the size bytes starting at target_addr are
+ * not all inside a single mapped memory region.
+ */
+void *
+HAL_SIM_translate
+(
+    addr_t target_addr,
+    uint32_t size
+);
+
+/***************************************************************************//**
+ * HAL_SIM_step() advances every register model by one step and then calls the
+ * handler of each asserted, enabled interrupt line provided interrupts are
+ * globally enabled. Drivers that wait for an interrupt-driven operation to
+ * complete must call HAL_SIM_step() from their wait loop.
+ */
+void
+HAL_SIM_step
+(
+    void
+);
+
+/***************************************************************************//**
+ * Interrupt line control.
+ * A register model drives the line level with HAL_SIM_set_irq(). The line is
+ * serviced from HAL_SIM_step() for as long as it is asserted and enabled.
+ */
+void HAL_SIM_set_irq_handler(uint8_t line, hal_sim_irq_handler_t handler);
+void HAL_SIM_enable_irq(uint8_t line);
+void HAL_SIM_disable_irq(uint8_t line);
+void HAL_SIM_set_irq(uint8_t line, uint8_t level);
+
+/***************************************************************************//**
+ * Simulated MTIME counter, used by miv_rv32_deadline.h.
+ * Every HAL_SIM_read_mtime() advances the counter by one tick so that a polling
+ * loop always reaches its deadline. A register model, or the test bench, with
+ * nothing to do while the code under test waits, moves the time forward with
+ * HAL_SIM_advance_mtime().
+ */
+uint64_t HAL_SIM_read_mtime(void);
+void HAL_SIM_advance_mtime(uint64_t ticks);
+
+/***************************************************************************//**
+ * HAL_SIM_reset_counters() clears the global and the per-model access counters.
+ */
+void
+HAL_SIM_reset_counters
+(
+    void
+);
+
+/***************************************************************************//**
+ * HAL_SIM_get_counters() returns a copy of the global access counters.
+ */
+hal_sim_counters_t
+HAL_SIM_get_counters
+(
+    void
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_SIM_H_ */
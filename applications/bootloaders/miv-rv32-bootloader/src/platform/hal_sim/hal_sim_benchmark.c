@@ -0,0 +1,2114 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file hal_sim_benchmark.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Host benchmark of the bootloader drivers against the register models.
+ *
+ * Runs the bootloader's UART, SPI flash, I2C EEPROM, uDMA, YModem and ZModem
+ * paths on the host and prints, in CSV format, the number of register accesses
+ * each operation needs. Register accesses are what dominates these operations on
+ * the Mi-V soft processor, each one being an uncached APB transaction, so the
+ * accesses per byte figure is a good proxy for their cost on the target. The
+ * data moved by every operation is checked and the program exits with a non
+ * zero status if any check fails. The hex_parser and elf_loader rows check
+ * the parser and the loader on valid and damaged files, without register
+ * accesses.
+ */
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include "fpga_design_config/fpga_design_config.h"
+#include "drivers/fabric_ip/CoreUARTapb/core_uart_apb.h"
+#include "drivers/fabric_ip/CoreUARTapb/core_uart_apb_static.h"
+#include "drivers/fabric_ip/CoreSPI/core_spi_static.h"
+#include "drivers/fabric_ip/miv_i2c/miv_i2c.h"
+#include "drivers/fabric_ip/miv_udma/miv_udma.h"
+#include "drivers/off_chip/spi_flash/spi_flash.h"
+#include "spi_bus/spi_bus.h"
+#include "i2c_sched/i2c_sched.h"
+#include "udma_service/udma_service.h"
+#include "irq_poll/irq_poll.h"
+#include "ymodem/ymodem.h"
+#include "zmodem/zmodem.h"
+#include "hex_parser/hex_parser.h"
+#include "elf_loader/elf_loader.h"
+#include "fw_slots/fw_slots.h"
+#include "boot_handoff/boot_handoff.h"
+#include "hal_sim_models.h"
+
+/* The uDMA is not part of the polarfire-eval-kit reference design. */
+#ifndef MIV_ESS_uDMA_BASE_ADDR
+#define MIV_ESS_uDMA_BASE_ADDR          0x78000000UL
+#endif
+
+/* CoreSPI in slave mode, not part of the polarfire-eval-kit reference design. */
+#define SLAVE_CORE_SPI_BASE             0x77000000UL
+
+#define LSRAM_BASE_ADDR                 0x80000000UL
+#define LSRAM_SIZE                      0x10000u
+#define SCRATCH_BASE_ADDR               0x80010000UL
+#define SCRATCH_SIZE                    0x10000u
+
+#define SIM_FLASH_SIZE                  0x100000u
+#define SIM_EEPROM_SIZE                 0x10000u
+#define SIM_EEPROM_ADDR                 0x50u
+
+#define BENCH_BLOCK_SIZE                4096u
+#define BENCH_I2C_PAGES                 16u
+#define BENCH_I2C_XFR_LEN               258u
+#define BENCH_TRANSFER_SIZE             32768u
+#define BENCH_FLASH_IMAGE_ADDR          0x10000u
+#define BENCH_SPI_BUS_XFERS             64u
+
+/* Remote master of the slave benchmarks: transactions of BENCH_SPI_SLAVE_XFR
+ * frames, the slave interrupt is serviced every BENCH_SPI_SLAVE_BURST frames. */
+#define BENCH_SPI_SLAVE_XFR             256u
+#define BENCH_SPI_SLAVE_BURST           16u
+#define BENCH_SPI_STREAM_RING           1024u
+
+/* Interrupt storm: the remote master clocks one frame per step and the main
+ * loop runs every BENCH_SPI_STORM_LOOP frames. */
+#define BENCH_SPI_STORM_LOOP            16u
+#define BENCH_SPI_STORM_BUDGET          64u
+#define BENCH_SCHED_TICKS               64u
+#define BENCH_SCHED_TICK_STEPS          400u
+#define BENCH_SCHED_READ_STEPS          50u
+
+/* uDMA service: two bulk copies at normal priority, then small high priority
+ * copies submitted once the first chunk is done. */
+#define BENCH_UDMA_BULK_SIZE            16384u
+#define BENCH_UDMA_URGENT_SIZE          256u
+#define BENCH_UDMA_URGENT_XFERS         4u
+
+/* Link used to estimate the transfer times. USB to UART bridges hold the
+ * receiver's replies for up to their latency timer, 16 ms by default on FTDI
+ * devices, so each turnaround costs about that long. */
+#define BENCH_LINK_LATENCY_MS           16u
+
+/*------------------------------------------------------------------------------
+ * Globals the bootloader middleware expects.
+ */
+UART_instance_t g_uart;
+
+static miv_i2c_instance_t g_miv_i2c_inst;
+static miv_udma_instance_t g_udma;
+static spi_instance_t g_spi_slave;
+
+/*------------------------------------------------------------------------------
+ * Models and their backing storage.
+ */
+static sim_uart_t g_sim_uart;
+static sim_spi_t g_sim_spi;
+static sim_spi_t g_sim_spi_slave;
+static sim_spi_flash_t g_sim_flash;
+static sim_i2c_t g_sim_i2c;
+static sim_i2c_eeprom_t g_sim_eeprom;
+static sim_udma_t g_sim_udma;
+
+static uint8_t g_flash_memory[SIM_FLASH_SIZE];
+static uint8_t g_eeprom_memory[SIM_EEPROM_SIZE];
+static uint8_t g_lsram[LSRAM_SIZE];
+static uint8_t g_scratch[SCRATCH_SIZE];
+
+static uint8_t g_pattern[BENCH_BLOCK_SIZE];
+static uint8_t g_readback[BENCH_BLOCK_SIZE];
+static uint8_t g_miso[BENCH_TRANSFER_SIZE];
+
+static uint32_t g_failures = 0u;
+
+/*------------------------------------------------------------------------------
+ * Link use of each file transfer, printed after the access counts.
+ */
+typedef struct
+{
+    const char * name;
+    uint32_t sent;
+    uint32_t replies;
+    uint32_t turnarounds;
+} link_result_t;
+
+static link_result_t g_link_results[4];
+static uint32_t g_link_result_count = 0u;
+
+/*------------------------------------------------------------------------------
+ * File sender, fed to the UART receiver whenever the driver finds it empty.
+ * The stream is cut into segments. Like a real YMODEM or ZMODEM sender, the
+ * harness only sends a segment once the receiver sent the reply it waits for;
+ * each of these waits is a link turnaround.
+ */
+#define LINK_STREAM_SIZE                ((2u * BENCH_TRANSFER_SIZE) + 4096u)
+#define LINK_MAX_SEGMENTS               64u
+
+/* Reply events: the bytes sent by the receiver, and the ZMODEM hex headers */
+#define LINK_ZMODEM_REPLY(type)         (0x100 | (type))
+
+#define ZDLE                            0x18u
+#define ZRQINIT                         0u
+#define ZRINIT                          1u
+#define ZACK                            3u
+#define ZFILE                           4u
+#define ZFIN                            8u
+#define ZRPOS                           9u
+#define ZDATA                           10u
+#define ZEOF                            11u
+#define ZCRCE                           'h'
+#define ZCRCG                           'i'
+#define ZCRCW                           'k'
+
+typedef struct
+{
+    uint32_t start;
+    int32_t trigger;
+} link_segment_t;
+
+static uint8_t g_link_stream[LINK_STREAM_SIZE];
+static uint32_t g_link_size = 0u;
+static uint32_t g_link_idx = 0u;
+static link_segment_t g_link_segments[LINK_MAX_SEGMENTS];
+static uint32_t g_link_segment_count = 0u;
+static uint32_t g_link_next = 0u;
+static uint32_t g_link_turnarounds = 0u;
+static uint32_t g_uart_tx_bytes = 0u;
+
+/* Progress through a "**" ZDLE 'B' header sent by the receiver */
+static uint32_t g_hex_match = 0u;
+static int32_t g_hex_type = 0;
+
+static void link_event(int32_t event)
+{
+    if ((g_link_next < g_link_segment_count) &&
+        (event == g_link_segments[g_link_next].trigger))
+    {
+        ++g_link_next;
+        ++g_link_turnarounds;
+    }
+}
+
+static int32_t hex_nibble(uint8_t c)
+{
+    return ((c >= '0') && (c <= '9')) ? (c - '0') : (c - 'a' + 10);
+}
+
+static void uart_tx_handler(void * ctx, uint8_t tx_byte)
+{
+    static const uint8_t hex_header[4] = { '*', '*', ZDLE, 'B' };
+
+    (void)ctx;
+    ++g_uart_tx_bytes;
+
+    link_event(tx_byte);
+
+    if (g_hex_match < sizeof(hex_header))
+    {
+        g_hex_match = (tx_byte == hex_header[g_hex_match]) ? (g_hex_match + 1u) :
+                      (('*' == tx_byte) ? 1u : 0u);
+    }
+    else if (sizeof(hex_header) == g_hex_match)
+    {
+        g_hex_type = hex_nibble(tx_byte) << 4;
+        ++g_hex_match;
+    }
+    else
+    {
+        link_event(LINK_ZMODEM_REPLY(g_hex_type | hex_nibble(tx_byte)));
+        g_hex_match = 0u;
+    }
+}
+
+static void uart_idle_handler(void * ctx)
+{
+    sim_uart_t * uart = (sim_uart_t *)ctx;
+    uint32_t released = (g_link_next < g_link_segment_count) ?
+                        g_link_segments[g_link_next].start : g_link_size;
+
+    if (g_link_idx < released)
+    {
+        g_link_idx += sim_uart_push_rx(uart, &g_link_stream[g_link_idx],
+                                       released - g_link_idx);
+    }
+    else
+    {
+        /* Nothing to send, let the receiver time out. */
+        HAL_SIM_advance_mtime(HAL_SIM_MTIME_FREQ / 100u);
+    }
+}
+
+static void link_reset(void)
+{
+    g_link_size = 0u;
+    g_link_idx = 0u;
+    g_link_segment_count = 0u;
+    g_link_next = 0u;
+    g_link_turnarounds = 0u;
+    g_uart_tx_bytes = 0u;
+    g_hex_match = 0u;
+}
+
+static void link_record(const char * name)
+{
+    link_result_t * result = &g_link_results[g_link_result_count++];
+
+    result->name = name;
+    result->sent = g_link_idx;
+    result->replies = g_uart_tx_bytes;
+    result->turnarounds = g_link_turnarounds;
+}
+
+/* What follows is only sent once the receiver sent trigger */
+static void link_wait(int32_t trigger)
+{
+    g_link_segments[g_link_segment_count].start = g_link_size;
+    g_link_segments[g_link_segment_count].trigger = trigger;
+    ++g_link_segment_count;
+}
+
+static void link_put(uint8_t c)
+{
+    g_link_stream[g_link_size++] = c;
+}
+
+static void ymodem_add_packet(uint8_t seq, const uint8_t * data, uint32_t size)
+{
+    uint8_t * packet = &g_link_stream[g_link_size];
+    uint32_t packet_size = (size > PACKET_SIZE) ? PACKET_1K_SIZE : PACKET_SIZE;
+    uint16_t crc;
+
+    packet[0] = (PACKET_1K_SIZE == packet_size) ? STX : SOH;
+    packet[PACKET_SEQNO_INDEX] = seq;
+    packet[PACKET_SEQNO_COMP_INDEX] = (uint8_t)~seq;
+    memset(&packet[PACKET_HEADER], 0x1A, packet_size);
+    if (size > 0u)
+    {
+        memcpy(&packet[PACKET_HEADER], data, size);
+    }
+    else
+    {
+        memset(&packet[PACKET_HEADER], 0, packet_size);
+    }
+
+    crc = sf2bl_crc16(&packet[PACKET_HEADER], packet_size);
+    packet[PACKET_HEADER + packet_size] = (uint8_t)(crc >> 8);
+    packet[PACKET_HEADER + packet_size + 1u] = (uint8_t)crc;
+
+    g_link_size += packet_size + PACKET_OVERHEAD;
+}
+
+static void ymodem_build_stream(const uint8_t * file, uint32_t size)
+{
+    uint8_t header[PACKET_SIZE];
+    uint32_t offset;
+    uint8_t seq = 1u;
+    int len;
+
+    link_reset();
+
+    memset(header, 0, sizeof(header));
+    len = snprintf((char *)header, sizeof(header), "image.bin");
+    snprintf((char *)&header[len + 1], sizeof(header) - (uint32_t)len - 1u,
+             "%u", (unsigned)size);
+    ymodem_add_packet(0u, header, sizeof(header));
+    link_wait(CRC);
+
+    for (offset = 0u; offset < size; offset += PACKET_1K_SIZE)
+    {
+        uint32_t chunk = ((size - offset) < PACKET_1K_SIZE) ? (size - offset) :
+                                                              PACKET_1K_SIZE;
+
+        ymodem_add_packet(seq++, &file[offset], chunk);
+        link_wait(ACK);
+    }
+
+    link_put(EOT);
+    link_wait(CRC);
+
+    /* Empty file name packet ends the batch */
+    ymodem_add_packet(0u, NULL, 0u);
+}
+
+static uint32_t crc32_of(const uint8_t * data, uint32_t size)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    uint32_t bit;
+
+    while (0u != size--)
+    {
+        crc ^= *data++;
+        for (bit = 0u; bit < 8u; ++bit)
+        {
+            crc = (crc & 1u) ? ((crc >> 1) ^ 0xEDB88320u) : (crc >> 1);
+        }
+    }
+
+    return ~crc;
+}
+
+/* ZDLE escape of the bytes lrzsz sz escapes by default */
+static void zmodem_put(uint8_t c)
+{
+    switch (c)
+    {
+    case ZDLE:
+    case 0x10u:
+    case 0x11u:
+    case 0x13u:
+    case 0x90u:
+    case 0x91u:
+    case 0x93u:
+        link_put(ZDLE);
+        link_put(c ^ 0x40u);
+        break;
+
+    default:
+        link_put(c);
+        break;
+    }
+}
+
+static void zmodem_hex_header(uint8_t type, uint32_t value)
+{
+    uint8_t raw[7];
+    uint16_t crc;
+    int len;
+
+    raw[0] = type;
+    memcpy(&raw[1], &value, 4u);
+    crc = sf2bl_crc16(raw, 5u);
+    raw[5] = (uint8_t)(crc >> 8);
+    raw[6] = (uint8_t)crc;
+
+    len = snprintf((char *)&g_link_stream[g_link_size], 24u,
+                   "**\x18" "B%02x%02x%02x%02x%02x%02x%02x\r\x8a",
+                   raw[0], raw[1], raw[2], raw[3], raw[4], raw[5], raw[6]);
+    g_link_size += (uint32_t)len;
+}
+
+static void zmodem_bin32_header(uint8_t type, uint32_t value)
+{
+    uint8_t raw[5];
+    uint32_t crc;
+    uint32_t idx;
+
+    raw[0] = type;
+    memcpy(&raw[1], &value, 4u);
+    crc = crc32_of(raw, sizeof(raw));
+
+    link_put('*');
+    link_put(ZDLE);
+    link_put('C');
+    for (idx = 0u; idx < sizeof(raw); ++idx)
+    {
+        zmodem_put(raw[idx]);
+    }
+    for (idx = 0u; idx < 4u; ++idx)
+    {
+        zmodem_put((uint8_t)(crc >> (8u * idx)));
+    }
+}
+
+static void zmodem_subpacket(const uint8_t * data, uint32_t size, uint8_t end)
+{
+    static uint8_t block[ZMODEM_BLOCK_SIZE + 1u];
+    uint32_t crc;
+    uint32_t idx;
+
+    memcpy(block, data, size);
+    block[size] = end;
+    crc = crc32_of(block, size + 1u);
+
+    for (idx = 0u; idx < size; ++idx)
+    {
+        zmodem_put(data[idx]);
+    }
+    link_put(ZDLE);
+    link_put(end);
+    for (idx = 0u; idx < 4u; ++idx)
+    {
+        zmodem_put((uint8_t)(crc >> (8u * idx)));
+    }
+}
+
+/* As sent by lrzsz sz: 1 kB subpackets with CRC-32, and a ZCRCW at the end of
+ * each window when the receiver sets one */
+static void zmodem_build_stream(const uint8_t * file, uint32_t size,
+                                uint32_t window)
+{
+    uint8_t info[32];
+    uint32_t offset;
+    uint32_t chunk;
+    uint8_t end;
+    int len;
+
+    link_reset();
+
+    link_put('r');
+    link_put('z');
+    link_put('\r');
+    zmodem_hex_header(ZRQINIT, 0u);
+    link_wait(LINK_ZMODEM_REPLY(ZRINIT));
+
+    memset(info, 0, sizeof(info));
+    len = snprintf((char *)info, sizeof(info), "image.bin");
+    len += 1 + snprintf((char *)&info[len + 1], sizeof(info) - (uint32_t)len - 1u,
+                        "%u 0 0", (unsigned)size);
+    zmodem_bin32_header(ZFILE, 0x01000000u);    /* ZF0 = ZCBIN */
+    zmodem_subpacket(info, (uint32_t)len + 1u, ZCRCW);
+    link_wait(LINK_ZMODEM_REPLY(ZRPOS));
+
+    zmodem_bin32_header(ZDATA, 0u);
+    for (offset = 0u; offset < size; offset += chunk)
+    {
+        chunk = ((size - offset) < ZMODEM_BLOCK_SIZE) ? (size - offset) :
+                                                        ZMODEM_BLOCK_SIZE;
+        end = ((offset + chunk) >= size) ? ZCRCE :
+              ((0u != window) && (0u == ((offset + chunk) % window))) ? ZCRCW :
+              ZCRCG;
+        zmodem_subpacket(&file[offset], chunk, end);
+
+        if (ZCRCW == end)
+        {
+            link_wait(LINK_ZMODEM_REPLY(ZACK));
+            zmodem_bin32_header(ZDATA, offset + chunk);
+        }
+    }
+    zmodem_bin32_header(ZEOF, size);
+    link_wait(LINK_ZMODEM_REPLY(ZRINIT));
+
+    zmodem_hex_header(ZFIN, 0u);
+    link_wait(LINK_ZMODEM_REPLY(ZFIN));
+    link_put('O');
+    link_put('O');
+}
+
+/*------------------------------------------------------------------------------
+ * Interrupt handlers
+ */
+static void i2c_irq_handler(void)
+{
+    MIV_I2C_isr(&g_miv_i2c_inst);
+}
+
+static void udma_irq_handler(void)
+{
+    MIV_uDMA_reset(&g_udma);
+}
+
+static udma_service_t g_udma_service;
+
+static void udma_service_irq_handler(void)
+{
+    udma_service_isr(&g_udma_service);
+}
+
+static void spi_slave_irq_handler(void)
+{
+    SPI_isr(&g_spi_slave);
+}
+
+static irq_poll_list_t g_poll_list;
+static irq_poll_t g_spi_slave_poll;
+
+static void spi_slave_poll_irq_handler(void)
+{
+    irq_poll_schedule(&g_spi_slave_poll);
+}
+
+static i2c_sched_t g_sched;
+
+static void timer_irq_handler(void)
+{
+    HAL_SIM_set_irq(HAL_SIM_IRQ_TIMER, 0u);
+    i2c_sched_tick(&g_sched);
+}
+
+static void wait_i2c(void)
+{
+    uint32_t guard = 0u;
+
+    /* Also let the stop condition issued by the ISR reach the bus. */
+    while (((MIV_I2C_IN_PROGRESS == g_miv_i2c_inst.master_status) ||
+            (NULL != g_sim_i2c.active)) &&
+           (guard++ < 1000000u))
+    {
+        HAL_SIM_step();
+    }
+}
+
+/*------------------------------------------------------------------------------
+ * Reporting
+ */
+static void report(const char * name, uint32_t nb_bytes, int passed)
+{
+    hal_sim_counters_t counters = HAL_SIM_get_counters();
+    uint32_t accesses = counters.reads + counters.writes;
+
+    printf("%s,%u,%u,%u,%u,%.2f,%u,%u,%s\n",
+           name,
+           (unsigned)nb_bytes,
+           (unsigned)counters.reads,
+           (unsigned)counters.writes,
+           (unsigned)accesses,
+           (nb_bytes > 0u) ? ((double)accesses / (double)nb_bytes) : 0.0,
+           (unsigned)counters.irqs,
+           (unsigned)counters.steps,
+           passed ? "ok" : "FAIL");
+
+    if (!passed)
+    {
+        ++g_failures;
+    }
+}
+
+static void fill_pattern(uint8_t * buf, uint32_t size, uint32_t seed)
+{
+    uint32_t idx;
+
+    for (idx = 0u; idx < size; ++idx)
+    {
+        seed = (seed * 1103515245u) + 12345u;
+        buf[idx] = (uint8_t)(seed >> 16);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ * Benchmarks
+ */
+static void bench_uart(void)
+{
+    static uint8_t message[1025];
+
+    memset(message, 'A', sizeof(message) - 1u);
+    message[sizeof(message) - 1u] = 0u;
+
+    g_uart_tx_bytes = 0u;
+    HAL_SIM_reset_counters();
+    UART_polled_tx_string(&g_uart, message);
+    report("uart_polled_tx_string", sizeof(message) - 1u,
+           (sizeof(message) - 1u) == g_uart_tx_bytes);
+
+    /* Same accesses with the base address folded in, see core_uart_apb_static.h */
+    g_uart_tx_bytes = 0u;
+    HAL_SIM_reset_counters();
+    COREUARTAPB0_polled_tx_string(&g_uart, message);
+    report("uart_polled_tx_string_static", sizeof(message) - 1u,
+           (sizeof(message) - 1u) == g_uart_tx_bytes);
+}
+
+/*
+ * Read the ID of the flashes on SSEL 0 and SSEL 1 in turn, as two drivers
+ * sharing the CoreSPI would, first selecting the slave around each transfer as
+ * the CoreSPI driver does, then through the bus manager.
+ */
+static void bench_spi_bus(void)
+{
+    static spi_instance_t spi;
+    static spi_bus_t bus;
+    static spi_bus_device_t device[2];
+    const uint8_t cmd = 0x9Fu;          /* Read ID */
+    uint8_t id[3];
+    uint32_t idx;
+    int passed = 1;
+
+    SPI_init(&spi, FLASH_CORE_SPI_BASE, 32u);
+    SPI_configure_master_mode(&spi);
+
+    HAL_SIM_reset_counters();
+    for (idx = 0u; idx < BENCH_SPI_BUS_XFERS; ++idx)
+    {
+        SPI_set_slave_select(&spi, (spi_slave_t)(idx & 1u));
+        SPI_transfer_block(&spi, &cmd, 1u, id, sizeof(id));
+        SPI_clear_slave_select(&spi, (spi_slave_t)(idx & 1u));
+        passed = passed && (0 == memcmp(id, g_sim_flash.id, sizeof(id)));
+    }
+    report("spi_select_per_transfer", BENCH_SPI_BUS_XFERS * sizeof(id), passed);
+
+    HAL_SIM_reset_counters();
+    for (idx = 0u; idx < BENCH_SPI_BUS_XFERS; ++idx)
+    {
+        SPI_set_slave_select(&spi, (spi_slave_t)(idx & 1u));
+        FLASH_CORE_SPI_transfer_block(&spi, &cmd, 1u, id, sizeof(id));
+        SPI_clear_slave_select(&spi, (spi_slave_t)(idx & 1u));
+        passed = passed && (0 == memcmp(id, g_sim_flash.id, sizeof(id)));
+    }
+    report("spi_select_per_transfer_static", BENCH_SPI_BUS_XFERS * sizeof(id), passed);
+
+    spi_bus_init(&bus, &spi, FLASH_CORE_SPI_BASE, 32u, SPI_BUS_MODE_0, 0u);
+    for (idx = 0u; idx < 2u; ++idx)
+    {
+        passed = passed &&
+                 (SPI_BUS_SUCCESS == spi_bus_add_device(&bus, &device[idx],
+                                                        (spi_slave_t)idx,
+                                                        SPI_BUS_MODE_0, 0u,
+                                                        SPI_BUS_PRIORITY_NORMAL));
+    }
+
+    HAL_SIM_reset_counters();
+    for (idx = 0u; idx < BENCH_SPI_BUS_XFERS; ++idx)
+    {
+        passed = passed &&
+                 (SPI_BUS_SUCCESS == spi_bus_transfer(&device[idx & 1u], &cmd, 1u,
+                                                      id, sizeof(id))) &&
+                 (0 == memcmp(id, g_sim_flash.id, sizeof(id)));
+    }
+    report("spi_bus_transfer", BENCH_SPI_BUS_XFERS * sizeof(id),
+           passed && (BENCH_SPI_BUS_XFERS == bus.selects));
+}
+
+static void bench_spi_flash(void)
+{
+    struct device_Info dev_info;
+    uint16_t status;
+
+    spi_flash_init(FLASH_CORE_SPI_BASE);
+    spi_flash_control_hw(SPI_FLASH_RESET, 0u, &status);
+
+    /* Otherwise loaded by the first erase */
+    spi_flash_load_erase_counts();
+
+    HAL_SIM_reset_counters();
+    spi_flash_control_hw(SPI_FLASH_READ_DEVICE_ID, 0u, &dev_info);
+    report("spi_flash_read_id", 3u,
+           (dev_info.manufacturer_id == g_sim_flash.id[0]) &&
+           (dev_info.device_id == g_sim_flash.id[1]));
+
+    HAL_SIM_reset_counters();
+    spi_flash_control_hw(SPI_FLASH_4KBLOCK_ERASE, 0u, NULL);
+    report("spi_flash_erase_4k", BENCH_BLOCK_SIZE, 1u == g_sim_flash.blocks_erased);
+
+    fill_pattern(g_pattern, BENCH_BLOCK_SIZE, 1u);
+    HAL_SIM_reset_counters();
+    spi_flash_write(0u, g_pattern, BENCH_BLOCK_SIZE);
+    report("spi_flash_write", BENCH_BLOCK_SIZE,
+           0 == memcmp(g_flash_memory, g_pattern, BENCH_BLOCK_SIZE));
+
+    memset(g_readback, 0, BENCH_BLOCK_SIZE);
+    HAL_SIM_reset_counters();
+    spi_flash_read(0u, g_readback, BENCH_BLOCK_SIZE);
+    report("spi_flash_read", BENCH_BLOCK_SIZE,
+           0 == memcmp(g_readback, g_pattern, BENCH_BLOCK_SIZE));
+}
+
+/*
+ * Save the erase counts of the flash benchmarks, then load them back. The
+ * save is the erase of one block of the reserved area and a 2 page program.
+ */
+static void bench_spi_flash_erase_counts(void)
+{
+    const spi_flash_latency_t * erase = spi_flash_get_latency(SPI_FLASH_LATENCY_4KBLOCK_ERASE);
+    uint32_t counts[SPI_FLASH_NB_SECTORS];
+    uint32_t erases = 0u;
+    uint32_t sector;
+    uint32_t bucket;
+    int passed;
+
+    HAL_SIM_reset_counters();
+    passed = (SPI_FLASH_SUCCESS == spi_flash_save_erase_counts());
+    report("spi_flash_save_erase_counts", (uint32_t)sizeof(counts), passed);
+
+    for (sector = 0u; sector < SPI_FLASH_NB_SECTORS; ++sector)
+    {
+        counts[sector] = spi_flash_get_erase_count(sector);
+    }
+
+    for (bucket = 0u; bucket < SPI_FLASH_LATENCY_BUCKETS; ++bucket)
+    {
+        erases += erase->buckets[bucket];
+    }
+
+    HAL_SIM_reset_counters();
+    passed = (SPI_FLASH_SUCCESS == spi_flash_load_erase_counts()) &&
+             (0u != counts[0]) &&
+             (0u != counts[SPI_FLASH_NB_SECTORS - 1u]) &&
+             (erase->count == erases) &&
+             (erase->count == g_sim_flash.blocks_erased);
+    for (sector = 0u; sector < SPI_FLASH_NB_SECTORS; ++sector)
+    {
+        passed = passed && (counts[sector] == spi_flash_get_erase_count(sector));
+    }
+    report("spi_flash_load_erase_counts", (uint32_t)sizeof(counts), passed);
+}
+
+/*
+ * The same flash behind a CoreSPI configured for 32 bit frames. The write and
+ * the read neither start nor end on a frame boundary.
+ */
+static void bench_spi_flash_wide(void)
+{
+    static spi_instance_t spi;
+    static spi_bus_t bus;
+    const uint32_t address = BENCH_BLOCK_SIZE + 1u;
+    const uint32_t size = BENCH_BLOCK_SIZE - 3u;
+
+    sim_spi_set_frame_width(&g_sim_spi, SPI_FRAME_WIDTH_32);
+    spi_bus_init(&bus, &spi, FLASH_CORE_SPI_BASE, 32u, SPI_BUS_MODE_0, 0u);
+    SPI_set_frame_width(&spi, SPI_FRAME_WIDTH_32);
+    spi_flash_attach(&bus, SPI_SLAVE_0);
+
+    spi_flash_control_hw(SPI_FLASH_4KBLOCK_ERASE, BENCH_BLOCK_SIZE, NULL);
+
+    fill_pattern(g_pattern, size, 8u);
+    HAL_SIM_reset_counters();
+    spi_flash_write(address, g_pattern, size);
+    report("spi_flash_write_32bit_frames", size,
+           (0 == memcmp(&g_flash_memory[address], g_pattern, size)) &&
+           (0xFFu == g_flash_memory[address - 1u]) &&
+           (0xFFu == g_flash_memory[address + size]));
+
+    memset(g_readback, 0, BENCH_BLOCK_SIZE);
+    HAL_SIM_reset_counters();
+    spi_flash_read(address, g_readback, size);
+    report("spi_flash_read_32bit_frames", size,
+           (0 == memcmp(g_readback, g_pattern, size)) &&
+           (0u == g_readback[size]));
+
+    /* Back to the bootloader configuration */
+    sim_spi_set_frame_width(&g_sim_spi, SPI_FRAME_WIDTH_8);
+    spi_flash_init(FLASH_CORE_SPI_BASE);
+}
+
+/*
+ * Transfer completion handler, counts the transactions the ISR reports. An
+ * RTOS wakes the waiting task from here, see miv_i2c_rtos.c.
+ */
+static uint32_t g_i2c_completions;
+
+static void i2c_transfer_done(miv_i2c_instance_t * this_i2c,
+                              miv_i2c_status_t status)
+{
+    (void)this_i2c;
+
+    if (MIV_I2C_SUCCESS == status)
+    {
+        ++g_i2c_completions;
+    }
+}
+
+static void bench_i2c_eeprom(void)
+{
+    static uint8_t tx_buffer[BENCH_I2C_XFR_LEN];
+    static uint8_t rx_buffer[1u + SIM_I2C_EEPROM_PAGE_SIZE];
+    uint8_t address[2];
+    uint32_t page;
+    int passed = 1;
+
+    MIV_I2C_init(&g_miv_i2c_inst, MIV_I2C_BASE_ADDR);
+    MIV_I2C_config(&g_miv_i2c_inst, 0x0063u);
+    MIV_I2C_register_transfer_completion_handler(&g_miv_i2c_inst,
+                                                 i2c_transfer_done);
+    HAL_enable_interrupts();
+
+    fill_pattern(g_pattern, BENCH_I2C_PAGES * SIM_I2C_EEPROM_PAGE_SIZE, 2u);
+
+    /* Same transfer pattern as write_program_to_i2ceeprom() */
+    HAL_SIM_reset_counters();
+    for (page = 0u; page < BENCH_I2C_PAGES; ++page)
+    {
+        tx_buffer[0] = (uint8_t)page;
+        tx_buffer[1] = 0u;
+        memcpy(&tx_buffer[2], &g_pattern[page * SIM_I2C_EEPROM_PAGE_SIZE],
+               SIM_I2C_EEPROM_PAGE_SIZE);
+
+        MIV_I2C_write(&g_miv_i2c_inst, SIM_EEPROM_ADDR, tx_buffer,
+                      BENCH_I2C_XFR_LEN, MIV_I2C_RELEASE_BUS,
+                      MIV_I2C_ACK_POLLING_ENABLE);
+        wait_i2c();
+        passed = passed && (MIV_I2C_SUCCESS == g_miv_i2c_inst.master_status);
+    }
+    report("i2c_eeprom_write", BENCH_I2C_PAGES * SIM_I2C_EEPROM_PAGE_SIZE,
+           passed && (BENCH_I2C_PAGES == g_i2c_completions) &&
+           (0 == memcmp(g_eeprom_memory, g_pattern,
+                                  BENCH_I2C_PAGES * SIM_I2C_EEPROM_PAGE_SIZE)));
+
+    /*
+     * MIV_I2C_write_read() stores the byte received with the address
+     * acknowledge one location before the read buffer, hence rx_buffer[0].
+     */
+    address[0] = 0u;
+    address[1] = 0u;
+    HAL_SIM_reset_counters();
+    MIV_I2C_write_read(&g_miv_i2c_inst, SIM_EEPROM_ADDR, address, sizeof(address),
+                       &rx_buffer[1], SIM_I2C_EEPROM_PAGE_SIZE,
+                       MIV_I2C_RELEASE_BUS, MIV_I2C_ACK_POLLING_ENABLE);
+    wait_i2c();
+    report("i2c_eeprom_write_read", SIM_I2C_EEPROM_PAGE_SIZE,
+           (MIV_I2C_SUCCESS == g_miv_i2c_inst.master_status) &&
+           (0 == memcmp(&rx_buffer[1], g_pattern, SIM_I2C_EEPROM_PAGE_SIZE)));
+}
+
+/*
+ * Three sensors read every 1, 2 and 4 ticks from the registers of the EEPROM
+ * written by bench_i2c_eeprom(). The main loop checks the last samples every
+ * BENCH_SCHED_READ_STEPS steps and never waits for the bus.
+ */
+static void bench_i2c_sched(void)
+{
+    static const struct
+    {
+        uint16_t reg;
+        uint8_t length;
+        uint32_t period_ms;
+    } config[3] =
+    {
+        { 0x0000u, 2u, 1u },
+        { 0x0040u, 6u, 2u },
+        { 0x0100u, 16u, 4u }
+    };
+    static i2c_sched_sensor_t sensors[3];
+    uint8_t data[I2C_SCHED_MAX_LENGTH];
+    uint32_t tick;
+    uint32_t step;
+    uint32_t idx;
+    uint32_t nb_bytes = 0u;
+    int passed = 1;
+
+    i2c_sched_init(&g_sched, &g_miv_i2c_inst, 1u);
+    for (idx = 0u; idx < 3u; ++idx)
+    {
+        passed = passed &&
+                 (I2C_SCHED_SUCCESS == i2c_sched_add_sensor(&g_sched, &sensors[idx],
+                                                            SIM_EEPROM_ADDR,
+                                                            config[idx].reg, 2u,
+                                                            config[idx].length,
+                                                            config[idx].period_ms));
+    }
+
+    HAL_SIM_set_irq_handler(HAL_SIM_IRQ_TIMER, timer_irq_handler);
+    HAL_SIM_enable_irq(HAL_SIM_IRQ_TIMER);
+
+    HAL_SIM_reset_counters();
+    for (tick = 0u; tick < BENCH_SCHED_TICKS; ++tick)
+    {
+        HAL_SIM_set_irq(HAL_SIM_IRQ_TIMER, 1u);
+        for (step = 0u; step < BENCH_SCHED_TICK_STEPS; ++step)
+        {
+            HAL_SIM_step();
+
+            if (0u == (step % BENCH_SCHED_READ_STEPS))
+            {
+                for (idx = 0u; idx < 3u; ++idx)
+                {
+                    if (0u != i2c_sched_read(&sensors[idx], data, NULL))
+                    {
+                        passed = passed &&
+                                 (0 == memcmp(data, &g_eeprom_memory[config[idx].reg],
+                                              config[idx].length));
+                    }
+                }
+            }
+        }
+    }
+
+    for (idx = 0u; idx < 3u; ++idx)
+    {
+        passed = passed &&
+                 (sensors[idx].published == (BENCH_SCHED_TICKS / config[idx].period_ms)) &&
+                 (0u == sensors[idx].errors) && (0u == sensors[idx].overruns);
+        nb_bytes += sensors[idx].published * config[idx].length;
+    }
+    report("i2c_sched_sensors", nb_bytes, passed);
+
+    HAL_SIM_disable_irq(HAL_SIM_IRQ_TIMER);
+}
+
+static void bench_udma(void)
+{
+    uint32_t guard = 0u;
+
+    MIV_uDMA_init(&g_udma, MIV_ESS_uDMA_BASE_ADDR);
+    HAL_SIM_enable_irq(HAL_SIM_IRQ_MIV_UDMA);
+
+    fill_pattern(g_lsram, BENCH_BLOCK_SIZE, 3u);
+    memset(g_scratch, 0, BENCH_BLOCK_SIZE);
+
+    HAL_SIM_reset_counters();
+    MIV_uDMA_config(&g_udma, LSRAM_BASE_ADDR, SCRATCH_BASE_ADDR,
+                    BENCH_BLOCK_SIZE / 4u, MIV_uDMA_CTRL_IRQ_CONFIG);
+    MIV_uDMA_start(&g_udma);
+    do
+    {
+        HAL_SIM_step();
+    } while ((MIV_uDMA_read_status(&g_udma) & MIV_uDMA_STATUS_BUSY) &&
+             (guard++ < 1000u));
+
+    report("udma_copy", BENCH_BLOCK_SIZE,
+           0 == memcmp(g_scratch, g_lsram, BENCH_BLOCK_SIZE));
+}
+
+/*
+ * Completion order of the requests of bench_udma_service(), by client: 'A' and
+ * 'B' for the bulk copies, 'H' for the high priority ones.
+ */
+static char g_udma_done_order[2u + BENCH_UDMA_URGENT_XFERS + 1u];
+static uint32_t g_udma_done_count = 0u;
+
+static void udma_request_done(udma_request_t * request, udma_service_status_t status)
+{
+    if ((UDMA_SERVICE_SUCCESS == status) &&
+        (g_udma_done_count < (sizeof(g_udma_done_order) - 1u)))
+    {
+        g_udma_done_order[g_udma_done_count++] = *(const char *)request->context;
+    }
+}
+
+static void bench_udma_service(void)
+{
+    static udma_client_t bulk[2];
+    static udma_client_t urgent;
+    static udma_request_t bulk_req[2];
+    static udma_request_t urgent_req[BENCH_UDMA_URGENT_XFERS];
+    static const char names[3] = { 'A', 'B', 'H' };
+    const uint32_t urgent_base = 2u * BENCH_UDMA_BULK_SIZE;
+    udma_service_stats_t stats;
+    uint32_t guard = 0u;
+    uint32_t idx;
+    int passed = 1;
+
+    HAL_SIM_set_irq_handler(HAL_SIM_IRQ_MIV_UDMA, udma_service_irq_handler);
+    udma_service_init(&g_udma_service, &g_udma, MIV_ESS_uDMA_BASE_ADDR);
+    for (idx = 0u; idx < 2u; ++idx)
+    {
+        passed = passed &&
+                 (UDMA_SERVICE_SUCCESS == udma_service_add_client(&g_udma_service, &bulk[idx],
+                                                                  UDMA_SERVICE_PRIORITY_NORMAL,
+                                                                  udma_request_done));
+    }
+    passed = passed &&
+             (UDMA_SERVICE_SUCCESS == udma_service_add_client(&g_udma_service, &urgent,
+                                                              UDMA_SERVICE_PRIORITY_HIGH,
+                                                              udma_request_done));
+
+    fill_pattern(g_lsram, urgent_base + (BENCH_UDMA_URGENT_XFERS * BENCH_UDMA_URGENT_SIZE), 5u);
+    memset(g_scratch, 0, urgent_base + (BENCH_UDMA_URGENT_XFERS * BENCH_UDMA_URGENT_SIZE));
+
+    HAL_SIM_reset_counters();
+    udma_service_clear_stats(&g_udma_service);
+    for (idx = 0u; idx < 2u; ++idx)
+    {
+        (void)udma_service_submit(&bulk[idx], &bulk_req[idx],
+                                  LSRAM_BASE_ADDR + (idx * BENCH_UDMA_BULK_SIZE),
+                                  SCRATCH_BASE_ADDR + (idx * BENCH_UDMA_BULK_SIZE),
+                                  BENCH_UDMA_BULK_SIZE / 4u, (void *)&names[idx]);
+    }
+
+    do
+    {
+        HAL_SIM_step();
+        if ((1u == g_udma_service.chunks) && (NULL == urgent.head) && (0u == urgent.requests))
+        {
+            for (idx = 0u; idx < BENCH_UDMA_URGENT_XFERS; ++idx)
+            {
+                (void)udma_service_submit(&urgent, &urgent_req[idx],
+                                          LSRAM_BASE_ADDR + urgent_base + (idx * BENCH_UDMA_URGENT_SIZE),
+                                          SCRATCH_BASE_ADDR + urgent_base + (idx * BENCH_UDMA_URGENT_SIZE),
+                                          BENCH_UDMA_URGENT_SIZE / 4u, (void *)&names[2]);
+            }
+        }
+    } while ((g_udma_done_count < (2u + BENCH_UDMA_URGENT_XFERS)) && (guard++ < 1000u));
+
+    udma_service_get_stats(&g_udma_service, &stats);
+
+    /* The urgent copies go first, then the bulk copies, which took turns,
+     * finish one chunk apart. */
+    passed = passed &&
+             (0 == strcmp(g_udma_done_order, "HHHHAB")) &&
+             (stats.chunks == ((2u * BENCH_UDMA_BULK_SIZE) / (4u * UDMA_SERVICE_CHUNK_WORDS)) +
+                              BENCH_UDMA_URGENT_XFERS) &&
+             (0u == (bulk[0].errors + bulk[1].errors + urgent.errors)) &&
+             (0 == memcmp(g_scratch, g_lsram,
+                          urgent_base + (BENCH_UDMA_URGENT_XFERS * BENCH_UDMA_URGENT_SIZE)));
+    report("udma_service_copy",
+           urgent_base + (BENCH_UDMA_URGENT_XFERS * BENCH_UDMA_URGENT_SIZE), passed);
+    printf("# udma_service: utilization %u%%, %u chunks, at most %u queued, "
+           "wait max %u ticks normal, %u ticks high\n",
+           (unsigned)stats.utilization, (unsigned)stats.chunks, (unsigned)stats.max_queued,
+           (unsigned)((bulk[0].wait_max > bulk[1].wait_max) ? bulk[0].wait_max : bulk[1].wait_max),
+           (unsigned)urgent.wait_max);
+
+    HAL_SIM_set_irq_handler(HAL_SIM_IRQ_MIV_UDMA, udma_irq_handler);
+}
+
+/*
+ * The remote master writes g_scratch and reads g_miso in BENCH_SPI_SLAVE_XFR
+ * frame transactions. Between bursts the slave interrupt is serviced, then
+ * consume() runs as the application main loop would.
+ */
+static void spi_slave_master(void (*consume)(void))
+{
+    uint32_t offset;
+    uint32_t end;
+
+    for (offset = 0u; offset < BENCH_TRANSFER_SIZE; offset += BENCH_SPI_SLAVE_BURST)
+    {
+        end = (0u == ((offset + BENCH_SPI_SLAVE_BURST) % BENCH_SPI_SLAVE_XFR));
+        sim_spi_master_clock(&g_sim_spi_slave, &g_scratch[offset], &g_miso[offset],
+                             BENCH_SPI_SLAVE_BURST, (uint8_t)end);
+        HAL_SIM_step();
+        if (NULL != consume)
+        {
+            consume();
+        }
+    }
+}
+
+static uint32_t g_slave_rx_bytes;
+
+static void slave_block_rx_handler(uint8_t * rx_buff, uint32_t rx_size)
+{
+    if ((g_slave_rx_bytes + rx_size) <= LSRAM_SIZE)
+    {
+        memcpy(&g_lsram[g_slave_rx_bytes], rx_buff, rx_size);
+    }
+    g_slave_rx_bytes += rx_size;
+}
+
+static volatile uint32_t g_stream_events;
+
+static void slave_stream_handler(spi_instance_t * this_spi, uint32_t events)
+{
+    (void)this_spi;
+    g_stream_events |= events;
+}
+
+/* Main loop side of the stream: read and write in batches when signalled */
+static void slave_stream_consume(void)
+{
+    static uint32_t tx_offset;
+    uint32_t events = g_stream_events;
+    uint32_t nb_bytes;
+
+    g_stream_events = 0u;
+
+    if (0u != (events & (SPI_STREAM_RX_WATERMARK | SPI_STREAM_SSEND)))
+    {
+        do
+        {
+            nb_bytes = SPI_stream_read(&g_spi_slave, &g_lsram[g_slave_rx_bytes],
+                                       LSRAM_SIZE - g_slave_rx_bytes);
+            g_slave_rx_bytes += nb_bytes;
+        } while (0u != nb_bytes);
+    }
+
+    if (0u != (events & SPI_STREAM_TX_WATERMARK))
+    {
+        if (0u == g_slave_rx_bytes)
+        {
+            tx_offset = 0u;
+        }
+        tx_offset += SPI_stream_write(&g_spi_slave, &g_pattern[tx_offset % BENCH_BLOCK_SIZE],
+                                      BENCH_BLOCK_SIZE - (tx_offset % BENCH_BLOCK_SIZE));
+    }
+}
+
+/*
+ * Frame by frame variant of spi_slave_master(): the slave interrupt is
+ * asserted for every frame, and consume() runs every BENCH_SPI_STORM_LOOP
+ * frames.
+ */
+static void spi_slave_storm(void (*consume)(void))
+{
+    uint32_t offset;
+    uint8_t end;
+
+    for (offset = 0u; offset < BENCH_TRANSFER_SIZE; ++offset)
+    {
+        end = (0u == ((offset + 1u) % BENCH_SPI_SLAVE_XFR));
+        sim_spi_master_clock(&g_sim_spi_slave, &g_scratch[offset], &g_miso[offset], 1u, end);
+        HAL_SIM_step();
+        if (0u == ((offset + 1u) % BENCH_SPI_STORM_LOOP))
+        {
+            consume();
+        }
+    }
+}
+
+static uint32_t spi_slave_poll(irq_poll_t * poll, uint32_t budget)
+{
+    uint32_t frames = g_spi_slave.stream_stats.rx_frames;
+
+    (void)poll;
+    (void)budget;
+
+    SPI_isr(&g_spi_slave);
+
+    return g_spi_slave.stream_stats.rx_frames - frames;
+}
+
+static void spi_slave_set_irq(irq_poll_t * poll, uint8_t enable)
+{
+    (void)poll;
+
+    if (enable)
+    {
+        HAL_SIM_enable_irq(HAL_SIM_IRQ_CORE_SPI1);
+    }
+    else
+    {
+        HAL_SIM_disable_irq(HAL_SIM_IRQ_CORE_SPI1);
+    }
+}
+
+static void slave_stream_poll_consume(void)
+{
+    (void)irq_poll_run(&g_poll_list);
+    slave_stream_consume();
+}
+
+/*
+ * The stream of bench_spi_slave() with an interrupt for every frame, serviced
+ * by SPI_isr() from the interrupt handler, then with irq_poll.
+ */
+static void bench_spi_slave_storm(void)
+{
+    static uint8_t rx_ring[BENCH_SPI_STREAM_RING];
+    static uint8_t tx_ring[BENCH_SPI_STREAM_RING];
+    static const char * const names[2] =
+    {
+        "spi_slave_storm_irq", "spi_slave_storm_polled"
+    };
+    spi_stream_stats_t stats;
+    uint32_t mode;
+    uint32_t idx;
+    int passed;
+
+    fill_pattern(g_scratch, BENCH_TRANSFER_SIZE, 8u);
+    fill_pattern(g_pattern, BENCH_BLOCK_SIZE, 9u);
+    irq_poll_list_init(&g_poll_list, NULL, NULL);
+    irq_poll_init(&g_spi_slave_poll, &g_poll_list, spi_slave_poll, spi_slave_set_irq,
+                  NULL, BENCH_SPI_STORM_BUDGET);
+
+    for (mode = 0u; mode < 2u; ++mode)
+    {
+        HAL_SIM_set_irq_handler(HAL_SIM_IRQ_CORE_SPI1,
+                                (0u == mode) ? spi_slave_irq_handler : spi_slave_poll_irq_handler);
+        HAL_SIM_enable_irq(HAL_SIM_IRQ_CORE_SPI1);
+
+        SPI_init(&g_spi_slave, SLAVE_CORE_SPI_BASE, SIM_SPI_FIFO_DEPTH);
+        SPI_configure_slave_mode(&g_spi_slave);
+        SPI_set_slave_stream_buffers(&g_spi_slave,
+                                     rx_ring, sizeof(rx_ring), BENCH_SPI_STREAM_RING / 4u,
+                                     tx_ring, sizeof(tx_ring), BENCH_SPI_STREAM_RING / 2u,
+                                     slave_stream_handler);
+        memset(g_lsram, 0, LSRAM_SIZE);
+        g_slave_rx_bytes = 0u;
+        g_stream_events = SPI_STREAM_TX_WATERMARK;
+        slave_stream_consume();
+
+        HAL_SIM_reset_counters();
+        spi_slave_storm((0u == mode) ? slave_stream_consume : slave_stream_poll_consume);
+
+        /* Frames still in the FIFO once the master stopped */
+        for (idx = 0u; (idx < 4u) && (g_slave_rx_bytes < BENCH_TRANSFER_SIZE); ++idx)
+        {
+            HAL_SIM_step();
+            if (0u == mode)
+            {
+                slave_stream_consume();
+            }
+            else
+            {
+                slave_stream_poll_consume();
+            }
+        }
+        SPI_get_stream_stats(&g_spi_slave, &stats);
+
+        passed = (BENCH_TRANSFER_SIZE == g_slave_rx_bytes) &&
+                 (0 == memcmp(g_lsram, g_scratch, BENCH_TRANSFER_SIZE)) &&
+                 (0u == stats.rx_overflows) && (0u == stats.tx_underruns) &&
+                 (0u == stats.fifo_overflows) && (0u == stats.fifo_underruns);
+        for (idx = SIM_SPI_FIFO_DEPTH; passed && (idx < BENCH_TRANSFER_SIZE); ++idx)
+        {
+            passed = (g_miso[idx] == g_pattern[(idx - SIM_SPI_FIFO_DEPTH) % BENCH_BLOCK_SIZE]);
+        }
+        report(names[mode], BENCH_TRANSFER_SIZE, passed);
+    }
+
+    printf("# spi_slave_storm_polled: %u interrupts, %u polls, %u frames polled, "
+           "%u budgets used up\n",
+           (unsigned)g_spi_slave_poll.irqs, (unsigned)g_spi_slave_poll.polls,
+           (unsigned)g_spi_slave_poll.items, (unsigned)g_spi_slave_poll.exhausted);
+
+    HAL_SIM_set_irq_handler(HAL_SIM_IRQ_CORE_SPI1, spi_slave_irq_handler);
+    HAL_SIM_enable_irq(HAL_SIM_IRQ_CORE_SPI1);
+}
+
+/*
+ * A sensor stream received by a CoreSPI slave, first with block buffers, which
+ * the application copies out at the end of each transaction, then through the
+ * stream rings, which it reads in batches. The stream also sends a pattern
+ * back to the master.
+ */
+static void bench_spi_slave(void)
+{
+    static uint8_t block_tx[BENCH_SPI_SLAVE_XFR];
+    static uint8_t block_rx[BENCH_SPI_SLAVE_XFR];
+    static uint8_t rx_ring[BENCH_SPI_STREAM_RING];
+    static uint8_t tx_ring[BENCH_SPI_STREAM_RING];
+    spi_stream_stats_t stats;
+    uint32_t idx;
+    int passed;
+
+    fill_pattern(g_scratch, BENCH_TRANSFER_SIZE, 6u);
+    fill_pattern(g_pattern, BENCH_BLOCK_SIZE, 7u);
+    HAL_SIM_enable_irq(HAL_SIM_IRQ_CORE_SPI1);
+    HAL_enable_interrupts();
+
+    SPI_init(&g_spi_slave, SLAVE_CORE_SPI_BASE, SIM_SPI_FIFO_DEPTH);
+    SPI_configure_slave_mode(&g_spi_slave);
+    SPI_set_slave_block_buffers(&g_spi_slave, block_tx, sizeof(block_tx),
+                                block_rx, sizeof(block_rx), slave_block_rx_handler);
+    memset(g_lsram, 0, LSRAM_SIZE);
+    g_slave_rx_bytes = 0u;
+
+    HAL_SIM_reset_counters();
+    spi_slave_master(NULL);
+    report("spi_slave_block_rx", BENCH_TRANSFER_SIZE,
+           (BENCH_TRANSFER_SIZE == g_slave_rx_bytes) &&
+           (0 == memcmp(g_lsram, g_scratch, BENCH_TRANSFER_SIZE)));
+
+    SPI_init(&g_spi_slave, SLAVE_CORE_SPI_BASE, SIM_SPI_FIFO_DEPTH);
+    SPI_configure_slave_mode(&g_spi_slave);
+    SPI_set_slave_stream_buffers(&g_spi_slave,
+                                 rx_ring, sizeof(rx_ring), BENCH_SPI_STREAM_RING / 4u,
+                                 tx_ring, sizeof(tx_ring), BENCH_SPI_STREAM_RING / 2u,
+                                 slave_stream_handler);
+    memset(g_lsram, 0, LSRAM_SIZE);
+    g_slave_rx_bytes = 0u;
+    g_stream_events = SPI_STREAM_TX_WATERMARK;
+    slave_stream_consume();
+
+    HAL_SIM_reset_counters();
+    spi_slave_master(slave_stream_consume);
+    SPI_get_stream_stats(&g_spi_slave, &stats);
+
+    /* The frames preloaded in the transmit FIFO are sent first */
+    passed = (BENCH_TRANSFER_SIZE == g_slave_rx_bytes) &&
+             (0 == memcmp(g_lsram, g_scratch, BENCH_TRANSFER_SIZE)) &&
+             (0u == stats.rx_overflows) && (0u == stats.tx_underruns) &&
+             (0u == stats.fifo_overflows) && (0u == stats.fifo_underruns);
+    for (idx = SIM_SPI_FIFO_DEPTH; passed && (idx < BENCH_TRANSFER_SIZE); ++idx)
+    {
+        passed = (g_miso[idx] == g_pattern[(idx - SIM_SPI_FIFO_DEPTH) % BENCH_BLOCK_SIZE]);
+    }
+    report("spi_slave_stream", BENCH_TRANSFER_SIZE, passed);
+}
+
+static void bench_ymodem(void)
+{
+    uint8_t file_name[FILE_NAME_LENGTH + 1u];
+    uint32_t received;
+
+    fill_pattern(g_scratch, BENCH_TRANSFER_SIZE, 4u);
+    ymodem_build_stream(g_scratch, BENCH_TRANSFER_SIZE);
+
+    memset(g_lsram, 0, LSRAM_SIZE);
+    sim_uart_set_handlers(&g_sim_uart, uart_tx_handler, uart_idle_handler,
+                          &g_sim_uart);
+
+    HAL_SIM_reset_counters();
+    received = ymodem_receive(g_lsram, LSRAM_SIZE, file_name);
+    report("ymodem_receive", BENCH_TRANSFER_SIZE,
+           (BENCH_TRANSFER_SIZE == received) &&
+           (0 == memcmp(g_lsram, g_scratch, BENCH_TRANSFER_SIZE)));
+
+    link_record("ymodem_receive");
+    sim_uart_set_handlers(&g_sim_uart, uart_tx_handler, NULL, NULL);
+}
+
+static int32_t zmodem_ram_write(void * context, uint32_t offset,
+                                const uint8_t * data, uint32_t length)
+{
+    memcpy((uint8_t *)context + offset, data, length);
+
+    return 0;
+}
+
+static int32_t zmodem_flash_write(void * context, uint32_t offset,
+                                  const uint8_t * data, uint32_t length)
+{
+    uint32_t address = BENCH_FLASH_IMAGE_ADDR + offset;
+    uint32_t block;
+
+    (void)context;
+
+    /* The file is written in order from a block boundary, each block is
+     * erased when the data reaches it */
+    for (block = (address + BENCH_BLOCK_SIZE - 1u) / BENCH_BLOCK_SIZE;
+         (block * BENCH_BLOCK_SIZE) < (address + length);
+         ++block)
+    {
+        spi_flash_control_hw(SPI_FLASH_4KBLOCK_ERASE, block * BENCH_BLOCK_SIZE, NULL);
+    }
+
+    return (SPI_FLASH_SUCCESS == spi_flash_write(address, (uint8_t *)data, length)) ?
+           0 : 1;
+}
+
+static void bench_zmodem(const char * name, uint32_t window)
+{
+    uint8_t file_name[FILE_NAME_LENGTH + 1u];
+    uint32_t received;
+    int passed;
+
+    fill_pattern(g_scratch, BENCH_TRANSFER_SIZE, 4u);
+    zmodem_build_stream(g_scratch, BENCH_TRANSFER_SIZE, window);
+
+    memset(g_lsram, 0, LSRAM_SIZE);
+    sim_uart_set_handlers(&g_sim_uart, uart_tx_handler, uart_idle_handler,
+                          &g_sim_uart);
+
+    HAL_SIM_reset_counters();
+    if (ZMODEM_STREAMING == window)
+    {
+        received = zmodem_receive(zmodem_ram_write, g_lsram, LSRAM_SIZE,
+                                  file_name, window);
+        passed = (0 == memcmp(g_lsram, g_scratch, BENCH_TRANSFER_SIZE));
+    }
+    else
+    {
+        received = zmodem_receive(zmodem_flash_write, NULL, BENCH_TRANSFER_SIZE,
+                                  file_name, window);
+        passed = (0 == memcmp(&g_flash_memory[BENCH_FLASH_IMAGE_ADDR], g_scratch,
+                              BENCH_TRANSFER_SIZE));
+    }
+    report(name, BENCH_TRANSFER_SIZE,
+           (BENCH_TRANSFER_SIZE == received) && passed &&
+           (0u == zmodem_get_stats()->crc_errors));
+
+    link_record(name);
+    sim_uart_set_handlers(&g_sim_uart, uart_tx_handler, NULL, NULL);
+}
+
+/*
+ * hex_parser: files built here, pushed in chunks which split the records, and
+ * written to a sink which checks that no write crosses a page.
+ */
+#define HEX_IMAGE_BASE                  0x40000000UL
+#define HEX_IMAGE_SIZE                  0x20000u
+#define HEX_TEXT_SIZE                   4096u
+#define HEX_PUSH_CHUNK                  7u
+
+typedef struct
+{
+    uint32_t base;
+    uint32_t writes;
+    uint32_t crossings;
+} hex_sink_t;
+
+static uint8_t g_hex_image[HEX_IMAGE_SIZE];
+static uint8_t g_hex_text[HEX_TEXT_SIZE];
+static uint32_t g_hex_text_len;
+
+static int32_t hex_sink_write(void * context, uint32_t address,
+                              const uint8_t * data, uint32_t length)
+{
+    hex_sink_t * sink = (hex_sink_t *)context;
+
+    if ((address < sink->base) || ((address - sink->base) > (HEX_IMAGE_SIZE - length)))
+    {
+        return 1;
+    }
+
+    if ((address / HEX_PARSER_PAGE_SIZE) != ((address + length - 1u) / HEX_PARSER_PAGE_SIZE))
+    {
+        ++sink->crossings;
+    }
+
+    memcpy(&g_hex_image[address - sink->base], data, length);
+    ++sink->writes;
+
+    return 0;
+}
+
+static void hex_text_byte(uint8_t value)
+{
+    static const char digits[] = "0123456789ABCDEF";
+
+    g_hex_text[g_hex_text_len++] = (uint8_t)digits[value >> 4];
+    g_hex_text[g_hex_text_len++] = (uint8_t)digits[value & 0xFu];
+}
+
+/* Intel HEX record, with a wrong checksum if bad is set */
+static void intel_line(uint8_t type, uint16_t address, const uint8_t * data,
+                       uint32_t length, int bad)
+{
+    uint8_t sum = (uint8_t)(length + (address >> 8) + address + type);
+    uint32_t idx;
+
+    g_hex_text[g_hex_text_len++] = ':';
+    hex_text_byte((uint8_t)length);
+    hex_text_byte((uint8_t)(address >> 8));
+    hex_text_byte((uint8_t)address);
+    hex_text_byte(type);
+    for (idx = 0u; idx < length; ++idx)
+    {
+        hex_text_byte(data[idx]);
+        sum += data[idx];
+    }
+    hex_text_byte((uint8_t)(bad ? (0x5Au - sum) : (0u - sum)));
+    g_hex_text[g_hex_text_len++] = '\r';
+    g_hex_text[g_hex_text_len++] = '\n';
+}
+
+/* S-record of type 0 to 9, with a wrong checksum if bad is set */
+static void srec_line(uint8_t type, uint32_t address, const uint8_t * data,
+                      uint32_t length, int bad)
+{
+    static const uint8_t address_size[10] = { 2u, 2u, 3u, 4u, 0u, 2u, 3u, 4u, 3u, 2u };
+    uint32_t addr_len = address_size[type];
+    uint8_t sum = (uint8_t)(addr_len + length + 1u);
+    uint32_t idx;
+
+    g_hex_text[g_hex_text_len++] = 'S';
+    g_hex_text[g_hex_text_len++] = (uint8_t)('0' + type);
+    hex_text_byte(sum);
+    for (idx = addr_len; idx > 0u; --idx)
+    {
+        hex_text_byte((uint8_t)(address >> ((idx - 1u) * 8u)));
+        sum += (uint8_t)(address >> ((idx - 1u) * 8u));
+    }
+    for (idx = 0u; idx < length; ++idx)
+    {
+        hex_text_byte(data[idx]);
+        sum += data[idx];
+    }
+    hex_text_byte((uint8_t)(bad ? sum : ~sum));
+    g_hex_text[g_hex_text_len++] = '\n';
+}
+
+/*
+ * Test image: 64 bytes at 0x400000F0 across the first page boundary, 32 bytes
+ * at 0x40000400 after a gap, and 16 bytes at 0x40010000, in the next 64 KB
+ * of the Intel HEX addresses. The data is taken from g_pattern. Each part is
+ * one write per page: 4 writes.
+ */
+#define HEX_TEST_WRITES                 4u
+#define HEX_TEST_DATA(address)          (&g_pattern[(address) % BENCH_BLOCK_SIZE])
+
+static const struct
+{
+    uint32_t offset;
+    uint32_t length;
+} g_hex_parts[3] = { { 0x00F0u, 64u }, { 0x0400u, 32u }, { 0x10000u, 16u } };
+
+/* Build the test image as a file, the record with index bad_record with a
+ * wrong checksum, without its end of file record if eof is 0 */
+static void hex_build_file(uint8_t format, uint32_t bad_record, int eof)
+{
+    uint8_t upper[2];
+    uint32_t part;
+    uint32_t offset;
+    uint32_t address;
+    uint32_t record = 0u;
+
+    g_hex_text_len = 0u;
+    if (':' == format)
+    {
+        upper[0] = (uint8_t)(HEX_IMAGE_BASE >> 24);
+        upper[1] = (uint8_t)(HEX_IMAGE_BASE >> 16);
+        intel_line(0x04u, 0u, upper, 2u, bad_record == record++);
+    }
+    else
+    {
+        srec_line(0u, 0u, (const uint8_t *)"hex_parser", 10u, bad_record == record++);
+    }
+
+    for (part = 0u; part < 3u; ++part)
+    {
+        for (offset = 0u; offset < g_hex_parts[part].length; offset += 16u)
+        {
+            address = HEX_IMAGE_BASE + g_hex_parts[part].offset + offset;
+            if (':' == format)
+            {
+                if ((0u == offset) && (0u == (address & 0xFFFFu)))
+                {
+                    /* Extended linear address of the next 64 KB */
+                    upper[0] = (uint8_t)(address >> 24);
+                    upper[1] = (uint8_t)(address >> 16);
+                    intel_line(0x04u, 0u, upper, 2u, bad_record == record++);
+                }
+                intel_line(0x00u, (uint16_t)address, HEX_TEST_DATA(address), 16u,
+                           bad_record == record++);
+            }
+            else
+            {
+                srec_line(3u, address, HEX_TEST_DATA(address), 16u,
+                          bad_record == record++);
+            }
+        }
+    }
+
+    if (eof)
+    {
+        if (':' == format)
+        {
+            intel_line(0x01u, 0u, NULL, 0u, bad_record == record++);
+        }
+        else
+        {
+            srec_line(7u, HEX_IMAGE_BASE, NULL, 0u, bad_record == record++);
+        }
+    }
+}
+
+static hex_parser_status_t hex_push_file(hex_parser_t * parser)
+{
+    hex_parser_status_t status = HEX_PARSER_SUCCESS;
+    uint32_t idx;
+    uint32_t count;
+
+    for (idx = 0u; idx < g_hex_text_len; idx += count)
+    {
+        count = g_hex_text_len - idx;
+        if (count > HEX_PUSH_CHUNK)
+        {
+            count = HEX_PUSH_CHUNK;
+        }
+        status = hex_parser_push(parser, &g_hex_text[idx], count);
+    }
+
+    return status;
+}
+
+/* Check the image written, and that nothing was written in the gaps */
+static int hex_image_ok(void)
+{
+    static uint8_t expected[HEX_IMAGE_SIZE];
+    uint32_t part;
+    uint32_t offset;
+
+    memset(expected, 0xFF, HEX_IMAGE_SIZE);
+    for (part = 0u; part < 3u; ++part)
+    {
+        for (offset = g_hex_parts[part].offset;
+             offset < (g_hex_parts[part].offset + g_hex_parts[part].length);
+             offset += 16u)
+        {
+            memcpy(&expected[offset], HEX_TEST_DATA(HEX_IMAGE_BASE + offset), 16u);
+        }
+    }
+
+    return (0 == memcmp(g_hex_image, expected, HEX_IMAGE_SIZE));
+}
+
+static void bench_hex_parser(void)
+{
+    static hex_parser_t parser;
+    static const uint8_t formats[2] = { ':', 'S' };
+    static const char * const names[2][4] =
+    {
+        { "hex_parser_intel", "hex_parser_intel_checksum",
+          "hex_parser_intel_no_eof", "hex_parser_intel_truncated" },
+        { "hex_parser_srec", "hex_parser_srec_checksum",
+          "hex_parser_srec_no_eof", "hex_parser_srec_truncated" }
+    };
+    hex_sink_t sink;
+    hex_parser_status_t status;
+    uint32_t format;
+    uint8_t segment[2];
+    int passed;
+
+    fill_pattern(g_pattern, BENCH_BLOCK_SIZE, 8u);
+
+    for (format = 0u; format < 2u; ++format)
+    {
+        sink.base = HEX_IMAGE_BASE;
+
+        /* Whole file, the data is written one page at a time */
+        memset(g_hex_image, 0xFF, HEX_IMAGE_SIZE);
+        sink.writes = 0u;
+        sink.crossings = 0u;
+        hex_build_file(formats[format], 0xFFFFFFFFu, 1);
+        HAL_SIM_reset_counters();
+        hex_parser_init(&parser, hex_sink_write, &sink);
+        status = hex_push_file(&parser);
+        report(names[format][0], parser.bytes,
+               (HEX_PARSER_DONE == status) && hex_image_ok() &&
+               (HEX_TEST_WRITES == sink.writes) && (HEX_TEST_WRITES == parser.writes) &&
+               (0u == sink.crossings) && ((':' == formats[format]) || parser.has_entry) &&
+               ((':' == formats[format]) || (HEX_IMAGE_BASE == parser.entry)));
+
+        /* Bad checksum on the second data record: only the page completed by
+         * the first one is written */
+        sink.writes = 0u;
+        hex_build_file(formats[format], 2u, 1);
+        HAL_SIM_reset_counters();
+        hex_parser_init(&parser, hex_sink_write, &sink);
+        status = hex_push_file(&parser);
+        report(names[format][1], parser.bytes,
+               (HEX_PARSER_CHECKSUM_ERROR == status) && (2u == parser.records) &&
+               (1u == sink.writes));
+
+        /* No end of file record, the last page is written by hex_parser_finish() */
+        memset(g_hex_image, 0xFF, HEX_IMAGE_SIZE);
+        sink.writes = 0u;
+        hex_build_file(formats[format], 0xFFFFFFFFu, 0);
+        HAL_SIM_reset_counters();
+        hex_parser_init(&parser, hex_sink_write, &sink);
+        passed = (HEX_PARSER_SUCCESS == hex_push_file(&parser)) &&
+                 ((HEX_TEST_WRITES - 1u) == sink.writes);
+        status = hex_parser_finish(&parser);
+        report(names[format][2], parser.bytes,
+               passed && (HEX_PARSER_DONE == status) && hex_image_ok() &&
+               (HEX_TEST_WRITES == sink.writes));
+
+        /* File cut in the middle of its last record */
+        g_hex_text_len -= 5u;
+        HAL_SIM_reset_counters();
+        hex_parser_init(&parser, hex_sink_write, &sink);
+        passed = (HEX_PARSER_SUCCESS == hex_push_file(&parser));
+        report(names[format][3], parser.bytes,
+               passed && (HEX_PARSER_SYNTAX_ERROR == hex_parser_finish(&parser)));
+    }
+
+    /* Intel HEX extended segment address: segment 0x1000 is address 0x10000 */
+    memset(g_hex_image, 0xFF, HEX_IMAGE_SIZE);
+    sink.base = 0u;
+    sink.writes = 0u;
+    g_hex_text_len = 0u;
+    segment[0] = 0x10u;
+    segment[1] = 0x00u;
+    intel_line(0x02u, 0u, segment, 2u, 0);
+    intel_line(0x00u, 0x0010u, g_pattern, 16u, 0);
+    intel_line(0x01u, 0u, NULL, 0u, 0);
+    HAL_SIM_reset_counters();
+    hex_parser_init(&parser, hex_sink_write, &sink);
+    status = hex_push_file(&parser);
+    report("hex_parser_intel_segment", parser.bytes,
+           (HEX_PARSER_DONE == status) && (1u == sink.writes) &&
+           (0 == memcmp(&g_hex_image[0x10010u], g_pattern, 16u)));
+}
+
+/*
+ * elf_loader: ELF32 files built here, pushed in chunks which split the program
+ * headers and the segments. The regions are those of the bootloader: images
+ * linked for the TCM are staged at the start of the LSRAM, where images linked
+ * for the LSRAM are placed.
+ */
+#define ELF_TCM_ADDR                    0x40000000UL
+#define ELF_STAGING_SIZE                0x8000u
+#define ELF_FILE_SIZE                   2048u
+#define ELF_PUSH_CHUNK                  100u
+#define ELF_ENTRY                       (ELF_TCM_ADDR + 0x40u)
+
+#define ELF_TEXT_OFFSET                 0x100u
+#define ELF_TEXT_SIZE                   600u
+#define ELF_DATA_OFFSET                 (ELF_TEXT_OFFSET + ELF_TEXT_SIZE)
+#define ELF_DATA_ADDR                   (ELF_TCM_ADDR + 0x1000u)
+#define ELF_DATA_FILESZ                 100u
+#define ELF_DATA_MEMSZ                  300u
+#define ELF_TRAILER_SIZE                200u
+
+static uint8_t g_elf_file[ELF_FILE_SIZE];
+static uint32_t g_elf_len;
+static uint8_t g_elf_staging[ELF_STAGING_SIZE];
+
+static void elf_put_u16(uint8_t * p, uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static void elf_put_u32(uint8_t * p, uint32_t value)
+{
+    elf_put_u16(p, value);
+    elf_put_u16(&p[2], value >> 16);
+}
+
+static void elf_put_phdr(uint8_t * phdr, uint32_t type, uint32_t offset,
+                         uint32_t paddr, uint32_t filesz, uint32_t memsz)
+{
+    elf_put_u32(&phdr[0], type);
+    elf_put_u32(&phdr[4], offset);
+    elf_put_u32(&phdr[8], paddr);
+    elf_put_u32(&phdr[12], paddr);
+    elf_put_u32(&phdr[16], filesz);
+    elf_put_u32(&phdr[20], memsz);
+    elf_put_u32(&phdr[24], 5u);
+    elf_put_u32(&phdr[28], 4u);
+}
+
+/* A .text segment, a PT_NOTE which is not loaded, a .data segment at data_paddr
+ * followed by its .bss, then sections the loader ignores. phnum other than 3
+ * only changes the header field. */
+static void elf_build_file(uint32_t data_paddr, uint32_t phnum)
+{
+    memset(g_elf_file, 0, ELF_FILE_SIZE);
+    g_elf_file[0] = 0x7Fu;
+    g_elf_file[1] = 'E';
+    g_elf_file[2] = 'L';
+    g_elf_file[3] = 'F';
+    g_elf_file[4] = 1u;                              /* ELFCLASS32 */
+    g_elf_file[5] = 1u;                              /* ELFDATA2LSB */
+    g_elf_file[6] = 1u;                              /* EV_CURRENT */
+    elf_put_u16(&g_elf_file[16], 2u);                /* ET_EXEC */
+    elf_put_u16(&g_elf_file[18], 243u);              /* EM_RISCV */
+    elf_put_u32(&g_elf_file[20], 1u);
+    elf_put_u32(&g_elf_file[24], ELF_ENTRY);
+    elf_put_u32(&g_elf_file[28], 52u);               /* e_phoff */
+    elf_put_u16(&g_elf_file[40], 52u);               /* e_ehsize */
+    elf_put_u16(&g_elf_file[42], 32u);               /* e_phentsize */
+    elf_put_u16(&g_elf_file[44], phnum);
+
+    elf_put_phdr(&g_elf_file[52], 1u, ELF_TEXT_OFFSET, ELF_TCM_ADDR,
+                 ELF_TEXT_SIZE, ELF_TEXT_SIZE);
+    elf_put_phdr(&g_elf_file[84], 4u, 0x94u, 0u, 0x20u, 0x20u);
+    elf_put_phdr(&g_elf_file[116], 1u, ELF_DATA_OFFSET, data_paddr,
+                 ELF_DATA_FILESZ, ELF_DATA_MEMSZ);
+
+    memcpy(&g_elf_file[ELF_TEXT_OFFSET], g_pattern, ELF_TEXT_SIZE + ELF_DATA_FILESZ);
+    memset(&g_elf_file[ELF_DATA_OFFSET + ELF_DATA_FILESZ], 0x5A, ELF_TRAILER_SIZE);
+    g_elf_len = ELF_DATA_OFFSET + ELF_DATA_FILESZ + ELF_TRAILER_SIZE;
+}
+
+static elf_loader_status_t elf_push_file(elf_loader_t * loader,
+                                         elf_loader_region_t * regions)
+{
+    elf_loader_status_t status = ELF_LOADER_SUCCESS;
+    uint32_t idx;
+    uint32_t count;
+
+    memset(g_elf_staging, 0xA5, ELF_STAGING_SIZE);
+    HAL_SIM_reset_counters();
+    elf_loader_init(loader, regions, 2u);
+    for (idx = 0u; idx < g_elf_len; idx += count)
+    {
+        count = g_elf_len - idx;
+        if (count > ELF_PUSH_CHUNK)
+        {
+            count = ELF_PUSH_CHUNK;
+        }
+        status = elf_loader_push(loader, &g_elf_file[idx], count);
+    }
+
+    return status;
+}
+
+/* Check the segments, the .bss, and that nothing else was written */
+static int elf_image_ok(const elf_loader_t * loader, const elf_loader_region_t * regions)
+{
+    static uint8_t expected[ELF_STAGING_SIZE];
+
+    memset(expected, 0xA5, ELF_STAGING_SIZE);
+    memcpy(expected, g_pattern, ELF_TEXT_SIZE);
+    memcpy(&expected[ELF_DATA_ADDR - ELF_TCM_ADDR], &g_pattern[ELF_TEXT_SIZE],
+           ELF_DATA_FILESZ);
+    memset(&expected[(ELF_DATA_ADDR - ELF_TCM_ADDR) + ELF_DATA_FILESZ], 0,
+           ELF_DATA_MEMSZ - ELF_DATA_FILESZ);
+
+    return (ELF_ENTRY == loader->entry) && (2u == loader->segment_count) &&
+           ((ELF_TEXT_SIZE + ELF_DATA_FILESZ) == loader->loaded) &&
+           ((ELF_DATA_MEMSZ - ELF_DATA_FILESZ) == loader->zeroed) &&
+           (((ELF_DATA_ADDR - ELF_TCM_ADDR) + ELF_DATA_FILESZ) == regions[0].end) &&
+           (0u == regions[1].end) &&
+           (0 == memcmp(g_elf_staging, expected, ELF_STAGING_SIZE));
+}
+
+static void bench_elf_loader(void)
+{
+    static elf_loader_t loader;
+    elf_loader_region_t regions[2] =
+    {
+        { ELF_TCM_ADDR, ELF_STAGING_SIZE, g_elf_staging, 0u },
+        { LSRAM_BASE_ADDR, ELF_STAGING_SIZE, g_elf_staging, 0u }
+    };
+    elf_loader_status_t status;
+
+    fill_pattern(g_pattern, BENCH_BLOCK_SIZE, 9u);
+
+    /* Two PT_LOAD segments and a PT_NOTE, the .bss is zero filled */
+    elf_build_file(ELF_DATA_ADDR, 3u);
+    status = elf_push_file(&loader, regions);
+    report("elf_loader_segments", loader.position,
+           (ELF_LOADER_SUCCESS == status) &&
+           (ELF_LOADER_SUCCESS == elf_loader_finish(&loader)) &&
+           elf_image_ok(&loader, regions));
+
+    /* File cut in the middle of the .data segment */
+    g_elf_len = ELF_DATA_OFFSET + (ELF_DATA_FILESZ / 2u);
+    status = elf_push_file(&loader, regions);
+    report("elf_loader_truncated", loader.position,
+           (ELF_LOADER_SUCCESS == status) &&
+           (ELF_LOADER_TRUNCATED == elf_loader_finish(&loader)));
+
+    /* .data linked for the LSRAM, staged over the .text linked for the TCM */
+    elf_build_file(LSRAM_BASE_ADDR + 0x100u, 3u);
+    status = elf_push_file(&loader, regions);
+    report("elf_loader_overlap", loader.position,
+           (ELF_LOADER_BAD_ADDRESS == status) &&
+           (ELF_LOADER_BAD_ADDRESS == elf_loader_finish(&loader)) &&
+           (0xA5u == g_elf_staging[0]));
+
+    /* .data outside the TCM and the LSRAM */
+    elf_build_file(0x60000000UL, 3u);
+    status = elf_push_file(&loader, regions);
+    report("elf_loader_bad_address", loader.position,
+           (ELF_LOADER_BAD_ADDRESS == status) && (0xA5u == g_elf_staging[0]));
+
+    /* More program headers than ELF_LOADER_HEADER_SIZE holds */
+    elf_build_file(ELF_DATA_ADDR, (ELF_LOADER_HEADER_SIZE / 32u) + 1u);
+    status = elf_push_file(&loader, regions);
+    report("elf_loader_too_many_headers", loader.position,
+           (ELF_LOADER_UNSUPPORTED == status) && (0u == loader.segment_count));
+}
+
+/*
+ * fw_slots: images written to the A/B slots of the simulated flash, booted
+ * with the staging RAM and the warm boot record in the LSRAM. The harness
+ * provides the copy routine, which records the start and returns to
+ * fw_boot() instead of running the image.
+ */
+#define FW_TEST_IMAGE_SIZE              5000u
+#define FW_TEST_CHUNK                   300u
+
+static jmp_buf g_fw_start;
+static uint32_t g_fw_started_size;
+
+void fw_slots_trampoline(uint32_t dest, uint32_t src, uint32_t size, uint32_t entry)
+{
+    (void)dest;
+    (void)src;
+    (void)entry;
+
+    g_fw_started_size = size;
+    longjmp(g_fw_start, 1);
+}
+
+/* Run fw_slots_boot(), return the slot of the hand-off block if an image was
+ * started, 0 otherwise */
+static uint32_t fw_boot(void)
+{
+    const boot_handoff_t * handoff;
+
+    boot_handoff_begin();
+    g_fw_started_size = 0u;
+    if (0 == setjmp(g_fw_start))
+    {
+        (void)fw_slots_boot();
+        return 0u;
+    }
+
+    handoff = boot_handoff_get();
+
+    return (NULL != handoff) ? handoff->image_source : 0u;
+}
+
+/* Write image number seed to the inactive slot, in chunks which do not fall
+ * on the page boundaries. corrupt writes a byte of the slot between the last
+ * write and the commit. */
+static fw_slots_status_t fw_write_image(uint32_t seed, int corrupt)
+{
+    static fw_slots_writer_t writer;
+    fw_slots_status_t status;
+    uint32_t offset;
+    uint32_t count;
+
+    fill_pattern(g_scratch, FW_TEST_IMAGE_SIZE, seed);
+    status = fw_slots_write_begin(&writer, FW_TEST_IMAGE_SIZE);
+    for (offset = 0u; (FW_SLOTS_SUCCESS == status) && (offset < FW_TEST_IMAGE_SIZE);
+         offset += count)
+    {
+        count = FW_TEST_IMAGE_SIZE - offset;
+        if (count > FW_TEST_CHUNK)
+        {
+            count = FW_TEST_CHUNK;
+        }
+        status = fw_slots_write(&writer, &g_scratch[offset], count);
+    }
+
+    if (corrupt)
+    {
+        g_flash_memory[((FW_SLOT_A == writer.slot) ? FW_SLOT_A_ADDR : FW_SLOT_B_ADDR) + 10u] ^= 0x01u;
+    }
+
+    return (FW_SLOTS_SUCCESS == status) ? fw_slots_write_commit(&writer) : status;
+}
+
+static int fw_staged(uint32_t seed)
+{
+    fill_pattern(g_scratch, FW_TEST_IMAGE_SIZE, seed);
+
+    return (FW_TEST_IMAGE_SIZE == g_fw_started_size) &&
+           (0 == memcmp(g_lsram, g_scratch, FW_TEST_IMAGE_SIZE));
+}
+
+static void bench_fw_slots(void)
+{
+    fw_slot_desc_t desc;
+    const boot_handoff_t * handoff;
+    boot_handoff_t * block;
+    int passed;
+
+    spi_flash_init(FLASH_CORE_SPI_BASE);
+    memset(&g_flash_memory[FW_SLOT_A_DESC_ADDR % SIM_FLASH_SIZE], 0xFF,
+           2u * FW_SLOTS_ERASE_BLOCK_SIZE);
+    memset(g_lsram, 0, LSRAM_SIZE);
+
+    /* Commit: the first image goes to slot A, the next one to slot B */
+    HAL_SIM_reset_counters();
+    passed = (FW_SLOT_NONE == fw_slots_active(NULL)) &&
+             (FW_SLOTS_SUCCESS == fw_write_image(1u, 0)) &&
+             (FW_SLOT_A == fw_slots_active(&desc)) && (1u == desc.sequence) &&
+             (FW_SLOTS_SUCCESS == fw_write_image(2u, 0)) &&
+             (FW_SLOT_B == fw_slots_active(&desc)) && (2u == desc.sequence) &&
+             (FW_SLOTS_SUCCESS == fw_slots_verify(FW_SLOT_A)) &&
+             (FW_SLOTS_SUCCESS == fw_slots_verify(FW_SLOT_B));
+    report("fw_slots_commit", 2u * FW_TEST_IMAGE_SIZE, passed);
+
+    /* CRC rejection: an image which does not read back as written is not
+     * committed, slot B stays the active one, and its descriptor is gone */
+    HAL_SIM_reset_counters();
+    passed = (FW_SLOTS_CRC_ERROR == fw_write_image(3u, 1)) &&
+             (FW_SLOT_B == fw_slots_active(NULL)) &&
+             (0u == fw_slots_read_desc(FW_SLOT_A, &desc));
+    report("fw_slots_crc_rejection", FW_TEST_IMAGE_SIZE, passed);
+
+    /* Rollback: rewrite slot A, then corrupt its image. The boot stages it,
+     * rejects it and starts slot B instead */
+    fw_slots_warm_invalidate();
+    passed = (FW_SLOTS_SUCCESS == fw_write_image(4u, 0)) &&
+             (FW_SLOT_A == fw_slots_active(NULL));
+    g_flash_memory[FW_SLOT_A_ADDR + 100u] ^= 0x80u;
+    HAL_SIM_reset_counters();
+    passed = passed && (FW_SLOTS_CRC_ERROR == fw_slots_verify(FW_SLOT_A)) &&
+             (BOOT_HANDOFF_SOURCE_SLOT_B == fw_boot()) && fw_staged(2u) &&
+             (0u == boot_handoff_get()->image_warm);
+    report("fw_slots_rollback", FW_TEST_IMAGE_SIZE, passed);
+
+    /* Warm record: the next boot starts the staged copy again without reading
+     * the flash, unless the copy, the record or the active slot changed */
+    g_flash_memory[FW_SLOT_A_ADDR + 100u] ^= 0x80u;
+    fw_slots_warm_invalidate();
+    passed = (BOOT_HANDOFF_SOURCE_SLOT_A == fw_boot()) &&
+             (0u == boot_handoff_get()->image_warm);
+    HAL_SIM_reset_counters();
+    passed = passed && (BOOT_HANDOFF_SOURCE_SLOT_A == fw_boot()) && fw_staged(4u) &&
+             (1u == boot_handoff_get()->image_warm) &&
+             ((HAL_SIM_get_counters().reads + HAL_SIM_get_counters().writes) <
+              FW_TEST_IMAGE_SIZE);
+    g_lsram[200] ^= 0x01u;
+    passed = passed && (BOOT_HANDOFF_SOURCE_SLOT_A == fw_boot()) && fw_staged(4u) &&
+             (0u == boot_handoff_get()->image_warm);
+    ((uint8_t *)HAL_SIM_translate(FW_SLOTS_WARM_ADDR, sizeof(fw_slots_warm_t)))[8] ^= 0x01u;
+    passed = passed && (BOOT_HANDOFF_SOURCE_SLOT_A == fw_boot()) &&
+             (0u == boot_handoff_get()->image_warm);
+    passed = passed && (FW_SLOTS_SUCCESS == fw_write_image(5u, 0)) &&
+             (BOOT_HANDOFF_SOURCE_SLOT_B == fw_boot()) && fw_staged(5u) &&
+             (0u == boot_handoff_get()->image_warm);
+    fw_slots_warm_invalidate();
+    passed = passed && (BOOT_HANDOFF_SOURCE_SLOT_B == fw_boot()) &&
+             (0u == boot_handoff_get()->image_warm);
+    report("fw_slots_warm_record", FW_TEST_IMAGE_SIZE, passed);
+
+    /* Hand-off block: sealed before the start, the reset request is carried
+     * to the next boot, and a changed byte invalidates it */
+    HAL_SIM_reset_counters();
+    handoff = boot_handoff_get();
+    passed = (NULL != handoff) && (FW_TEST_IMAGE_SIZE == handoff->image_size) &&
+             (handoff->phase_cycles[BOOT_HANDOFF_PHASE_LOAD] <=
+              handoff->phase_cycles[BOOT_HANDOFF_PHASE_START]);
+    boot_handoff_request_reset(BOOT_HANDOFF_RESET_SOFT);
+    passed = passed && (BOOT_HANDOFF_SOURCE_SLOT_B == fw_boot());
+    handoff = boot_handoff_get();
+    passed = passed && (NULL != handoff) &&
+             (BOOT_HANDOFF_RESET_SOFT == handoff->reset_cause) &&
+             (2u <= handoff->boot_count);
+    block = (boot_handoff_t *)HAL_SIM_translate(BOOT_HANDOFF_ADDR, sizeof(boot_handoff_t));
+    block->image_size ^= 0x01u;
+    passed = passed && (NULL == boot_handoff_get());
+    report("boot_handoff_seal", (uint32_t)sizeof(boot_handoff_t), passed);
+
+    HAL_enable_interrupts();
+}
+
+/*
+ * Time each transfer would take on a link with BENCH_LINK_LATENCY_MS per
+ * turnaround, at two baud rates. The replies are counted as if the link was
+ * half duplex.
+ */
+static void report_links(void)
+{
+    static const uint32_t baud[2] = { 115200u, 921600u };
+    const link_result_t * result;
+    double ms[2];
+    uint32_t idx;
+    uint32_t rate;
+
+    printf("\nprotocol,bytes,sent,replies,turnarounds,ms_at_115200,ms_at_921600,"
+           "kbit_per_s_at_115200\n");
+
+    for (idx = 0u; idx < g_link_result_count; ++idx)
+    {
+        result = &g_link_results[idx];
+        for (rate = 0u; rate < 2u; ++rate)
+        {
+            ms[rate] = ((double)(result->sent + result->replies) * 10000.0 /
+                        (double)baud[rate]) +
+                       ((double)result->turnarounds * BENCH_LINK_LATENCY_MS);
+        }
+
+        printf("%s,%u,%u,%u,%u,%.1f,%.1f,%.1f\n",
+               result->name,
+               (unsigned)BENCH_TRANSFER_SIZE,
+               (unsigned)result->sent,
+               (unsigned)result->replies,
+               (unsigned)result->turnarounds,
+               ms[0],
+               ms[1],
+               (double)BENCH_TRANSFER_SIZE * 8.0 / ms[0]);
+    }
+}
+
+int main(void)
+{
+    sim_uart_init(&g_sim_uart, COREUARTAPB0_BASE_ADDR);
+    sim_uart_set_handlers(&g_sim_uart, uart_tx_handler, NULL, NULL);
+
+    sim_spi_init(&g_sim_spi, FLASH_CORE_SPI_BASE, HAL_SIM_IRQ_CORE_SPI0);
+    sim_spi_flash_init(&g_sim_flash, g_flash_memory, SIM_FLASH_SIZE);
+    sim_spi_attach(&g_sim_spi, 0u, &g_sim_flash.slave);
+    sim_spi_attach(&g_sim_spi, 1u, &g_sim_flash.slave);
+
+    sim_i2c_init(&g_sim_i2c, MIV_I2C_BASE_ADDR, HAL_SIM_IRQ_MIV_I2C);
+    sim_i2c_eeprom_init(&g_sim_eeprom, SIM_EEPROM_ADDR, g_eeprom_memory,
+                        SIM_EEPROM_SIZE);
+    sim_i2c_attach(&g_sim_i2c, &g_sim_eeprom.target);
+    HAL_SIM_set_irq_handler(HAL_SIM_IRQ_MIV_I2C, i2c_irq_handler);
+
+    sim_udma_init(&g_sim_udma, MIV_ESS_uDMA_BASE_ADDR, HAL_SIM_IRQ_MIV_UDMA);
+    HAL_SIM_set_irq_handler(HAL_SIM_IRQ_MIV_UDMA, udma_irq_handler);
+
+    sim_spi_init(&g_sim_spi_slave, SLAVE_CORE_SPI_BASE, HAL_SIM_IRQ_CORE_SPI1);
+    HAL_SIM_set_irq_handler(HAL_SIM_IRQ_CORE_SPI1, spi_slave_irq_handler);
+
+    HAL_SIM_map_memory(LSRAM_BASE_ADDR, g_lsram, LSRAM_SIZE);
+    HAL_SIM_map_memory(SCRATCH_BASE_ADDR, g_scratch, SCRATCH_SIZE);
+
+    UART_init(&g_uart, COREUARTAPB0_BASE_ADDR, BAUD_VALUE_115200,
+              (DATA_8_BITS | NO_PARITY));
+
+    printf("operation,bytes,reads,writes,accesses,accesses_per_byte,irqs,steps,result\n");
+
+    bench_uart();
+    bench_spi_bus();
+    bench_spi_flash();
+    bench_spi_flash_wide();
+    bench_i2c_eeprom();
+    bench_i2c_sched();
+    bench_udma();
+    bench_udma_service();
+    bench_spi_slave();
+    bench_spi_slave_storm();
+    bench_ymodem();
+    bench_zmodem("zmodem_receive", ZMODEM_STREAMING);
+    bench_zmodem("zmodem_receive_flash", ZMODEM_BLOCK_SIZE);
+    bench_spi_flash_erase_counts();
+    bench_hex_parser();
+    bench_elf_loader();
+    bench_fw_slots();
+
+    report_links();
+
+    return (0u == g_failures) ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file hal_sim_models.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Register models of the fabric IP used by the bootloader.
+ *
+ * The models implement the register behaviour the drivers in
+ * platform/drivers rely on, not the cycle timing of the IP. Time only advances
+ * when HAL_SIM_step() is called or, for the SPI flash and I2C EEPROM, when the
+ * driver polls the device for the end of a program or erase cycle.
+ */
+#ifndef HAL_SIM_MODELS_H_
+#define HAL_SIM_MODELS_H_
+
+#include "hal_sim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*==============================================================================
+ * CoreUARTapb
+ */
+#define SIM_UART_RX_QUEUE_SIZE          4096u
+
+typedef void (*sim_uart_tx_handler_t)(void * ctx, uint8_t tx_byte);
+
+/* Called when the driver reads STATUS while the receive queue is empty. */
+typedef void (*sim_uart_idle_handler_t)(void * ctx);
+
+typedef struct
+{
+    hal_sim_model_t             model;
+    uint8_t                     ctrl1;
+    uint8_t                     ctrl2;
+    uint8_t                     rx_queue[SIM_UART_RX_QUEUE_SIZE];
+    uint32_t                    rx_head;
+    uint32_t                    rx_count;
+    sim_uart_tx_handler_t       tx_handler;
+    sim_uart_idle_handler_t     idle_handler;
+    void *                      ctx;
+    uint32_t                    tx_count;
+    uint32_t                    rx_overflows;
+} sim_uart_t;
+
+void sim_uart_init(sim_uart_t * uart, addr_t base_addr);
+
+void sim_uart_set_handlers(sim_uart_t * uart,
+                           sim_uart_tx_handler_t tx_handler,
+                           sim_uart_idle_handler_t idle_handler,
+                           void * ctx);
+
+/* Queue bytes for reception. Returns the number of bytes accepted. */
+uint32_t sim_uart_push_rx(sim_uart_t * uart,
+                          const uint8_t * data,
+                          uint32_t size);
+
+/*==============================================================================
+ * SPI slave interface, implemented by the SPI flash model.
+ */
+typedef struct
+{
+    void *  ctx;
+    void    (*select)(void * ctx);
+    uint8_t (*transfer)(void * ctx, uint8_t mosi);
+    void    (*deselect)(void * ctx);
+} sim_spi_slave_t;
+
+/*==============================================================================
+ * CoreSPI.
+ * In master mode, frames written while the core is disabled are held in the
+ * transmit FIFO and shifted out when it is enabled. Frames written while it is
+ * enabled are shifted immediately. The slave is selected on the first frame of
+ * a transfer and deselected after the frame written through TXLAST. Up to
+ * SIM_SPI_NB_SLAVES slaves are attached, one per SSEL bit. Master frames
+ * are 8, 16 or 32 bits wide, see sim_spi_set_frame_width(), and are shifted to
+ * the slave most significant byte first.
+ *
+ * In slave mode the harness plays the remote master with sim_spi_master_clock(),
+ * which shifts count frames at once, as if the interrupt latency of the hart
+ * was count frames long. The interrupt line follows the interrupts enabled in
+ * CTRL1 and CTRL2.
+ */
+#define SIM_SPI_FIFO_DEPTH              32u
+#define SIM_SPI_NB_SLAVES               8u
+
+typedef struct
+{
+    hal_sim_model_t         model;
+    uint8_t                 ctrl1;
+    uint8_t                 ctrl2;
+    uint8_t                 ssel;
+    uint8_t                 status;
+    uint8_t                 intraw;
+    uint8_t                 frame_bytes;
+    uint32_t                tx_fifo[SIM_SPI_FIFO_DEPTH];
+    uint8_t                 tx_last[SIM_SPI_FIFO_DEPTH];
+    uint32_t                tx_count;
+    uint32_t                rx_fifo[SIM_SPI_FIFO_DEPTH];
+    uint32_t                rx_head;
+    uint32_t                rx_count;
+    uint8_t                 selected;
+    const sim_spi_slave_t * slave;      /* Selected slave */
+    const sim_spi_slave_t * slaves[SIM_SPI_NB_SLAVES];
+    uint32_t                frames;
+    uint8_t                 irq_line;
+} sim_spi_t;
+
+void sim_spi_init(sim_spi_t * spi, addr_t base_addr, uint8_t irq_line);
+void sim_spi_attach(sim_spi_t * spi, uint8_t ssel, const sim_spi_slave_t * slave);
+void sim_spi_set_frame_width(sim_spi_t * spi, uint8_t frame_width);
+
+/* Slave mode: the remote master shifts count frames, mosi and miso may be NULL.
+ * The slave select is de-asserted after the last one if end is set. Returns the
+ * number of frames shifted, 0 unless the core is an enabled slave. */
+uint32_t sim_spi_master_clock(sim_spi_t * spi,
+                              const uint8_t * mosi,
+                              uint8_t * miso,
+                              uint32_t count,
+                              uint8_t end);
+
+/*==============================================================================
+ * SPI NOR flash using the command set driven by spi_flash.c.
+ * Program and erase cycles last for a configurable number of status register
+ * reads, which makes the cost of the driver's busy polling visible.
+ */
+#define SIM_SPI_FLASH_PAGE_SIZE         256u
+
+typedef struct
+{
+    uint8_t *       memory;
+    uint32_t        size;
+    uint8_t         id[3];
+
+    uint32_t        program_polls;      /* Busy polls per page program  */
+    uint32_t        erase_polls;        /* Busy polls per block erase   */
+
+    sim_spi_slave_t slave;
+
+    /* Transaction state */
+    uint8_t         opcode;
+    uint32_t        byte_idx;
+    uint32_t        address;
+    uint8_t         write_enabled;
+    uint32_t        busy;
+
+    /* Statistics */
+    uint32_t        commands;
+    uint32_t        pages_programmed;
+    uint32_t        blocks_erased;
+    uint32_t        status_polls;
+    uint32_t        errors;
+} sim_spi_flash_t;
+
+void sim_spi_flash_init(sim_spi_flash_t * flash,
+                        uint8_t * memory,
+                        uint32_t size);
+
+/*==============================================================================
+ * I2C target interface, implemented by the I2C EEPROM model.
+ * start() and write() return 0 for ACK and 1 for NACK. read() is passed 0 when
+ * the master acknowledges the byte and 1 when it does not.
+ */
+typedef struct sim_i2c_target sim_i2c_target_t;
+
+struct sim_i2c_target
+{
+    uint8_t             addr;
+    void *              ctx;
+    uint8_t             (*start)(void * ctx, uint8_t read);
+    uint8_t             (*write)(void * ctx, uint8_t data);
+    uint8_t             (*read)(void * ctx, uint8_t nack);
+    void                (*stop)(void * ctx);
+    sim_i2c_target_t *  next;
+};
+
+/*==============================================================================
+ * MIV_I2C
+ * Commands written to the COMMAND register are latched and executed on the
+ * next HAL_SIM_step(), after which STATUS.IF is set and, if enabled, the
+ * interrupt line is asserted until IACK is written.
+ */
+typedef struct
+{
+    hal_sim_model_t     model;
+    uint16_t            prescale;
+    uint8_t             control;
+    uint8_t             transmit;
+    uint8_t             receive;
+    uint8_t             command;
+    uint8_t             status;
+    uint8_t             irq_line;
+    sim_i2c_target_t *  targets;
+    sim_i2c_target_t *  active;
+    uint32_t            bytes;
+    uint32_t            nacks;
+} sim_i2c_t;
+
+void sim_i2c_init(sim_i2c_t * i2c, addr_t base_addr, uint8_t irq_line);
+void sim_i2c_attach(sim_i2c_t * i2c, sim_i2c_target_t * target);
+
+/*==============================================================================
+ * I2C EEPROM with a two byte memory address and a page write buffer.
+ * The device does not acknowledge its address for write_cycle_polls start
+ * conditions after a page write, as a real EEPROM does during its internal
+ * write cycle.
+ */
+#define SIM_I2C_EEPROM_PAGE_SIZE        256u
+
+typedef struct
+{
+    uint8_t *           memory;
+    uint32_t            size;
+    uint32_t            write_cycle_polls;
+
+    sim_i2c_target_t    target;
+
+    /* Transaction state */
+    uint8_t             reading;
+    uint32_t            byte_idx;
+    uint32_t            address;
+    uint8_t             page[SIM_I2C_EEPROM_PAGE_SIZE];
+    uint32_t            page_base;
+    uint32_t            page_fill;
+    uint32_t            busy;
+
+    /* Statistics */
+    uint32_t            pages_written;
+    uint32_t            busy_nacks;
+} sim_i2c_eeprom_t;
+
+void sim_i2c_eeprom_init(sim_i2c_eeprom_t * eeprom,
+                         uint8_t target_addr,
+                         uint8_t * memory,
+                         uint32_t size);
+
+/*==============================================================================
+ * MIV_ESS uDMA
+ * A started transfer is completed by the next HAL_SIM_step(). Both addresses
+ * must be in memory made visible with HAL_SIM_map_memory(), otherwise the
+ * transfer ends with the ERROR status bit set.
+ */
+typedef struct
+{
+    hal_sim_model_t model;
+    uint32_t        control;
+    uint32_t        irq_cfg;
+    uint32_t        status;
+    uint32_t        src_addr;
+    uint32_t        dest_addr;
+    uint32_t        blk_size;
+    uint8_t         irq_line;
+    uint8_t         pending;
+    uint32_t        words;
+} sim_udma_t;
+
+void sim_udma_init(sim_udma_t * udma, addr_t base_addr, uint8_t irq_line);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_SIM_MODELS_H_ */
@@ -0,0 +1,358 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file sim_core_spi.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief CoreSPI register model.
+ *
+ * In master mode, frames are shifted instantly, so the receive FIFO fills as
+ * soon as a frame is written to an enabled core. This is the worst case for
+ * receive overflow and is what SPI_transfer_block() is written to cope with.
+ *
+ * In slave mode, frames are only shifted by sim_spi_master_clock().
+ */
+#include <string.h>
+#include "hal_sim_models.h"
+#include "drivers/fabric_ip/CoreSPI/corespi_regs.h"
+
+#define IS_SLAVE(spi)   (0u == ((spi)->ctrl1 & CTRL1_MASTER_MASK))
+
+/*
+ * Raw interrupts masked by the enables of CTRL1 and CTRL2, as read from
+ * INTMASK.
+ */
+static uint8_t masked_interrupts(const sim_spi_t * spi)
+{
+    uint8_t enabled = 0u;
+
+    enabled |= (spi->ctrl1 & CTRL1_INTTXDONE_MASK)   ? INTMASK_TXDONE_MASK     : 0u;
+    enabled |= (spi->ctrl1 & CTRL1_INTRXOVFLOW_MASK) ? INTMASK_RXOVERFLOW_MASK : 0u;
+    enabled |= (spi->ctrl1 & CTRL1_INTTXURUN_MASK)   ? INTMASK_TXUNDERRUN_MASK : 0u;
+    enabled |= (spi->ctrl2 & CTRL2_INTCMD_MASK)      ? INTMASK_CMDINT_MASK     : 0u;
+    enabled |= (spi->ctrl2 & CTRL2_INTSSEND_MASK)    ? INTMASK_SSEND_MASK      : 0u;
+    enabled |= (spi->ctrl2 & CTRL2_INTRXDATA_MASK)   ? INTMASK_RXDATA_MASK     : 0u;
+    enabled |= (spi->ctrl2 & CTRL2_INTTXDATA_MASK)   ? INTMASK_TXDATA_MASK     : 0u;
+
+    return (uint8_t)(spi->intraw & enabled);
+}
+
+static void update_irq(const sim_spi_t * spi)
+{
+    HAL_SIM_set_irq(spi->irq_line, (0u != masked_interrupts(spi)) ? 1u : 0u);
+}
+
+static void shift_frame(sim_spi_t * spi, uint32_t frame, uint8_t last)
+{
+    uint32_t miso = 0u;
+    uint32_t idx;
+    uint8_t shift;
+
+    if ((0u == spi->selected) && (0u != spi->ssel))
+    {
+        /* Only one slave select is expected to be set */
+        for (idx = 0u; 0u == (spi->ssel & (1u << idx)); ++idx)
+        {
+            ;
+        }
+        spi->selected = 1u;
+        spi->slave = spi->slaves[idx];
+        if (NULL != spi->slave)
+        {
+            spi->slave->select(spi->slave->ctx);
+        }
+    }
+
+    for (shift = (uint8_t)(spi->frame_bytes * 8u); shift > 0u; shift -= 8u)
+    {
+        miso <<= 8;
+        if (spi->selected && (NULL != spi->slave))
+        {
+            miso |= spi->slave->transfer(spi->slave->ctx,
+                                         (uint8_t)(frame >> (shift - 8u)));
+        }
+        else
+        {
+            miso |= 0xFFu;
+        }
+    }
+
+    ++spi->frames;
+
+    if (spi->rx_count < SIM_SPI_FIFO_DEPTH)
+    {
+        spi->rx_fifo[(spi->rx_head + spi->rx_count) % SIM_SPI_FIFO_DEPTH] = miso;
+        ++spi->rx_count;
+    }
+    else
+    {
+        spi->status |= STATUS_RXOVFLOW_MASK;
+        spi->intraw |= INTRAW_RXOVERFLOW_MASK;
+    }
+
+    if (last)
+    {
+        if (spi->selected && (NULL != spi->slave))
+        {
+            spi->slave->deselect(spi->slave->ctx);
+        }
+        spi->selected = 0u;
+        spi->status |= STATUS_DONE_MASK;
+        spi->intraw |= INTRAW_TXDONE_MASK;
+    }
+}
+
+static void flush_tx_fifo(sim_spi_t * spi)
+{
+    uint32_t idx;
+
+    for (idx = 0u; idx < spi->tx_count; ++idx)
+    {
+        shift_frame(spi, spi->tx_fifo[idx], spi->tx_last[idx]);
+    }
+    spi->tx_count = 0u;
+}
+
+static void push_frame(sim_spi_t * spi, uint32_t frame, uint8_t last)
+{
+    spi->status &= (uint8_t)~STATUS_DONE_MASK;
+
+    if ((0u != (spi->ctrl1 & CTRL1_ENABLE_MASK)) && !IS_SLAVE(spi))
+    {
+        shift_frame(spi, frame, last);
+    }
+    else if (spi->tx_count < SIM_SPI_FIFO_DEPTH)
+    {
+        spi->tx_fifo[spi->tx_count] = frame;
+        spi->tx_last[spi->tx_count] = last;
+        ++spi->tx_count;
+    }
+    else
+    {
+        /* Written to a full FIFO, the frame is lost. */
+    }
+}
+
+static uint32_t spi_read(hal_sim_model_t * model, uint32_t offset, uint8_t width)
+{
+    sim_spi_t * spi = (sim_spi_t *)model->state;
+    uint32_t value = 0u;
+
+    (void)width;
+
+    switch (offset)
+    {
+        case CTRL1_REG_OFFSET:
+            value = spi->ctrl1;
+            break;
+
+        case RXDATA_REG_OFFSET:
+            if (spi->rx_count > 0u)
+            {
+                value = spi->rx_fifo[spi->rx_head];
+                spi->rx_head = (spi->rx_head + 1u) % SIM_SPI_FIFO_DEPTH;
+                --spi->rx_count;
+            }
+            break;
+
+        case INTMASK_REG_OFFSET:
+            value = masked_interrupts(spi);
+            break;
+
+        case INTRAW_REG_OFFSET:
+            value = spi->intraw;
+            break;
+
+        case CTRL2_REG_OFFSET:
+            value = spi->ctrl2;
+            break;
+
+        case STATUS_REG_OFFSET:
+            value = spi->status;
+            if (0u == spi->rx_count)
+            {
+                value |= STATUS_RXEMPTY_MASK;
+            }
+            if (SIM_SPI_FIFO_DEPTH == spi->tx_count)
+            {
+                value |= STATUS_TXFULL_MASK;
+            }
+            if (spi->selected)
+            {
+                value |= STATUS_SSEL_MASK | STATUS_ACTIVE_MASK;
+            }
+            break;
+
+        case SSEL_REG_OFFSET:
+            value = spi->ssel;
+            break;
+
+        default:
+            break;
+    }
+
+    return value;
+}
+
+static void spi_write(hal_sim_model_t * model,
+                      uint32_t offset,
+                      uint32_t value,
+                      uint8_t width)
+{
+    sim_spi_t * spi = (sim_spi_t *)model->state;
+
+    (void)width;
+
+    switch (offset)
+    {
+        case CTRL1_REG_OFFSET:
+        {
+            uint8_t was_enabled = spi->ctrl1 & CTRL1_ENABLE_MASK;
+
+            spi->ctrl1 = (uint8_t)value;
+            if ((0u == was_enabled) && (0u != (spi->ctrl1 & CTRL1_ENABLE_MASK)) &&
+                !IS_SLAVE(spi))
+            {
+                flush_tx_fifo(spi);
+            }
+            update_irq(spi);
+        }
+        break;
+
+        case INTCLR_REG_OFFSET:
+            spi->intraw &= (uint8_t)~value;
+            if (0u != (value & INTCLR_RXOVERFLOW_MASK))
+            {
+                spi->status &= (uint8_t)~STATUS_RXOVFLOW_MASK;
+            }
+            if (0u != (value & INTCLR_TXUNDERRUN_MASK))
+            {
+                spi->status &= (uint8_t)~STATUS_TXUNDERRUN_MASK;
+            }
+            update_irq(spi);
+            break;
+
+        case TXDATA_REG_OFFSET:
+            push_frame(spi, value, 0u);
+            break;
+
+        case CTRL2_REG_OFFSET:
+            spi->ctrl2 = (uint8_t)value;
+            update_irq(spi);
+            break;
+
+        case CMD_REG_OFFSET:
+            if (0u != (value & CMD_RXFIFORST_MASK))
+            {
+                spi->rx_head = 0u;
+                spi->rx_count = 0u;
+                spi->status &= (uint8_t)~STATUS_RXOVFLOW_MASK;
+            }
+            if (0u != (value & CMD_TXFIFORST_MASK))
+            {
+                spi->tx_count = 0u;
+            }
+            break;
+
+        case SSEL_REG_OFFSET:
+            spi->ssel = (uint8_t)value;
+            break;
+
+        case TXLAST_REG_OFFSET:
+            push_frame(spi, value, 1u);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void sim_spi_init(sim_spi_t * spi, addr_t base_addr, uint8_t irq_line)
+{
+    memset(spi, 0, sizeof(sim_spi_t));
+
+    spi->ctrl1 = CTRL1_MASTER_MASK;
+    spi->irq_line = irq_line;
+    spi->frame_bytes = 1u;
+
+    spi->model.name = "CoreSPI";
+    spi->model.base_addr = base_addr;
+    spi->model.size = 0x30u;
+    spi->model.read = spi_read;
+    spi->model.write = spi_write;
+    spi->model.step = NULL;
+    spi->model.state = spi;
+
+    HAL_SIM_register(&spi->model);
+}
+
+void sim_spi_attach(sim_spi_t * spi, uint8_t ssel, const sim_spi_slave_t * slave)
+{
+    spi->slaves[ssel] = slave;
+}
+
+void sim_spi_set_frame_width(sim_spi_t * spi, uint8_t frame_width)
+{
+    spi->frame_bytes = (uint8_t)(frame_width / 8u);
+}
+
+uint32_t sim_spi_master_clock(sim_spi_t * spi,
+                              const uint8_t * mosi,
+                              uint8_t * miso,
+                              uint32_t count,
+                              uint8_t end)
+{
+    uint32_t idx;
+    uint8_t frame;
+
+    if (!IS_SLAVE(spi) || (0u == (spi->ctrl1 & CTRL1_ENABLE_MASK)))
+    {
+        return 0u;
+    }
+
+    for (idx = 0u; idx < count; ++idx)
+    {
+        /* Transmit side, the FIFO is shifted towards its head */
+        frame = 0u;
+        if (spi->tx_count > 0u)
+        {
+            frame = (uint8_t)spi->tx_fifo[0];
+            --spi->tx_count;
+            memmove(spi->tx_fifo, &spi->tx_fifo[1], spi->tx_count * sizeof(spi->tx_fifo[0]));
+        }
+        else
+        {
+            spi->status |= STATUS_TXUNDERRUN_MASK;
+            spi->intraw |= INTRAW_TXUNDERRUN_MASK;
+        }
+        if (NULL != miso)
+        {
+            miso[idx] = frame;
+        }
+
+        /* Receive side */
+        if (spi->rx_count < SIM_SPI_FIFO_DEPTH)
+        {
+            spi->rx_fifo[(spi->rx_head + spi->rx_count) % SIM_SPI_FIFO_DEPTH] =
+                (NULL != mosi) ? mosi[idx] : 0u;
+            ++spi->rx_count;
+        }
+        else
+        {
+            spi->status |= STATUS_RXOVFLOW_MASK;
+            spi->intraw |= INTRAW_RXOVERFLOW_MASK;
+        }
+        spi->intraw |= INTRAW_RXDATA_MASK;
+        ++spi->frames;
+    }
+
+    if (end)
+    {
+        spi->intraw |= INTRAW_SSEND_MASK;
+    }
+
+    update_irq(spi);
+
+    return count;
+}
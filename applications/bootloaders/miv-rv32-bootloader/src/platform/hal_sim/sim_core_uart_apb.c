@@ -0,0 +1,140 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file sim_core_uart_apb.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief CoreUARTapb register model.
+ *
+ * The transmitter is always ready and hands each byte to the tx handler. The
+ * receiver is a software queue filled by sim_uart_push_rx().
+ */
+#include <string.h>
+#include "hal_sim_models.h"
+#include "drivers/fabric_ip/CoreUARTapb/coreuartapb_regs.h"
+
+static uint32_t uart_read(hal_sim_model_t * model, uint32_t offset, uint8_t width)
+{
+    sim_uart_t * uart = (sim_uart_t *)model->state;
+    uint32_t value = 0u;
+
+    (void)width;
+
+    switch (offset)
+    {
+        case RXDATA_REG_OFFSET:
+            if (uart->rx_count > 0u)
+            {
+                value = uart->rx_queue[uart->rx_head];
+                uart->rx_head = (uart->rx_head + 1u) % SIM_UART_RX_QUEUE_SIZE;
+                --uart->rx_count;
+            }
+            break;
+
+        case CTRL1_REG_OFFSET:
+            value = uart->ctrl1;
+            break;
+
+        case CTRL2_REG_OFFSET:
+            value = uart->ctrl2;
+            break;
+
+        case STATUS_REG_OFFSET:
+            if ((0u == uart->rx_count) && (NULL != uart->idle_handler))
+            {
+                uart->idle_handler(uart->ctx);
+            }
+
+            value = STATUS_TXRDY_MASK;
+            if (uart->rx_count > 0u)
+            {
+                value |= STATUS_RXFULL_MASK;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return value;
+}
+
+static void uart_write(hal_sim_model_t * model,
+                       uint32_t offset,
+                       uint32_t value,
+                       uint8_t width)
+{
+    sim_uart_t * uart = (sim_uart_t *)model->state;
+
+    (void)width;
+
+    switch (offset)
+    {
+        case TXDATA_REG_OFFSET:
+            ++uart->tx_count;
+            if (NULL != uart->tx_handler)
+            {
+                uart->tx_handler(uart->ctx, (uint8_t)value);
+            }
+            break;
+
+        case CTRL1_REG_OFFSET:
+            uart->ctrl1 = (uint8_t)value;
+            break;
+
+        case CTRL2_REG_OFFSET:
+            uart->ctrl2 = (uint8_t)value;
+            break;
+
+        default:
+            break;
+    }
+}
+
+void sim_uart_init(sim_uart_t * uart, addr_t base_addr)
+{
+    memset(uart, 0, sizeof(sim_uart_t));
+
+    uart->model.name = "CoreUARTapb";
+    uart->model.base_addr = base_addr;
+    uart->model.size = 0x20u;
+    uart->model.read = uart_read;
+    uart->model.write = uart_write;
+    uart->model.step = NULL;
+    uart->model.state = uart;
+
+    HAL_SIM_register(&uart->model);
+}
+
+void sim_uart_set_handlers(sim_uart_t * uart,
+                           sim_uart_tx_handler_t tx_handler,
+                           sim_uart_idle_handler_t idle_handler,
+                           void * ctx)
+{
+    uart->tx_handler = tx_handler;
+    uart->idle_handler = idle_handler;
+    uart->ctx = ctx;
+}
+
+uint32_t sim_uart_push_rx(sim_uart_t * uart,
+                          const uint8_t * data,
+                          uint32_t size)
+{
+    uint32_t idx;
+
+    for (idx = 0u; idx < size; ++idx)
+    {
+        if (uart->rx_count >= SIM_UART_RX_QUEUE_SIZE)
+        {
+            ++uart->rx_overflows;
+            break;
+        }
+
+        uart->rx_queue[(uart->rx_head + uart->rx_count) % SIM_UART_RX_QUEUE_SIZE] =
+                data[idx];
+        ++uart->rx_count;
+    }
+
+    return idx;
+}
@@ -0,0 +1,118 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file sim_i2c_eeprom.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief I2C EEPROM model attached to the MIV_I2C model.
+ *
+ * Behaves like a 24xx512 style device: the first two bytes written after the
+ * address byte select the memory address, further bytes are buffered and wrap
+ * within the current page, and the page is committed on the stop condition.
+ */
+#include <string.h>
+#include "hal_sim_models.h"
+
+#define I2C_ACK     0u
+#define I2C_NACK    1u
+
+static uint8_t eeprom_start(void * ctx, uint8_t read)
+{
+    sim_i2c_eeprom_t * eeprom = (sim_i2c_eeprom_t *)ctx;
+
+    if (eeprom->busy > 0u)
+    {
+        /* Internal write cycle in progress */
+        --eeprom->busy;
+        ++eeprom->busy_nacks;
+        return I2C_NACK;
+    }
+
+    eeprom->reading = read;
+    eeprom->byte_idx = 0u;
+
+    return I2C_ACK;
+}
+
+static uint8_t eeprom_write(void * ctx, uint8_t data)
+{
+    sim_i2c_eeprom_t * eeprom = (sim_i2c_eeprom_t *)ctx;
+    uint32_t idx = eeprom->byte_idx++;
+
+    if (eeprom->reading)
+    {
+        return I2C_NACK;
+    }
+
+    if (idx < 2u)
+    {
+        eeprom->address = ((eeprom->address << 8) | data) & 0xFFFFu;
+        if (1u == idx)
+        {
+            eeprom->address %= eeprom->size;
+        }
+    }
+    else
+    {
+        if (0u == eeprom->page_fill)
+        {
+            eeprom->page_base = eeprom->address & ~(SIM_I2C_EEPROM_PAGE_SIZE - 1u);
+            memcpy(eeprom->page, &eeprom->memory[eeprom->page_base],
+                   SIM_I2C_EEPROM_PAGE_SIZE);
+        }
+
+        eeprom->page[(eeprom->address + (idx - 2u)) & (SIM_I2C_EEPROM_PAGE_SIZE - 1u)] = data;
+        ++eeprom->page_fill;
+    }
+
+    return I2C_ACK;
+}
+
+static uint8_t eeprom_read(void * ctx, uint8_t nack)
+{
+    sim_i2c_eeprom_t * eeprom = (sim_i2c_eeprom_t *)ctx;
+    uint8_t data = eeprom->memory[eeprom->address];
+
+    (void)nack;
+
+    eeprom->address = (eeprom->address + 1u) % eeprom->size;
+
+    return data;
+}
+
+static void eeprom_stop(void * ctx)
+{
+    sim_i2c_eeprom_t * eeprom = (sim_i2c_eeprom_t *)ctx;
+
+    if (eeprom->page_fill > 0u)
+    {
+        memcpy(&eeprom->memory[eeprom->page_base], eeprom->page,
+               SIM_I2C_EEPROM_PAGE_SIZE);
+        eeprom->page_fill = 0u;
+        ++eeprom->pages_written;
+        eeprom->busy = eeprom->write_cycle_polls;
+    }
+}
+
+void sim_i2c_eeprom_init(sim_i2c_eeprom_t * eeprom,
+                         uint8_t target_addr,
+                         uint8_t * memory,
+                         uint32_t size)
+{
+    memset(eeprom, 0, sizeof(sim_i2c_eeprom_t));
+
+    eeprom->memory = memory;
+    eeprom->size = size;
+    memset(memory, 0xFF, size);
+
+    eeprom->write_cycle_polls = 8u;
+
+    eeprom->target.addr = target_addr;
+    eeprom->target.ctx = eeprom;
+    eeprom->target.start = eeprom_start;
+    eeprom->target.write = eeprom_write;
+    eeprom->target.read = eeprom_read;
+    eeprom->target.stop = eeprom_stop;
+    eeprom->target.next = NULL;
+}
@@ -0,0 +1,269 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file sim_miv_i2c.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief MIV_I2C register model, master mode.
+ *
+ * The command bits written to the COMMAND register are accumulated until the
+ * next HAL_SIM_step(), as the driver builds a command with several read-modify-
+ * write accesses. The step then performs, in order, the start condition and
+ * address byte, a data byte write or read, and the stop condition, and sets
+ * STATUS.IF. This file also provides MIV_I2C_enable_irq() and
+ * MIV_I2C_disable_irq() in place of miv_i2c_interrupt.c.
+ */
+#include <string.h>
+#include "hal_sim_models.h"
+#include "drivers/fabric_ip/miv_i2c/mivi2c_regs.h"
+
+#define CMD_EXEC_MASK   (CMD_STA_MASK | CMD_STO_MASK | CMD_WR_MASK | CMD_RD_MASK)
+
+/* A start condition is only generated together with a WR command. */
+#define CMD_GO_MASK     (CMD_STO_MASK | CMD_WR_MASK | CMD_RD_MASK)
+
+static sim_i2c_t * g_irq_i2c = NULL;
+
+static sim_i2c_target_t * find_target(sim_i2c_t * i2c, uint8_t addr)
+{
+    sim_i2c_target_t * target;
+
+    for (target = i2c->targets; NULL != target; target = target->next)
+    {
+        if (target->addr == addr)
+        {
+            break;
+        }
+    }
+
+    return target;
+}
+
+static void i2c_step(hal_sim_model_t * model)
+{
+    sim_i2c_t * i2c = (sim_i2c_t *)model->state;
+    uint8_t cmd = i2c->command;
+    uint8_t nack = 1u;
+
+    if ((0u == (cmd & CMD_GO_MASK)) || (0u == (i2c->control & CTRL_CORE_EN_MASK)))
+    {
+        return;
+    }
+
+    if (0u != (cmd & CMD_WR_MASK))
+    {
+        if (0u != (cmd & CMD_STA_MASK))
+        {
+            /* (Repeated) start followed by the address byte */
+            i2c->status |= STAT_BUSY_MASK;
+            i2c->active = find_target(i2c, (uint8_t)(i2c->transmit >> TX_TARGET_ADDR_SHIFT));
+            if (NULL != i2c->active)
+            {
+                nack = i2c->active->start(i2c->active->ctx,
+                                          (uint8_t)(i2c->transmit & TX_DIR_MASK));
+            }
+        }
+        else if (NULL != i2c->active)
+        {
+            nack = i2c->active->write(i2c->active->ctx, i2c->transmit);
+        }
+        else
+        {
+            /* Nobody to talk to */
+        }
+
+        ++i2c->bytes;
+        if (nack)
+        {
+            ++i2c->nacks;
+            i2c->status |= STAT_RXACK_MASK;
+        }
+        else
+        {
+            i2c->status &= (uint8_t)~STAT_RXACK_MASK;
+        }
+    }
+    else if (0u != (cmd & CMD_RD_MASK))
+    {
+        i2c->receive = 0xFFu;
+        if (NULL != i2c->active)
+        {
+            i2c->receive = i2c->active->read(i2c->active->ctx,
+                                             (cmd & CMD_ACK_MASK) ? 1u : 0u);
+        }
+        ++i2c->bytes;
+    }
+    else
+    {
+        /* STO only */
+    }
+
+    if (0u != (cmd & CMD_STO_MASK))
+    {
+        if (NULL != i2c->active)
+        {
+            i2c->active->stop(i2c->active->ctx);
+        }
+        i2c->active = NULL;
+        i2c->status &= (uint8_t)~STAT_BUSY_MASK;
+    }
+
+    /* Command bits self clear on completion, ACK and IACK are left as set. */
+    i2c->command &= (uint8_t)~CMD_EXEC_MASK;
+    i2c->status &= (uint8_t)~STAT_TIP_MASK;
+    i2c->status |= STAT_IF_MASK;
+
+    if (0u != (i2c->control & CTRL_IRQ_EN_MASK))
+    {
+        HAL_SIM_set_irq(i2c->irq_line, 1u);
+    }
+}
+
+static uint32_t i2c_read(hal_sim_model_t * model, uint32_t offset, uint8_t width)
+{
+    sim_i2c_t * i2c = (sim_i2c_t *)model->state;
+    uint32_t value = 0u;
+
+    (void)width;
+
+    switch (offset)
+    {
+        case PRESCALE_REG_OFFSET:
+            value = i2c->prescale;
+            break;
+
+        case CONTROL_REG_OFFSET:
+            value = i2c->control;
+            break;
+
+        case TRANSMIT_REG_OFFSET:
+            value = i2c->transmit;
+            break;
+
+        case RECEIVE_REG_OFFSET:
+            value = i2c->receive;
+            break;
+
+        case COMMAND_REG_OFFSET:
+            value = i2c->command;
+            break;
+
+        case STATUS_REG_OFFSET:
+            value = i2c->status;
+            break;
+
+        default:
+            break;
+    }
+
+    return value;
+}
+
+static void i2c_write(hal_sim_model_t * model,
+                      uint32_t offset,
+                      uint32_t value,
+                      uint8_t width)
+{
+    sim_i2c_t * i2c = (sim_i2c_t *)model->state;
+
+    switch (offset)
+    {
+        case PRESCALE_REG_OFFSET:
+            /* Only writable while the core is disabled */
+            if (0u == (i2c->control & CTRL_CORE_EN_MASK))
+            {
+                i2c->prescale = (uint16_t)((2u == width) ? value : (value & 0xFFu));
+            }
+            break;
+
+        case CONTROL_REG_OFFSET:
+            i2c->control = (uint8_t)(value & CONTROL_MASK);
+            break;
+
+        case TRANSMIT_REG_OFFSET:
+            i2c->transmit = (uint8_t)value;
+            break;
+
+        case COMMAND_REG_OFFSET:
+            if ((0u != (i2c->command & CMD_STO_MASK)) &&
+                (0u == (i2c->command & CMD_STA_MASK)) &&
+                (0u != (value & CMD_STA_MASK)))
+            {
+                /*
+                 * New start while the previous stop has not been generated,
+                 * as happens when a transfer is issued as soon as the driver
+                 * reports completion. The core waits for the bus to be free
+                 * before generating the start, so complete the stop first.
+                 * The driver sets STA with a read-modify-write of the command
+                 * register, which writes the pending STO back: drop it too.
+                 */
+                if (NULL != i2c->active)
+                {
+                    i2c->active->stop(i2c->active->ctx);
+                }
+                i2c->active = NULL;
+                i2c->status &= (uint8_t)~STAT_BUSY_MASK;
+                i2c->command &= (uint8_t)~CMD_STO_MASK;
+                value &= ~(uint32_t)CMD_STO_MASK;
+            }
+            i2c->command = (uint8_t)((i2c->command & CMD_EXEC_MASK) | (value & COMMAND_MASK));
+            if (0u != (value & CMD_IACK_MASK))
+            {
+                i2c->status &= (uint8_t)~STAT_IF_MASK;
+                HAL_SIM_set_irq(i2c->irq_line, 0u);
+            }
+            if (0u != (i2c->command & CMD_GO_MASK))
+            {
+                i2c->status |= STAT_TIP_MASK;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void sim_i2c_init(sim_i2c_t * i2c, addr_t base_addr, uint8_t irq_line)
+{
+    memset(i2c, 0, sizeof(sim_i2c_t));
+
+    i2c->irq_line = irq_line;
+
+    i2c->model.name = "MIV_I2C";
+    i2c->model.base_addr = base_addr;
+    i2c->model.size = 0x18u;
+    i2c->model.read = i2c_read;
+    i2c->model.write = i2c_write;
+    i2c->model.step = i2c_step;
+    i2c->model.state = i2c;
+
+    g_irq_i2c = i2c;
+
+    HAL_SIM_register(&i2c->model);
+}
+
+void sim_i2c_attach(sim_i2c_t * i2c, sim_i2c_target_t * target)
+{
+    target->next = i2c->targets;
+    i2c->targets = target;
+}
+
+/*------------------------------------------------------------------------------
+ * Replacement for miv_i2c_interrupt.c
+ */
+void MIV_I2C_disable_irq(void)
+{
+    if (NULL != g_irq_i2c)
+    {
+        HAL_SIM_disable_irq(g_irq_i2c->irq_line);
+    }
+}
+
+void MIV_I2C_enable_irq(void)
+{
+    if (NULL != g_irq_i2c)
+    {
+        HAL_SIM_enable_irq(g_irq_i2c->irq_line);
+    }
+}
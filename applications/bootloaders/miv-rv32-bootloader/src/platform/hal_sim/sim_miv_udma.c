@@ -0,0 +1,164 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file sim_miv_udma.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief MIV_ESS uDMA register model.
+ *
+ * The transfer started by CONTROL_SR.START is performed in one go on the next
+ * HAL_SIM_step(). BUSY is reported until then. On completion the interrupt line
+ * is asserted if IRQ_CFG is set, on error it is always asserted. The line is
+ * released by the CONTROL_SR.RESET toggle done by MIV_uDMA_reset().
+ */
+#include <string.h>
+#include "hal_sim_models.h"
+#include "drivers/fabric_ip/miv_udma/miv_udma_regs.h"
+
+#define UDMA_STATUS_BUSY    0x01u
+#define UDMA_STATUS_ERROR   0x02u
+
+static void udma_step(hal_sim_model_t * model)
+{
+    sim_udma_t * udma = (sim_udma_t *)model->state;
+    uint32_t nb_bytes;
+    void * src;
+    void * dest;
+
+    if (0u == udma->pending)
+    {
+        return;
+    }
+
+    udma->pending = 0u;
+    nb_bytes = udma->blk_size * 4u;
+    src = HAL_SIM_translate(udma->src_addr, nb_bytes);
+    dest = HAL_SIM_translate(udma->dest_addr, nb_bytes);
+
+    if ((NULL != src) && (NULL != dest))
+    {
+        memmove(dest, src, nb_bytes);
+        udma->words += udma->blk_size;
+        udma->status = 0u;
+        if (0u != (udma->irq_cfg & IRQ_CFG_MASK))
+        {
+            HAL_SIM_set_irq(udma->irq_line, 1u);
+        }
+    }
+    else
+    {
+        udma->status = UDMA_STATUS_ERROR;
+        HAL_SIM_set_irq(udma->irq_line, 1u);
+    }
+}
+
+static uint32_t udma_read(hal_sim_model_t * model, uint32_t offset, uint8_t width)
+{
+    sim_udma_t * udma = (sim_udma_t *)model->state;
+    uint32_t value = 0u;
+
+    (void)width;
+
+    switch (offset)
+    {
+        case CONTROL_SR_REG_OFFSET:
+            value = udma->control;
+            break;
+
+        case IRQ_CFG_REG_OFFSET:
+            value = udma->irq_cfg;
+            break;
+
+        case TX_STATUS_REG_OFFSET:
+            value = udma->status;
+            break;
+
+        case SRC_START_ADDR_REG_OFFSET:
+            value = udma->src_addr;
+            break;
+
+        case DEST_START_ADDR_REG_OFFSET:
+            value = udma->dest_addr;
+            break;
+
+        case BLK_SIZE_REG_OFFSET:
+            value = udma->blk_size;
+            break;
+
+        default:
+            break;
+    }
+
+    return value;
+}
+
+static void udma_write(hal_sim_model_t * model,
+                       uint32_t offset,
+                       uint32_t value,
+                       uint8_t width)
+{
+    sim_udma_t * udma = (sim_udma_t *)model->state;
+
+    (void)width;
+
+    switch (offset)
+    {
+        case CONTROL_SR_REG_OFFSET:
+            if (0u != (value & CTRL_RESET_TX_MASK))
+            {
+                udma->pending = 0u;
+                udma->status = 0u;
+                udma->irq_cfg = 0u;
+                HAL_SIM_set_irq(udma->irq_line, 0u);
+            }
+            else if (0u != (value & CTRL_START_TX_MASK))
+            {
+                udma->pending = 1u;
+                udma->status = UDMA_STATUS_BUSY;
+            }
+            else
+            {
+                /* No change */
+            }
+            /* START is self clearing, RESET is held until written to 0. */
+            udma->control = value & CTRL_RESET_TX_MASK;
+            break;
+
+        case IRQ_CFG_REG_OFFSET:
+            udma->irq_cfg = value & IRQ_CFG_MASK;
+            break;
+
+        case SRC_START_ADDR_REG_OFFSET:
+            udma->src_addr = value;
+            break;
+
+        case DEST_START_ADDR_REG_OFFSET:
+            udma->dest_addr = value;
+            break;
+
+        case BLK_SIZE_REG_OFFSET:
+            udma->blk_size = value;
+            break;
+
+        default:
+            break;
+    }
+}
+
+void sim_udma_init(sim_udma_t * udma, addr_t base_addr, uint8_t irq_line)
+{
+    memset(udma, 0, sizeof(sim_udma_t));
+
+    udma->irq_line = irq_line;
+
+    udma->model.name = "MIV_uDMA";
+    udma->model.base_addr = base_addr;
+    udma->model.size = 0x18u;
+    udma->model.read = udma_read;
+    udma->model.write = udma_write;
+    udma->model.step = udma_step;
+    udma->model.state = udma;
+
+    HAL_SIM_register(&udma->model);
+}
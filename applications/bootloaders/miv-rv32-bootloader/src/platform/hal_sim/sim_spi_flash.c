@@ -0,0 +1,247 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file sim_spi_flash.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief SPI NOR flash model attached to the CoreSPI model.
+ *
+ * Implements the subset of the Micron N25Q/MT25Q command set used by
+ * drivers/off_chip/spi_flash/spi_flash.c, with 3 byte addressing. Programming
+ * can only clear bits and wraps within a 256 byte page, as on the device.
+ */
+#include <string.h>
+#include "hal_sim_models.h"
+
+#define CMD_WRITE_STATUS        0x01u
+#define CMD_PAGE_PROGRAM        0x02u
+#define CMD_READ                0x03u
+#define CMD_WRITE_DISABLE       0x04u
+#define CMD_READ_STATUS         0x05u
+#define CMD_WRITE_ENABLE        0x06u
+#define CMD_ERASE_4K            0x20u
+#define CMD_PROTECT_SECTOR      0x36u
+#define CMD_UNPROTECT_SECTOR    0x39u
+#define CMD_READ_PROTECT        0x3Cu
+#define CMD_ERASE_32K           0x52u
+#define CMD_CHIP_ERASE          0x60u
+#define CMD_RESET_ENABLE        0x66u
+#define CMD_READ_FLAG_STATUS    0x70u
+#define CMD_RESET               0x99u
+#define CMD_READ_ID             0x9Fu
+#define CMD_CHIP_ERASE_ALT      0xC7u
+#define CMD_ERASE_64K           0xD8u
+
+#define STATUS_WIP              0x01u
+#define STATUS_WEL              0x02u
+#define FLAG_STATUS_READY       0x80u
+
+#define ADDRESS_BYTES           3u
+
+static uint8_t poll_status(sim_spi_flash_t * flash)
+{
+    ++flash->status_polls;
+
+    if (flash->busy > 0u)
+    {
+        --flash->busy;
+        return 1u;
+    }
+
+    return 0u;
+}
+
+static void flash_select(void * ctx)
+{
+    sim_spi_flash_t * flash = (sim_spi_flash_t *)ctx;
+
+    flash->byte_idx = 0u;
+    flash->address = 0u;
+    flash->opcode = 0u;
+}
+
+static uint8_t flash_transfer(void * ctx, uint8_t mosi)
+{
+    sim_spi_flash_t * flash = (sim_spi_flash_t *)ctx;
+    uint32_t idx = flash->byte_idx++;
+    uint8_t miso = 0xFFu;
+
+    if (0u == idx)
+    {
+        flash->opcode = mosi;
+        ++flash->commands;
+        return miso;
+    }
+
+    switch (flash->opcode)
+    {
+        case CMD_READ_STATUS:
+            miso = poll_status(flash) ? STATUS_WIP : 0u;
+            miso |= flash->write_enabled ? STATUS_WEL : 0u;
+            break;
+
+        case CMD_READ_FLAG_STATUS:
+            miso = poll_status(flash) ? 0u : FLAG_STATUS_READY;
+            break;
+
+        case CMD_READ_ID:
+            if (idx <= sizeof(flash->id))
+            {
+                miso = flash->id[idx - 1u];
+            }
+            break;
+
+        case CMD_READ_PROTECT:
+            miso = 0u;
+            break;
+
+        default:
+            if (idx <= ADDRESS_BYTES)
+            {
+                flash->address = (flash->address << 8) | mosi;
+            }
+            else if (CMD_READ == flash->opcode)
+            {
+                miso = flash->memory[flash->address % flash->size];
+                ++flash->address;
+            }
+            else if ((CMD_PAGE_PROGRAM == flash->opcode) &&
+                     flash->write_enabled && (0u == flash->busy))
+            {
+                uint32_t page = flash->address & ~(SIM_SPI_FLASH_PAGE_SIZE - 1u);
+                uint32_t column = (flash->address + (idx - ADDRESS_BYTES - 1u)) &
+                                  (SIM_SPI_FLASH_PAGE_SIZE - 1u);
+
+                flash->memory[(page + column) % flash->size] &= mosi;
+            }
+            else
+            {
+                /* Data bytes of other commands are ignored. */
+            }
+            break;
+    }
+
+    return miso;
+}
+
+static void erase(sim_spi_flash_t * flash, uint32_t block_size)
+{
+    uint32_t base = (flash->address % flash->size) & ~(block_size - 1u);
+
+    if (block_size > flash->size)
+    {
+        block_size = flash->size;
+        base = 0u;
+    }
+
+    memset(&flash->memory[base], 0xFF, block_size);
+    ++flash->blocks_erased;
+    flash->busy = flash->erase_polls;
+}
+
+static void flash_deselect(void * ctx)
+{
+    sim_spi_flash_t * flash = (sim_spi_flash_t *)ctx;
+    uint8_t has_address = (flash->byte_idx > ADDRESS_BYTES) ? 1u : 0u;
+
+    if ((flash->busy > 0u) &&
+        (CMD_READ_STATUS != flash->opcode) &&
+        (CMD_READ_FLAG_STATUS != flash->opcode))
+    {
+        /* The device ignores commands during a program or erase cycle. */
+        ++flash->errors;
+        return;
+    }
+
+    switch (flash->opcode)
+    {
+        case CMD_WRITE_ENABLE:
+            flash->write_enabled = 1u;
+            break;
+
+        case CMD_WRITE_DISABLE:
+            flash->write_enabled = 0u;
+            break;
+
+        case CMD_PAGE_PROGRAM:
+            if (flash->write_enabled && (flash->byte_idx > (ADDRESS_BYTES + 1u)))
+            {
+                ++flash->pages_programmed;
+                flash->busy = flash->program_polls;
+            }
+            else
+            {
+                ++flash->errors;
+            }
+            flash->write_enabled = 0u;
+            break;
+
+        case CMD_ERASE_4K:
+        case CMD_ERASE_32K:
+        case CMD_ERASE_64K:
+            if (flash->write_enabled && has_address)
+            {
+                erase(flash, (CMD_ERASE_4K == flash->opcode) ? 0x1000u :
+                             (CMD_ERASE_32K == flash->opcode) ? 0x8000u :
+                                                                 0x10000u);
+            }
+            else
+            {
+                ++flash->errors;
+            }
+            flash->write_enabled = 0u;
+            break;
+
+        case CMD_CHIP_ERASE:
+        case CMD_CHIP_ERASE_ALT:
+            if (flash->write_enabled)
+            {
+                erase(flash, flash->size);
+            }
+            else
+            {
+                ++flash->errors;
+            }
+            flash->write_enabled = 0u;
+            break;
+
+        case CMD_WRITE_STATUS:
+        case CMD_PROTECT_SECTOR:
+        case CMD_UNPROTECT_SECTOR:
+            flash->write_enabled = 0u;
+            break;
+
+        case CMD_RESET:
+            flash->write_enabled = 0u;
+            flash->busy = 0u;
+            break;
+
+        default:
+            break;
+    }
+}
+
+void sim_spi_flash_init(sim_spi_flash_t * flash,
+                        uint8_t * memory,
+                        uint32_t size)
+{
+    memset(flash, 0, sizeof(sim_spi_flash_t));
+
+    flash->memory = memory;
+    flash->size = size;
+    memset(memory, 0xFF, size);
+
+    /* Micron MT25QL01G */
+    flash->id[0] = 0x20u;
+    flash->id[1] = 0xBAu;
+    flash->id[2] = 0x21u;
+
+    flash->program_polls = 4u;
+    flash->erase_polls = 64u;
+
+    flash->slave.ctx = flash;
+    flash->slave.select = flash_select;
+    flash->slave.transfer = flash_transfer;
+    flash->slave.deselect = flash_deselect;
+}
@@ -0,0 +1,161 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file miv_rv32_arith.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Integer multiply and divide for Mi-V soft processors without the M
+ * extension.
+ *
+ * Without the M extension, GCC calls the libgcc functions __mulsi3, __udivsi3,
+ * __udivdi3 and so on for the multiplications and divisions which it cannot
+ * turn into shifts and additions. miv_rv32_arith.S implements these functions
+ * in fewer cycles, see the top of that file. They can be called by name, or
+ * replace the libgcc functions for the whole image, by adding these options to
+ * the linker flags of an RV32I build configuration:
+ *
+ *      -Wl,--wrap=__mulsi3 -Wl,--wrap=__udivsi3 -Wl,--wrap=__umodsi3
+ *      -Wl,--wrap=__divsi3 -Wl,--wrap=__modsi3
+ *      -Wl,--wrap=__udivdi3 -Wl,--wrap=__umoddi3
+ *
+ * With the M extension, the compiler uses the mul and div instructions and
+ * only calls the 64-bit divisions.
+ *
+ * A division by a constant, such as the conversions between ticks, cycles and
+ * microseconds, costs a full __udivsi3 call on RV32I, because GCC only replaces
+ * it with a multiplication by the reciprocal when it has a multiply
+ * instruction. miv_udiv_const() and miv_umod_const() do that replacement with
+ * the multiplications by the constant parts of the reciprocal, which GCC turns
+ * into shifts and additions:
+ *
+ *      us = miv_udiv_const(cycles, SYS_CLK_FREQ / 1000000u);
+ *      digit = miv_umod_const(value, 10u);
+ */
+#ifndef MIV_RV32_ARITH_H_
+#define MIV_RV32_ARITH_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MIV_ARITH_INLINE    static inline __attribute__((always_inline))
+
+/***************************************************************************//**
+ * miv_mulsi3() returns a * b.
+ */
+uint32_t miv_mulsi3(uint32_t a, uint32_t b);
+
+/***************************************************************************//**
+ * miv_udivsi3() and miv_umodsi3() return n / d and n % d. For d equal to 0
+ * they return 0xFFFFFFFF and n.
+ */
+uint32_t miv_udivsi3(uint32_t n, uint32_t d);
+uint32_t miv_umodsi3(uint32_t n, uint32_t d);
+
+/***************************************************************************//**
+ * miv_divsi3() and miv_modsi3() return n / d and n % d, rounded toward zero as
+ * in C. For d equal to 0 they return -1, or 1 for a negative n, and n. For
+ * INT32_MIN / -1 they return INT32_MIN and 0.
+ */
+int32_t miv_divsi3(int32_t n, int32_t d);
+int32_t miv_modsi3(int32_t n, int32_t d);
+
+/***************************************************************************//**
+ * miv_udivdi3() and miv_umoddi3() return n / d and n % d. For d equal to 0
+ * they return 0xFFFFFFFFFFFFFFFF and n.
+ */
+uint64_t miv_udivdi3(uint64_t n, uint64_t d);
+uint64_t miv_umoddi3(uint64_t n, uint64_t d);
+
+/***************************************************************************//**
+ * miv_mulhu() returns the high 32 bits of the 64-bit product n * m, from four
+ * 16 x 16 bit products. When m is a constant, they are multiplications by
+ * constants.
+ */
+MIV_ARITH_INLINE uint32_t
+miv_mulhu
+(
+    uint32_t n,
+    uint32_t m
+)
+{
+    const uint32_t n_lo = n & 0xFFFFu;
+    const uint32_t n_hi = n >> 16;
+    const uint32_t m_lo = m & 0xFFFFu;
+    const uint32_t m_hi = m >> 16;
+    uint32_t low;
+    uint32_t mid1;
+    uint32_t mid2;
+
+    low = n_lo * m_lo;
+    mid1 = (n_hi * m_lo) + (low >> 16);
+    mid2 = (n_lo * m_hi) + (mid1 & 0xFFFFu);
+
+    return (n_hi * m_hi) + (mid1 >> 16) + (mid2 >> 16);
+}
+
+/***************************************************************************//**
+ * miv_udiv_const() returns n / d for a compile time constant d, different from
+ * 0, for all values of n.
+ *
+ * For d a power of two, it is a shift. Otherwise, with l = ceil(log2(d)) and
+ * m = floor(2^32 * (2^l - d) / d) + 1, all computed by the compiler:
+ *
+ *      t = mulhu(n, m)
+ *      n / d = (t + ((n - t) >> 1)) >> (l - 1)
+ *
+ * When d is not a constant, when the function is not optimized, or when the M
+ * extension is present, it returns n / d.
+ */
+MIV_ARITH_INLINE uint32_t
+miv_udiv_const
+(
+    uint32_t n,
+    uint32_t d
+)
+{
+#ifndef __riscv_div
+    if (__builtin_constant_p(d) && (0u != d))
+    {
+        uint32_t shift;
+        uint32_t m;
+        uint32_t t;
+
+        if (0u == (d & (d - 1u)))
+        {
+            return n >> __builtin_ctz(d);
+        }
+
+        shift = 32u - (uint32_t)__builtin_clz(d - 1u);
+        m = (uint32_t)((((uint64_t)((1ULL << shift) - d) << 32) / d) + 1u);
+        t = miv_mulhu(n, m);
+
+        return (t + ((n - t) >> 1)) >> (shift - 1u);
+    }
+#endif
+
+    return n / d;
+}
+
+/***************************************************************************//**
+ * miv_umod_const() returns n % d for a compile time constant d, different from
+ * 0, with miv_udiv_const().
+ */
+MIV_ARITH_INLINE uint32_t
+miv_umod_const
+(
+    uint32_t n,
+    uint32_t d
+)
+{
+    return n - (miv_udiv_const(n, d) * d);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MIV_RV32_ARITH_H_ */
@@ -0,0 +1,56 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file miv_rv32_string.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief memcpy(), memset() and memcmp() for the Mi-V soft processors.
+ *
+ * miv_rv32_string.S implements the three functions for the Mi-V pipeline:
+ * word moves, four per loop iteration, with byte heads and tails, and no
+ * misaligned access. They can be called by name, or replace the newlib
+ * functions for the whole image, the drivers and newlib itself included, by
+ * adding these options to the linker flags of the build configuration:
+ *
+ *      -Wl,--wrap=memcpy -Wl,--wrap=memset -Wl,--wrap=memcmp
+ *
+ * The linker then resolves memcpy to __wrap_memcpy, another name of
+ * miv_memcpy, and so on. Without the options, and with --gc-sections, the
+ * functions which are not called by name are left out of the image.
+ *
+ * Calls which the compiler expands inline, such as a memcpy() of a small
+ * constant size, are not affected.
+ */
+#ifndef MIV_RV32_STRING_H_
+#define MIV_RV32_STRING_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************//**
+ * miv_memcpy() copies n bytes from src to dest, which must not overlap, and
+ * returns dest, as memcpy() does.
+ */
+void * miv_memcpy(void * dest, const void * src, size_t n);
+
+/***************************************************************************//**
+ * miv_memset() sets n bytes at dest to (unsigned char)c and returns dest, as
+ * memset() does.
+ */
+void * miv_memset(void * dest, int c, size_t n);
+
+/***************************************************************************//**
+ * miv_memcmp() compares n bytes at s1 and s2, as memcmp() does. It returns the
+ * difference between the first two bytes which differ, as unsigned char, or 0.
+ */
+int miv_memcmp(const void * s1, const void * s2, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MIV_RV32_STRING_H_ */
@@ -117,6 +117,14 @@
 #define configGENERATE_RUN_TIME_STATS	0
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION 1
 
+/* Heap regions (heap_regions.c).  The size of each region is set in the linker
+script; configTOTAL_HEAP_SIZE above is only used by the single region heaps.
+Task stacks are taken from LSRAM.  Use REGION_FAST to take them from the TCM
+when the design has one and FAST_HEAP_SIZE is set in the linker script. */
+#define configSTACK_ALLOCATION_FROM_SEPARATE_HEAP	1
+#define configHEAP_DEFAULT_REGION		REGION_BULK
+#define configHEAP_STACK_REGION			REGION_BULK
+
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES 			0
 #define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
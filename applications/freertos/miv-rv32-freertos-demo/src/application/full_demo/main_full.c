@@ -52,6 +52,14 @@
  * containing an unexpected value is indicative of an error in the context
  * switching mechanism.
  *
+ * "I2C EEPROM" task - Only built for the MIV_RV32 designs, whose MIV_ESS has an
+ * MIV_I2C.  Once a second, the task reads the first bytes of the I2C EEPROM
+ * at address mainI2C_EEPROM_ADDRESS through the miv_i2c_rtos middleware, which
+ * blocks the task while the MIV_I2C interrupt performs the transaction.  The
+ * first read is kept as a reference, and every later read must return the same
+ * bytes.  Nothing is written, so an image stored in the EEPROM for the
+ * Bootstrap of the bootloader is left untouched.
+ *
  * "Check" task - The check executes every three seconds.  It checks that all
  * the standard demo tasks, and the register check tasks, are not only still
  * executing, but are executing without reporting any errors.  If the check task
@@ -73,6 +81,9 @@
 #include "drivers/fpga_ip/CoreTimer/core_timer.h"
 #include "miv_rv32_hal/miv_rv32_hal.h"
 #include "hal/hal.h"
+#ifndef MIV_LEGACY_RV32
+#include "miv_i2c_rtos/miv_i2c_rtos.h"
+#endif /* MIV_LEGACY_RV32 */
 
 /* Standard demo application includes. */
 #include "dynamic.h"
@@ -114,6 +125,17 @@ comments at the top of this file. */
 /* Size of the stacks to allocated for the register check tasks. */
 #define mainREG_TEST_STACK_SIZE_WORDS 300
 
+/* The I2C EEPROM task.  The EEPROM has a two byte memory address, 24LC256 for
+example.  mainI2C_PRESCALE sets the MIV_I2C clock to 100kHz, see
+MIV_I2C_config(). */
+#define mainI2C_EEPROM_TASK_PRIORITY		( tskIDLE_PRIORITY + 1UL )
+#define mainI2C_EEPROM_STACK_SIZE_WORDS		configMINIMAL_STACK_SIZE
+#define mainI2C_EEPROM_ADDRESS				( 0x50U )
+#define mainI2C_EEPROM_READ_SIZE			( 16U )
+#define mainI2C_EEPROM_READ_PERIOD			pdMS_TO_TICKS( 1000UL )
+#define mainI2C_EEPROM_TIMEOUT_MS			( 100UL )
+#define mainI2C_PRESCALE					( ( SYS_CLK_FREQ / ( 5UL * 100000UL ) ) - 1UL )
+
 /* Maintain compatibility accross all designs */
 #ifndef CORETIMER0_BASE_ADDR
 #define CORETIMER0_BASE_ADDR    MIV_ESS_APBSLOT3_BASE_ADDR
@@ -153,6 +175,15 @@ extern void vRegTest1Implementation( void );
 static void prvRegTestTaskEntry2( void *pvParameters );
 extern void vRegTest2Implementation( void );
 
+#ifndef MIV_LEGACY_RV32
+/*
+ * Initialise the MIV_I2C and create the I2C EEPROM task described at the top
+ * of this file.
+ */
+static void prvSetupI2CEeprom( void );
+static void prvI2CEepromTask( void *pvParameters );
+#endif /* MIV_LEGACY_RV32 */
+
 /*
  * Tick hook used by the full demo, which includes code that interacts with
  * some of the tests.
@@ -174,6 +205,17 @@ then the register check tasks have not discovered any errors.  If a variable
 stops incrementing, then an error has been found. */
 volatile uint32_t ulRegTest1LoopCounter = 0UL, ulRegTest2LoopCounter = 0UL;
 
+#ifndef MIV_LEGACY_RV32
+/* The MIV_I2C of the MIV_ESS, shared through the miv_i2c_rtos middleware. */
+static miv_i2c_instance_t g_miv_i2c_inst;
+static miv_i2c_rtos_t xI2CBus;
+
+/* Incremented by the I2C EEPROM task after each read that returned the
+reference bytes.  If the variable stops incrementing, then an error has been
+found. */
+volatile uint32_t ulI2CEepromLoopCounter = 0UL;
+#endif /* MIV_LEGACY_RV32 */
+
 /*-----------------------------------------------------------*/
 
 void main_full( void )
@@ -214,6 +256,12 @@ void main_full( void )
 	running. */
 	vCreateSuicidalTasks( mainCREATOR_TASK_PRIORITY );
 
+	#ifndef MIV_LEGACY_RV32
+	/* Create the task that reads the I2C EEPROM, as described at the top of
+	this file. */
+	prvSetupI2CEeprom();
+	#endif /* MIV_LEGACY_RV32 */
+
 	/* Start the timers that are used to exercise external interrupt handling. */
 	prvSetupPeripheralTimers();
 
@@ -237,6 +285,9 @@ TickType_t xDelayPeriod = mainNO_ERROR_CHECK_TASK_PERIOD;
 TickType_t xLastExecutionTime;
 uint32_t ulLastRegTest1Value = 0, ulLastRegTest2Value = 0;
 uint32_t ulLastTimer0Interrupts = 0, ulLastTimer1Interrupts = 0;
+#ifndef MIV_LEGACY_RV32
+uint32_t ulLastI2CEepromValue = 0;
+#endif /* MIV_LEGACY_RV32 */
 char * const pcPassMessage = ".";
 char * pcStatusMessage = pcPassMessage;
 extern void vToggleLED( void );
@@ -353,6 +404,16 @@ extern void vToggleLED( void );
 		}
 		ulLastTimer1Interrupts = ulTimer1Interrupts;
 
+		#ifndef MIV_LEGACY_RV32
+		/* Check that the I2C EEPROM task is still reading the reference
+		bytes. */
+		if( ulLastI2CEepromValue == ulI2CEepromLoopCounter )
+		{
+			pcStatusMessage = "ERROR: I2C EEPROM.\r\n";
+		}
+		ulLastI2CEepromValue = ulI2CEepromLoopCounter;
+		#endif /* MIV_LEGACY_RV32 */
+
 		/* Write the status message to the UART. */
 		vSendString( pcStatusMessage );
 		vToggleLED();
@@ -403,6 +464,72 @@ static void prvRegTestTaskEntry2( void *pvParameters )
 }
 /*-----------------------------------------------------------*/
 
+#ifndef MIV_LEGACY_RV32
+static void prvSetupI2CEeprom( void )
+{
+	MIV_I2C_init( &g_miv_i2c_inst, MIV_ESS_I2C_BASE_ADDR );
+	MIV_I2C_config( &g_miv_i2c_inst, mainI2C_PRESCALE );
+
+	/* If the mutex of the bus cannot be created the task is not created
+	either, and the check task reports the error. */
+	if( miv_i2c_rtos_init( &xI2CBus, &g_miv_i2c_inst ) == MIV_I2C_SUCCESS )
+	{
+		xTaskCreate( prvI2CEepromTask, "I2C", mainI2C_EEPROM_STACK_SIZE_WORDS, NULL, mainI2C_EEPROM_TASK_PRIORITY, NULL );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvI2CEepromTask( void *pvParameters )
+{
+const uint8_t ucMemoryAddress[ 2 ] = { 0U, 0U };
+uint8_t ucReference[ mainI2C_EEPROM_READ_SIZE ];
+/* The driver stores the byte received while the EEPROM acknowledges its
+address one location before the read buffer, so ucRead[ 0 ] is spare. */
+uint8_t ucRead[ mainI2C_EEPROM_READ_SIZE + 1U ];
+BaseType_t xHaveReference = pdFALSE;
+TickType_t xLastExecutionTime;
+miv_i2c_status_t xStatus;
+
+	( void ) pvParameters;
+
+	xLastExecutionTime = xTaskGetTickCount();
+
+	for( ;; )
+	{
+		vTaskDelayUntil( &xLastExecutionTime, mainI2C_EEPROM_READ_PERIOD );
+
+		/* Write the memory address then read from it after a repeated START.
+		The task blocks until the MIV_I2C interrupt has done the transaction. */
+		xStatus = MIV_I2C_transfer_blocking( &xI2CBus,
+											 mainI2C_EEPROM_ADDRESS,
+											 ucMemoryAddress,
+											 sizeof( ucMemoryAddress ),
+											 &ucRead[ 1 ],
+											 mainI2C_EEPROM_READ_SIZE,
+											 MIV_I2C_ACK_POLLING_DISABLE,
+											 mainI2C_EEPROM_TIMEOUT_MS );
+
+		if( xStatus == MIV_I2C_SUCCESS )
+		{
+			if( xHaveReference == pdFALSE )
+			{
+				memcpy( ucReference, &ucRead[ 1 ], sizeof( ucReference ) );
+				xHaveReference = pdTRUE;
+				ulI2CEepromLoopCounter++;
+			}
+			else if( memcmp( ucReference, &ucRead[ 1 ], sizeof( ucReference ) ) == 0 )
+			{
+				ulI2CEepromLoopCounter++;
+			}
+		}
+
+		/* A failed read leaves the counter unchanged for the check task to
+		report. */
+	}
+}
+/*-----------------------------------------------------------*/
+#endif /* MIV_LEGACY_RV32 */
+
 void vFullDemoTickHook( void )
 {
 	/* The full demo includes a software timer demo/test that requires
@@ -508,4 +635,10 @@ uint8_t External_IRQHandler( void )
 
     return( EXT_IRQ_KEEP_ENABLED );
 }
+
+/*MIV_I2C Interrupt Handler for MIV_RV32 core*/
+void MSYS_EI2_IRQHandler( void )
+{
+    MIV_I2C_isr( &g_miv_i2c_inst );
+}
 #endif /* MIV_LEGACY_RV32 */
@@ -145,11 +145,10 @@ void vApplicationMallocFailedHook( void )
 	function that will get called if a call to pvPortMalloc() fails.
 	pvPortMalloc() is called internally by the kernel whenever a task, queue,
 	timer or semaphore is created.  It is also called by various parts of the
-	demo application.  If heap_1.c or heap_2.c are used, then the size of the
-	heap available to pvPortMalloc() is defined by configTOTAL_HEAP_SIZE in
-	FreeRTOSConfig.h, and the xPortGetFreeHeapSize() API function can be used
-	to query the size of free heap space that remains (although it does not
-	provide information on how the remaining heap might be fragmented). */
+	demo application.  This demo uses heap_regions.c, so the size of each heap
+	region available to pvPortMalloc() is defined in the linker script, and the
+	xPortGetRegionFreeHeapSize() and vPortGetRegionHeapStats() API functions can
+	be used to query the free heap space that remains in each region. */
 	taskDISABLE_INTERRUPTS();
 	__asm volatile( "ebreak" );
 	for( ;; );
@@ -0,0 +1,712 @@
+/*
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Derived from heap_4.c/heap_5.c:
+ * FreeRTOS Kernel V10.4.4
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ */
+
+/*
+ * A multi-region implementation of pvPortMalloc() and vPortFree().
+ *
+ * Like heap_5.c the heap spans several non-contiguous blocks of RAM, but each
+ * block is kept as a separate region with its own free list and statistics so
+ * the application can choose where an allocation is placed, e.g.
+ *
+ *      pucBuffer = pvPortMallocIn( REGION_FAST, 512 );
+ *
+ * The regions are taken from the linker script (see heap_regions.h) rather than
+ * from a vPortDefineHeapRegions() call, so no heap space is reserved in .bss
+ * and configTOTAL_HEAP_SIZE is not used.
+ *
+ * pvPortMalloc() allocates from configHEAP_DEFAULT_REGION and falls back to the
+ * remaining regions in order.  Freed blocks are coalesced in the same way as
+ * heap_4.c.  Use this file instead of, not in addition to, heap_4.c.
+ */
+#include <stdlib.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+ * all the API functions to use the MPU wrappers.  That should only be done when
+ * task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "heap_regions.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if ( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+    #error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+/* Block sizes must not get too small. */
+#define heapMINIMUM_BLOCK_SIZE    ( ( size_t ) ( xHeapStructSize << 1 ) )
+
+/* Assumes 8bit bytes! */
+#define heapBITS_PER_BYTE         ( ( size_t ) 8 )
+
+/* The top bit of xBlockSize is set while a block is owned by the application. */
+#define heapBLOCK_ALLOCATED_BIT   ( ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * heapBITS_PER_BYTE ) - 1 ) )
+
+/* Region boundaries provided by the linker script. */
+extern uint8_t __heap_fast_start[], __heap_fast_end[];
+extern uint8_t __heap_bulk_start[], __heap_bulk_end[];
+extern uint8_t __heap_dma_start[], __heap_dma_end[];
+
+/* Define the linked list structure.  This is used to link free blocks in order
+ * of their memory address. */
+typedef struct A_BLOCK_LINK
+{
+    struct A_BLOCK_LINK * pxNextFreeBlock; /*<< The next free block in the list. */
+    size_t xBlockSize;                     /*<< The size of the free block. */
+} BlockLink_t;
+
+/* Per region state.  Each region is a heap_4 style heap in its own right. */
+typedef struct HEAP_REGION_STATE
+{
+    uint8_t * pucStart;                     /*<< First byte of the region (aligned). */
+    uint8_t * pucEnd;                       /*<< One past the last usable byte. */
+    BlockLink_t xStart;                     /*<< Head of the free list. */
+    BlockLink_t * pxEnd;                    /*<< End marker, NULL if the region is empty. */
+    size_t xTotalBytes;
+    size_t xFreeBytesRemaining;
+    size_t xMinimumEverFreeBytesRemaining;
+    size_t xNumberOfSuccessfulAllocations;
+    size_t xNumberOfSuccessfulFrees;
+} HeapRegionState_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Inserts a block of memory that is being freed into the correct position in
+ * the free list of its region, merging it with adjacent free blocks.
+ */
+static void prvInsertBlockIntoFreeList( HeapRegionState_t * pxRegion,
+                                        BlockLink_t * pxBlockToInsert ) PRIVILEGED_FUNCTION;
+
+/*
+ * Called automatically to setup the regions the first time the heap is used.
+ */
+static void prvHeapInit( void ) PRIVILEGED_FUNCTION;
+
+/*
+ * Allocate from a single region.  Must be called with the scheduler suspended.
+ */
+static void * prvAllocateFromRegion( HeapRegionState_t * pxRegion,
+                                     size_t xWantedSize ) PRIVILEGED_FUNCTION;
+
+/*
+ * Adds the header and alignment padding to a requested size.  Returns 0 if the
+ * request cannot be satisfied by any region.
+ */
+static size_t prvAdjustWantedSize( size_t xWantedSize ) PRIVILEGED_FUNCTION;
+
+/*
+ * Returns the region that contains pv, or NULL.
+ */
+static HeapRegionState_t * prvFindRegion( const void * pv ) PRIVILEGED_FUNCTION;
+
+static void prvMallocFailed( void * pvReturn );
+
+/*-----------------------------------------------------------*/
+
+/* The size of the structure placed at the beginning of each allocated memory
+ * block must by correctly byte aligned. */
+static const size_t xHeapStructSize = ( sizeof( BlockLink_t ) + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+PRIVILEGED_DATA static HeapRegionState_t xRegions[ heapNUM_REGIONS ];
+PRIVILEGED_DATA static BaseType_t xHeapInitialised = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+void * pvPortMallocIn( HeapRegionId_t xRegion,
+                       size_t xWantedSize )
+{
+    void * pvReturn = NULL;
+
+    configASSERT( xRegion < heapNUM_REGIONS );
+
+    vTaskSuspendAll();
+    {
+        if( xHeapInitialised == pdFALSE )
+        {
+            prvHeapInit();
+        }
+
+        xWantedSize = prvAdjustWantedSize( xWantedSize );
+
+        if( ( xWantedSize > 0 ) && ( xRegion < heapNUM_REGIONS ) )
+        {
+            pvReturn = prvAllocateFromRegion( &xRegions[ xRegion ], xWantedSize );
+        }
+
+        traceMALLOC( pvReturn, xWantedSize );
+    }
+    ( void ) xTaskResumeAll();
+
+    /* The malloc failed hook is not called here, the caller is expected to
+     * handle a full region, for example by retrying with pvPortMalloc(). */
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortMalloc( size_t xWantedSize )
+{
+    void * pvReturn = NULL;
+    BaseType_t x;
+
+    vTaskSuspendAll();
+    {
+        if( xHeapInitialised == pdFALSE )
+        {
+            prvHeapInit();
+        }
+
+        xWantedSize = prvAdjustWantedSize( xWantedSize );
+
+        if( xWantedSize > 0 )
+        {
+            pvReturn = prvAllocateFromRegion( &xRegions[ configHEAP_DEFAULT_REGION ], xWantedSize );
+
+            for( x = 0; ( x < ( BaseType_t ) heapNUM_REGIONS ) && ( pvReturn == NULL ); x++ )
+            {
+                if( x != ( BaseType_t ) configHEAP_DEFAULT_REGION )
+                {
+                    pvReturn = prvAllocateFromRegion( &xRegions[ x ], xWantedSize );
+                }
+            }
+        }
+
+        traceMALLOC( pvReturn, xWantedSize );
+    }
+    ( void ) xTaskResumeAll();
+
+    prvMallocFailed( pvReturn );
+
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+#if ( configSTACK_ALLOCATION_FROM_SEPARATE_HEAP == 1 )
+
+    void * pvPortMallocStack( size_t xSize )
+    {
+        void * pvReturn;
+
+        /* Prefer the stack region, but a task that does not fit there is
+         * better than a task that cannot be created at all. */
+        vTaskSuspendAll();
+        {
+            if( xHeapInitialised == pdFALSE )
+            {
+                prvHeapInit();
+            }
+
+            pvReturn = prvAllocateFromRegion( &xRegions[ configHEAP_STACK_REGION ], prvAdjustWantedSize( xSize ) );
+        }
+        ( void ) xTaskResumeAll();
+
+        if( pvReturn == NULL )
+        {
+            pvReturn = pvPortMalloc( xSize );
+        }
+
+        return pvReturn;
+    }
+    /*-----------------------------------------------------------*/
+
+    void vPortFreeStack( void * pv )
+    {
+        vPortFree( pv );
+    }
+    /*-----------------------------------------------------------*/
+
+#endif /* configSTACK_ALLOCATION_FROM_SEPARATE_HEAP */
+
+void vPortFree( void * pv )
+{
+    uint8_t * puc = ( uint8_t * ) pv;
+    BlockLink_t * pxLink;
+    HeapRegionState_t * pxRegion;
+
+    if( pv != NULL )
+    {
+        /* The memory being freed will have an BlockLink_t structure immediately
+         * before it. */
+        puc -= xHeapStructSize;
+
+        /* This casting is to keep the compiler from issuing warnings. */
+        pxLink = ( void * ) puc;
+        pxRegion = prvFindRegion( puc );
+
+        /* Check the block is actually allocated and belongs to a region. */
+        configASSERT( pxRegion != NULL );
+        configASSERT( ( pxLink->xBlockSize & heapBLOCK_ALLOCATED_BIT ) != 0 );
+        configASSERT( pxLink->pxNextFreeBlock == NULL );
+
+        if( ( pxRegion != NULL ) &&
+            ( ( pxLink->xBlockSize & heapBLOCK_ALLOCATED_BIT ) != 0 ) &&
+            ( pxLink->pxNextFreeBlock == NULL ) )
+        {
+            /* The block is being returned to the heap - it is no longer
+             * allocated. */
+            pxLink->xBlockSize &= ~heapBLOCK_ALLOCATED_BIT;
+
+            vTaskSuspendAll();
+            {
+                /* Add this block to the list of free blocks. */
+                pxRegion->xFreeBytesRemaining += pxLink->xBlockSize;
+                traceFREE( pv, pxLink->xBlockSize );
+                prvInsertBlockIntoFreeList( pxRegion, pxLink );
+                pxRegion->xNumberOfSuccessfulFrees++;
+            }
+            ( void ) xTaskResumeAll();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+    size_t xTotal = 0;
+    BaseType_t x;
+
+    for( x = 0; x < ( BaseType_t ) heapNUM_REGIONS; x++ )
+    {
+        xTotal += xRegions[ x ].xFreeBytesRemaining;
+    }
+
+    return xTotal;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+    size_t xTotal = 0;
+    BaseType_t x;
+
+    /* The regions reach their low water marks independently, so this is a
+     * lower bound rather than an exact figure. */
+    for( x = 0; x < ( BaseType_t ) heapNUM_REGIONS; x++ )
+    {
+        xTotal += xRegions[ x ].xMinimumEverFreeBytesRemaining;
+    }
+
+    return xTotal;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetRegionHeapSize( HeapRegionId_t xRegion )
+{
+    configASSERT( xRegion < heapNUM_REGIONS );
+
+    return ( xRegion < heapNUM_REGIONS ) ? xRegions[ xRegion ].xTotalBytes : 0U;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetRegionFreeHeapSize( HeapRegionId_t xRegion )
+{
+    configASSERT( xRegion < heapNUM_REGIONS );
+
+    return ( xRegion < heapNUM_REGIONS ) ? xRegions[ xRegion ].xFreeBytesRemaining : 0U;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetRegionMinimumEverFreeHeapSize( HeapRegionId_t xRegion )
+{
+    configASSERT( xRegion < heapNUM_REGIONS );
+
+    return ( xRegion < heapNUM_REGIONS ) ? xRegions[ xRegion ].xMinimumEverFreeBytesRemaining : 0U;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+    /* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetRegionHeapStats( HeapRegionId_t xRegion,
+                              HeapStats_t * pxHeapStats )
+{
+    BlockLink_t * pxBlock;
+    HeapRegionState_t * pxRegion;
+    size_t xBlocks = 0, xMaxSize = 0, xMinSize = portMAX_DELAY; /* portMAX_DELAY used as a portable way of getting the maximum value. */
+
+    configASSERT( xRegion < heapNUM_REGIONS );
+    pxRegion = &xRegions[ xRegion ];
+
+    vTaskSuspendAll();
+    {
+        pxBlock = pxRegion->xStart.pxNextFreeBlock;
+
+        /* pxBlock will be NULL if the heap has not been initialised or the
+         * region is not present in the design. */
+        if( pxBlock != NULL )
+        {
+            while( pxBlock != pxRegion->pxEnd )
+            {
+                xBlocks++;
+
+                if( pxBlock->xBlockSize > xMaxSize )
+                {
+                    xMaxSize = pxBlock->xBlockSize;
+                }
+
+                if( pxBlock->xBlockSize < xMinSize )
+                {
+                    xMinSize = pxBlock->xBlockSize;
+                }
+
+                pxBlock = pxBlock->pxNextFreeBlock;
+            }
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    if( xBlocks == 0 )
+    {
+        xMinSize = 0;
+    }
+
+    pxHeapStats->xSizeOfLargestFreeBlockInBytes = xMaxSize;
+    pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xMinSize;
+    pxHeapStats->xNumberOfFreeBlocks = xBlocks;
+
+    taskENTER_CRITICAL();
+    {
+        pxHeapStats->xAvailableHeapSpaceInBytes = pxRegion->xFreeBytesRemaining;
+        pxHeapStats->xNumberOfSuccessfulAllocations = pxRegion->xNumberOfSuccessfulAllocations;
+        pxHeapStats->xNumberOfSuccessfulFrees = pxRegion->xNumberOfSuccessfulFrees;
+        pxHeapStats->xMinimumEverFreeBytesRemaining = pxRegion->xMinimumEverFreeBytesRemaining;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t * pxHeapStats )
+{
+    HeapStats_t xRegionStats;
+    BaseType_t x;
+
+    pxHeapStats->xAvailableHeapSpaceInBytes = 0;
+    pxHeapStats->xSizeOfLargestFreeBlockInBytes = 0;
+    pxHeapStats->xSizeOfSmallestFreeBlockInBytes = portMAX_DELAY;
+    pxHeapStats->xNumberOfFreeBlocks = 0;
+    pxHeapStats->xMinimumEverFreeBytesRemaining = 0;
+    pxHeapStats->xNumberOfSuccessfulAllocations = 0;
+    pxHeapStats->xNumberOfSuccessfulFrees = 0;
+
+    for( x = 0; x < ( BaseType_t ) heapNUM_REGIONS; x++ )
+    {
+        vPortGetRegionHeapStats( ( HeapRegionId_t ) x, &xRegionStats );
+
+        if( xRegionStats.xSizeOfLargestFreeBlockInBytes > pxHeapStats->xSizeOfLargestFreeBlockInBytes )
+        {
+            pxHeapStats->xSizeOfLargestFreeBlockInBytes = xRegionStats.xSizeOfLargestFreeBlockInBytes;
+        }
+
+        if( ( xRegionStats.xNumberOfFreeBlocks > 0 ) &&
+            ( xRegionStats.xSizeOfSmallestFreeBlockInBytes < pxHeapStats->xSizeOfSmallestFreeBlockInBytes ) )
+        {
+            pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xRegionStats.xSizeOfSmallestFreeBlockInBytes;
+        }
+
+        pxHeapStats->xAvailableHeapSpaceInBytes += xRegionStats.xAvailableHeapSpaceInBytes;
+        pxHeapStats->xNumberOfFreeBlocks += xRegionStats.xNumberOfFreeBlocks;
+        pxHeapStats->xMinimumEverFreeBytesRemaining += xRegionStats.xMinimumEverFreeBytesRemaining;
+        pxHeapStats->xNumberOfSuccessfulAllocations += xRegionStats.xNumberOfSuccessfulAllocations;
+        pxHeapStats->xNumberOfSuccessfulFrees += xRegionStats.xNumberOfSuccessfulFrees;
+    }
+
+    if( pxHeapStats->xNumberOfFreeBlocks == 0 )
+    {
+        pxHeapStats->xSizeOfSmallestFreeBlockInBytes = 0;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvAdjustWantedSize( size_t xWantedSize ) /* PRIVILEGED_FUNCTION */
+{
+    /* Check the requested block size is not so large that the top bit is set.
+     * The top bit of the block size member of the BlockLink_t structure is used
+     * to determine who owns the block - the application or the kernel. */
+    if( ( xWantedSize == 0 ) || ( ( xWantedSize & heapBLOCK_ALLOCATED_BIT ) != 0 ) )
+    {
+        return 0;
+    }
+
+    /* The wanted size must be increased so it can contain a BlockLink_t
+     * structure in addition to the requested amount of bytes. */
+    if( ( xWantedSize + xHeapStructSize ) <= xWantedSize )
+    {
+        return 0;
+    }
+
+    xWantedSize += xHeapStructSize;
+
+    /* Ensure that blocks are always aligned. */
+    if( ( xWantedSize & portBYTE_ALIGNMENT_MASK ) != 0x00 )
+    {
+        if( ( xWantedSize + ( portBYTE_ALIGNMENT - ( xWantedSize & portBYTE_ALIGNMENT_MASK ) ) ) <= xWantedSize )
+        {
+            return 0;
+        }
+
+        xWantedSize += ( portBYTE_ALIGNMENT - ( xWantedSize & portBYTE_ALIGNMENT_MASK ) );
+        configASSERT( ( xWantedSize & portBYTE_ALIGNMENT_MASK ) == 0 );
+    }
+
+    return xWantedSize;
+}
+/*-----------------------------------------------------------*/
+
+static void * prvAllocateFromRegion( HeapRegionState_t * pxRegion,
+                                     size_t xWantedSize ) /* PRIVILEGED_FUNCTION */
+{
+    BlockLink_t * pxBlock, * pxPreviousBlock, * pxNewBlockLink;
+    void * pvReturn = NULL;
+
+    if( ( pxRegion->pxEnd == NULL ) || ( xWantedSize == 0 ) || ( xWantedSize > pxRegion->xFreeBytesRemaining ) )
+    {
+        return NULL;
+    }
+
+    /* Traverse the list from the start (lowest address) block until one of
+     * adequate size is found. */
+    pxPreviousBlock = &pxRegion->xStart;
+    pxBlock = pxRegion->xStart.pxNextFreeBlock;
+
+    while( ( pxBlock->xBlockSize < xWantedSize ) && ( pxBlock->pxNextFreeBlock != NULL ) )
+    {
+        pxPreviousBlock = pxBlock;
+        pxBlock = pxBlock->pxNextFreeBlock;
+    }
+
+    /* If the end marker was reached then a block of adequate size was not
+     * found. */
+    if( pxBlock != pxRegion->pxEnd )
+    {
+        /* Return the memory space pointed to - jumping over the BlockLink_t
+         * structure at its start. */
+        pvReturn = ( void * ) ( ( ( uint8_t * ) pxPreviousBlock->pxNextFreeBlock ) + xHeapStructSize );
+
+        /* This block is being returned for use so must be taken out of the
+         * list of free blocks. */
+        pxPreviousBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+
+        /* If the block is larger than required it can be split into two. */
+        if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+        {
+            pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+            configASSERT( ( ( ( size_t ) pxNewBlockLink ) & portBYTE_ALIGNMENT_MASK ) == 0 );
+
+            pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+            pxBlock->xBlockSize = xWantedSize;
+
+            prvInsertBlockIntoFreeList( pxRegion, pxNewBlockLink );
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        pxRegion->xFreeBytesRemaining -= pxBlock->xBlockSize;
+
+        if( pxRegion->xFreeBytesRemaining < pxRegion->xMinimumEverFreeBytesRemaining )
+        {
+            pxRegion->xMinimumEverFreeBytesRemaining = pxRegion->xFreeBytesRemaining;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        /* The block is being returned - it is allocated and owned by the
+         * application and has no "next" block. */
+        pxBlock->xBlockSize |= heapBLOCK_ALLOCATED_BIT;
+        pxBlock->pxNextFreeBlock = NULL;
+        pxRegion->xNumberOfSuccessfulAllocations++;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    configASSERT( ( ( ( size_t ) pvReturn ) & ( size_t ) portBYTE_ALIGNMENT_MASK ) == 0 );
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+static HeapRegionState_t * prvFindRegion( const void * pv ) /* PRIVILEGED_FUNCTION */
+{
+    const uint8_t * puc = ( const uint8_t * ) pv;
+    BaseType_t x;
+
+    for( x = 0; x < ( BaseType_t ) heapNUM_REGIONS; x++ )
+    {
+        if( ( xRegions[ x ].pxEnd != NULL ) &&
+            ( puc >= xRegions[ x ].pucStart ) &&
+            ( puc < xRegions[ x ].pucEnd ) )
+        {
+            return &xRegions[ x ];
+        }
+    }
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvMallocFailed( void * pvReturn )
+{
+    #if ( configUSE_MALLOC_FAILED_HOOK == 1 )
+        {
+            if( pvReturn == NULL )
+            {
+                extern void vApplicationMallocFailedHook( void );
+                vApplicationMallocFailedHook();
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+    #else
+        ( void ) pvReturn;
+    #endif /* if ( configUSE_MALLOC_FAILED_HOOK == 1 ) */
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void ) /* PRIVILEGED_FUNCTION */
+{
+    BlockLink_t * pxFirstFreeBlock;
+    HeapRegionState_t * pxRegion;
+    size_t uxStart, uxEnd;
+    BaseType_t x;
+    uint8_t * const pucBounds[ heapNUM_REGIONS ][ 2 ] =
+    {
+        { __heap_fast_start, __heap_fast_end },
+        { __heap_bulk_start, __heap_bulk_end },
+        { __heap_dma_start,  __heap_dma_end  }
+    };
+
+    for( x = 0; x < ( BaseType_t ) heapNUM_REGIONS; x++ )
+    {
+        pxRegion = &xRegions[ x ];
+        pxRegion->xStart.pxNextFreeBlock = NULL;
+        pxRegion->xStart.xBlockSize = ( size_t ) 0;
+        pxRegion->pxEnd = NULL;
+
+        /* Ensure the region starts on a correctly aligned boundary. */
+        uxStart = ( size_t ) pucBounds[ x ][ 0 ];
+        uxStart = ( uxStart + ( portBYTE_ALIGNMENT - 1 ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+        /* pxEnd is used to mark the end of the list of free blocks and is
+         * inserted at the end of the region. */
+        uxEnd = ( size_t ) pucBounds[ x ][ 1 ];
+
+        if( uxEnd < ( uxStart + xHeapStructSize + heapMINIMUM_BLOCK_SIZE ) )
+        {
+            /* Region not present in this design, or too small to be useful. */
+            continue;
+        }
+
+        uxEnd -= xHeapStructSize;
+        uxEnd &= ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+        pxRegion->pucStart = ( uint8_t * ) uxStart;
+        pxRegion->pucEnd = ( uint8_t * ) uxEnd;
+        pxRegion->pxEnd = ( void * ) uxEnd;
+        pxRegion->pxEnd->xBlockSize = 0;
+        pxRegion->pxEnd->pxNextFreeBlock = NULL;
+
+        /* To start with there is a single free block that is sized to take up
+         * the entire region, minus the space taken by pxEnd. */
+        pxFirstFreeBlock = ( void * ) uxStart;
+        pxFirstFreeBlock->xBlockSize = uxEnd - uxStart;
+        pxFirstFreeBlock->pxNextFreeBlock = pxRegion->pxEnd;
+        pxRegion->xStart.pxNextFreeBlock = pxFirstFreeBlock;
+
+        pxRegion->xTotalBytes = pxFirstFreeBlock->xBlockSize;
+        pxRegion->xFreeBytesRemaining = pxFirstFreeBlock->xBlockSize;
+        pxRegion->xMinimumEverFreeBytesRemaining = pxFirstFreeBlock->xBlockSize;
+    }
+
+    /* At least one region must have been defined in the linker script. */
+    configASSERT( ( xRegions[ REGION_FAST ].pxEnd != NULL ) ||
+                  ( xRegions[ REGION_BULK ].pxEnd != NULL ) ||
+                  ( xRegions[ REGION_DMA ].pxEnd != NULL ) );
+
+    xHeapInitialised = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertBlockIntoFreeList( HeapRegionState_t * pxRegion,
+                                        BlockLink_t * pxBlockToInsert ) /* PRIVILEGED_FUNCTION */
+{
+    BlockLink_t * pxIterator;
+    uint8_t * puc;
+
+    /* Iterate through the list until a block is found that has a higher address
+     * than the block being inserted. */
+    for( pxIterator = &pxRegion->xStart; pxIterator->pxNextFreeBlock < pxBlockToInsert; pxIterator = pxIterator->pxNextFreeBlock )
+    {
+        /* Nothing to do here, just iterate to the right position. */
+    }
+
+    /* Do the block being inserted, and the block it is being inserted after
+     * make a contiguous block of memory? */
+    puc = ( uint8_t * ) pxIterator;
+
+    if( ( puc + pxIterator->xBlockSize ) == ( uint8_t * ) pxBlockToInsert )
+    {
+        pxIterator->xBlockSize += pxBlockToInsert->xBlockSize;
+        pxBlockToInsert = pxIterator;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    /* Do the block being inserted, and the block it is being inserted before
+     * make a contiguous block of memory? */
+    puc = ( uint8_t * ) pxBlockToInsert;
+
+    if( ( puc + pxBlockToInsert->xBlockSize ) == ( uint8_t * ) pxIterator->pxNextFreeBlock )
+    {
+        if( pxIterator->pxNextFreeBlock != pxRegion->pxEnd )
+        {
+            /* Form one big block from the two blocks. */
+            pxBlockToInsert->xBlockSize += pxIterator->pxNextFreeBlock->xBlockSize;
+            pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock->pxNextFreeBlock;
+        }
+        else
+        {
+            pxBlockToInsert->pxNextFreeBlock = pxRegion->pxEnd;
+        }
+    }
+    else
+    {
+        pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock;
+    }
+
+    /* If the block being inserted plugged a gap, so was merged with the block
+     * before and the block after, then it's pxNextFreeBlock pointer will have
+     * already been set, and should not be set here as that would make it point
+     * to itself. */
+    if( pxIterator != pxBlockToInsert )
+    {
+        pxIterator->pxNextFreeBlock = pxBlockToInsert;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
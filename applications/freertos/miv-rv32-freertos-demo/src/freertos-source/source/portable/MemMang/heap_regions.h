@@ -0,0 +1,69 @@
+/*
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Multi-region heap for Mi-V designs that have RAM blocks with different access
+ * latencies (TCM, LSRAM, ...).  See heap_regions.c.
+ *
+ * Each region is described by a pair of linker script symbols:
+ *
+ *      REGION_FAST : __heap_fast_start / __heap_fast_end  (TCM)
+ *      REGION_BULK : __heap_bulk_start / __heap_bulk_end  (main LSRAM)
+ *      REGION_DMA  : __heap_dma_start  / __heap_dma_end   (uDMA visible LSRAM)
+ *
+ * A region whose start and end symbols are equal is simply not used, so a
+ * linker script only needs to reserve space for the regions that exist in the
+ * Libero design.
+ */
+
+#ifndef HEAP_REGIONS_H
+#define HEAP_REGIONS_H
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include heap_regions.h"
+#endif
+
+/* Identifies the RAM region an allocation must be placed in. */
+typedef enum
+{
+    REGION_FAST = 0,    /* Lowest latency RAM (TCM) - hot buffers, task stacks. */
+    REGION_BULK,        /* Large general purpose RAM - default region. */
+    REGION_DMA,         /* RAM reachable by the MIV_ESS uDMA. */
+    heapNUM_REGIONS
+} HeapRegionId_t;
+
+/* The region used by pvPortMalloc() before falling back to the others. */
+#ifndef configHEAP_DEFAULT_REGION
+    #define configHEAP_DEFAULT_REGION    REGION_BULK
+#endif
+
+/* The region task stacks are taken from when
+ * configSTACK_ALLOCATION_FROM_SEPARATE_HEAP is set to 1. */
+#ifndef configHEAP_STACK_REGION
+    #define configHEAP_STACK_REGION      REGION_BULK
+#endif
+
+/*
+ * Allocate xWantedSize bytes from the region xRegion only.  NULL is returned if
+ * the region does not exist in the design or cannot satisfy the request - there
+ * is deliberately no fallback to another region, and the malloc failed hook is
+ * not called.  The memory is released with the normal vPortFree().
+ */
+void * pvPortMallocIn( HeapRegionId_t xRegion,
+                       size_t xWantedSize );
+
+/*
+ * Returns the heap statistics for a single region.  vPortGetHeapStats() still
+ * returns the totals for all the regions.
+ */
+void vPortGetRegionHeapStats( HeapRegionId_t xRegion,
+                              HeapStats_t * pxHeapStats );
+
+/* Total size, in bytes, of the region as defined by the linker script. */
+size_t xPortGetRegionHeapSize( HeapRegionId_t xRegion );
+
+size_t xPortGetRegionFreeHeapSize( HeapRegionId_t xRegion );
+size_t xPortGetRegionMinimumEverFreeHeapSize( HeapRegionId_t xRegion );
+
+#endif /* HEAP_REGIONS_H */
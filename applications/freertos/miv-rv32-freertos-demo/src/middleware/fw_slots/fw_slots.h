@@ -0,0 +1,300 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file fw_slots.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief A/B firmware slots in the SPI flash.
+ *
+ * The SPI flash holds two application slots, A and B. Each slot has its own
+ * descriptor, stored on its own in a 4 KB erase block at the top of the flash.
+ * A descriptor records the image size, the image CRC-32 and a sequence number,
+ * and is protected by its own CRC-32.
+ *
+ *   0x000000 +----------------------------+
+ *            | Boot image, loaded into    |  Written by menu option 1. Copied
+ *            | the TCM by MIV_ESS         |  to the TCM by the MIV_ESS
+ *            |                            |  bootstrap on reset.
+ *   0x010000 +----------------------------+
+ *            | Slot A                     |
+ *   0x020000 +----------------------------+
+ *            | Slot B                     |
+ *   0x030000 +----------------------------+
+ *            ~                            ~
+ *   0x7FE000 +----------------------------+
+ *            | Slot A descriptor          |
+ *   0x7FF000 +----------------------------+
+ *            | Slot B descriptor          |
+ *            +----------------------------+
+ *
+ * A new image is always written to the inactive slot, the slot which does not
+ * hold the newest valid image. Its descriptor is erased first, the image is
+ * then written and read back to check its CRC-32, and the descriptor is written
+ * last with a sequence number one higher than the active slot. A power loss at
+ * any point leaves either the previous image or the new one valid, never
+ * neither.
+ *
+ * At boot, fw_slots_boot() selects the valid slot with the highest sequence
+ * number, copies its image to RAM, checks its CRC-32 and starts it from the
+ * TCM. If the newest image is corrupted, the other slot is booted.
+ *
+ * The staged copy of the image is left in RAM when it is started, together
+ * with a warm boot record giving its slot, sequence number, size and CRC-32.
+ * After a reset which does not clear the RAM, a soft reset or a watchdog
+ * reset, fw_slots_boot() checks the record against the active descriptor and
+ * the staged copy against the image CRC-32. When both match, the image is
+ * started again from the staged copy without being read from the flash.
+ *
+ * spi_flash_init() must have been called before any function of this module is
+ * used. The module does not serialise access to the SPI flash.
+ */
+#ifndef FW_SLOTS_H_
+#define FW_SLOTS_H_
+
+#include "hal/cpu_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+ * Flash layout. All addresses are offsets in the SPI flash.
+ */
+#ifndef FW_SLOTS_FLASH_SIZE
+#define FW_SLOTS_FLASH_SIZE             0x800000u
+#endif
+
+#ifndef FW_SLOT_A_ADDR
+#define FW_SLOT_A_ADDR                  0x010000u
+#endif
+
+#ifndef FW_SLOT_B_ADDR
+#define FW_SLOT_B_ADDR                  0x020000u
+#endif
+
+#ifndef FW_SLOT_SIZE
+#define FW_SLOT_SIZE                    0x010000u
+#endif
+
+#define FW_SLOTS_ERASE_BLOCK_SIZE       4096u
+#define FW_SLOTS_PAGE_SIZE              256u
+
+#define FW_SLOT_A_DESC_ADDR             (FW_SLOTS_FLASH_SIZE - (2u * FW_SLOTS_ERASE_BLOCK_SIZE))
+#define FW_SLOT_B_DESC_ADDR             (FW_SLOTS_FLASH_SIZE - FW_SLOTS_ERASE_BLOCK_SIZE)
+
+/*------------------------------------------------------------------------------
+ * Boot parameters.
+ * FW_SLOTS_EXEC_ADDR is where the image is linked to run, the TCM.
+ * FW_SLOTS_STAGING_ADDR is the RAM the image is read into and checked before
+ * it is copied to the TCM. It must be able to hold FW_SLOTS_MAX_IMAGE_SIZE
+ * bytes followed by the copy routine, and must allow execution.
+ */
+#ifndef FW_SLOTS_EXEC_ADDR
+#define FW_SLOTS_EXEC_ADDR              0x40000000u
+#endif
+
+#ifndef FW_SLOTS_MAX_IMAGE_SIZE
+#define FW_SLOTS_MAX_IMAGE_SIZE         0x8000u
+#endif
+
+#ifndef FW_SLOTS_STAGING_ADDR
+#define FW_SLOTS_STAGING_ADDR           0x80000000u
+#endif
+
+/*------------------------------------------------------------------------------
+ * Address of the warm boot record, in RAM which is neither cleared at reset nor
+ * used by the staged image and the copy routine which follows it.
+ */
+#ifndef FW_SLOTS_WARM_ADDR
+#define FW_SLOTS_WARM_ADDR              (FW_SLOTS_STAGING_ADDR + FW_SLOTS_MAX_IMAGE_SIZE + 0x100u)
+#endif
+
+#define FW_SLOT_DESC_MAGIC              0x544F4C53u     /* "SLOT" */
+#define FW_SLOT_DESC_VERSION            1u
+#define FW_SLOTS_WARM_MAGIC             0x4D524157u     /* "WARM" */
+
+typedef enum
+{
+    FW_SLOT_A = 0,
+    FW_SLOT_B = 1,
+    FW_SLOT_NONE = 0xFF
+} fw_slot_id_t;
+
+typedef enum
+{
+    FW_SLOTS_SUCCESS = 0,
+    FW_SLOTS_FLASH_ERROR,
+    FW_SLOTS_INVALID_SIZE,
+    FW_SLOTS_CRC_ERROR,
+    FW_SLOTS_NO_VALID_SLOT,
+    FW_SLOTS_WRITE_SEQUENCE_ERROR,
+    FW_SLOTS_TIMEOUT,
+    FW_SLOTS_ABORTED
+} fw_slots_status_t;
+
+/*------------------------------------------------------------------------------
+ * Slot descriptor, one flash page long. desc_crc is the CRC-32 of all the
+ * preceding fields.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sequence;
+    uint32_t image_size;
+    uint32_t image_crc;
+    uint32_t reserved[58];
+    uint32_t desc_crc;
+} fw_slot_desc_t;
+
+/*------------------------------------------------------------------------------
+ * Warm boot record, written at FW_SLOTS_WARM_ADDR by fw_slots_boot() before it
+ * starts an image. record_crc is the CRC-32 of all the preceding fields.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t slot;
+    uint32_t sequence;
+    uint32_t image_size;
+    uint32_t image_crc;
+    uint32_t record_crc;
+} fw_slots_warm_t;
+
+/*------------------------------------------------------------------------------
+ * State of an image being written. Initialised by fw_slots_write_begin().
+ */
+typedef struct
+{
+    fw_slot_id_t slot;
+    uint32_t sequence;
+    uint32_t image_size;
+    uint32_t written;
+    uint32_t crc;
+    uint32_t page_fill;
+    uint8_t page[FW_SLOTS_PAGE_SIZE];
+} fw_slots_writer_t;
+
+/***************************************************************************//**
+ * fw_slots_crc32() computes the CRC-32 (IEEE 802.3) of a buffer. Pass 0 as crc
+ * for the first buffer, and the previous result to continue the computation
+ * over several buffers.
+ */
+uint32_t
+fw_slots_crc32
+(
+    uint32_t crc,
+    const uint8_t * buf,
+    uint32_t length
+);
+
+/***************************************************************************//**
+ * fw_slots_read_desc() reads the descriptor of a slot.
+ *
+ * @return
+ *      1 if the descriptor is valid, 0 otherwise. The image itself is not
+ *      checked.
+ */
+uint8_t
+fw_slots_read_desc
+(
+    fw_slot_id_t slot,
+    fw_slot_desc_t * desc
+);
+
+/***************************************************************************//**
+ * fw_slots_active() returns the slot with a valid descriptor and the highest
+ * sequence number, or FW_SLOT_NONE. desc receives its descriptor when not NULL.
+ */
+fw_slot_id_t
+fw_slots_active
+(
+    fw_slot_desc_t * desc
+);
+
+/***************************************************************************//**
+ * fw_slots_verify() reads the image of a slot back from the flash and checks
+ * it against the CRC-32 of its descriptor.
+ */
+fw_slots_status_t
+fw_slots_verify
+(
+    fw_slot_id_t slot
+);
+
+/***************************************************************************//**
+ * fw_slots_write_begin() starts writing a new image to the inactive slot. The
+ * descriptor of that slot is erased, so it is no longer bootable. The slot
+ * itself is erased as the image is written.
+ *
+ * @param writer
+ *      State of the write, passed to the other fw_slots_write functions.
+ *
+ * @param image_size
+ *      Size of the image in bytes. At most FW_SLOTS_MAX_IMAGE_SIZE.
+ */
+fw_slots_status_t
+fw_slots_write_begin
+(
+    fw_slots_writer_t * writer,
+    uint32_t image_size
+);
+
+/***************************************************************************//**
+ * fw_slots_write() appends data to the image. The data can be given in chunks
+ * of any size. Full flash pages are written as soon as they are complete.
+ */
+fw_slots_status_t
+fw_slots_write
+(
+    fw_slots_writer_t * writer,
+    const uint8_t * data,
+    uint32_t length
+);
+
+/***************************************************************************//**
+ * fw_slots_write_commit() writes the last page of the image, checks the image
+ * read back from the flash and writes the slot descriptor. The new image is
+ * booted from the next reset. Returns FW_SLOTS_WRITE_SEQUENCE_ERROR if fewer
+ * bytes than announced to fw_slots_write_begin() were written.
+ */
+fw_slots_status_t
+fw_slots_write_commit
+(
+    fw_slots_writer_t * writer
+);
+
+/***************************************************************************//**
+ * fw_slots_boot() starts the newest valid image. It only returns if no slot
+ * holds a valid image, with FW_SLOTS_NO_VALID_SLOT.
+ * The image is started from the staged copy left in RAM by the previous boot
+ * when the warm boot record shows that it is still the active image and its
+ * CRC-32 is still correct. It is read from the flash otherwise.
+ * The image source and the end of the load and start phases are recorded in
+ * the boot_handoff block, which is sealed just before the image is started.
+ * Interrupts are disabled before the image is started.
+ */
+fw_slots_status_t
+fw_slots_boot
+(
+    void
+);
+
+/***************************************************************************//**
+ * fw_slots_warm_invalidate() clears the warm boot record, so that the image is
+ * read from the flash at the next reset. An application calls it before a
+ * reset when the staged copy must not be trusted, for example after a memory
+ * error.
+ */
+void
+fw_slots_warm_invalidate
+(
+    void
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FW_SLOTS_H_ */
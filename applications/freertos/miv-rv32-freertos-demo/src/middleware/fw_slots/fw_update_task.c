@@ -0,0 +1,208 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file fw_update_task.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Background firmware update for FreeRTOS applications.
+ *
+ * See fw_update_task.h for details of how to use this module.
+ */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "stream_buffer.h"
+#include "fw_update_task.h"
+
+static StreamBufferHandle_t g_stream = NULL;
+static SemaphoreHandle_t g_start = NULL;
+static SemaphoreHandle_t g_done = NULL;
+
+static fw_slots_writer_t g_writer;
+static volatile uint32_t g_image_size;
+static volatile fw_slots_status_t g_status;
+static volatile BaseType_t g_busy = pdFALSE;
+static volatile BaseType_t g_abort = pdFALSE;
+
+/*
+ * Update task. Waits for fw_update_start(), then moves the image from the
+ * stream buffer to the flash one page at a time. The wait for each part of the
+ * image is cut in FW_UPDATE_POLL_PERIOD slices to check for fw_update_abort().
+ */
+static void
+fw_update_task
+(
+    void * parameters
+)
+{
+    uint8_t buf[FW_SLOTS_PAGE_SIZE];
+    fw_slots_status_t status;
+    uint32_t remaining;
+    size_t received;
+    TickType_t idle;
+
+    (void)parameters;
+
+    for (;;)
+    {
+        xSemaphoreTake(g_start, portMAX_DELAY);
+
+        status = fw_slots_write_begin(&g_writer, g_image_size);
+        idle = 0u;
+
+        while ((FW_SLOTS_SUCCESS == status) &&
+               (g_writer.written < g_writer.image_size))
+        {
+            remaining = g_writer.image_size - g_writer.written;
+            received = xStreamBufferReceive(g_stream, buf,
+                                            (remaining < sizeof(buf)) ? remaining : sizeof(buf),
+                                            FW_UPDATE_POLL_PERIOD);
+            if (pdFALSE != g_abort)
+            {
+                status = FW_SLOTS_ABORTED;
+            }
+            else if (0u != received)
+            {
+                idle = 0u;
+                status = fw_slots_write(&g_writer, buf, (uint32_t)received);
+            }
+            else
+            {
+                idle += FW_UPDATE_POLL_PERIOD;
+                if (idle >= FW_UPDATE_RX_TIMEOUT)
+                {
+                    status = FW_SLOTS_TIMEOUT;
+                }
+            }
+        }
+
+        if (FW_SLOTS_SUCCESS == status)
+        {
+            status = fw_slots_write_commit(&g_writer);
+        }
+
+        g_status = status;
+        g_busy = pdFALSE;
+        xSemaphoreGive(g_done);
+    }
+}
+
+/***************************************************************************//**
+ * fw_update_task_create()
+ * See "fw_update_task.h" for details of how to use this function.
+ */
+BaseType_t
+fw_update_task_create
+(
+    void
+)
+{
+    g_stream = xStreamBufferCreate(FW_UPDATE_STREAM_SIZE, 1u);
+    g_start = xSemaphoreCreateBinary();
+    g_done = xSemaphoreCreateBinary();
+
+    if ((NULL == g_stream) || (NULL == g_start) || (NULL == g_done))
+    {
+        return pdFAIL;
+    }
+
+    return xTaskCreate(fw_update_task,
+                       "FWUPD",
+                       FW_UPDATE_TASK_STACK_SIZE,
+                       NULL,
+                       FW_UPDATE_TASK_PRIORITY,
+                       NULL);
+}
+
+/***************************************************************************//**
+ * fw_update_start()
+ * See "fw_update_task.h" for details of how to use this function.
+ */
+BaseType_t
+fw_update_start
+(
+    uint32_t image_size
+)
+{
+    BaseType_t started = pdFAIL;
+
+    configASSERT(NULL != g_stream);
+
+    taskENTER_CRITICAL();
+    if (pdFALSE == g_busy)
+    {
+        g_busy = pdTRUE;
+        started = pdPASS;
+    }
+    taskEXIT_CRITICAL();
+
+    if (pdPASS == started)
+    {
+        /* Drop anything left over from a failed update */
+        (void)xStreamBufferReset(g_stream);
+        (void)xSemaphoreTake(g_done, 0u);
+        g_abort = pdFALSE;
+        g_image_size = image_size;
+        xSemaphoreGive(g_start);
+    }
+
+    return started;
+}
+
+/***************************************************************************//**
+ * fw_update_push()
+ * See "fw_update_task.h" for details of how to use this function.
+ */
+size_t
+fw_update_push
+(
+    const uint8_t * data,
+    size_t length,
+    TickType_t timeout
+)
+{
+    if (pdFALSE == g_busy)
+    {
+        return 0u;
+    }
+
+    return xStreamBufferSend(g_stream, data, length, timeout);
+}
+
+/***************************************************************************//**
+ * fw_update_abort()
+ * See "fw_update_task.h" for details of how to use this function.
+ */
+void
+fw_update_abort
+(
+    void
+)
+{
+    if (pdFALSE != g_busy)
+    {
+        g_abort = pdTRUE;
+    }
+}
+
+/***************************************************************************//**
+ * fw_update_wait()
+ * See "fw_update_task.h" for details of how to use this function.
+ */
+BaseType_t
+fw_update_wait
+(
+    fw_slots_status_t * status,
+    TickType_t timeout
+)
+{
+    if (pdTRUE != xSemaphoreTake(g_done, timeout))
+    {
+        return pdFAIL;
+    }
+
+    *status = g_status;
+
+    return pdPASS;
+}
@@ -0,0 +1,145 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file fw_update_task.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Background firmware update for FreeRTOS applications.
+ *
+ * A low priority task writes a new image to the inactive A/B slot (see
+ * fw_slots.h) while the application keeps running. The application receives
+ * the image from any source (UART, network, ...) and pushes it to the task
+ * through a stream buffer with fw_update_push(). The SPI flash erase and
+ * program waits then only use processor time left over by the application's
+ * tasks. The new image is started by the next reset.
+ *
+ * This file is not used by the bootloader, which has no RTOS, and is excluded
+ * from the SoftConsole build configurations of this project. The FreeRTOS demo,
+ * applications/freertos/miv-rv32-freertos-demo, builds it with a copy of
+ * fw_slots and of the SPI flash driver. The application must not use the SPI
+ * flash while an update is in progress.
+ */
+#ifndef FW_UPDATE_TASK_H_
+#define FW_UPDATE_TASK_H_
+
+#include "FreeRTOS.h"
+#include "fw_slots.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef FW_UPDATE_TASK_PRIORITY
+#define FW_UPDATE_TASK_PRIORITY         (tskIDLE_PRIORITY + 1u)
+#endif
+
+#ifndef FW_UPDATE_TASK_STACK_SIZE
+#define FW_UPDATE_TASK_STACK_SIZE       (configMINIMAL_STACK_SIZE * 2u)
+#endif
+
+/*------------------------------------------------------------------------------
+ * Size of the stream buffer between the application and the update task.
+ * A multiple of the flash page size keeps the task writing whole pages.
+ */
+#ifndef FW_UPDATE_STREAM_SIZE
+#define FW_UPDATE_STREAM_SIZE           (4u * FW_SLOTS_PAGE_SIZE)
+#endif
+
+/*------------------------------------------------------------------------------
+ * Longest time the update task waits for the next part of the image. The update
+ * then fails with FW_SLOTS_TIMEOUT, for example when the sender went away, so
+ * that fw_update_start() can be called again.
+ */
+#ifndef FW_UPDATE_RX_TIMEOUT
+#define FW_UPDATE_RX_TIMEOUT            pdMS_TO_TICKS(10000u)
+#endif
+
+/*------------------------------------------------------------------------------
+ * Period at which the update task checks for fw_update_abort() while it waits
+ * for data.
+ */
+#ifndef FW_UPDATE_POLL_PERIOD
+#define FW_UPDATE_POLL_PERIOD           pdMS_TO_TICKS(100u)
+#endif
+
+/***************************************************************************//**
+ * fw_update_task_create() creates the update task and its stream buffer. Call
+ * it once, before the scheduler is started or from a task.
+ *
+ * @return
+ *      pdPASS, or pdFAIL if the FreeRTOS heap is too small.
+ */
+BaseType_t
+fw_update_task_create
+(
+    void
+);
+
+/***************************************************************************//**
+ * fw_update_start() starts an update of image_size bytes. The inactive slot is
+ * made unbootable before the first byte is accepted.
+ *
+ * @return
+ *      pdPASS, or pdFAIL if an update is already in progress.
+ */
+BaseType_t
+fw_update_start
+(
+    uint32_t image_size
+);
+
+/***************************************************************************//**
+ * fw_update_push() passes the next part of the image to the update task. It
+ * blocks for at most timeout ticks while the stream buffer is full.
+ *
+ * @return
+ *      Number of bytes accepted. Less than length on a timeout, or if the
+ *      update failed.
+ */
+size_t
+fw_update_push
+(
+    const uint8_t * data,
+    size_t length,
+    TickType_t timeout
+);
+
+/***************************************************************************//**
+ * fw_update_abort() stops the update in progress. The update task drops the
+ * rest of the image and completes the update with FW_SLOTS_ABORTED within
+ * FW_UPDATE_POLL_PERIOD, or after the page it is writing. The inactive slot is
+ * left unbootable and the active image is unchanged. It does nothing when no
+ * update is in progress.
+ */
+void
+fw_update_abort
+(
+    void
+);
+
+/***************************************************************************//**
+ * fw_update_wait() waits for at most timeout ticks for the update started by
+ * fw_update_start() to complete.
+ *
+ * @param status
+ *      Receives the outcome of the update, FW_SLOTS_SUCCESS when the new image
+ *      is committed, FW_SLOTS_TIMEOUT when no data was pushed for
+ *      FW_UPDATE_RX_TIMEOUT, FW_SLOTS_ABORTED after fw_update_abort().
+ *
+ * @return
+ *      pdPASS when the update completed, successfully or not, pdFAIL on a
+ *      timeout.
+ */
+BaseType_t
+fw_update_wait
+(
+    fw_slots_status_t * status,
+    TickType_t timeout
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FW_UPDATE_TASK_H_ */
@@ -0,0 +1,166 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file miv_i2c_rtos.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief FreeRTOS binding of the MIV_I2C driver.
+ *
+ * See miv_i2c_rtos.h for details of how to use this module.
+ */
+#include "miv_i2c_rtos.h"
+
+/*
+ * A transaction which outlives the timeout is abandoned by
+ * MIV_I2C_wait_complete() after this further wait.
+ */
+#define ABANDON_WAIT_MS                 1u
+
+/*
+ * Transfer completion handler, called by MIV_I2C_isr().
+ */
+static void
+transfer_done
+(
+    miv_i2c_instance_t * this_i2c,
+    miv_i2c_status_t status
+)
+{
+    miv_i2c_rtos_t * bus = (miv_i2c_rtos_t *)this_i2c->p_user_data;
+    TaskHandle_t owner = bus->owner;
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    (void)status;
+
+    if (NULL != owner)
+    {
+        vTaskNotifyGiveIndexedFromISR(owner, MIV_I2C_RTOS_NOTIFY_INDEX,
+                                      &higher_priority_task_woken);
+    }
+
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+static void
+start_transfer
+(
+    miv_i2c_instance_t * i2c,
+    uint8_t target_addr,
+    const uint8_t * write_buffer,
+    uint16_t write_size,
+    uint8_t * read_buffer,
+    uint16_t read_size,
+    uint8_t ack_polling_options
+)
+{
+    if (0u == read_size)
+    {
+        MIV_I2C_write(i2c, target_addr, write_buffer, write_size,
+                      MIV_I2C_RELEASE_BUS, ack_polling_options);
+    }
+    else if (0u == write_size)
+    {
+        MIV_I2C_read(i2c, target_addr, read_buffer, read_size,
+                     MIV_I2C_RELEASE_BUS, ack_polling_options);
+    }
+    else
+    {
+        MIV_I2C_write_read(i2c, target_addr, write_buffer, write_size,
+                           read_buffer, read_size,
+                           MIV_I2C_RELEASE_BUS, ack_polling_options);
+    }
+}
+
+/***************************************************************************//**
+ * See miv_i2c_rtos.h for details of how to use this function.
+ */
+miv_i2c_status_t
+miv_i2c_rtos_init
+(
+    miv_i2c_rtos_t * bus,
+    miv_i2c_instance_t * i2c
+)
+{
+    bus->i2c = i2c;
+    bus->owner = NULL;
+    bus->mutex = xSemaphoreCreateMutex();
+    if (NULL == bus->mutex)
+    {
+        return MIV_I2C_FAILED;
+    }
+
+    i2c->p_user_data = bus;
+    MIV_I2C_register_transfer_completion_handler(i2c, transfer_done);
+
+    return MIV_I2C_SUCCESS;
+}
+
+/***************************************************************************//**
+ * See miv_i2c_rtos.h for details of how to use this function.
+ */
+miv_i2c_status_t
+MIV_I2C_transfer_blocking
+(
+    miv_i2c_rtos_t * bus,
+    uint8_t target_addr,
+    const uint8_t * write_buffer,
+    uint16_t write_size,
+    uint8_t * read_buffer,
+    uint16_t read_size,
+    uint8_t ack_polling_options,
+    uint32_t timeout_ms
+)
+{
+    TimeOut_t timeout;
+    TickType_t ticks_to_wait;
+    miv_i2c_status_t status;
+
+    if (taskSCHEDULER_NOT_STARTED == xTaskGetSchedulerState())
+    {
+        /* No other task can use the bus, and none can be woken */
+        start_transfer(bus->i2c, target_addr, write_buffer, write_size,
+                       read_buffer, read_size, ack_polling_options);
+        return MIV_I2C_wait_complete(bus->i2c, timeout_ms);
+    }
+
+    ticks_to_wait = (MIV_I2C_NO_TIMEOUT == timeout_ms) ?
+                    portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    vTaskSetTimeOutState(&timeout);
+
+    if (pdTRUE != xSemaphoreTake(bus->mutex, ticks_to_wait))
+    {
+        return MIV_I2C_TIMED_OUT;
+    }
+
+    /* Discard the notification of a transaction which completed after it
+     * was abandoned */
+    (void)ulTaskNotifyTakeIndexed(MIV_I2C_RTOS_NOTIFY_INDEX, pdTRUE, 0u);
+    bus->owner = xTaskGetCurrentTaskHandle();
+
+    start_transfer(bus->i2c, target_addr, write_buffer, write_size,
+                   read_buffer, read_size, ack_polling_options);
+
+    /* The transaction may already be done, the notification is then pending */
+    while ((MIV_I2C_IN_PROGRESS == bus->i2c->master_status) &&
+           (pdFALSE == xTaskCheckForTimeOut(&timeout, &ticks_to_wait)))
+    {
+        (void)ulTaskNotifyTakeIndexed(MIV_I2C_RTOS_NOTIFY_INDEX, pdTRUE,
+                                      ticks_to_wait);
+    }
+
+    if (MIV_I2C_IN_PROGRESS == bus->i2c->master_status)
+    {
+        /* Stops the transaction unless it completes meanwhile */
+        status = MIV_I2C_wait_complete(bus->i2c, ABANDON_WAIT_MS);
+    }
+    else
+    {
+        status = bus->i2c->master_status;
+    }
+
+    bus->owner = NULL;
+    (void)xSemaphoreGive(bus->mutex);
+
+    return status;
+}
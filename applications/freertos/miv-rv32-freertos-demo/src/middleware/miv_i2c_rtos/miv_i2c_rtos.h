@@ -0,0 +1,125 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file miv_i2c_rtos.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief FreeRTOS binding of the MIV_I2C driver.
+ *
+ * MIV_I2C_write(), MIV_I2C_read() and MIV_I2C_write_read() return as soon as
+ * the transaction is started and the interrupt handler performs it byte by
+ * byte. A bare metal caller polls the master status, with
+ * MIV_I2C_wait_complete() for example, which under FreeRTOS keeps the CPU from
+ * the other tasks for the whole transaction.
+ *
+ * MIV_I2C_transfer_blocking() instead blocks the calling task until the
+ * transaction ends. MIV_I2C_isr() calls the transfer completion handler
+ * registered by miv_i2c_rtos_init(), which wakes the task with a direct to
+ * task notification and yields to it if it has a higher priority than the
+ * interrupted task. The CPU runs the other tasks in the meantime.
+ *
+ * A mutex per bus serialises the transactions of the tasks sharing the
+ * MIV_I2C. Each transaction releases the bus with a STOP condition; the
+ * driver functions must not be called directly on a bus used through this
+ * binding.
+ *
+ * The waiting task is woken with its direct to task notification of index
+ * MIV_I2C_RTOS_NOTIFY_INDEX, which it must not use for anything else during
+ * a transfer.
+ *
+ * This file is not used by the bootloader, which has no RTOS, and is excluded
+ * from the SoftConsole build configurations of this project. The full demo of
+ * the FreeRTOS demo, applications/freertos/miv-rv32-freertos-demo, reads an
+ * I2C EEPROM with it.
+ */
+#ifndef MIV_I2C_RTOS_H_
+#define MIV_I2C_RTOS_H_
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "drivers/fpga_ip/miv_i2c/miv_i2c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MIV_I2C_RTOS_NOTIFY_INDEX
+#define MIV_I2C_RTOS_NOTIFY_INDEX       0u
+#endif
+
+/*------------------------------------------------------------------------------
+ * MIV_I2C shared by the tasks of the application.
+ */
+typedef struct
+{
+    miv_i2c_instance_t *        i2c;
+    SemaphoreHandle_t           mutex;
+    volatile TaskHandle_t       owner;      /* Task waiting for the transaction */
+} miv_i2c_rtos_t;
+
+/***************************************************************************//**
+ * miv_i2c_rtos_init() creates the mutex of the bus and registers the transfer
+ * completion handler of i2c. Call it once after MIV_I2C_init() and
+ * MIV_I2C_config(), before the tasks use the bus. It uses the p_user_data
+ * member of i2c.
+ *
+ * @return
+ *      MIV_I2C_SUCCESS, or MIV_I2C_FAILED if the mutex could not be allocated.
+ */
+miv_i2c_status_t
+miv_i2c_rtos_init
+(
+    miv_i2c_rtos_t * bus,
+    miv_i2c_instance_t * i2c
+);
+
+/***************************************************************************//**
+ * MIV_I2C_transfer_blocking() performs one transaction with the slave at
+ * target_addr and returns once it is done:
+ *  - write_size bytes of write_buffer are written if read_size is 0,
+ *  - read_size bytes are read into read_buffer if write_size is 0,
+ *  - otherwise write_buffer is written then, after a repeated START,
+ *    read_buffer is read, as MIV_I2C_write_read() does.
+ *
+ * As with the driver functions, the byte received with the acknowledge of the
+ * address of a read is stored one location before read_buffer, which must be
+ * preceded by a spare byte.
+ *
+ * The calling task blocks while another task uses the bus and while the
+ * transaction runs. Before the scheduler is started the transaction is
+ * performed with MIV_I2C_wait_complete() instead.
+ *
+ * @param ack_polling_options
+ *      MIV_I2C_ACK_POLLING_ENABLE to retry the address until the slave
+ *      acknowledges it, an EEPROM in its write cycle for example, or
+ *      MIV_I2C_ACK_POLLING_DISABLE.
+ *
+ * @param timeout_ms
+ *      Longest time to wait for the bus and the transaction together, or
+ *      MIV_I2C_NO_TIMEOUT. A transaction still running after it is abandoned
+ *      with a STOP condition.
+ *
+ * @return
+ *      MIV_I2C_SUCCESS, MIV_I2C_FAILED if the slave did not acknowledge, or
+ *      MIV_I2C_TIMED_OUT.
+ */
+miv_i2c_status_t
+MIV_I2C_transfer_blocking
+(
+    miv_i2c_rtos_t * bus,
+    uint8_t target_addr,
+    const uint8_t * write_buffer,
+    uint16_t write_size,
+    uint8_t * read_buffer,
+    uint16_t read_size,
+    uint8_t ack_polling_options,
+    uint32_t timeout_ms
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MIV_I2C_RTOS_H_ */
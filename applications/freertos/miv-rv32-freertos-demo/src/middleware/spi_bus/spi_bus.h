@@ -0,0 +1,270 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file spi_bus.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Sharing of a CoreSPI master between several devices.
+ *
+ * A CoreSPI instance can drive up to 8 slave selects, for example the SPI
+ * flash, an ADC and a display. The bus manager lets the driver of each device
+ * use the bus without knowing about the others:
+ *  - each device is registered once with its slave select, the SPI modes it
+ *    supports and its highest clock rate,
+ *  - transactions are queued per bus and run highest priority first, in the
+ *    order they were submitted within a priority,
+ *  - the bus remembers which device is selected. A transaction to the device
+ *    of the previous transaction does not access the SSEL register at all,
+ *    and a change of device is a single SSEL write instead of the read-modify-
+ *    write of SPI_clear_slave_select() and SPI_set_slave_select().
+ *
+ * The SPI mode and clock rate of a CoreSPI are set in the FPGA design and
+ * cannot be changed by software. They are given to spi_bus_init() and a device
+ * which cannot work with them is refused by spi_bus_add_device().
+ *
+ * Transactions are run by spi_bus_run(), or by spi_bus_transfer() which runs
+ * the queue until its own transaction is done. Transactions may be submitted
+ * from an interrupt handler and run later from the main loop. Under FreeRTOS,
+ * see spi_bus_rtos.h, spi_bus_transfer() blocks the calling task instead while
+ * another task runs the queue.
+ */
+#ifndef SPI_BUS_H_
+#define SPI_BUS_H_
+
+#include "hal/cpu_types.h"
+#include "drivers/fpga_ip/CoreSPI/core_spi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+ * SPI modes, clock polarity and phase. A device gives the set of modes it
+ * supports, for example SPI_BUS_MODE_0 | SPI_BUS_MODE_3 for most SPI flashes.
+ */
+#define SPI_BUS_MODE_0                  0x01u   /* CPOL 0, CPHA 0 */
+#define SPI_BUS_MODE_1                  0x02u   /* CPOL 0, CPHA 1 */
+#define SPI_BUS_MODE_2                  0x04u   /* CPOL 1, CPHA 0 */
+#define SPI_BUS_MODE_3                  0x08u   /* CPOL 1, CPHA 1 */
+
+/*------------------------------------------------------------------------------
+ * Transaction priorities. Any value from 0 to 255 can be used, higher values
+ * run first.
+ */
+#define SPI_BUS_PRIORITY_LOW            0u
+#define SPI_BUS_PRIORITY_NORMAL         128u
+#define SPI_BUS_PRIORITY_HIGH           255u
+
+typedef enum
+{
+    SPI_BUS_SUCCESS = 0,
+    SPI_BUS_INVALID_ARGUMENTS,
+    SPI_BUS_UNSUPPORTED_MODE,
+    SPI_BUS_CLOCK_TOO_FAST,
+    SPI_BUS_ALREADY_QUEUED,
+    SPI_BUS_BUSY
+} spi_bus_status_t;
+
+typedef struct spi_bus spi_bus_t;
+typedef struct spi_bus_device spi_bus_device_t;
+typedef struct spi_bus_xfer spi_bus_xfer_t;
+
+/*------------------------------------------------------------------------------
+ * Called by spi_bus_run() once the transaction is done, from the context which
+ * runs the queue. It may submit another transaction.
+ */
+typedef void (*spi_bus_done_t)(spi_bus_xfer_t * xfer);
+
+/*------------------------------------------------------------------------------
+ * CoreSPI master shared by several devices.
+ */
+struct spi_bus
+{
+    spi_instance_t *            spi;
+    uint8_t                     mode;       /* SPI_BUS_MODE_x of the CoreSPI */
+    uint32_t                    clock_hz;   /* SPI clock of the CoreSPI, 0 if unknown */
+    const spi_bus_device_t *    selected;   /* Device in SSEL, NULL for none */
+    spi_bus_xfer_t *            queue;      /* Highest priority first */
+    volatile uint8_t            running;
+
+    /* Replaces the body of spi_bus_transfer(), set by spi_bus_rtos_init() */
+    spi_bus_status_t            (*wait_transfer)(spi_bus_xfer_t * xfer);
+
+    /* Counts since spi_bus_init() */
+    uint32_t                    transfers;
+    uint32_t                    selects;    /* SSEL writes */
+};
+
+/*------------------------------------------------------------------------------
+ * Device on a bus, see spi_bus_add_device().
+ */
+struct spi_bus_device
+{
+    spi_bus_t *                 bus;
+    spi_slave_t                 slave;
+    uint8_t                     modes;
+    uint32_t                    max_clock_hz;
+    uint8_t                     priority;   /* Of spi_bus_transfer() calls */
+};
+
+/*------------------------------------------------------------------------------
+ * Transaction: cmd_size bytes of cmd_buffer are sent, then rx_size bytes are
+ * read into rx_buffer, with the device selected throughout, as for
+ * SPI_transfer_block(). The structure belongs to the bus from spi_bus_submit()
+ * until done is called, or until spi_bus_done() returns 1.
+ */
+struct spi_bus_xfer
+{
+    spi_bus_device_t *          device;
+    const uint8_t *             cmd_buffer;
+    uint16_t                    cmd_size;
+    uint8_t *                   rx_buffer;
+    uint16_t                    rx_size;
+    uint8_t                     priority;
+    spi_bus_done_t              done;
+    void *                      context;    /* For the done function */
+
+    volatile uint8_t            state;
+    spi_bus_xfer_t *            next;
+};
+
+/***************************************************************************//**
+ * spi_bus_init() initializes the CoreSPI at base_addr in master mode, with no
+ * slave selected, and the bus which manages it.
+ *
+ * @param spi
+ *      CoreSPI instance, initialized by this function.
+ *
+ * @param base_addr
+ *      Base address of the CoreSPI.
+ *
+ * @param fifo_depth
+ *      Depth of the CoreSPI FIFOs, as for SPI_init().
+ *
+ * @param mode
+ *      SPI_BUS_MODE_x the CoreSPI was configured with in the FPGA design.
+ *
+ * @param clock_hz
+ *      SPI clock rate of the CoreSPI, or 0 if it is not known. Device clock
+ *      limits are not checked in that case.
+ */
+void
+spi_bus_init
+(
+    spi_bus_t * bus,
+    spi_instance_t * spi,
+    addr_t base_addr,
+    uint16_t fifo_depth,
+    uint8_t mode,
+    uint32_t clock_hz
+);
+
+/***************************************************************************//**
+ * spi_bus_add_device() registers a device on the slave select slave of bus.
+ *
+ * @param modes
+ *      SPI_BUS_MODE_x values the device supports, ORed together.
+ *
+ * @param max_clock_hz
+ *      Highest SPI clock rate of the device, 0 for no limit.
+ *
+ * @param priority
+ *      Priority of the transactions of spi_bus_transfer() for this device.
+ *
+ * @return
+ *      SPI_BUS_SUCCESS, SPI_BUS_UNSUPPORTED_MODE or SPI_BUS_CLOCK_TOO_FAST if
+ *      the device cannot be used with the CoreSPI configuration.
+ */
+spi_bus_status_t
+spi_bus_add_device
+(
+    spi_bus_t * bus,
+    spi_bus_device_t * device,
+    spi_slave_t slave,
+    uint8_t modes,
+    uint32_t max_clock_hz,
+    uint8_t priority
+);
+
+/***************************************************************************//**
+ * spi_bus_xfer_init() fills in a transaction for device, with the priority of
+ * the device and no done function.
+ */
+void
+spi_bus_xfer_init
+(
+    spi_bus_xfer_t * xfer,
+    spi_bus_device_t * device,
+    const uint8_t * cmd_buffer,
+    uint16_t cmd_size,
+    uint8_t * rx_buffer,
+    uint16_t rx_size
+);
+
+/***************************************************************************//**
+ * spi_bus_submit() adds xfer to the queue of its bus. It does not run it. It
+ * can be called from an interrupt handler.
+ *
+ * @return
+ *      SPI_BUS_SUCCESS, or SPI_BUS_ALREADY_QUEUED if xfer is still queued.
+ */
+spi_bus_status_t
+spi_bus_submit
+(
+    spi_bus_xfer_t * xfer
+);
+
+/***************************************************************************//**
+ * spi_bus_run() runs the queued transactions of bus until the queue is empty.
+ * Only one caller runs the queue at a time; transactions submitted while it
+ * runs are run by it.
+ *
+ * @return
+ *      SPI_BUS_SUCCESS once the queue is empty, or SPI_BUS_BUSY if the queue
+ *      is already being run, by an interrupted caller or another task.
+ */
+spi_bus_status_t
+spi_bus_run
+(
+    spi_bus_t * bus
+);
+
+/***************************************************************************//**
+ * spi_bus_done() returns 1 once xfer was run, 0 while it is queued.
+ */
+uint8_t
+spi_bus_done
+(
+    const spi_bus_xfer_t * xfer
+);
+
+/***************************************************************************//**
+ * spi_bus_transfer() performs one transaction with device, as
+ * SPI_transfer_block() does, after the queued transactions of higher
+ * priority. It returns once the transaction is done.
+ *
+ * It must not be called from an interrupt handler or a done function, use
+ * spi_bus_submit() there.
+ *
+ * @return
+ *      SPI_BUS_SUCCESS, or SPI_BUS_BUSY if the queue is being run by the code
+ *      this call interrupted. Under FreeRTOS, after spi_bus_rtos_init(), the
+ *      calling task blocks until the task running the queue has performed the
+ *      transaction instead.
+ */
+spi_bus_status_t
+spi_bus_transfer
+(
+    spi_bus_device_t * device,
+    const uint8_t * cmd_buffer,
+    uint16_t cmd_size,
+    uint8_t * rx_buffer,
+    uint16_t rx_size
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPI_BUS_H_ */
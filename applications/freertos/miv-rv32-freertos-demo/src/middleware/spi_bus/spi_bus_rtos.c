@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file spi_bus_rtos.c
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief FreeRTOS binding of the CoreSPI bus manager.
+ *
+ * See spi_bus_rtos.h for details of how to use this module.
+ */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "spi_bus_rtos.h"
+
+/*
+ * Done function of the transactions of waiting tasks, called by the task which
+ * runs the queue. That task does not notify itself, its transaction is done
+ * when spi_bus_run() returns. The notification is the last access to xfer, the
+ * waiting task may return as soon as it is given.
+ */
+static void
+wake_owner
+(
+    spi_bus_xfer_t * xfer
+)
+{
+    TaskHandle_t owner = (TaskHandle_t)xfer->context;
+
+    if (owner != xTaskGetCurrentTaskHandle())
+    {
+        xTaskNotifyGiveIndexed(owner, SPI_BUS_RTOS_NOTIFY_INDEX);
+    }
+}
+
+static spi_bus_status_t
+wait_transfer
+(
+    spi_bus_xfer_t * xfer
+)
+{
+    spi_bus_t * bus = xfer->device->bus;
+
+    if (taskSCHEDULER_NOT_STARTED == xTaskGetSchedulerState())
+    {
+        /* Nothing can be running the queue */
+        (void)spi_bus_submit(xfer);
+        return spi_bus_run(bus);
+    }
+
+    xfer->done = wake_owner;
+    xfer->context = xTaskGetCurrentTaskHandle();
+
+    (void)spi_bus_submit(xfer);
+
+    if (SPI_BUS_SUCCESS == spi_bus_run(bus))
+    {
+        /* Another task may have run xfer before this one claimed the bus and
+         * notified it, clear that notification */
+        (void)ulTaskNotifyTakeIndexed(SPI_BUS_RTOS_NOTIFY_INDEX, pdTRUE, 0u);
+    }
+    else
+    {
+        /* Another task runs the queue and notifies this one once xfer is done */
+        do
+        {
+            (void)ulTaskNotifyTakeIndexed(SPI_BUS_RTOS_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+        } while (!spi_bus_done(xfer));
+    }
+
+    return SPI_BUS_SUCCESS;
+}
+
+/***************************************************************************//**
+ * See spi_bus_rtos.h for details of how to use this function.
+ */
+void
+spi_bus_rtos_init
+(
+    spi_bus_t * bus
+)
+{
+    bus->wait_transfer = wait_transfer;
+}
@@ -0,0 +1,61 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file spi_bus_rtos.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief FreeRTOS binding of the CoreSPI bus manager.
+ *
+ * After spi_bus_rtos_init(), a task calling spi_bus_transfer() on the bus, for
+ * example through the SPI flash driver, queues its transaction and blocks
+ * until it is done instead of failing with SPI_BUS_BUSY. The first task which
+ * finds the bus idle runs the queue, its own transaction and those of the tasks
+ * which queued theirs meanwhile, highest priority first, and wakes each of
+ * them as their transaction completes. No bus task or mutex is needed and the
+ * bus never waits for a task to be scheduled between two transactions.
+ *
+ * The running task performs the transfers of the other tasks at its own
+ * priority. Give the devices of high priority tasks a high transaction
+ * priority so that they are served first.
+ *
+ * The tasks are woken with their direct to task notification of index
+ * SPI_BUS_RTOS_NOTIFY_INDEX, which they must not use for anything else while
+ * they wait for the bus.
+ *
+ * This file is not used by the bootloader, which has no RTOS, and is excluded
+ * from the SoftConsole build configurations of this project. The FreeRTOS demo,
+ * applications/freertos/miv-rv32-freertos-demo, builds it with a copy of
+ * spi_bus.c.
+ */
+#ifndef SPI_BUS_RTOS_H_
+#define SPI_BUS_RTOS_H_
+
+#include "FreeRTOS.h"
+#include "spi_bus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SPI_BUS_RTOS_NOTIFY_INDEX
+#define SPI_BUS_RTOS_NOTIFY_INDEX       0u
+#endif
+
+/***************************************************************************//**
+ * spi_bus_rtos_init() makes spi_bus_transfer() block the calling task while
+ * the bus is in use. Call it once after spi_bus_init(), before the tasks use
+ * the bus. spi_bus_transfer() still runs the queue directly before the
+ * scheduler is started.
+ */
+void
+spi_bus_rtos_init
+(
+    spi_bus_t * bus
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPI_BUS_RTOS_H_ */
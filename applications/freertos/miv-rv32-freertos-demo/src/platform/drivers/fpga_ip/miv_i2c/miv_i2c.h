@@ -198,6 +198,15 @@ typedef enum miv_i2c_status
     MIV_I2C_TIMED_OUT
 }miv_i2c_status_t;
 
+/*-------------------------------------------------------------------------*//**
+  The miv_i2c_transfer_completion_t type is the type of the function called by
+  MIV_I2C_isr() when a master transaction completes, see
+  MIV_I2C_register_transfer_completion_handler().
+ */
+struct miv_i2c_instance;
+typedef void (*miv_i2c_transfer_completion_t)(struct miv_i2c_instance *this_i2c,
+                                              miv_i2c_status_t status);
+
 /*-------------------------------------------------------------------------*//**
   This structure is used to identify the MIV_I2C hardware instances in a system.
   Your application software should declare one instance of this structure for
@@ -246,6 +255,9 @@ typedef struct miv_i2c_instance
     volatile miv_i2c_status_t master_status;
     uint32_t master_timeout_ms;
 
+    /* Called from the ISR when a master transaction completes */
+    miv_i2c_transfer_completion_t transfer_completion_handler;
+
     /* user  specific data */
     void *p_user_data ;
 
@@ -315,6 +327,15 @@ typedef struct miv_i2c_instance
  */
 #define MIV_I2C_ACK_POLLING_ENABLE  				0x01u
 
+/*-------------------------------------------------------------------------*//**
+  MIV_I2C_NO_TIMEOUT
+  =====================
+  The MIV_I2C_NO_TIMEOUT constant is used as the timeout_ms parameter of
+  MIV_I2C_wait_complete() to wait for the end of the transaction for as long
+  as it takes.
+ */
+#define MIV_I2C_NO_TIMEOUT                          0u
+
 /*--------------------------------Public APIs---------------------------------*/
 
 /*-------------------------------------------------------------------------*//**
@@ -847,6 +868,96 @@ MIV_I2C_get_status
     miv_i2c_instance_t *this_i2c
 );
 
+/*-------------------------------------------------------------------------*//**
+  The MIV_I2C_wait_complete() function waits for the current transaction of
+  the MIV_I2C instance to complete. The wait is bounded by an MTIME deadline,
+  see miv_rv32_deadline.h, so neither a system tick interrupt nor a call from
+  the application is needed to detect the timeout.
+
+  A transaction still in progress when the timeout expires is abandoned: a
+  STOP condition is generated to release the bus and the master status is set
+  to MIV_I2C_TIMED_OUT. This ends, for example, the acknowledgment polling of
+  an EEPROM which never answers.
+
+  @param this_i2c
+                   A pointer to the miv_i2c_instance_t data structure which
+                   will hold all the data related to the Mi-V I2C module
+                   instance being used.
+
+  @param timeout_ms
+                   Longest time to wait, in milliseconds, or MIV_I2C_NO_TIMEOUT
+                   to wait until the transaction completes.
+
+  @return
+                   The master status at the end of the wait: MIV_I2C_SUCCESS,
+                   MIV_I2C_FAILED or MIV_I2C_TIMED_OUT.
+
+  Example:
+  @code
+    MIV_I2C_write(&miv_i2c, target_slave_addr, tx_buffer, write_length,
+                  MIV_I2C_RELEASE_BUS, MIV_I2C_ACK_POLLING_ENABLE);
+
+    if (MIV_I2C_SUCCESS != MIV_I2C_wait_complete(&miv_i2c, 100u))
+    {
+        // Handle the error
+    }
+  @endcode
+ */
+miv_i2c_status_t
+MIV_I2C_wait_complete
+(
+    miv_i2c_instance_t *this_i2c,
+    uint32_t timeout_ms
+);
+
+/*-------------------------------------------------------------------------*//**
+  The MIV_I2C_register_transfer_completion_handler() function registers a
+  function which MIV_I2C_isr() calls, from the interrupt context, each time a
+  master transaction completes with MIV_I2C_SUCCESS or MIV_I2C_FAILED. The
+  master status is already updated when it is called. It is not called for a
+  transaction abandoned by MIV_I2C_wait_complete().
+
+  The handler lets an RTOS wake the task waiting for the transaction instead of
+  that task polling the master status, see src/middleware/miv_i2c_rtos. The
+  p_user_data member of the instance can be used to pass it context.
+
+  @param this_i2c
+                   A pointer to the miv_i2c_instance_t data structure which
+                   will hold all the data related to the Mi-V I2C module
+                   instance being used.
+
+  @param completion_handler
+                   Function to call, or NULL to call none. MIV_I2C_init()
+                   clears the handler.
+
+  @return
+                   This function does not return any value.
+
+  Example:
+  @code
+    static volatile uint8_t g_done;
+
+    static void transfer_done(miv_i2c_instance_t *this_i2c,
+                              miv_i2c_status_t status)
+    {
+        g_done = 1u;
+    }
+
+    void main( void )
+    {
+        MIV_I2C_init(&g_miv_i2c_inst, MIV_I2C_BASE_ADDR);
+        MIV_I2C_register_transfer_completion_handler(&g_miv_i2c_inst,
+                                                     transfer_done);
+    }
+  @endcode
+ */
+void
+MIV_I2C_register_transfer_completion_handler
+(
+    miv_i2c_instance_t *this_i2c,
+    miv_i2c_transfer_completion_t completion_handler
+);
+
 #ifdef __cplusplus
 }
 #endif
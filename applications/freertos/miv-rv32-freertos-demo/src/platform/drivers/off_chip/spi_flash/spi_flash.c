@@ -0,0 +1,926 @@
+/*******************************************************************************
+*
+* (c) Copyright 2013 Microsemi SoC Products Group.  All rights reserved.
+*
+* Company: Microsemi Corporation
+*
+* File: spi_flash.c
+*
+* Description:
+*
+* Device driver for the on-board SPI flash for SmartFusion KITS Atmel AT25DF641
+*
+* SVN $Revision: 8241 $
+* SVN $Date: 2016-02-15 11:21:27 +0000 (Mon, 15 Feb 2016) $
+*
+*******************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#ifndef LEGACY_DIR_STRUCTURE
+#include "hal/hal.h"
+
+#else
+#include "hal.h"
+#endif
+#include "drivers/fpga_ip/CoreSPI/core_spi.h"
+#include "miv_rv32_hal/miv_rv32_deadline.h"
+#include "spi_bus/spi_bus.h"
+#include "spi_flash.h"
+
+#define READ_ARRAY_OPCODE         0x1B
+#define DEVICE_ID_READ            0x9F
+
+#define WRITE_ENABLE_CMD          0x06
+#define WRITE_DISABLE_CMD         0x04
+#define PROGRAM_PAGE_CMD          0x02
+#define WRITE_STATUS1_OPCODE      0x01
+#define CHIP_ERASE_OPCODE         0x60
+#define ERASE_4K_BLOCK_OPCODE     0x20
+#define ERASE_32K_BLOCK_OPCODE    0x52
+#define ERASE_64K_BLOCK_OPCODE    0xD8
+#define READ_STATUS               0x05
+#define PROGRAM_RESUME_CMD        0xD0
+#define READ_SECTOR_PROTECT       0x3C
+
+
+#define READY_BIT_MASK            0x01
+#define PROTECT_SECTOR_OPCODE     0x36
+#define UNPROTECT_SECTOR_OPCODE   0x39
+
+#define DONT_CARE                    0
+
+#define NB_BYTES_PER_PAGE          256
+
+#define BLOCK_ALIGN_MASK_4K      0xFFFFF000
+#define BLOCK_ALIGN_MASK_32K     0xFFFF8000
+#define BLOCK_ALIGN_MASK_64K     0xFFFF0000
+
+/*
+ * Longest time the device may stay busy, in milliseconds. A 64KB block erase
+ * takes up to 3 seconds, a chip erase several minutes. The operation is
+ * reported as failed if the device is still busy after that.
+ */
+#ifndef SPI_FLASH_READY_TIMEOUT_MS
+#define SPI_FLASH_READY_TIMEOUT_MS          3000u
+#endif
+
+#ifndef SPI_FLASH_CHIP_ERASE_TIMEOUT_MS
+#define SPI_FLASH_CHIP_ERASE_TIMEOUT_MS     480000u
+#endif
+
+/*
+ * Maximum bytes required for command including opcode,
+ * address and any dummy bytes.
+ */
+
+#define ATMEL_MAX_CMD_BYTES 6
+#define ATMEL_MAX_WRITE_BYTES (ATMEL_MAX_CMD_BYTES + NB_BYTES_PER_PAGE)
+
+/*
+ * SPI modes supported by the flash, and mode of the CoreSPI initialized by
+ * spi_flash_init().
+ */
+#define SPI_FLASH_SPI_MODES       (SPI_BUS_MODE_0 | SPI_BUS_MODE_3)
+
+#ifndef SPI_FLASH_BUS_MODE
+#define SPI_FLASH_BUS_MODE        SPI_BUS_MODE_0
+#endif
+
+/*
+ * Frame width of the CoreSPI initialized by spi_flash_init(). With 16 or 32
+ * bit frames, each APB access moves 2 or 4 bytes. The read, program and erase
+ * commands are 4 bytes long so their data stays aligned on frames; a page
+ * program which does not end on a frame is padded with 0xFF, which leaves the
+ * flash unchanged. Single byte commands such as write enable are followed by
+ * 0 bytes, the flash must ignore them.
+ */
+#ifndef SPI_FLASH_FRAME_WIDTH
+#define SPI_FLASH_FRAME_WIDTH     SPI_FRAME_WIDTH_8
+#endif
+
+#define MAX_FRAME_BYTES           4
+
+/*
+ * Erase count record, written alternately to the two 4KB blocks at
+ * SPI_FLASH_ERASE_COUNT_ADDR so that a reset during a save leaves the previous
+ * record intact. check is the complement of the sum of the preceding words.
+ */
+#define ERASE_COUNT_MAGIC         0x53415245u     /* "ERAS" */
+#define ERASE_COUNT_BLOCK_SIZE    0x1000u
+#define ERASE_COUNT_BLOCK_ADDR(block) \
+    (SPI_FLASH_ERASE_COUNT_ADDR + ((uint32_t)(block) * ERASE_COUNT_BLOCK_SIZE))
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t counts[SPI_FLASH_NB_SECTORS];
+    uint32_t check;
+} erase_count_record_t;
+
+/* g_erase_count_state values */
+#define ERASE_COUNTS_NOT_LOADED   0u
+#define ERASE_COUNTS_CLEAN        1u
+#define ERASE_COUNTS_DIRTY        2u
+
+static erase_count_record_t g_erase_counts;
+static uint8_t g_erase_count_state = ERASE_COUNTS_NOT_LOADED;
+static uint8_t g_erase_count_block;     /* Block of the last record read or written */
+
+static spi_flash_latency_t g_latency[SPI_FLASH_NB_LATENCIES];
+
+spi_instance_t g_flash_core_spi;
+
+/*
+ * Bus of spi_flash_init(), unused when the flash is attached to a bus shared
+ * with other devices.
+ */
+static spi_bus_t g_flash_spi_bus;
+static spi_bus_device_t g_flash_device;
+
+#define SPI_INSTANCE    &g_flash_device
+#define SPI_SLAVE       SPI_SLAVE_0
+
+#define SPI_TRANS_BLOCK spi_bus_transfer
+
+/*
+ * Our maximum write to the SPI FLASH device will be a 6 byte command
+ * and a full 256 byte page of data. We construct this here because the
+ * SPI block transfer only supports a single write buffer. To avoid the
+ * overhead of buffer copying you could use the driver SPI_transfer_block()
+ * as a template for writing a block transfer routine that allowed transfers
+ * from two separate buffers without deselecting the slave.
+ */
+static uint8_t flash_write_buffer[ATMEL_MAX_WRITE_BYTES + MAX_FRAME_BYTES - 1];
+
+static uint8_t wait_ready( void );
+static uint8_t wait_ready_for( uint32_t timeout_ms );
+static uint8_t wait_ready_erase( void );
+static uint8_t wait_done( spi_flash_latency_op_t op, uint64_t start, uint32_t timeout_ms );
+static void record_latency( spi_flash_latency_op_t op, uint64_t start );
+static void count_erase( uint32_t address, uint32_t size );
+
+/******************************************************************************
+ *For more details please refer the spi_flash.h file
+ ******************************************************************************/
+spi_flash_status_t spi_flash_init( uint32_t base_addr )
+{
+    /*--------------------------------------------------------------------------
+     * Configure CoreSPI, the flash is the only device on the bus.
+     */
+    spi_bus_init( &g_flash_spi_bus, &g_flash_core_spi, base_addr, 32,
+                  SPI_FLASH_BUS_MODE, 0 );
+    SPI_set_frame_width( &g_flash_core_spi, SPI_FLASH_FRAME_WIDTH );
+
+    return( spi_flash_attach( &g_flash_spi_bus, SPI_SLAVE ) );
+}
+
+/******************************************************************************
+ *For more details please refer the spi_flash.h file
+ ******************************************************************************/
+spi_flash_status_t spi_flash_attach( spi_bus_t * bus, spi_slave_t slave )
+{
+    /* Erases and page programs are long sequences of transactions, let the
+     * other devices of the bus go first. */
+    if( SPI_BUS_SUCCESS != spi_bus_add_device( bus,
+                                               &g_flash_device,
+                                               slave,
+                                               SPI_FLASH_SPI_MODES,
+                                               0,
+                                               SPI_BUS_PRIORITY_LOW ) )
+    {
+        return( SPI_FLASH_INVALID_ARGUMENTS );
+    }
+
+    return( SPI_FLASH_SUCCESS );
+}
+
+/******************************************************************************
+ *For more details please refer the spi_flash.h file
+ ******************************************************************************/
+spi_flash_status_t
+spi_flash_control_hw
+(
+    spi_flash_control_hw_t operation,
+    uint32_t param1,
+    void *   ptrParam
+)
+{
+    uint8_t x;
+    uint64_t start;
+    switch(operation){
+        case SPI_FLASH_READ_DEVICE_ID:
+        {
+            uint8_t read_device_id_cmd = DEVICE_ID_READ;
+            uint8_t read_buffer[3];
+            struct device_Info *ptrDevInfo = (struct device_Info *)ptrParam;
+//x=1;
+
+//while(x<0xff)
+{
+        //read_device_id_cmd = x;
+            SPI_TRANS_BLOCK( SPI_INSTANCE,
+                                    &read_device_id_cmd,
+                                    1,
+                                    read_buffer,
+                                    sizeof(read_buffer) );
+            x++;
+}
+
+            ptrDevInfo->manufacturer_id = read_buffer[0];
+            ptrDevInfo->device_id = read_buffer[1];
+            ptrDevInfo->mem_cap = read_buffer[2];
+
+        }
+        break;
+        case SPI_FLASH_SECTOR_PROTECT:
+        {
+            uint8_t cmd_buffer[4];
+            uint32_t address = param1;
+
+            /* Send Write Enable command */
+            cmd_buffer[0] = WRITE_ENABLE_CMD;
+            if(wait_ready())
+                   return SPI_FLASH_UNSUCCESS;
+            SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 1, 0, 0 );
+            /* protect sector */
+            cmd_buffer[0] = PROTECT_SECTOR_OPCODE;
+            cmd_buffer[1] = (address >> 16) & 0xFF;
+            cmd_buffer[2] = (address >> 8 ) & 0xFF;
+            cmd_buffer[3] = address & 0xFF;
+            if(wait_ready())
+                return SPI_FLASH_UNSUCCESS;
+
+            SPI_TRANS_BLOCK( SPI_INSTANCE,
+                                    cmd_buffer,
+                                    sizeof(cmd_buffer),
+                                    0,
+                                    0 );
+        }
+        break;
+        case SPI_FLASH_SECTOR_UNPROTECT:
+        {
+            uint8_t cmd_buffer[4];
+            uint32_t address = param1;
+
+            /* Send Write Enable command */
+            cmd_buffer[0] = WRITE_ENABLE_CMD;
+            if(wait_ready())
+                return SPI_FLASH_UNSUCCESS;
+
+            SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 1, 0, 0 );
+
+            /* Unprotect sector */
+            cmd_buffer[0] = UNPROTECT_SECTOR_OPCODE;
+            cmd_buffer[1] = (address >> 16) & 0xFF;
+            cmd_buffer[2] = (address >> 8 ) & 0xFF;
+            cmd_buffer[3] = address & 0xFF;
+            if(wait_ready())
+                return SPI_FLASH_UNSUCCESS;
+
+            SPI_TRANS_BLOCK( SPI_INSTANCE,
+                                    cmd_buffer,
+                                    sizeof(cmd_buffer),
+                                    0,
+                                    0 );
+        }
+        break;
+
+        case SPI_FLASH_GLOBAL_PROTECT:
+        case SPI_FLASH_GLOBAL_UNPROTECT:
+        {
+            uint8_t cmd_buffer[2];
+            /* Send Write Enable command */
+            cmd_buffer[0] = WRITE_ENABLE_CMD;
+
+            if(wait_ready())
+               return SPI_FLASH_UNSUCCESS;
+
+            SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 1, 0, 0 );
+
+            /* Send Chip Erase command */
+            cmd_buffer[0] = WRITE_STATUS1_OPCODE;
+            cmd_buffer[1] = 0;
+
+            if(wait_ready())
+               return SPI_FLASH_UNSUCCESS;
+
+            SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 2, 0, 0 );
+            if(wait_ready())
+                return SPI_FLASH_UNSUCCESS;
+        }
+        break;
+        case SPI_FLASH_CHIP_ERASE:
+        {
+            uint8_t cmd_buffer;
+            /* Send Write Enable command */
+            cmd_buffer = WRITE_ENABLE_CMD;
+
+            if(wait_ready())
+                return SPI_FLASH_UNSUCCESS;
+
+            SPI_TRANS_BLOCK( SPI_INSTANCE, &cmd_buffer, 1, 0, 0 );
+
+            /* Send Chip Erase command */
+            cmd_buffer = CHIP_ERASE_OPCODE;
+
+            if(wait_ready())
+                return SPI_FLASH_UNSUCCESS;
+
+            start = DEADLINE_READ_MTIME();
+            SPI_TRANS_BLOCK( SPI_INSTANCE, &cmd_buffer, 1, 0, 0 );
+            if(wait_done(SPI_FLASH_LATENCY_CHIP_ERASE, start,
+                         SPI_FLASH_CHIP_ERASE_TIMEOUT_MS))
+                return SPI_FLASH_UNSUCCESS;
+
+            count_erase(0, SPI_FLASH_SIZE);
+        }
+        break;
+        case SPI_FLASH_RESET:
+        {
+            uint8_t cmd_buffer;
+            /* Send Write Enable command */
+            cmd_buffer = 0x66;
+            SPI_TRANS_BLOCK( SPI_INSTANCE, &cmd_buffer, 1, 0, 0 );
+            cmd_buffer = 0x99;
+            SPI_TRANS_BLOCK( SPI_INSTANCE, &cmd_buffer, 1, 0, 0 );
+            if(wait_ready())
+                return SPI_FLASH_UNSUCCESS;
+        }
+        break;
+
+        case SPI_FLASH_4KBLOCK_ERASE:
+        {
+            uint32_t address = param1 & BLOCK_ALIGN_MASK_4K;
+            uint8_t cmd_buffer[4];
+            /* Send Write Enable command */
+            cmd_buffer[0] = WRITE_ENABLE_CMD;
+
+            if(wait_ready())
+                return SPI_FLASH_UNSUCCESS;
+
+            SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 1, 0, 0 );
+
+            if(wait_ready())
+                            return SPI_FLASH_UNSUCCESS;
+
+            /* Send Chip Erase command */
+            cmd_buffer[0] = ERASE_4K_BLOCK_OPCODE;
+            cmd_buffer[1] = (address >> 16) & 0xFF;
+            cmd_buffer[2] = (address >> 8 ) & 0xFF;
+            cmd_buffer[3] = address & 0xFF;
+
+            if(wait_ready())
+                return SPI_FLASH_UNSUCCESS;
+
+            wait_ready_erase();
+
+            start = DEADLINE_READ_MTIME();
+            SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 4, 0, 0 );
+            if(wait_done(SPI_FLASH_LATENCY_4KBLOCK_ERASE, start,
+                         SPI_FLASH_READY_TIMEOUT_MS))
+                return SPI_FLASH_UNSUCCESS;
+
+            wait_ready_erase();
+            count_erase(address, 0x1000);
+
+        }
+        break;
+        case SPI_FLASH_32KBLOCK_ERASE:
+        {
+            uint32_t address = param1 & BLOCK_ALIGN_MASK_32K;
+            uint8_t cmd_buffer[4];
+            /* Send Write Enable command */
+            cmd_buffer[0] = WRITE_ENABLE_CMD;
+
+            wait_ready();
+            SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 1, 0, 0 );
+
+            /* Send Chip Erase command */
+            cmd_buffer[0] = ERASE_32K_BLOCK_OPCODE;
+            cmd_buffer[1] = (address >> 16) & 0xFF;
+            cmd_buffer[2] = (address >> 8 ) & 0xFF;
+            cmd_buffer[3] = address & 0xFF;
+
+            if(wait_ready())
+                return SPI_FLASH_UNSUCCESS;
+
+            start = DEADLINE_READ_MTIME();
+            SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 4, 0, 0 );
+            if(wait_done(SPI_FLASH_LATENCY_32KBLOCK_ERASE, start,
+                         SPI_FLASH_READY_TIMEOUT_MS))
+                return SPI_FLASH_UNSUCCESS;
+
+            count_erase(address, 0x8000);
+        }
+        break;
+        case SPI_FLASH_64KBLOCK_ERASE:
+        {
+            uint32_t address = param1 & BLOCK_ALIGN_MASK_64K;
+            uint8_t cmd_buffer[4];
+            /* Send Write Enable command */
+            cmd_buffer[0] = WRITE_ENABLE_CMD;
+
+            if(wait_ready())
+                return SPI_FLASH_UNSUCCESS;
+
+            SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 1, 0, 0 );
+
+             /* Send Chip Erase command */
+            cmd_buffer[0] = ERASE_64K_BLOCK_OPCODE;
+            cmd_buffer[1] = (address >> 16) & 0xFF;
+            cmd_buffer[2] = (address >> 8 ) & 0xFF;
+            cmd_buffer[3] = address & 0xFF;
+
+            if(wait_ready())
+                return SPI_FLASH_UNSUCCESS;
+            start = DEADLINE_READ_MTIME();
+            SPI_TRANS_BLOCK( SPI_INSTANCE,
+                                    cmd_buffer,
+                                    sizeof(cmd_buffer),
+                                    0,
+                                    0 );
+            if(wait_done(SPI_FLASH_LATENCY_64KBLOCK_ERASE, start,
+                         SPI_FLASH_READY_TIMEOUT_MS))
+                return SPI_FLASH_UNSUCCESS;
+
+            count_erase(address, 0x10000);
+        }
+        break;
+        case SPI_FLASH_GET_STATUS:
+        {
+            uint8_t status[2];
+            uint8_t command = READ_STATUS;
+
+            SPI_TRANS_BLOCK( SPI_INSTANCE,
+                                    &command,
+                                    sizeof(uint8_t),
+                                    status,
+                                    2 );
+
+            *((uint16_t *)ptrParam) = (status[1]) << 8 | status[0];
+        }
+        break;
+
+        case SPI_FLASH_GET_PROTECT:
+        {
+            uint8_t cmd_buffer[4];
+
+             /* Send Read Sector Protection Register command */
+            cmd_buffer[0] = READ_SECTOR_PROTECT;
+            cmd_buffer[1] = (param1 >> 16) & 0xFF;
+            cmd_buffer[2] = (param1 >> 8 ) & 0xFF;
+            cmd_buffer[3] = param1 & 0xFF;
+
+            if(wait_ready())
+                return SPI_FLASH_UNSUCCESS;
+
+            SPI_TRANS_BLOCK( SPI_INSTANCE,
+                                    cmd_buffer,
+                                    sizeof(cmd_buffer),
+                                    (uint8_t *)ptrParam,
+                                    1 );
+
+            if(wait_ready())
+            {
+                *((uint8_t *)ptrParam) = 1; // Mark as bad result as real one is 0 or 255
+                return SPI_FLASH_UNSUCCESS;
+            }
+        }
+        break;
+
+        default:
+              return SPI_FLASH_INVALID_ARGUMENTS;
+        break;
+    }
+    return SPI_FLASH_SUCCESS;
+}
+
+
+/******************************************************************************
+ *For more details please refer the spi_flash.h file
+ ******************************************************************************/
+spi_flash_status_t
+spi_flash_read
+(
+    uint32_t address,
+    uint8_t * rx_buffer,
+    size_t size_in_bytes
+)
+{
+    uint8_t cmd_buffer[6];
+
+    cmd_buffer[0] = 0x03;//READ_ARRAY_OPCODE;
+    cmd_buffer[1] = (uint8_t)((address >> 16) & 0xFF);
+    cmd_buffer[2] = (uint8_t)((address >> 8) & 0xFF);;
+    cmd_buffer[3] = (uint8_t)(address & 0xFF);
+    cmd_buffer[4] = DONT_CARE;
+    cmd_buffer[5] = DONT_CARE;
+
+    wait_ready_erase();
+
+    if(wait_ready())
+        return SPI_FLASH_UNSUCCESS;
+
+    wait_ready_erase();
+
+    SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 4/*sizeof(cmd_buffer)*/, rx_buffer, size_in_bytes );
+    wait_ready_erase();
+    return 0;
+}
+
+
+/*******************************************************************************
+ * This function sends the command and data to the FLASH device via SPI.
+ */
+static void write_cmd_data
+(
+    spi_bus_device_t * this_spi,
+    const uint8_t * cmd_buffer,
+    uint16_t cmd_byte_size,
+    uint8_t * data_buffer,
+    uint16_t data_byte_size
+)
+{
+    uint16_t frame_bytes = this_spi->bus->spi->frame_bytes;
+    uint16_t total_size = cmd_byte_size + data_byte_size;
+
+    /*
+     * Construct our combined command and data block
+     */
+    if( cmd_byte_size )
+        memcpy( flash_write_buffer, cmd_buffer, cmd_byte_size );
+
+    if( data_byte_size )
+        memcpy( &flash_write_buffer[cmd_byte_size], data_buffer, data_byte_size );
+
+    /* Fill the last frame with erased bytes rather than the 0s of the driver */
+    while( total_size % frame_bytes )
+        flash_write_buffer[total_size++] = 0xFF;
+
+    SPI_TRANS_BLOCK( this_spi, flash_write_buffer, total_size, 0, 0 );
+}
+
+/******************************************************************************
+ *For more details please refer the spi_flash.h file
+ ******************************************************************************/
+spi_flash_status_t
+spi_flash_write
+(
+    uint32_t address,
+    uint8_t * write_buffer,
+    size_t size_in_bytes
+)
+{
+    uint8_t cmd_buffer[4];
+
+    uint32_t in_buffer_idx;
+    uint32_t nb_bytes_to_write;
+    uint32_t target_addr;
+    uint64_t start;
+
+    /* Send Write Enable command */
+    cmd_buffer[0] = WRITE_ENABLE_CMD;
+    wait_ready();
+    SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 1, 0, 0 );
+
+    /* Unprotect sector */
+    cmd_buffer[0] = UNPROTECT_SECTOR_OPCODE;
+    cmd_buffer[1] = (address >> 16) & 0xFF;
+    cmd_buffer[2] = (address >> 8 ) & 0xFF;
+    cmd_buffer[3] = address & 0xFF;
+    wait_ready();
+    SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, sizeof(cmd_buffer), 0, 0 );
+    wait_ready_erase();
+
+    /* Send Write Enable command */
+    cmd_buffer[0] = WRITE_ENABLE_CMD;
+    if(wait_ready())
+        return SPI_FLASH_UNSUCCESS;
+
+    SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 1, 0, 0 );
+
+    /**/
+    in_buffer_idx = 0;
+    nb_bytes_to_write = size_in_bytes;
+    target_addr = address;
+
+    while ( in_buffer_idx < size_in_bytes )
+    {
+        wait_ready_erase();
+        uint32_t size_left;
+        nb_bytes_to_write = 0x100 - (target_addr & 0xFF);
+        /* adjust max possible size to page boundary. */
+        size_left = size_in_bytes - in_buffer_idx;
+        if ( size_left < nb_bytes_to_write )
+        {
+            nb_bytes_to_write = size_left;
+        }
+
+        if(wait_ready())
+            return SPI_FLASH_UNSUCCESS;
+
+        /* Send Write Enable command */
+        cmd_buffer[0] = WRITE_ENABLE_CMD;
+        SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 1, 0, 0 );
+
+        /* Program page */
+        if(wait_ready())
+            return SPI_FLASH_UNSUCCESS;
+
+
+        cmd_buffer[0] = PROGRAM_PAGE_CMD;
+        cmd_buffer[1] = (target_addr >> 16) & 0xFF;
+        cmd_buffer[2] = (target_addr >> 8 ) & 0xFF;
+        cmd_buffer[3] = target_addr & 0xFF;
+
+        start = DEADLINE_READ_MTIME();
+        write_cmd_data
+          (
+            SPI_INSTANCE,
+            cmd_buffer,
+            sizeof(cmd_buffer),
+            &write_buffer[in_buffer_idx],
+            nb_bytes_to_write
+          );
+
+        if(wait_done(SPI_FLASH_LATENCY_PAGE_PROGRAM, start,
+                     SPI_FLASH_READY_TIMEOUT_MS))
+            return SPI_FLASH_UNSUCCESS;
+
+        target_addr += nb_bytes_to_write;
+        in_buffer_idx += nb_bytes_to_write;
+        wait_ready_erase();
+    }
+
+    /* Send Write Disable command. */
+    cmd_buffer[0] = WRITE_DISABLE_CMD;
+
+    if(wait_ready())
+        return SPI_FLASH_UNSUCCESS;
+
+    SPI_TRANS_BLOCK( SPI_INSTANCE, cmd_buffer, 1, 0, 0 );
+    return 0;
+}
+
+
+/******************************************************************************
+ * This function waits for the SPI operation to complete. It returns the busy
+ * bit, still set if the device did not complete within timeout_ms.
+ ******************************************************************************/
+static uint8_t wait_ready_for( uint32_t timeout_ms )
+{
+    uint64_t start = DEADLINE_READ_MTIME();
+    deadline_t deadline = deadline_in_ms(timeout_ms);
+    uint8_t ready_bit;
+    uint8_t command = READ_STATUS;
+
+    do {
+        SPI_TRANS_BLOCK(SPI_INSTANCE, &command, 1, &ready_bit, 1);
+        ready_bit = ready_bit & READY_BIT_MASK;
+    } while((ready_bit & READY_BIT_MASK) && !deadline_expired(deadline));
+
+    record_latency(SPI_FLASH_LATENCY_BUSY_WAIT, start);
+    return (ready_bit);
+}
+
+static uint8_t wait_ready( void )
+{
+    return wait_ready_for(SPI_FLASH_READY_TIMEOUT_MS);
+}
+
+static uint8_t wait_ready_erase( void )
+{
+    uint64_t start = DEADLINE_READ_MTIME();
+    deadline_t deadline = deadline_in_ms(SPI_FLASH_READY_TIMEOUT_MS);
+    uint8_t ready_bit;
+    uint8_t command = 0x70 ; // FLAG_READ_STATUS;
+
+    do {
+        SPI_TRANS_BLOCK(SPI_INSTANCE, &command, 1, &ready_bit, 1);
+    } while(((ready_bit & 0x80) == 0) && !deadline_expired(deadline));
+
+    record_latency(SPI_FLASH_LATENCY_BUSY_WAIT, start);
+    return (ready_bit);
+}
+
+/******************************************************************************
+ * This function waits for the program or erase started at MTIME start to
+ * complete and records its duration if it did.
+ ******************************************************************************/
+static uint8_t wait_done( spi_flash_latency_op_t op, uint64_t start, uint32_t timeout_ms )
+{
+    uint8_t busy = wait_ready_for(timeout_ms);
+
+    if(!busy)
+        record_latency(op, start);
+
+    return (busy);
+}
+
+/******************************************************************************
+ * This function adds the time elapsed since MTIME start to the latency
+ * histogram of op.
+ ******************************************************************************/
+static void record_latency( spi_flash_latency_op_t op, uint64_t start )
+{
+    spi_flash_latency_t * latency;
+    uint64_t elapsed_us;
+    uint32_t us;
+    uint32_t value;
+    uint32_t bucket = 0;
+
+    if(op >= SPI_FLASH_NB_LATENCIES)
+        return;
+
+    elapsed_us = ((DEADLINE_READ_MTIME() - start) * 1000000u) / DEADLINE_MTIME_FREQ;
+    us = (elapsed_us > 0xFFFFFFFFu) ? 0xFFFFFFFFu : (uint32_t)elapsed_us;
+
+    /* Bucket n counts the durations from 2^n to 2^(n+1) - 1 microseconds */
+    value = us;
+    while((value > 1u) && (bucket < (SPI_FLASH_LATENCY_BUCKETS - 1u)))
+    {
+        value >>= 1;
+        ++bucket;
+    }
+
+    latency = &g_latency[op];
+    ++latency->count;
+    ++latency->buckets[bucket];
+    latency->total_us += us;
+    if(us > latency->max_us)
+        latency->max_us = us;
+}
+
+/******************************************************************************
+ * For more details please refer the spi_flash.h file
+ ******************************************************************************/
+const spi_flash_latency_t *
+spi_flash_get_latency
+(
+    spi_flash_latency_op_t op
+)
+{
+    if(op >= SPI_FLASH_NB_LATENCIES)
+        return NULL;
+
+    return &g_latency[op];
+}
+
+/******************************************************************************
+ * For more details please refer the spi_flash.h file
+ ******************************************************************************/
+void
+spi_flash_clear_latency
+(
+    void
+)
+{
+    memset(g_latency, 0, sizeof(g_latency));
+}
+
+static uint32_t erase_count_check( void )
+{
+    const uint32_t * word = (const uint32_t *)&g_erase_counts;
+    uint32_t nb_words = offsetof(erase_count_record_t, check) / sizeof(uint32_t);
+    uint32_t sum = 0;
+
+    while(nb_words--)
+        sum += *word++;
+
+    return (~sum);
+}
+
+/******************************************************************************
+ * This function counts an erase of size bytes at address in the sectors it
+ * covers. The counts are loaded from the flash the first time.
+ ******************************************************************************/
+static void count_erase( uint32_t address, uint32_t size )
+{
+    uint32_t sector;
+
+    if(ERASE_COUNTS_NOT_LOADED == g_erase_count_state)
+        (void)spi_flash_load_erase_counts();
+
+    if(ERASE_COUNTS_NOT_LOADED == g_erase_count_state)
+        return;
+
+    for(sector = address / SPI_FLASH_SECTOR_SIZE;
+        (sector < SPI_FLASH_NB_SECTORS) && ((sector * SPI_FLASH_SECTOR_SIZE) < (address + size));
+        ++sector)
+    {
+        ++g_erase_counts.counts[sector];
+    }
+
+    g_erase_count_state = ERASE_COUNTS_DIRTY;
+}
+
+/******************************************************************************
+ * For more details please refer the spi_flash.h file
+ ******************************************************************************/
+spi_flash_status_t
+spi_flash_load_erase_counts
+(
+    void
+)
+{
+    uint8_t block;
+    uint8_t found = 0;
+    uint32_t sequence = 0;
+
+    g_erase_count_state = ERASE_COUNTS_NOT_LOADED;
+
+    for(block = 0; block < 2; ++block)
+    {
+        if(spi_flash_read(ERASE_COUNT_BLOCK_ADDR(block),
+                          (uint8_t *)&g_erase_counts,
+                          sizeof(g_erase_counts)))
+        {
+            memset(&g_erase_counts, 0, sizeof(g_erase_counts));
+            return SPI_FLASH_UNSUCCESS;
+        }
+
+        if((ERASE_COUNT_MAGIC == g_erase_counts.magic) &&
+           (erase_count_check() == g_erase_counts.check) &&
+           (!found || ((int32_t)(g_erase_counts.sequence - sequence) > 0)))
+        {
+            found = 1;
+            sequence = g_erase_counts.sequence;
+            g_erase_count_block = block;
+        }
+    }
+
+    if(!found)
+    {
+        /* Blank area, the first save goes to block 0 */
+        memset(&g_erase_counts, 0, sizeof(g_erase_counts));
+        g_erase_count_block = 1;
+    }
+    else if(0 == g_erase_count_block)
+    {
+        /* Block 1 was read last */
+        if(spi_flash_read(ERASE_COUNT_BLOCK_ADDR(0),
+                          (uint8_t *)&g_erase_counts,
+                          sizeof(g_erase_counts)))
+        {
+            memset(&g_erase_counts, 0, sizeof(g_erase_counts));
+            return SPI_FLASH_UNSUCCESS;
+        }
+    }
+
+    g_erase_count_state = ERASE_COUNTS_CLEAN;
+    return SPI_FLASH_SUCCESS;
+}
+
+/******************************************************************************
+ * For more details please refer the spi_flash.h file
+ ******************************************************************************/
+spi_flash_status_t
+spi_flash_save_erase_counts
+(
+    void
+)
+{
+    uint8_t block;
+    uint32_t address;
+
+    if(ERASE_COUNTS_DIRTY != g_erase_count_state)
+        return SPI_FLASH_SUCCESS;
+
+    /* The erase of the block is counted in the record written to it */
+    block = g_erase_count_block ^ 1u;
+    address = ERASE_COUNT_BLOCK_ADDR(block);
+    if(spi_flash_control_hw(SPI_FLASH_4KBLOCK_ERASE, address, NULL))
+        return SPI_FLASH_UNSUCCESS;
+
+    g_erase_counts.magic = ERASE_COUNT_MAGIC;
+    ++g_erase_counts.sequence;
+    g_erase_counts.check = erase_count_check();
+
+    if(spi_flash_write(address, (uint8_t *)&g_erase_counts, sizeof(g_erase_counts)))
+        return SPI_FLASH_UNSUCCESS;
+
+    g_erase_count_block = block;
+    g_erase_count_state = ERASE_COUNTS_CLEAN;
+    return SPI_FLASH_SUCCESS;
+}
+
+/******************************************************************************
+ * For more details please refer the spi_flash.h file
+ ******************************************************************************/
+uint32_t
+spi_flash_get_erase_count
+(
+    uint32_t sector
+)
+{
+    if(ERASE_COUNTS_NOT_LOADED == g_erase_count_state)
+        (void)spi_flash_load_erase_counts();
+
+    if(sector >= SPI_FLASH_NB_SECTORS)
+        return 0;
+
+    return g_erase_counts.counts[sector];
+}
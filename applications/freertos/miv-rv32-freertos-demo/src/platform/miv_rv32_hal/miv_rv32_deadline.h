@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * Copyright 2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @file miv_rv32_deadline.h
+ * @author Microchip FPGA Embedded Systems Solutions
+ * @brief Polled timeouts based on the MTIME counter.
+ *
+ * A deadline is the MTIME value at which a wait gives up. It is computed once,
+ * before the wait, and the wait loop only reads MTIME to check it:
+ *
+ *      deadline_t deadline = deadline_in_ms(100u);
+ *
+ *      while (!ready())
+ *      {
+ *          if (deadline_expired(deadline))
+ *          {
+ *              return TIMEOUT;
+ *          }
+ *      }
+ *
+ * No timer interrupt is needed, and the resolution is that of MTIME,
+ * SYS_CLK_FREQ / MTIME_PRESCALER, instead of the 10 ms of a SysTick count.
+ * MTIME is 64 bits wide so it does not wrap in the life of the system; the
+ * comparison is nevertheless done on the difference, which stays correct
+ * across a wrap.
+ *
+ * The internal MTIME of the Mi-V soft processor is used, these functions are
+ * not available when MIV_RV32_EXT_TIMER is defined. The legacy RV32 cores,
+ * which have no MTIME_PRESCALER register, count MTIME at SYS_CLK_FREQ / 100.
+ *
+ * When HAL_HOST_SIMULATION is defined the simulated MTIME of hal_sim is used
+ * instead, see hal_sim.h.
+ */
+#ifndef MIV_RV32_DEADLINE_H_
+#define MIV_RV32_DEADLINE_H_
+
+#include <stdint.h>
+
+#ifndef HAL_HOST_SIMULATION
+#include "miv_rv32_hal/miv_rv32_hal.h"
+
+#ifdef MIV_RV32_EXT_TIMER
+#error "miv_rv32_deadline.h needs the internal MTIME of the Mi-V soft processor"
+#endif
+
+#define DEADLINE_READ_MTIME()           MRV_read_mtime()
+#ifdef MIV_LEGACY_RV32
+#define DEADLINE_MTIME_FREQ             ((uint64_t)SYS_CLK_FREQ / 100u)
+#else
+#define DEADLINE_MTIME_FREQ             ((uint64_t)SYS_CLK_FREQ / MTIME_PRESCALER)
+#endif
+#else
+#include "hal_sim.h"
+
+#define DEADLINE_READ_MTIME()           HAL_SIM_read_mtime()
+#define DEADLINE_MTIME_FREQ             ((uint64_t)HAL_SIM_MTIME_FREQ)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+ * MTIME value at which a wait times out.
+ */
+typedef uint64_t deadline_t;
+
+/***************************************************************************//**
+ * deadline_in_ms() returns the deadline ms milliseconds from now.
+ */
+static inline deadline_t deadline_in_ms(uint32_t ms)
+{
+    return DEADLINE_READ_MTIME() + (((uint64_t)ms * DEADLINE_MTIME_FREQ) / 1000u);
+}
+
+/***************************************************************************//**
+ * deadline_in_us() returns the deadline us microseconds from now. The wait is
+ * rounded up to the next MTIME tick.
+ */
+static inline deadline_t deadline_in_us(uint32_t us)
+{
+    return DEADLINE_READ_MTIME() +
+           ((((uint64_t)us * DEADLINE_MTIME_FREQ) + 999999u) / 1000000u);
+}
+
+/***************************************************************************//**
+ * deadline_expired() returns 1 once MTIME has reached deadline, 0 before.
+ */
+static inline uint8_t deadline_expired(deadline_t deadline)
+{
+    return (((int64_t)(DEADLINE_READ_MTIME() - deadline)) >= 0) ? 1u : 0u;
+}
+
+/***************************************************************************//**
+ * deadline_wait() busy waits until deadline.
+ */
+static inline void deadline_wait(deadline_t deadline)
+{
+    while (!deadline_expired(deadline))
+    {
+        ;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MIV_RV32_DEADLINE_H_ */